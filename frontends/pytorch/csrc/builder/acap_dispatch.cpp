@@ -132,7 +132,7 @@ void AcapController::returns(std::vector<at::Tensor> tensors) {
     if (mlirValueIsNull(v)) {
       debugTrace(
           "Return of imported-constant tensor (intentional memorization?)");
-      v = importTensorByValue(tensor);
+      v = importExternalTensor(tensor);
     }
 
     returnsTypes.push_back(mlirValueGetType(v));
@@ -460,7 +460,7 @@ MlirValue AcapController::mapIValueToMlirValue(MlirLocation loc,
       return mappedValue;
     }
 
-    mappedValue = importTensorByValue(ival.toTensor());
+    mappedValue = importExternalTensor(ival.toTensor());
     assert(mappedValue.ptr);
     return mappedValue;
   }
@@ -530,7 +530,10 @@ MlirType AcapController::mapIValueToMlirType(MlirLocation loc,
 
 MlirValue AcapController::importTensorByValue(at::Tensor tensor) {
   auto loc = getCurrentLocation();
-  MlirAttribute valueAttribute = converTensorToMlirElementsAttr(tensor, loc);
+  MlirAttribute valueAttribute =
+      weightsDir.empty()
+          ? converTensorToMlirElementsAttr(tensor, loc)
+          : convertTensorToMlirExternalElementsAttr(tensor, loc, weightsDir);
   MlirValue constTensorValue =
       funcBuilder->getGeneralConstant(loc, valueAttribute);
 
@@ -550,6 +553,21 @@ MlirValue AcapController::importTensorByValue(at::Tensor tensor) {
   return constArrayValue;
 }
 
+MlirValue AcapController::importExternalTensor(at::Tensor tensor) {
+  if (!liftParameters)
+    return importTensorByValue(tensor);
+
+  // Lift to a new trailing argument. The order in which tensors are first
+  // touched is deterministic for a given trace, so the resulting parameter
+  // list is stable across captures of the same architecture.
+  MlirValue arg =
+      funcBuilder->appendArgument(typeMapper.forwardTensorToType(tensor));
+  liftedParameters.push_back(tensor);
+  liftedParameterVersions.push_back(tensor._version());
+  funcBuilder->mapTensor(tensor, arg);
+  return arg;
+}
+
 TORCH_LIBRARY_IMPL(aten, BackendSelect, m) {
   // PyTorch logs a warning when kernels are overriden, which is unavoidable
   // for factory-function BackendSelect kernels (there is not yet a "safe"
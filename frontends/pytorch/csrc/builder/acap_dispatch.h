@@ -16,6 +16,8 @@
 
 #include <list>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "../pybind.h"
 
@@ -33,8 +35,11 @@ namespace torch_mlir {
 class AcapController : public std::enable_shared_from_this<AcapController> {
 public:
   AcapController(TypeMapper &typeMapper,
-                 std::unique_ptr<FuncBuilder> funcBuilder)
-      : typeMapper(typeMapper), funcBuilder(std::move(funcBuilder)) {}
+                 std::unique_ptr<FuncBuilder> funcBuilder,
+                 std::string weightsDir = std::string(),
+                 bool liftParameters = false)
+      : typeMapper(typeMapper), funcBuilder(std::move(funcBuilder)),
+        weightsDir(std::move(weightsDir)), liftParameters(liftParameters) {}
 
   // Enter and exit the context manager.
   pybind11::object contextEnter();
@@ -44,6 +49,17 @@ public:
   // Terminates capture and returns tensors from the function.
   void returns(std::vector<at::Tensor> tensors);
 
+  // Tensors that were lifted to trailing function arguments, in argument
+  // order. Only populated when capturing with `liftParameters`.
+  std::vector<at::Tensor> getLiftedParameters() { return liftedParameters; }
+
+  // The version counter of each lifted parameter when it was lifted, that is,
+  // before the captured ops ran. Comparing it with the current version
+  // detects in-place updates made by the capture.
+  std::vector<int64_t> getLiftedParameterVersions() {
+    return liftedParameterVersions;
+  }
+
   // Returns the current AcapController (if it has been activated on this
   // thread. Returns nullptr if none (not active on the current thread).
   static std::shared_ptr<AcapController> getCurrentThreadAcapController();
@@ -105,7 +121,12 @@ private:
   MlirValue mapIValueToMlirValue(MlirLocation loc, const c10::IValue &ival);
   MlirType mapIValueToMlirType(MlirLocation loc, const c10::IValue &ival);
   /// Imports a tensor by value (as a constant), remembering the association.
+  /// If `weightsDir` is set, the constant refers to a blob of the data
+  /// instead of holding it.
   MlirValue importTensorByValue(at::Tensor tensor);
+  /// Imports a tensor that was not produced within the capture, either as a
+  /// lifted parameter (if `liftParameters`) or by value.
+  MlirValue importExternalTensor(at::Tensor tensor);
   void verifyHasNotReturned();
   struct Activation {
     Activation(std::shared_ptr<AcapController> controller)
@@ -122,6 +143,10 @@ private:
 
   TypeMapper &typeMapper;
   std::unique_ptr<FuncBuilder> funcBuilder;
+  std::string weightsDir;
+  bool liftParameters;
+  std::vector<at::Tensor> liftedParameters;
+  std::vector<int64_t> liftedParameterVersions;
   bool hasReturned = false;
 };
 
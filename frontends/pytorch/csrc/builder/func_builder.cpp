@@ -19,25 +19,33 @@ using namespace torch_mlir;
 KernelCallBuilder::KernelCallBuilder(MlirContext context, MlirLocation loc,
                                      const std::string &kernelName,
                                      const c10::FunctionSchema &schema)
-    : context(context), loc(loc), state("torch.kernel_call", loc),
-      schema(schema) {
+    : KernelCallBuilder(context, loc,
+                        getAttributes(context, kernelName, schema)) {}
+
+KernelCallBuilder::KernelCallBuilder(
+    MlirContext context, MlirLocation loc,
+    const std::vector<MlirNamedAttribute> &attributes)
+    : context(context), loc(loc), state("torch.kernel_call", loc) {
   (void)this->context; // Preserve for future.
-  MlirNamedAttribute kernelNameAttr = toMlirNamedAttribute(
-      "kernelName",
-      mlirStringAttrGet(
-          context, mlirStringRefCreate(kernelName.data(), kernelName.size())));
-  mlirOperationStateAddAttributes(state, 1, &kernelNameAttr);
-  addSchemaAttrs();
+  mlirOperationStateAddAttributes(state, attributes.size(), attributes.data());
 }
 
-void KernelCallBuilder::addSchemaAttrs() {
+std::vector<MlirNamedAttribute>
+KernelCallBuilder::getAttributes(MlirContext context,
+                                 const std::string &kernelName,
+                                 const c10::FunctionSchema &schema) {
   // Map the op schema to the kernel_call attributes:
+  //   kernelName
   //   sigArgTypes
   //   sigRetTypes
   //   sigIsVararg
   //   sigIsVarret
   //   sigIsMutable
   std::vector<MlirNamedAttribute> attrs;
+  attrs.push_back(toMlirNamedAttribute(
+      "kernelName",
+      mlirStringAttrGet(
+          context, mlirStringRefCreate(kernelName.data(), kernelName.size()))));
   attrs.push_back(toMlirNamedAttribute(
       "sigIsMutable", mlirBoolAttrGet(context, schema.is_mutable())));
   attrs.push_back(toMlirNamedAttribute(
@@ -65,9 +73,7 @@ void KernelCallBuilder::addSchemaAttrs() {
   attrs.push_back(toMlirNamedAttribute(
       "sigRetTypes",
       mlirArrayAttrGet(context, returns.size(), returns.data())));
-
-  // Add attrs to op.
-  mlirOperationStateAddAttributes(state, attrs.size(), attrs.data());
+  return attrs;
 }
 
 void KernelCallBuilder::addOperand(MlirValue operand) {
@@ -142,6 +148,33 @@ void FuncBuilder::rewriteFuncReturnTypes(std::vector<MlirType> &resultTypes) {
   (void)newFuncTypeAttr;
 }
 
+MlirValue FuncBuilder::appendArgument(MlirType type) {
+  MlirAttribute funcTypeAttr =
+      mlirOperationGetAttributeByName(funcOp, toMlirStringRef("type"));
+  assert(!mlirAttributeIsNull(funcTypeAttr) &&
+         "function missing 'type' attribute");
+  assert(mlirAttributeIsAType(funcTypeAttr) &&
+         "function type is not a TypeAttr");
+  MlirType funcType = mlirTypeAttrGetValue(funcTypeAttr);
+  std::vector<MlirType> inputTypes;
+  for (intptr_t i = 0, e = mlirFunctionTypeGetNumInputs(funcType); i < e; ++i) {
+    inputTypes.push_back(mlirFunctionTypeGetInput(funcType, i));
+  }
+  inputTypes.push_back(type);
+  std::vector<MlirType> resultTypes;
+  for (intptr_t i = 0, e = mlirFunctionTypeGetNumResults(funcType); i < e;
+       ++i) {
+    resultTypes.push_back(mlirFunctionTypeGetResult(funcType, i));
+  }
+
+  MlirType newFuncType =
+      mlirFunctionTypeGet(context, inputTypes.size(), inputTypes.data(),
+                          resultTypes.size(), resultTypes.data());
+  mlirOperationSetAttributeByName(funcOp, toMlirStringRef("type"),
+                                  mlirTypeAttrGet(newFuncType));
+  return mlirBlockAddArgument(entryBlock.getBlock(), type);
+}
+
 MlirValue FuncBuilder::insertConstantOp(MlirOperation op) {
   mlirBlockInsertOwnedOperationAfter(entryBlock.getBlock(), prevConstantOp, op);
   prevConstantOp = op;
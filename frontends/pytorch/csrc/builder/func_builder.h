@@ -75,6 +75,17 @@ public:
   KernelCallBuilder(MlirContext context, MlirLocation loc,
                     const std::string &kernelName,
                     const c10::FunctionSchema &schema);
+  /// Creates a builder from attributes previously computed by getAttributes.
+  /// Importers that emit many calls to the same kernel use this to avoid
+  /// rebuilding the signature attributes for each call.
+  KernelCallBuilder(MlirContext context, MlirLocation loc,
+                    const std::vector<MlirNamedAttribute> &attributes);
+
+  /// Gets the attributes of a kernel_call op for the given kernel.
+  static std::vector<MlirNamedAttribute>
+  getAttributes(MlirContext context, const std::string &kernelName,
+                const c10::FunctionSchema &schema);
+
   void addOperand(MlirValue operand);
   void addResultType(MlirType resultType);
   MlirOperation create();
@@ -84,9 +95,7 @@ protected:
   MlirLocation loc;
 
 private:
-  void addSchemaAttrs();
   OperationStateHolder state;
-  const c10::FunctionSchema &schema;
 };
 
 /// Wraps a 'func' MlirOperation and provides facilities for constructing
@@ -114,6 +123,10 @@ public:
   /// assumed that a compatible terminator has been added.
   void rewriteFuncReturnTypes(std::vector<MlirType> &resultTypes);
 
+  /// Appends an argument of the given type to the entry block and the
+  /// function's signature, returning the new block argument.
+  MlirValue appendArgument(MlirType type);
+
   /// Maps a live Tensor to an MlirValue.
   void mapTensor(at::Tensor tensor, MlirValue value) {
     tensorValueMap.push_back(std::make_pair(tensor, value));
@@ -91,13 +91,15 @@ namespace {
 /// correctly modeling the many ways that tensors can overlap and alias when
 /// they share storage is difficult. Example hard cases are weird
 /// strides/offsets that overlap, and even cases where the data types mismatch
-/// (PyTorch allows this!).
+/// (PyTorch allows this!). Importing such tensors as views of one storage
+/// would not get far either: torch-globalize-object-graph rejects slots whose
+/// initial values may alias, and general strided views have no lowering.
 class IValueImporter {
 public:
   IValueImporter(MlirBlock importBlock, MlirContext context,
-                 ClassAnnotator &annotator)
+                 ClassAnnotator &annotator, const std::string &weightsDir)
       : importBlock(importBlock), context(context), typeMapper(context),
-        annotator(annotator) {}
+        annotator(annotator), weightsDir(weightsDir) {}
 
   MlirValue importIValue(c10::IValue value);
 
@@ -113,6 +115,9 @@ private:
   MlirContext context;
   TypeMapper typeMapper;
   ClassAnnotator &annotator;
+  // If not empty, tensors are imported by reference to blobs in this
+  // directory.
+  std::string weightsDir;
 
   // Map tracking already-imported values.
   std::unordered_map<c10::IValue, MlirValue, IValueHasher, IValueEq> valueMap;
@@ -279,8 +284,12 @@ MlirValue IValueImporter::rawImportIValue(c10::IValue ivalue) {
     return mlirOperationGetResult(operation, 0);
   }
   if (ivalue.isTensor()) {
-    at::Tensor tensor = ivalue.toTensor().contiguous();
-    MlirAttribute denseElements = converTensorToMlirElementsAttr(tensor, loc);
+    // The attribute conversion makes the tensor contiguous if needed.
+    at::Tensor tensor = ivalue.toTensor();
+    MlirAttribute denseElements =
+        weightsDir.empty()
+            ? converTensorToMlirElementsAttr(tensor, loc)
+            : convertTensorToMlirExternalElementsAttr(tensor, loc, weightsDir);
     MlirOperation constant = createMlirOperationAtEnd(
         importBlock, "std.constant", loc, mlirAttributeGetType(denseElements),
         toMlirNamedAttribute("value", denseElements));
@@ -422,10 +431,11 @@ void IValueImporter::importCompilationUnit(torch::jit::CompilationUnit *cu) {
 }
 
 void torch_mlir::importIValue(c10::IValue ivalue, MlirBlock block,
-                              MlirContext context, ClassAnnotator &annotator) {
+                              MlirContext context, ClassAnnotator &annotator,
+                              const std::string &weightsDir) {
   // When debugging module importing, it can be useful to dump as so:
   // if (ivalue.isModule())
   //   ivalue.toModule().dump(true, false, false);
-  IValueImporter importer(block, context, annotator);
+  IValueImporter importer(block, context, annotator, weightsDir);
   importer.importIValue(ivalue);
 }
@@ -9,6 +9,7 @@
 #define NPCOMP_FRONTENDS_PYTORCH_CSRC_IVALUE_IMPORTER_H
 
 #include <memory>
+#include <string>
 
 #include "../pybind.h"
 #include "func_builder.h"
@@ -24,8 +25,11 @@ namespace torch_mlir {
 
 /// Main entry-point for importing torch IValue's .
 /// Recursively imports `ivalue`, inserting operations at the end of `block`.
+/// If `weightsDir` is not empty, tensors are written to it and imported by
+/// reference (see convertTensorToMlirExternalElementsAttr).
 void importIValue(c10::IValue ivalue, MlirBlock block, MlirContext context,
-                  ClassAnnotator &annotator);
+                  ClassAnnotator &annotator,
+                  const std::string &weightsDir = std::string());
 
 } // namespace torch_mlir
 
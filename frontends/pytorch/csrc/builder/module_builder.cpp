@@ -83,12 +83,14 @@ static void registerPythonSysStderrDiagnosticHandler(MlirContext context) {
   (void)id;
 }
 
-ModuleBuilder::ModuleBuilder(pybind11::object contextObj)
+ModuleBuilder::ModuleBuilder(pybind11::object contextObj,
+                             std::string weightsDir)
     : contextObj(createPythonContextIfNone(std::move(contextObj))),
       context(castPythonObjectToMlirContext(this->contextObj)),
       module(createEmptyModule(this->context)),
       moduleObj(castMlirModuleToPythonObject(module)),
-      unknownLoc(mlirLocationUnknownGet(context)), typeMapper(this->context) {
+      unknownLoc(mlirLocationUnknownGet(context)),
+      weightsDir(std::move(weightsDir)), typeMapper(this->context) {
   // TODO: Rework this once dialect registration C-APIs are in place.
   // https://reviews.llvm.org/D88162
   mlirRegisterAllDialects(context);
@@ -98,11 +100,18 @@ ModuleBuilder::ModuleBuilder(pybind11::object contextObj)
 
   // Terminator will always be the first op of an empty module.
   terminator = mlirBlockGetFirstOperation(getBodyBlock());
+
+  if (!this->weightsDir.empty()) {
+    using namespace pybind11::literals;
+    py::module::import("os").attr("makedirs")(this->weightsDir,
+                                              "exist_ok"_a = true);
+  }
 }
 
 std::shared_ptr<AcapController>
 ModuleBuilder::startCaptureFunction(std::string &name,
-                                    std::vector<at::Tensor> args) {
+                                    std::vector<at::Tensor> args,
+                                    bool liftParameters) {
   // TODO: Verify that arguments do not alias each other.
   std::vector<MlirType> inputTypes;
   for (auto &arg : args) {
@@ -121,7 +130,8 @@ ModuleBuilder::startCaptureFunction(std::string &name,
   for (size_t i = 0; i < args.size(); ++i) {
     funcBuilder->mapTensor(args[i], mlirBlockGetArgument(entryBlock, i));
   }
-  return std::make_shared<AcapController>(typeMapper, std::move(funcBuilder));
+  return std::make_shared<AcapController>(typeMapper, std::move(funcBuilder),
+                                          weightsDir, liftParameters);
 }
 
 torch::jit::StrongFunctionPtr
@@ -141,7 +151,7 @@ void ModuleBuilder::importModule(torch::jit::Module jitModule,
     classAnnotator = py::cast<ClassAnnotator *>(maybeClassAnnotator);
   }
   importIValue(jitModule._ivalue(), mlirModuleGetBody(module),
-               mlirModuleGetContext(module), *classAnnotator);
+               mlirModuleGetContext(module), *classAnnotator, weightsDir);
 }
 
 FuncBuilder::Inserter ModuleBuilder::createInserter() {
@@ -159,11 +169,13 @@ MlirBlock ModuleBuilder::getBodyBlock() {
 
 void ModuleBuilder::bind(py::module &m) {
   py::class_<ModuleBuilder>(m, "ModuleBuilder")
-      .def(py::init<py::object>(), py::arg("context") = py::none())
+      .def(py::init<py::object, std::string>(), py::arg("context") = py::none(),
+           py::arg("weights_dir") = "")
       .def_property_readonly("context", &ModuleBuilder::getContextObj)
       .def_property_readonly("module", &ModuleBuilder::getModuleObj)
       .def("capture_function", &ModuleBuilder::startCaptureFunction,
-           py::keep_alive<0, 1>())
+           py::arg("name"), py::arg("args"),
+           py::arg("lift_parameters") = false, py::keep_alive<0, 1>())
       .def("import_function", &ModuleBuilder::importFunction)
       .def("import_module", &ModuleBuilder::importModule, py::arg("module"),
            py::arg("classAnnotator") = py::none());
@@ -26,7 +26,9 @@ namespace torch_mlir {
 /// of PyTorch programs/execution.
 class ModuleBuilder {
 public:
-  ModuleBuilder(pybind11::object contextObj);
+  /// If `weightsDir` is not empty, tensors are imported by reference to blobs
+  /// written to that directory instead of by value.
+  ModuleBuilder(pybind11::object contextObj, std::string weightsDir);
 
   /// Creates Python bindings for the class.
   static void bind(pybind11::module &m);
@@ -35,8 +37,12 @@ public:
   pybind11::object getModuleObj() { return moduleObj; }
 
   // Starts a device-capture based function.
+  // If `liftParameters`, tensors used by the capture that are neither
+  // arguments nor produced within it are appended as extra arguments instead
+  // of being embedded as constants (see AcapController::getLiftedParameters).
   std::shared_ptr<AcapController>
-  startCaptureFunction(std::string &name, std::vector<at::Tensor> args);
+  startCaptureFunction(std::string &name, std::vector<at::Tensor> args,
+                       bool liftParameters);
 
   // Imports a traced function. Note that the python type
   // torch.jit.ScriptFunction is the C++ type torch::jit::StrongFunctionPtr.
@@ -64,6 +70,7 @@ private:
   pybind11::object moduleObj;
   MlirOperation terminator;
   MlirLocation unknownLoc;
+  std::string weightsDir;
 
   TypeMapper typeMapper;
 };
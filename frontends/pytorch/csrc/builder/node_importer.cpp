@@ -7,6 +7,7 @@
 
 #include "node_importer.h"
 
+#include <algorithm>
 #include <unordered_map>
 
 #include "mlir_utils.h"
@@ -27,7 +28,7 @@ using Node = torch::jit::Node;
 namespace {
 class NodeImporter {
 public:
-  NodeImporter(MlirContext context) : context(context) {}
+  NodeImporter(MlirContext context) : context(context), typeMapper(context) {}
 
   void importNode(Node *node, MlirBlock appendToBlock);
   MlirBlock importBlock(Block *jitBlock, CreateTerminatorFn createTerminator);
@@ -42,13 +43,30 @@ private:
   MlirValue lookupMappedValue(Value *jitValue);
   std::vector<MlirValue> lookupMappedValues(c10::ArrayRef<Value *> values);
 
+  /// Like TypeMapper::mapFromTorchType, but memoized. Graphs reuse a small
+  /// number of types across many values.
+  MlirType mapType(MlirLocation loc, const c10::TypePtr &torchType);
+  /// Like getMlirTypesFromValues, but through the memoized mapType.
+  std::vector<MlirType> mapTypes(MlirLocation loc,
+                                 c10::ArrayRef<Value *> values);
+  /// Gets the kernel_call attributes for the kernel invoked by `node`,
+  /// building them only on the first call to each schema.
+  const std::vector<MlirNamedAttribute> &getKernelCallAttributes(Node *node);
+
   MlirContext context;
-  std::unordered_map<Value *, MlirValue> valueMap;
+  TypeMapper typeMapper;
+  /// Mapped values, indexed by Value::unique(). All values imported by one
+  /// NodeImporter belong to the same graph, so these are dense.
+  std::vector<MlirValue> valueMap;
+  /// The TypePtr is held to keep the key alive.
+  std::unordered_map<c10::Type *, std::pair<c10::TypePtr, MlirType>> typeCache;
+  std::unordered_map<const c10::FunctionSchema *,
+                     std::vector<MlirNamedAttribute>>
+      kernelCallAttributes;
 };
 } // namespace
 
 void NodeImporter::importPrimNode(Node *node, MlirBlock appendToBlock) {
-  TypeMapper typeMapper(context);
   MlirLocation loc = getMlirLocationFromNode(context, node);
   auto kind = node->kind();
   if (kind == c10::prim::Constant) {
@@ -85,7 +103,7 @@ void NodeImporter::importPrimNode(Node *node, MlirBlock appendToBlock) {
 
   if (kind == c10::prim::GetAttr) {
     MlirType resultType =
-        typeMapper.mapFromTorchType(loc, node->output()->type());
+        mapType(loc, node->output()->type());
     MlirOperation operation = createMlirOperationAtEnd(
         appendToBlock, "torch.prim.GetAttr", loc, resultType,
         lookupMappedValues(node->inputs()),
@@ -106,7 +124,7 @@ void NodeImporter::importPrimNode(Node *node, MlirBlock appendToBlock) {
 
   if (kind == c10::prim::CallMethod) {
     MlirType resultType =
-        typeMapper.mapFromTorchType(loc, node->output()->type());
+        mapType(loc, node->output()->type());
     MlirOperation operation = createMlirOperationAtEnd(
         appendToBlock, "torch.prim.CallMethod", loc, resultType,
         lookupMappedValues(node->inputs()),
@@ -142,7 +160,7 @@ void NodeImporter::importPrimNode(Node *node, MlirBlock appendToBlock) {
 
   if (kind == c10::prim::Loop) {
     std::vector<MlirType> resultTypes =
-        getMlirTypesFromValues(loc, node->outputs());
+        mapTypes(loc, node->outputs());
     MlirOperation operation = createMlirOperationAtEnd(
         appendToBlock, "torch.prim.Loop", loc, resultTypes,
         lookupMappedValues(node->inputs().slice(0, 2)),
@@ -173,7 +191,7 @@ void NodeImporter::importPrimNode(Node *node, MlirBlock appendToBlock) {
         appendToBlock, "basicpy.bool_cast", loc, mlirIntegerTypeGet(context, 1),
         lookupMappedValue(node->input()));
     std::vector<MlirType> resultTypes =
-        getMlirTypesFromValues(loc, node->outputs());
+        mapTypes(loc, node->outputs());
     MlirOperation operation = createMlirOperationAtEnd(
         appendToBlock, "scf.if", loc, mlirOperationGetResult(pred, 0),
         resultTypes, mlirRegionCreate(), mlirRegionCreate());
@@ -196,7 +214,7 @@ void NodeImporter::importPrimNode(Node *node, MlirBlock appendToBlock) {
   if (kind == c10::prim::NumToTensor) {
     MlirOperation operation =
         createMlirOperationAtEnd(appendToBlock, "torch.prim.NumToTensor", loc,
-                                 getMlirTypesFromValues(loc, node->outputs()),
+                                 mapTypes(loc, node->outputs()),
                                  lookupMappedValues(node->inputs()));
     mapResults(node, operation);
     return;
@@ -207,11 +225,11 @@ void NodeImporter::importPrimNode(Node *node, MlirBlock appendToBlock) {
     torch::jit::Block *calleeEntryBlock =
         functionType->function()->graph()->block();
     auto expectedTypes = c10::fmap(calleeEntryBlock->inputs(), [&](Value *v) {
-      return typeMapper.mapFromTorchType(loc, v->type());
+      return mapType(loc, v->type());
     });
     MlirOperation operation = createMlirOperationAtEnd(
         appendToBlock, "std.call_indirect", loc,
-        getMlirTypesFromValues(loc, node->outputs()),
+        mapTypes(loc, node->outputs()),
         lookupMappedValue(node->input(0)),
         derefineValues(lookupMappedValues(node->inputs().slice(1)),
                        expectedTypes, loc, appendToBlock));
@@ -222,7 +240,7 @@ void NodeImporter::importPrimNode(Node *node, MlirBlock appendToBlock) {
   if (kind == c10::prim::RaiseException) {
     MlirOperation operation = createMlirOperationAtEnd(
         appendToBlock, "torch.prim.RaiseException", loc,
-        getMlirTypesFromValues(loc, node->outputs()),
+        mapTypes(loc, node->outputs()),
         lookupMappedValues(node->inputs()));
     mapResults(node, operation);
     return;
@@ -231,7 +249,7 @@ void NodeImporter::importPrimNode(Node *node, MlirBlock appendToBlock) {
   if (kind == c10::prim::Uninitialized) {
     MlirOperation operation =
         createMlirOperationAtEnd(appendToBlock, "torch.prim.Uninitialized", loc,
-                                 getMlirTypesFromValues(loc, node->outputs()),
+                                 mapTypes(loc, node->outputs()),
                                  lookupMappedValues(node->inputs()));
     mapResults(node, operation);
     return;
@@ -240,7 +258,7 @@ void NodeImporter::importPrimNode(Node *node, MlirBlock appendToBlock) {
   if (kind == c10::prim::unchecked_cast) {
     MlirOperation operation = createMlirOperationAtEnd(
         appendToBlock, "torch.prim.unchecked_cast", loc,
-        getMlirTypesFromValues(loc, node->outputs()),
+        mapTypes(loc, node->outputs()),
         lookupMappedValues(node->inputs()));
     mapResults(node, operation);
     return;
@@ -249,7 +267,7 @@ void NodeImporter::importPrimNode(Node *node, MlirBlock appendToBlock) {
   if (kind == c10::prim::TupleUnpack) {
     MlirOperation operation =
         createMlirOperationAtEnd(appendToBlock, "torch.prim.TupleUnpack", loc,
-                                 getMlirTypesFromValues(loc, node->outputs()),
+                                 mapTypes(loc, node->outputs()),
                                  lookupMappedValues(node->inputs()));
     mapResults(node, operation);
     return;
@@ -258,7 +276,7 @@ void NodeImporter::importPrimNode(Node *node, MlirBlock appendToBlock) {
   if (kind == c10::prim::TupleIndex) {
     MlirOperation operation =
         createMlirOperationAtEnd(appendToBlock, "torch.prim.TupleIndex", loc,
-                                 getMlirTypesFromValues(loc, node->outputs()),
+                                 mapTypes(loc, node->outputs()),
                                  lookupMappedValues(node->inputs()));
     mapResults(node, operation);
     return;
@@ -267,7 +285,7 @@ void NodeImporter::importPrimNode(Node *node, MlirBlock appendToBlock) {
   if (kind == c10::prim::ListUnpack) {
     MlirOperation operation =
         createMlirOperationAtEnd(appendToBlock, "torch.prim.ListUnpack", loc,
-                                 getMlirTypesFromValues(loc, node->outputs()),
+                                 mapTypes(loc, node->outputs()),
                                  lookupMappedValues(node->inputs()));
     mapResults(node, operation);
     return;
@@ -284,14 +302,12 @@ void NodeImporter::importPrimNode(Node *node, MlirBlock appendToBlock) {
 }
 
 void NodeImporter::importKernelCall(Node *node, MlirBlock appendToBlock) {
-  TypeMapper typeMapper(context);
   MlirLocation loc = getMlirLocationFromNode(context, node);
-  KernelCallBuilder kcb(context, loc, node->kind().toQualString(),
-                        node->schema());
+  KernelCallBuilder kcb(context, loc, getKernelCallAttributes(node));
   for (MlirValue value : lookupMappedValues(node->inputs())) {
     kcb.addOperand(value);
   }
-  for (MlirType type : getMlirTypesFromValues(loc, node->outputs())) {
+  for (MlirType type : mapTypes(loc, node->outputs())) {
     kcb.addResultType(type);
   }
   MlirOperation op = kcb.create();
@@ -333,7 +349,7 @@ MlirBlock NodeImporter::createBlockFor(Block *jitBlock) {
   Node *paramNode = jitBlock->param_node();
   MlirLocation loc = getMlirLocationFromNode(context, paramNode);
   std::vector<MlirType> blockArgTypes =
-      getMlirTypesFromValues(loc, paramNode->outputs());
+      mapTypes(loc, paramNode->outputs());
   MlirBlock block = mlirBlockCreate(blockArgTypes.size(), blockArgTypes.data());
   for (int i = 0, e = mlirBlockGetNumArguments(block); i < e; i++) {
     Value *jitValue = paramNode->outputs()[i];
@@ -344,10 +360,12 @@ MlirBlock NodeImporter::createBlockFor(Block *jitBlock) {
 }
 
 void NodeImporter::mapValue(Value *jitValue, MlirValue value) {
-  auto it = valueMap.find(jitValue);
-  (void)it;
-  assert(it == valueMap.end() && "jitValue has already been mapped");
-  valueMap[jitValue] = value;
+  size_t index = jitValue->unique();
+  if (index >= valueMap.size())
+    valueMap.resize(std::max(index + 1, 2 * valueMap.size()), {nullptr});
+  assert(mlirValueIsNull(valueMap[index]) &&
+         "jitValue has already been mapped");
+  valueMap[index] = value;
 }
 void NodeImporter::mapResults(Node *node, MlirOperation operation) {
   assert(node->outputs().size() ==
@@ -357,20 +375,57 @@ void NodeImporter::mapResults(Node *node, MlirOperation operation) {
   }
 }
 MlirValue NodeImporter::lookupMappedValue(Value *jitValue) {
-  auto it = valueMap.find(jitValue);
-  assert(it != valueMap.end() &&
+  size_t index = jitValue->unique();
+  assert(index < valueMap.size() && !mlirValueIsNull(valueMap[index]) &&
          "trying to get mapping for jitValue that is not mapped yet!");
-  return it->second;
+  return valueMap[index];
 }
 std::vector<MlirValue>
 NodeImporter::lookupMappedValues(c10::ArrayRef<Value *> values) {
   std::vector<MlirValue> ret;
+  ret.reserve(values.size());
   for (Value *value : values) {
     ret.push_back(lookupMappedValue(value));
   }
   return ret;
 }
 
+MlirType NodeImporter::mapType(MlirLocation loc,
+                              const c10::TypePtr &torchType) {
+  auto it = typeCache.find(torchType.get());
+  if (it != typeCache.end())
+    return it->second.second;
+  MlirType type = typeMapper.mapFromTorchType(loc, torchType);
+  // Failures emit a diagnostic at `loc`, so they are not cached.
+  if (!mlirTypeIsNull(type))
+    typeCache.emplace(torchType.get(), std::make_pair(torchType, type));
+  return type;
+}
+std::vector<MlirType> NodeImporter::mapTypes(MlirLocation loc,
+                                             c10::ArrayRef<Value *> values) {
+  std::vector<MlirType> ret;
+  ret.reserve(values.size());
+  for (Value *value : values) {
+    MlirType t = mapType(loc, value->type());
+    if (mlirTypeIsNull(t))
+      throw mlir_diagnostic_emitted("unsupported type");
+    ret.push_back(t);
+  }
+  return ret;
+}
+
+const std::vector<MlirNamedAttribute> &
+NodeImporter::getKernelCallAttributes(Node *node) {
+  const c10::FunctionSchema &schema = node->schema();
+  auto it = kernelCallAttributes.find(&schema);
+  if (it != kernelCallAttributes.end())
+    return it->second;
+  return kernelCallAttributes
+      .emplace(&schema, KernelCallBuilder::getAttributes(
+                            context, node->kind().toQualString(), schema))
+      .first->second;
+}
+
 MlirBlock torch_mlir::importBlock(MlirContext context, Block *jitBlock,
                                   CreateTerminatorFn createTerminator) {
   NodeImporter importer(context);
@@ -136,7 +136,11 @@ void torch_mlir::InitBuilderBindings(py::module &m) {
                                                               "AcapController")
       .def("__enter__", &AcapController::contextEnter)
       .def("__exit__", &AcapController::contextExit)
-      .def("returns", &AcapController::returns);
+      .def("returns", &AcapController::returns)
+      .def_property_readonly("lifted_parameters",
+                             &AcapController::getLiftedParameters)
+      .def_property_readonly("lifted_parameter_versions",
+                             &AcapController::getLiftedParameterVersions);
   m.def("get_registered_ops", &GetRegisteredOps, kGetRegisteredOpsDocstring);
 
   ModuleBuilder::bind(m);
@@ -8,13 +8,22 @@
 #include "function_importer.h"
 #include "ivalue_importer.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <unordered_map>
 
+#include <unistd.h>
+
 #include "mlir_utils.h"
 
 #include "mlir-c/BuiltinAttributes.h"
 #include "mlir-c/BuiltinTypes.h"
 #include "mlir-c/Diagnostics.h"
+#include "npcomp-c/Attributes.h"
 #include "npcomp-c/Types.h"
 
 using namespace torch_mlir;
@@ -189,19 +198,19 @@ torch_mlir::getFunctionTypeFromSchema(MlirContext context,
                              outputTypes.size(), outputTypes.data());
 }
 
-MlirAttribute torch_mlir::converTensorToMlirElementsAttr(at::Tensor tensor,
-                                                         MlirLocation loc) {
+static void throwUnsupportedTensorError(const at::Tensor &tensor) {
+  std::stringstream msg;
+  msg << "Unsupported import tensor type: " << tensor;
+  throw std::invalid_argument(msg.str());
+}
+
+// Makes `tensor` C-contiguous, as its data is bulk-loaded in that form, and
+// returns the ShapedType it is imported as.
+static MlirType prepareTensorForImport(at::Tensor &tensor, MlirLocation loc) {
   MlirContext context = mlirLocationGetContext(loc);
   TypeMapper typeMapper(context);
   using at::ScalarType;
 
-  auto throwUnsupportedTensorError = [&]() {
-    std::stringstream msg;
-    msg << "Unsupported import tensor type: " << tensor;
-    throw std::invalid_argument(msg.str());
-  };
-
-  // Get a C-contiguous form as we can bulk-load that into a DenseElementsAttr.
   if (!tensor.is_contiguous())
     tensor = tensor.contiguous();
 
@@ -224,8 +233,15 @@ MlirAttribute torch_mlir::converTensorToMlirElementsAttr(at::Tensor tensor,
   MlirType shapedType = mlirRankedTensorTypeGetChecked(
       shape.size(), shape.data(), elementType, loc);
   if (mlirTypeIsNull(shapedType)) {
-    throwUnsupportedTensorError();
+    throwUnsupportedTensorError(tensor);
   }
+  return shapedType;
+}
+
+MlirAttribute torch_mlir::converTensorToMlirElementsAttr(at::Tensor tensor,
+                                                         MlirLocation loc) {
+  using at::ScalarType;
+  MlirType shapedType = prepareTensorForImport(tensor, loc);
 
   // Import DenseElementsAttr data.
   // TODO: Support bool tensors.
@@ -257,11 +273,103 @@ MlirAttribute torch_mlir::converTensorToMlirElementsAttr(at::Tensor tensor,
                                         static_cast<const int *>(tensorData));
     break;
   default:
-    throwUnsupportedTensorError();
+    throwUnsupportedTensorError(tensor);
   }
   return {nullptr}; // Unreachable.
 }
 
+// A 64-bit FNV-1a variant that consumes 8 bytes at a time, with an xorshift
+// after each step so that the high bits of a word reach the low bits of the
+// hash. Weights are large enough for byte-wise hashing to be noticeable.
+static uint64_t hashTensorData(const char *data, size_t size) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  const uint64_t prime = 0x100000001b3ULL;
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+    uint64_t word;
+    std::memcpy(&word, data + i, sizeof(word));
+    hash = (hash ^ word) * prime;
+    hash ^= hash >> 29;
+  }
+  for (; i < size; i++)
+    hash = (hash ^ static_cast<unsigned char>(data[i])) * prime;
+  return hash;
+}
+
+// Whether the file at `path` holds exactly `size` bytes of `data`.
+static bool fileHasContents(const std::string &path, const char *data,
+                            size_t size) {
+  std::ifstream in(path, std::ios::binary | std::ios::ate);
+  if (!in || static_cast<size_t>(in.tellg()) != size)
+    return false;
+  in.seekg(0);
+  char chunk[1 << 16];
+  for (size_t offset = 0; offset < size;) {
+    size_t chunkSize = std::min(sizeof(chunk), size - offset);
+    if (!in.read(chunk, chunkSize) ||
+        std::memcmp(chunk, data + offset, chunkSize) != 0)
+      return false;
+    offset += chunkSize;
+  }
+  return true;
+}
+
+static std::string getBlobPath(const std::string &dir, uint64_t key) {
+  char name[sizeof("0123456789ABCDEF.bin")];
+  std::snprintf(name, sizeof(name), "%016" PRIX64 ".bin", key);
+  return dir + "/" + name;
+}
+
+static void writeBlob(const std::string &path, const char *data, size_t size) {
+  // Write to a temporary file first so that an interrupted import never
+  // leaves a truncated blob under the final name. Its name is unique to this
+  // write, so that importers running concurrently, in this process or in
+  // others, never write to the same temporary file.
+  static std::atomic<uint64_t> tmpCounter(0);
+  std::string tmpPath = path + "." + std::to_string(getpid()) + "." +
+                        std::to_string(tmpCounter++) + ".tmp";
+  std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+  out.write(data, size);
+  out.close();
+  if (!out || std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+    std::remove(tmpPath.c_str());
+    std::stringstream msg;
+    msg << "could not write weight blob '" << path << "'";
+    throw std::runtime_error(msg.str());
+  }
+}
+
+MlirAttribute
+torch_mlir::convertTensorToMlirExternalElementsAttr(at::Tensor tensor,
+                                                    MlirLocation loc,
+                                                    const std::string &dir) {
+  MlirType shapedType = prepareTensorForImport(tensor, loc);
+  if (tensor.scalar_type() == at::ScalarType::Bool) {
+    // Bool tensors are stored as bytes but imported as i1; see
+    // converTensorToMlirElementsAttr.
+    throwUnsupportedTensorError(tensor);
+  }
+
+  const char *data = static_cast<const char *>(tensor.data_ptr());
+  size_t size = tensor.nbytes();
+
+  // Blobs are named by a hash of their contents, so an existing blob with the
+  // same contents is reused, e.g. when the same weights are imported again.
+  // A 64-bit hash can collide, so a blob is only reused after comparing its
+  // contents; on a mismatch, the next key is tried.
+  uint64_t key = hashTensorData(data, size);
+  for (;; key++) {
+    std::string path = getBlobPath(dir, key);
+    if (!std::ifstream(path)) {
+      writeBlob(path, data, size);
+      break;
+    }
+    if (fileHasContents(path, data, size))
+      break;
+  }
+  return npcompExternalElementsAttrGet(shapedType, key);
+}
+
 MlirAttribute torch_mlir::importAttribute(MlirLocation loc,
                                           torch::jit::Node *node,
                                           c10::Symbol symbol) {
@@ -62,6 +62,14 @@ MlirType getFunctionTypeFromSchema(MlirContext context,
 MlirAttribute converTensorToMlirElementsAttr(at::Tensor tensor,
                                              MlirLocation loc);
 
+/// Writes the data of `tensor` to directory `dir`, in a blob named by its
+/// content hash unless one is already there, and creates an MlirAttribute that
+/// refers to it. Unlike converTensorToMlirElementsAttr, the data is never
+/// copied into the context.
+MlirAttribute convertTensorToMlirExternalElementsAttr(at::Tensor tensor,
+                                                      MlirLocation loc,
+                                                      const std::string &dir);
+
 MlirAttribute importAttribute(MlirLocation loc, torch::jit::Node *node,
                               c10::Symbol symbol);
 
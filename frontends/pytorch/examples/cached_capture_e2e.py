@@ -0,0 +1,36 @@
+# -*- Python -*-
+# This file is licensed under a pytorch-style license
+# See frontends/pytorch/LICENSE for license information.
+
+import torch
+
+from npcomp.compiler.pytorch.capture_cache import CaptureCache
+from npcomp.compiler.utils import logging
+
+import test_utils
+
+logging.enable()
+
+torch.manual_seed(0)
+weight = torch.rand(3, 4)
+
+cache = CaptureCache()
+
+
+@cache
+def mm(lhs):
+  return torch.mm(lhs, weight)
+
+
+lhs = torch.rand(2, 3)
+# First call captures and compiles; the rest hit the cache.
+test_utils.compare_outputs(lambda x: torch.mm(x, weight), mm, lhs)
+test_utils.compare_outputs(lambda x: torch.mm(x, weight), mm, lhs + 1)
+# Updates to the lifted weight are observed by the cached function.
+weight.mul_(2)
+test_utils.compare_outputs(lambda x: torch.mm(x, weight), mm, lhs - 1)
+assert (cache.misses, cache.hits) == (1, 2)
+
+# A new shape is a new entry.
+test_utils.compare_outputs(lambda x: torch.mm(x, weight), mm, torch.rand(5, 3))
+assert (cache.misses, cache.hits) == (2, 2)
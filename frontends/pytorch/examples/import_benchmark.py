@@ -0,0 +1,51 @@
+# -*- Python -*-
+# This file is licensed under a pytorch-style license
+# See frontends/pytorch/LICENSE for license information.
+
+# Measures the time to import a large TorchScript graph.
+#
+# Usage: python import_benchmark.py [num_statements] [repetitions]
+
+import sys
+import time
+
+import torch
+import torch_mlir
+
+
+def generate_source(num_statements):
+  """Generates a straight-line function with ~2 nodes per statement."""
+  lines = [
+      "def chain(x: torch.Tensor, y: torch.Tensor) -> torch.Tensor:",
+  ]
+  for i in range(num_statements):
+    if i % 2 == 0:
+      lines.append(f"  x = torch.add(x, y, alpha={i % 7 + 1})")
+    else:
+      lines.append(f"  x = torch.relu(torch.mul(x, y))")
+  lines.append("  return x")
+  return "\n".join(lines)
+
+
+def main():
+  num_statements = int(sys.argv[1]) if len(sys.argv) > 1 else 5000
+  repetitions = int(sys.argv[2]) if len(sys.argv) > 2 else 5
+
+  cu = torch.jit.CompilationUnit(generate_source(num_statements))
+  function = cu.chain
+  num_nodes = len(list(function.graph.nodes()))
+
+  timings = []
+  for _ in range(repetitions):
+    mb = torch_mlir.ModuleBuilder()
+    start = time.perf_counter()
+    mb.import_function(function)
+    timings.append(time.perf_counter() - start)
+
+  best = min(timings)
+  print(f"Imported {num_nodes} nodes: best {best * 1000:.1f} ms "
+        f"({best / num_nodes * 1e6:.2f} us/node) over {repetitions} runs")
+
+
+if __name__ == "__main__":
+  main()
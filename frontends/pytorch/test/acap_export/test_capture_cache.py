@@ -0,0 +1,96 @@
+# -*- Python -*-
+# This file is licensed under a pytorch-style license
+# See frontends/pytorch/LICENSE for license information.
+
+import torch
+
+from npcomp.compiler.pytorch.capture_cache import CaptureCache
+
+# RUN: %PYTHON %s | FileCheck %s
+
+torch.manual_seed(0)
+cache = CaptureCache()
+
+
+def make_mm(weight):
+
+  @cache
+  def mm(lhs):
+    return torch.mm(lhs, weight)
+
+  return mm
+
+
+def check(name, fn, lhs, weight):
+  result = fn(lhs)
+  ok = torch.allclose(result, torch.mm(lhs, weight))
+  print(name, "OK" if ok else "MISMATCH", cache.misses, cache.hits)
+
+
+lhs = torch.rand(2, 3)
+weight = torch.rand(3, 4)
+mm = make_mm(weight)
+
+# The first call captures; later calls with the same shapes hit, and see
+# in-place updates of the lifted weight.
+# CHECK: capture OK 1 0
+# CHECK: hit OK 1 1
+# CHECK: update OK 1 2
+check("capture", mm, lhs, weight)
+check("hit", mm, lhs + 1, weight)
+weight.mul_(2)
+check("update", mm, lhs, weight)
+
+# Tensors that require grad are passed without their autograd history.
+# CHECK: requires_grad OK 1 3
+check("requires_grad", mm, lhs.clone().requires_grad_(), weight)
+
+# Each closure instance gets its own entry, even once the previous instance
+# is gone and its cells could otherwise be reused.
+# CHECK: closure 0 OK 2 3
+# CHECK: closure 1 OK 3 3
+# CHECK: closure 2 OK 4 3
+del mm
+for i in range(3):
+  other_weight = torch.rand(3, 4)
+  check("closure {}".format(i), make_mm(other_weight), lhs, other_weight)
+
+# Bound methods of different receivers get their own entries.
+# CHECK: method 0 OK 5 3
+# CHECK: method 1 OK 6 3
+
+
+class Linear:
+
+  def __init__(self):
+    self.weight = torch.rand(3, 4)
+
+  def forward(self, lhs):
+    return torch.mm(lhs, self.weight)
+
+
+for i in range(2):
+  linear = Linear()
+  check("method {}".format(i), cache(linear.forward), lhs, linear.weight)
+
+# A function that updates a lifted parameter in place is not compiled, since
+# the compiled function would not apply the update. It runs eagerly on every
+# call, so the weight keeps changing.
+# CHECK: sgd 0 OK 7 3
+# CHECK: sgd 1 OK 8 3
+weight = torch.rand(3, 4)
+grad = torch.rand(3, 4)
+
+
+@cache
+def sgd_step(lhs):
+  weight.sub_(grad)
+  return torch.mm(lhs, weight)
+
+
+for i in range(2):
+  expected = weight - grad
+  result = sgd_step(lhs)
+  ok = torch.allclose(weight, expected) and torch.allclose(
+      result, torch.mm(lhs, expected))
+  print("sgd", i, "OK" if ok else "MISMATCH", cache.misses, cache.hits)
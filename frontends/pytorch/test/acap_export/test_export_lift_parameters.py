@@ -0,0 +1,33 @@
+# -*- Python -*-
+# This file is licensed under a pytorch-style license
+# See frontends/pytorch/LICENSE for license information.
+
+import torch
+import torch_mlir
+
+# RUN: %PYTHON %s | npcomp-opt | FileCheck %s
+
+x = torch.randn(2, 4)
+w0 = torch.randn(4, 3)
+w1 = torch.randn(3, 5)
+
+mb = torch_mlir.ModuleBuilder()
+with mb.capture_function("mlp", [x], lift_parameters=True) as f:
+  y = torch.mm(torch.mm(x, w0), w1)
+  f.returns([y])
+
+# w0 and w1 are not produced by the capture, so they are appended as
+# arguments (in first-use order) instead of being embedded as constants.
+params = f.lifted_parameters
+assert len(params) == 2
+assert params[0].data_ptr() == w0.data_ptr()
+assert params[1].data_ptr() == w1.data_ptr()
+
+# CHECK-LABEL: func @mlp(
+# CHECK-SAME:      %[[X:.*]]: !numpy.ndarray<[2,4]:f32>,
+# CHECK-SAME:      %[[W0:.*]]: !numpy.ndarray<[4,3]:f32>,
+# CHECK-SAME:      %[[W1:.*]]: !numpy.ndarray<[3,5]:f32>)
+# CHECK-NOT:     constant dense
+# CHECK:         %[[T0:.*]] = torch.kernel_call "aten::mm" %[[X]], %[[W0]]
+# CHECK:         torch.kernel_call "aten::mm" %[[T0]], %[[W1]]
+print(mb.module)
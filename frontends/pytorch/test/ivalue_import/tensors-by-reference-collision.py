@@ -0,0 +1,38 @@
+# -*- Python -*-
+# This file is licensed under a pytorch-style license
+# See frontends/pytorch/LICENSE for license information.
+
+import os
+import tempfile
+
+import torch
+import torch_mlir
+
+# RUN: %PYTHON %s | FileCheck %s
+
+weights_dir = tempfile.mkdtemp()
+mb = torch_mlir.ModuleBuilder(weights_dir=weights_dir)
+
+# A blob of the right size but other contents under the name that the hash of
+# the weight picks, as if another tensor's hash collided with it.
+with open(os.path.join(weights_dir, "90DC09162F9CFE2B.bin"), "wb") as f:
+    f.write(bytes(12))
+
+class TestModule(torch.nn.Module):
+    def __init__(self):
+        super().__init__()
+        self.p = torch.nn.Parameter(torch.arange(3.0))
+
+# The blob is not reused; the weight gets the next key instead.
+# CHECK:         constant opaque<"torch", "0x90DC09162F9CFE2C"> : tensor<3xf32>
+# CHECK:         90DC09162F9CFE2B.bin 12
+# CHECK-NEXT:    90DC09162F9CFE2C.bin 12
+# CHECK-NOT:     .bin
+
+
+test_module = TestModule()
+recursivescriptmodule = torch.jit.script(test_module)
+mb.import_module(recursivescriptmodule._c)
+mb.module.operation.print()
+for name in sorted(os.listdir(weights_dir)):
+    print(name, os.path.getsize(os.path.join(weights_dir, name)))
@@ -0,0 +1,47 @@
+# -*- Python -*-
+# This file is licensed under a pytorch-style license
+# See frontends/pytorch/LICENSE for license information.
+
+import os
+import tempfile
+
+import torch
+import torch_mlir
+
+# RUN: %PYTHON %s | FileCheck %s
+
+weights_dir = tempfile.mkdtemp()
+mb = torch_mlir.ModuleBuilder(weights_dir=weights_dir)
+
+class TestModule(torch.nn.Module):
+    def __init__(self):
+        super().__init__()
+        self.t = torch.ones(1)
+        self.p = torch.nn.Parameter(torch.arange(3.0))
+        # Same contents, so the same blob.
+        self.q = torch.nn.Parameter(torch.arange(3.0))
+
+# CHECK:         %[[CP:.*]] = constant opaque<"torch", "0x90DC09162F9CFE2B"> : tensor<3xf32>
+# CHECK:         %[[P:.*]] = numpy.create_array_from_tensor %[[CP]] : (tensor<3xf32>) -> !numpy.ndarray<*:!numpy.any_dtype>
+# CHECK:         %[[CQ:.*]] = constant opaque<"torch", "0x90DC09162F9CFE2B"> : tensor<3xf32>
+# CHECK:         %[[Q:.*]] = numpy.create_array_from_tensor %[[CQ]] : (tensor<3xf32>) -> !numpy.ndarray<*:!numpy.any_dtype>
+# CHECK:         %[[CT:.*]] = constant opaque<"torch", "0x4B72477F9C5C2F98"> : tensor<1xf32>
+# CHECK:         %[[T:.*]] = numpy.create_array_from_tensor %[[CT]] : (tensor<1xf32>) -> !numpy.ndarray<*:!numpy.any_dtype>
+# CHECK:         %[[ROOT:.*]] = torch.nn_module  {
+# CHECK:           torch.slot "p", %[[P]] : !numpy.ndarray<*:!numpy.any_dtype>
+# CHECK:           torch.slot "q", %[[Q]] : !numpy.ndarray<*:!numpy.any_dtype>
+# CHECK:           torch.slot "t", %[[T]] : !numpy.ndarray<*:!numpy.any_dtype>
+# CHECK:         }
+
+# The blobs hold the raw data.
+# CHECK:         4B72477F9C5C2F98.bin 4
+# CHECK-NEXT:    90DC09162F9CFE2B.bin 12
+# CHECK-NOT:     .bin
+
+
+test_module = TestModule()
+recursivescriptmodule = torch.jit.script(test_module)
+mb.import_module(recursivescriptmodule._c)
+mb.module.operation.print()
+for name in sorted(os.listdir(weights_dir)):
+    print(name, os.path.getsize(os.path.join(weights_dir, name)))
@@ -0,0 +1,40 @@
+/*===-- npcomp-c/Attributes.h - NPComp custom attributes ----------*- C -*-===*\
+|*                                                                            *|
+|* Part of the LLVM Project, under the Apache License v2.0 with LLVM          *|
+|* Exceptions.                                                                *|
+|* See https://llvm.org/LICENSE.txt for license information.                  *|
+|* SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception                    *|
+|*                                                                            *|
+\*===----------------------------------------------------------------------===*/
+
+#ifndef NPCOMP_C_ATTRIBUTES_H
+#define NPCOMP_C_ATTRIBUTES_H
+
+#include "mlir-c/IR.h"
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*============================================================================*/
+/* External elements attribute.                                               */
+/*============================================================================*/
+
+/** Checks whether the given attribute refers to elements stored outside of the
+ * context. */
+int npcompAttributeIsAExternalElements(MlirAttribute attr);
+
+/** Gets an elements attribute of the given shaped type whose data is not held
+ * in the context, but in an external blob named by the 64-bit content hash of
+ * the data. The attribute is `opaque<"torch", "0x<hash>">`, and the blob is
+ * `<hash>.bin` with the hash in upper case hex. */
+MlirAttribute npcompExternalElementsAttrGet(MlirType shapedType,
+                                            uint64_t contentHash);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NPCOMP_C_ATTRIBUTES_H
@@ -0,0 +1,105 @@
+//===- ATenConstantUtils.h --------------------------------------*- C++ -*-===//
+//
+// This file is licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef NPCOMP_DIALECT_ATEN_IR_ATENCONSTANTUTILS_H
+#define NPCOMP_DIALECT_ATEN_IR_ATENCONSTANTUTILS_H
+
+#include "npcomp/Dialect/ATen/IR/ATenDialect.h"
+#include "npcomp/Dialect/Numpy/IR/NumpyOps.h"
+
+#include "mlir/IR/BuiltinAttributes.h"
+#include "mlir/IR/Matchers.h"
+
+/// Matchers for the constant operands of ATen ops, shared by the passes and
+/// conversions that specialize ops on them.
+
+namespace mlir {
+namespace NPCOMP {
+namespace aten {
+
+/// Returns the attribute that a constant `value` was created from, looking
+/// through both foldable constants and aten.constant, or null if `value` is
+/// not constant.
+inline Attribute getConstantValue(Value value) {
+  Attribute attr;
+  if (matchPattern(value, m_Constant(&attr)))
+    return attr;
+  if (auto constant = value.getDefiningOp<aten::ConstantOp>())
+    return constant->getAttr("value");
+  return {};
+}
+
+/// Imported parameters reach ATen ops as
+/// `numpy.copy_to_tensor(numpy.create_array_from_tensor(constant))`. Returns
+/// the tensor that such a copy was made from, or `value` itself, so that
+/// matchers do not depend on canonicalization having run.
+inline Value lookThroughParameterCopy(Value value) {
+  if (auto copy = value.getDefiningOp<Numpy::CopyToTensorOp>())
+    if (auto create =
+            copy.source().getDefiningOp<Numpy::CreateArrayFromTensorOp>())
+      return create.source();
+  return value;
+}
+
+/// Matches a constant f32 tensor, such as a weight, looking through
+/// parameter copies. Returns null if `value` is not one.
+inline DenseFPElementsAttr matchConstantTensor(Value value) {
+  auto elements = getConstantValue(lookThroughParameterCopy(value))
+                      .dyn_cast_or_null<DenseFPElementsAttr>();
+  if (!elements || !elements.getType().getElementType().isF32())
+    return nullptr;
+  return elements;
+}
+
+inline bool matchConstantInt(Value value, int64_t &result) {
+  auto attr = getConstantValue(value).dyn_cast_or_null<IntegerAttr>();
+  if (!attr)
+    return false;
+  result = attr.getValue().getSExtValue();
+  return true;
+}
+
+inline bool matchConstantBool(Value value, bool &result) {
+  Attribute attr = getConstantValue(value);
+  if (auto boolAttr = attr.dyn_cast_or_null<BoolAttr>()) {
+    result = boolAttr.getValue();
+    return true;
+  }
+  if (auto intAttr = attr.dyn_cast_or_null<IntegerAttr>()) {
+    result = !intAttr.getValue().isNullValue();
+    return true;
+  }
+  return false;
+}
+
+/// Matches a constant Python number, which may be either an int or a float,
+/// or a rank-0 tensor holding one (as scalars that multiply tensors are
+/// imported).
+inline bool matchConstantNumber(Value value, double &result) {
+  Attribute attr = getConstantValue(value);
+  if (auto elements = attr.dyn_cast_or_null<DenseElementsAttr>()) {
+    if (elements.getType().getRank() != 0)
+      return false;
+    attr = elements.getSplatValue();
+  }
+  if (auto floatAttr = attr.dyn_cast_or_null<FloatAttr>()) {
+    result = floatAttr.getValueAsDouble();
+    return true;
+  }
+  if (auto intAttr = attr.dyn_cast_or_null<IntegerAttr>()) {
+    result = static_cast<double>(intAttr.getValue().getSExtValue());
+    return true;
+  }
+  return false;
+}
+
+} // namespace aten
+} // namespace NPCOMP
+} // namespace mlir
+
+#endif // NPCOMP_DIALECT_ATEN_IR_ATENCONSTANTUTILS_H
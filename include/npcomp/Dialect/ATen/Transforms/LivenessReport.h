@@ -18,6 +18,9 @@ namespace mlir {
 namespace NPCOMP {
 namespace aten {
 
+/// Reports, for the `graph` function of a module, the ops at which each
+/// argument and layer result is live. Built on BlockLiveness; the module is
+/// not modified.
 struct LivenessReport {
 
 public:
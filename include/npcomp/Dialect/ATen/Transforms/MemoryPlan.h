@@ -0,0 +1,142 @@
+//===- MemoryPlan.h ---------------------------------------------*- C++ -*-===//
+//
+// This file is licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef NPCOMP_DIALECT_ATEN_TRANSFORMS_MEMORYPLAN_H
+#define NPCOMP_DIALECT_ATEN_TRANSFORMS_MEMORYPLAN_H
+
+#include "mlir/IR/Block.h"
+#include "mlir/IR/Value.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Optional.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace mlir {
+namespace NPCOMP {
+namespace aten {
+
+/// The storage of a tensor value in a block whose ops are numbered in order.
+/// Views (e.g. `aten.t` or `aten.view`) share the range of the value they
+/// view, which stays live until the last use of any of them.
+struct LiveRange {
+  enum class Kind {
+    /// A block argument, owned by the caller.
+    Argument,
+    /// The result of a constant op; not allocated at runtime.
+    Constant,
+    /// The result of an op in the block.
+    Intermediate,
+  };
+
+  /// The value that owns the storage.
+  Value value;
+  Kind kind;
+  /// The index of the defining op, or 0 for block arguments.
+  unsigned start;
+  /// The index of the last op that uses the value or a view of it (through
+  /// ops nested in its regions too). Equal to `start` if it is unused.
+  unsigned end;
+  /// The size of the storage, or 0 if the shape is not static.
+  uint64_t bytes;
+  /// Whether the value (or a view of it) is used by the terminator, so that
+  /// its storage outlives the block.
+  bool escapes;
+};
+
+/// Live ranges of the tensor-like values (tensors, memrefs and numpy arrays)
+/// defined by a single block. Built in time linear in the number of ops and
+/// uses, without modifying the IR.
+class BlockLiveness {
+public:
+  explicit BlockLiveness(Block &block);
+
+  ArrayRef<Operation *> getOps() const { return ops; }
+  ArrayRef<LiveRange> getRanges() const { return ranges; }
+
+  /// Return the index of `op` in the block.
+  unsigned getIndex(Operation *op) const { return opIndex.lookup(op); }
+
+  /// Return the index of the range holding the storage of `value`, if it is
+  /// a tensor-like value of the block.
+  Optional<unsigned> getRangeIndex(Value value) const;
+
+  /// Return, for each op, the bytes live while it executes: its operands,
+  /// its results and every value needed later. Constants are not counted.
+  ArrayRef<uint64_t> getLiveBytes() const { return liveBytes; }
+
+  uint64_t getPeakBytes() const { return peakBytes; }
+  /// Return the index of the first op at which the peak is reached.
+  unsigned getPeakIndex() const { return peakIndex; }
+
+  /// Return the number of values whose size is not static, and are counted
+  /// as 0 bytes.
+  unsigned getNumDynamicRanges() const { return numDynamicRanges; }
+
+private:
+  std::vector<Operation *> ops;
+  llvm::DenseMap<Operation *, unsigned> opIndex;
+  std::vector<LiveRange> ranges;
+  llvm::DenseMap<Value, unsigned> rangeIndex;
+  std::vector<uint64_t> liveBytes;
+  uint64_t peakBytes = 0;
+  unsigned peakIndex = 0;
+  unsigned numDynamicRanges = 0;
+};
+
+/// A static allocation plan for the intermediate tensors of a function body:
+/// each is assigned a buffer, at a fixed offset in one arena, that it may
+/// share with other intermediates whose live ranges do not overlap.
+/// Arguments, constants, escaping values and values with dynamic shapes are
+/// left to the caller.
+///
+/// Buffers are assigned in program order: each new value takes the smallest
+/// free buffer that fits it, else grows the largest free buffer, else gets a
+/// new one. This takes O(n log n) time.
+///
+/// Usable as an analysis on function-like ops, e.g.
+/// `getAnalysis<MemoryPlan>()` from a FuncOp pass.
+class MemoryPlan {
+public:
+  struct Buffer {
+    uint64_t offset;
+    uint64_t bytes;
+  };
+
+  /// Plan the entry block of `op`, which must have one region.
+  explicit MemoryPlan(Operation *op);
+
+  const BlockLiveness &getLiveness() const { return liveness; }
+  ArrayRef<Buffer> getBuffers() const { return buffers; }
+
+  /// Return the buffer assigned to the range with the given index, or None
+  /// if the range is not planned.
+  Optional<unsigned> getBufferIndex(unsigned rangeIndex) const;
+
+  /// Return the size of the arena holding all buffers.
+  uint64_t getArenaBytes() const { return arenaBytes; }
+  /// Return the bytes the plan saves over giving every planned value its
+  /// own buffer.
+  uint64_t getReusedBytes() const { return plannedBytes - arenaBytes; }
+
+  /// The alignment of buffers in the arena.
+  static constexpr uint64_t kAlignment = 64;
+
+private:
+  BlockLiveness liveness;
+  std::vector<Buffer> buffers;
+  std::vector<int> rangeToBuffer;
+  uint64_t arenaBytes = 0;
+  uint64_t plannedBytes = 0;
+};
+
+} // namespace aten
+} // namespace NPCOMP
+} // namespace mlir
+
+#endif // NPCOMP_DIALECT_ATEN_TRANSFORMS_MEMORYPLAN_H
@@ -0,0 +1,121 @@
+//===- OpCostAnalysis.h -----------------------------------------*- C++ -*-===//
+//
+// This file is licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef NPCOMP_DIALECT_ATEN_TRANSFORMS_OPCOSTANALYSIS_H
+#define NPCOMP_DIALECT_ATEN_TRANSFORMS_OPCOSTANALYSIS_H
+
+#include "mlir/IR/Operation.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/StringRef.h"
+
+#include <array>
+#include <cstdint>
+
+namespace mlir {
+namespace NPCOMP {
+namespace aten {
+
+/// The kinds of arithmetic counted by the cost model.
+enum class FlopKind : unsigned {
+  /// Multiply-accumulate, counted as two flops.
+  MAC,
+  /// Add and subtract.
+  Add,
+  Mul,
+  /// Divide and remainder.
+  Div,
+  /// Compare, select, min and max.
+  Compare,
+  /// exp, log, sqrt, trigonometric and similar functions.
+  Transcendental,
+  /// Rounding, sign and other cheap elementwise ops.
+  Other,
+};
+constexpr unsigned kNumFlopKinds = static_cast<unsigned>(FlopKind::Other) + 1;
+
+/// Return a short name for `kind`, e.g. "mac" or "add".
+llvm::StringRef getFlopKindName(FlopKind kind);
+
+/// The static cost of an operation, derived from its types: arithmetic by
+/// kind and the bytes of tensors (or buffers) it reads and writes, assuming
+/// each is moved exactly once.
+struct OpCost {
+  std::array<uint64_t, kNumFlopKinds> flops = {};
+  uint64_t bytesRead = 0;
+  uint64_t bytesWritten = 0;
+  /// The part of `bytesRead` that is model parameters (weights, biases,
+  /// normalization statistics and other constants).
+  uint64_t parameterBytes = 0;
+  /// False if the op is not modeled or has dynamic shapes; all counts are
+  /// then zero.
+  bool known = true;
+
+  static OpCost getUnknown() {
+    OpCost cost;
+    cost.known = false;
+    return cost;
+  }
+
+  uint64_t &operator[](FlopKind kind) {
+    return flops[static_cast<unsigned>(kind)];
+  }
+  uint64_t operator[](FlopKind kind) const {
+    return flops[static_cast<unsigned>(kind)];
+  }
+
+  /// Total floating point operations, counting a MAC as two.
+  uint64_t getTotalFlops() const;
+  uint64_t getBytesMoved() const { return bytesRead + bytesWritten; }
+  /// Flops per byte moved, or 0 if the op moves no data.
+  double getArithmeticIntensity() const;
+  /// Whether the op is known to neither compute nor move data (e.g. views
+  /// and constants).
+  bool isFree() const {
+    return known && getTotalFlops() == 0 && getBytesMoved() == 0;
+  }
+
+  /// Accumulate `other`. If either side is unknown, so is the sum, whose
+  /// counts are then a lower bound.
+  OpCost &operator+=(const OpCost &other);
+};
+
+/// Return the size in bytes of a tensor-like type (tensor, memref or numpy
+/// array) with a static shape, or None.
+llvm::Optional<uint64_t> getStaticSizeInBytes(Type type);
+
+/// Compute the cost of a single op. ATen, TCF and linalg structured ops are
+/// modeled; ops of other dialects are free, since they are either scalar or
+/// structural (functions, terminators, the bodies of linalg ops).
+OpCost computeOpCost(Operation *op);
+
+/// The costs of all operations nested under an op, computed in one walk and
+/// cached by the pass manager, e.g. `getAnalysis<OpCostAnalysis>()`. Only
+/// ops that are not free are stored, so memory stays proportional to the
+/// compute ops of the graph.
+class OpCostAnalysis {
+public:
+  OpCostAnalysis(Operation *root);
+
+  /// Return the cost of `op`. Ops created after the analysis ran are costed
+  /// on demand.
+  OpCost getCost(Operation *op) const;
+
+  /// Return the sum of the costs of all ops under the root.
+  const OpCost &getTotalCost() const { return total; }
+
+private:
+  llvm::DenseMap<Operation *, OpCost> costs;
+  OpCost total;
+};
+
+} // namespace aten
+} // namespace NPCOMP
+} // namespace mlir
+
+#endif // NPCOMP_DIALECT_ATEN_TRANSFORMS_OPCOSTANALYSIS_H
@@ -18,12 +18,19 @@ namespace NPCOMP {
 namespace aten {
 
 std::unique_ptr<OperationPass<FuncOp>> createRecognizeKernelsPass();
+std::unique_ptr<OperationPass<FuncOp>> createATenFoldBatchNormPass();
+std::unique_ptr<OperationPass<FuncOp>> createATenFuseOptimizerUpdatePass();
 
 std::unique_ptr<OperationPass<ModuleOp>> createATenOpReportPass();
 // Return the report in the given output string.
 std::unique_ptr<OperationPass<ModuleOp>>
 createATenOpReportPass(std::string &output);
 
+std::unique_ptr<OperationPass<ModuleOp>> createATenMemoryReportPass();
+std::unique_ptr<OperationPass<FuncOp>> createATenMemorySchedulePass();
+std::unique_ptr<OperationPass<FuncOp>> createATenPrepackWeightsPass();
+std::unique_ptr<OperationPass<FuncOp>> createATenRematerializePass();
+
 std::unique_ptr<OperationPass<ModuleOp>> createATenLayerNamePass();
 std::unique_ptr<OperationPass<ModuleOp>> createATenLoweringPass();
 std::unique_ptr<OperationPass<ModuleOp>> createReturnEliminationPass();
@@ -19,6 +19,8 @@ namespace Numpy {
 
 std::unique_ptr<OperationPass<ModuleOp>> createPublicFunctionsToTensorPass();
 
+std::unique_ptr<OperationPass<FuncOp>> createElideArrayCopiesPass();
+
 } // namespace Numpy
 
 /// Registers all Numpy transformation passes.
@@ -17,7 +17,13 @@ namespace mlir {
 namespace NPCOMP {
 namespace Torch {
 
+std::unique_ptr<OperationPass<ModuleOp>> createFreezeGlobalSlotsPass();
 std::unique_ptr<OperationPass<ModuleOp>> createGlobalizeObjectGraphPass();
+std::unique_ptr<OperationPass<ModuleOp>> createLowerGlobalSlotsPass();
+
+/// Creates a pipeline that globalizes the object graph of an imported
+/// TorchScript module, then freezes the slots that are never set.
+void createGlobalizedModulePipeline(OpPassManager &pm);
 
 } // namespace Torch
 
@@ -0,0 +1,77 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// The blocking parameters of the ATen kernel library's sgemm, and the layout
+// of the B operand once packed into its panels.
+//
+// This is shared between the kernel library, which packs B on every call
+// unless it is given prepacked panels, and `-aten-prepack-weights`, which
+// packs constant weights at compile time. It must therefore not depend on
+// anything but the C++ standard library.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef NPCOMP_REFBACKEND_ATENKERNELS_GEMMLAYOUT_H
+#define NPCOMP_REFBACKEND_ATENKERNELS_GEMMLAYOUT_H
+
+#include <algorithm>
+#include <cstdint>
+
+namespace refbackrt {
+namespace aten {
+
+// Register block. MR x NR floats of accumulators must fit in the register
+// file: 6 x 16 is 12 AVX registers (or 24 SSE/NEON registers).
+constexpr std::int64_t kGemmMR = 6;
+constexpr std::int64_t kGemmNR = 16;
+// Cache blocks. A KC x NR panel of B should stay in L1, an MC x KC block of
+// A in L2 and the KC x NC block of B in L3.
+constexpr std::int64_t kGemmKC = 256;
+constexpr std::int64_t kGemmMC = 96;
+constexpr std::int64_t kGemmNC = 2048;
+
+static_assert(kGemmNC % kGemmNR == 0, "NC blocks must hold whole panels");
+
+inline std::int64_t roundUpGemmBlock(std::int64_t x, std::int64_t multiple) {
+  return (x + multiple - 1) / multiple * multiple;
+}
+
+// B [K, N] packed for sgemm is a sequence of (NC column block, KC row slice)
+// blocks, column blocks outermost. Each block holds the NR-wide panels of its
+// columns, each panel stored k-major (NR consecutive floats per row), with
+// the columns past N zero padded.
+
+// Returns the number of floats of B [K, N] once packed.
+inline std::int64_t getPackedGemmBSize(std::int64_t K, std::int64_t N) {
+  return K * roundUpGemmBlock(N, kGemmNR);
+}
+
+// Returns the offset of the packed (jc, pc) block, where `jc` and `pc` are
+// multiples of NC and KC.
+inline std::int64_t getPackedGemmBBlockOffset(std::int64_t K, std::int64_t N,
+                                              std::int64_t jc,
+                                              std::int64_t pc) {
+  std::int64_t nc = std::min(kGemmNC, N - jc);
+  return jc * K + roundUpGemmBlock(nc, kGemmNR) * pc;
+}
+
+// Returns the offset of element (k, n) of B [K, N] once packed.
+inline std::int64_t getPackedGemmBIndex(std::int64_t K, std::int64_t N,
+                                        std::int64_t k, std::int64_t n) {
+  std::int64_t jc = n / kGemmNC * kGemmNC;
+  std::int64_t pc = k / kGemmKC * kGemmKC;
+  std::int64_t kc = std::min(kGemmKC, K - pc);
+  std::int64_t panel = (n - jc) / kGemmNR;
+  return getPackedGemmBBlockOffset(K, N, jc, pc) + panel * kGemmNR * kc +
+         (k - pc) * kGemmNR + (n - jc) % kGemmNR;
+}
+
+} // namespace aten
+} // namespace refbackrt
+
+#endif // NPCOMP_REFBACKEND_ATENKERNELS_GEMMLAYOUT_H
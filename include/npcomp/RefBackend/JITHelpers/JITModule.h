@@ -16,8 +16,10 @@
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/Error.h"
+#include "llvm/Support/MemoryBuffer.h"
 
 #include <memory>
+#include <vector>
 
 namespace mlir {
 class PassManager;
@@ -36,9 +38,15 @@ public:
   /// Constructs a JITModule from a compiled Module.
   /// The module should be the result of having run the backend compilation
   /// pipeline successfully.
+  /// Weights imported by reference are bound to the blobs of the same key in
+  /// `weightsDirectory`, which are memory mapped rather than read. Blobs are
+  /// mapped once per process, however many JITModules use them.
+  /// The module initializer, if any, is run before returning, so that the
+  /// module can then be invoked from multiple threads.
   static llvm::Expected<std::unique_ptr<JITModule>>
   fromCompiledModule(mlir::ModuleOp module,
-                     llvm::ArrayRef<llvm::StringRef> sharedLibs);
+                     llvm::ArrayRef<llvm::StringRef> sharedLibs,
+                     llvm::StringRef weightsDirectory = "");
 
   llvm::Expected<llvm::SmallVector<refbackrt::Ref<refbackrt::Tensor>, 6>>
   invoke(llvm::StringRef functionName,
@@ -46,8 +54,13 @@ public:
 
 private:
   JITModule();
+  llvm::Error bindExternalWeights(llvm::StringRef weightsDirectory);
+  llvm::Error runModuleInitializer();
   std::unique_ptr<mlir::ExecutionEngine> engine;
   refbackrt::ModuleDescriptor *descriptor;
+  // The blobs bound to external weights, shared with other JITModules in the
+  // process that use the same weights.
+  std::vector<std::shared_ptr<const llvm::MemoryBuffer>> weightBuffers;
 };
 } // namespace refback
 
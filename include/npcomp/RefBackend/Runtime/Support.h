@@ -25,6 +25,8 @@ public:
   StringRef(const char *ptr, std::size_t length) : ptr(ptr), length(length){};
   // Construct from NUL-terminated C string.
   StringRef(const char *ptr) : ptr(ptr), length(std::strlen(ptr)) {}
+  const char *data() const { return ptr; }
+  std::size_t size() const { return length; }
   bool equals(StringRef other) {
     if (length != other.length)
       return false;
@@ -181,6 +181,27 @@ LogicalResult getMetadata(ModuleDescriptor *moduleDescriptor,
                           StringRef functionName,
                           FunctionMetadata &outMetadata);
 
+// Metadata for a weight imported by reference.
+struct ExternalWeightMetadata {
+  // The key of the blob holding the data, the hex content hash of the data.
+  StringRef key;
+  std::int64_t byteSize;
+};
+
+// The number of weights that must be bound with bindExternalWeight before any
+// function of the module is invoked.
+std::int32_t getNumExternalWeights(ModuleDescriptor *moduleDescriptor);
+
+// Metadata for external weight `index`.
+ExternalWeightMetadata
+getExternalWeightMetadata(ModuleDescriptor *moduleDescriptor,
+                          std::int32_t index);
+
+// Binds external weight `index` to `data`, which must hold `byteSize` bytes
+// and stay alive and unchanged while the module is in use.
+void bindExternalWeight(ModuleDescriptor *moduleDescriptor, std::int32_t index,
+                        const void *data);
+
 } // namespace refbackrt
 
 #endif // NPCOMP_RUNTIME_USERAPI_H
@@ -17,7 +17,11 @@
 #define NPCOMP_TYPING_ANALYSIS_CPA_ALGORITHM_H
 
 #include "npcomp/Typing/Analysis/CPA/Types.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/SmallVector.h"
+
+#include <vector>
 
 namespace mlir {
 namespace NPCOMP {
@@ -34,16 +38,33 @@ public:
   /// Expanding to:
   ///   τv <: τ
   /// (τv=ValueType, t=TypeVar, τ=TypeBase)
+  ///
+  /// Only constraints added since the last commit (initially, all of them)
+  /// are joined, against indexes of all constraints seen so far.
   void propagateTransitivity();
 
   /// Commits the current round, returning true if any new constraints were
   /// added.
   bool commit();
 
+  /// Adds a constraint that was derived outside of the worklist. It takes
+  /// part in propagation from the next round on.
+  void addConstraint(Constraint *c);
+
 private:
+  void addDerivedConstraint(ValueType *from, TypeNode *to);
+
   Environment &env;
   llvm::DenseSet<Constraint *> currentConstraints;
-  int newConstraintCount = 0;
+  /// Constraints to join in the current round.
+  std::vector<Constraint *> deltaConstraints;
+  /// Constraints derived in the current round.
+  std::vector<Constraint *> newConstraints;
+
+  // Persistent join indexes over all constraints that have been in a delta.
+  static constexpr size_t N = 8;
+  llvm::DenseMap<TypeVar *, llvm::SmallVector<ValueType *, N>> varToValueType;
+  llvm::DenseMap<TypeVar *, llvm::SmallVector<TypeNode *, N>> varToAny;
 };
 
 /// Resolves all variables associated with a type node in a greedy fashion.
@@ -17,7 +17,7 @@ namespace mlir {
 namespace NPCOMP {
 namespace Typing {
 
-std::unique_ptr<OperationPass<FuncOp>> createCPAFunctionTypeInferencePass();
+std::unique_ptr<OperationPass<ModuleOp>> createCPAFunctionTypeInferencePass();
 
 } // namespace Typing
 
@@ -83,24 +83,28 @@ py::array wrapTensorAsArray(Ref<Tensor> tensor) {
 }
 
 void npcomp::python::defineBackendRefJitModule(py::module &m) {
-  m.def("build_backend_compilation_pipeline", [](MlirPassManager capiPm) {
-    mlir::PassManager *pm = unwrap(capiPm);
-    JITModule::buildBackendCompilationPipeline(*pm);
-  });
+  m.def(
+      "build_backend_compilation_pipeline",
+      [](MlirPassManager capiPm, bool optimize) {
+        mlir::PassManager *pm = unwrap(capiPm);
+        JITModule::buildBackendCompilationPipeline(*pm, optimize);
+      },
+      py::arg("pm"), py::arg("optimize") = false);
   py::class_<JITModule>(m, "JITModule")
       .def_static(
           "from_compiled_module",
-          [](MlirModule capiModule, std::vector<std::string> pySharedLibs)
-              -> std::unique_ptr<JITModule> {
+          [](MlirModule capiModule, std::vector<std::string> pySharedLibs,
+             std::string weightsDir) -> std::unique_ptr<JITModule> {
             SmallVector<StringRef, 4> sharedLibs(pySharedLibs.begin(),
                                                  pySharedLibs.end());
             auto module = unwrap(capiModule);
-            auto jitModule =
-                checkError(JITModule::fromCompiledModule(module, sharedLibs),
-                           "error creating JITModule: ");
+            auto jitModule = checkError(
+                JITModule::fromCompiledModule(module, sharedLibs, weightsDir),
+                "error creating JITModule: ");
             return jitModule;
           },
-          py::arg("module"), py::arg("shared_libs"))
+          py::arg("module"), py::arg("shared_libs"),
+          py::arg("weights_dir") = "")
       .def(
           "invoke",
           [](JITModule &self, std::string functionName,
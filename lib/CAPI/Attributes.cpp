@@ -0,0 +1,40 @@
+//===- Attributes.cpp - C Interface for NPComp attributes -----------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "npcomp-c/Attributes.h"
+
+#include "mlir/CAPI/IR.h"
+#include "mlir/CAPI/Support.h"
+#include "mlir/IR/BuiltinAttributes.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "npcomp/Dialect/Torch/IR/TorchDialect.h"
+
+using namespace mlir;
+using namespace mlir::NPCOMP;
+
+/*============================================================================*/
+/* External elements attribute.                                               */
+/*============================================================================*/
+
+int npcompAttributeIsAExternalElements(MlirAttribute attr) {
+  auto opaque = unwrap(attr).dyn_cast<OpaqueElementsAttr>();
+  return opaque && opaque.getDialect()->getNamespace() ==
+                       Torch::TorchDialect::getDialectNamespace();
+}
+
+MlirAttribute npcompExternalElementsAttrGet(MlirType shapedType,
+                                            uint64_t contentHash) {
+  auto type = unwrap(shapedType).cast<ShapedType>();
+  // Big endian, so that the printed attribute spells the hash.
+  char bytes[8];
+  for (int i = 0; i < 8; i++)
+    bytes[i] = static_cast<char>(contentHash >> (56 - 8 * i));
+  auto *dialect = type.getContext()->getOrLoadDialect<Torch::TorchDialect>();
+  return wrap(OpaqueElementsAttr::get(dialect, type,
+                                      StringRef(bytes, sizeof(bytes))));
+}
@@ -11,12 +11,73 @@
 #include "mlir/IR/MLIRContext.h"
 #include "mlir/IR/Matchers.h"
 #include "mlir/IR/PatternMatch.h"
+#include "npcomp/Dialect/ATen/IR/ATenConstantUtils.h"
 #include "npcomp/Dialect/ATen/IR/ATenDialect.h"
+#include "npcomp/Dialect/Basicpy/IR/BasicpyDialect.h"
+#include "npcomp/Dialect/Basicpy/IR/BasicpyOps.h"
 #include "npcomp/Dialect/TCF/IR/TCFOps.h"
 
 using namespace mlir;
 using namespace mlir::NPCOMP;
 
+using aten::getConstantValue;
+using aten::matchConstantBool;
+using aten::matchConstantInt;
+using aten::matchConstantNumber;
+
+// Matches an int list, either built from constants with basicpy.build_list
+// (as imported from TorchScript) or a dense aten.constant.
+static bool matchConstantIntList(Value value,
+                                 SmallVectorImpl<int64_t> &result) {
+  if (auto list = value.getDefiningOp<Basicpy::BuildListOp>()) {
+    for (Value element : list.elements()) {
+      int64_t elementValue;
+      if (!matchConstantInt(element, elementValue))
+        return false;
+      result.push_back(elementValue);
+    }
+    return true;
+  }
+  auto attr = getConstantValue(value).dyn_cast_or_null<DenseIntElementsAttr>();
+  if (!attr)
+    return false;
+  for (const APInt &element : attr)
+    result.push_back(element.getSExtValue());
+  return true;
+}
+
+// Matches a constant [height, width] list, where a single element applies
+// to both dimensions as in PyTorch's `_pair`.
+static bool matchConstantHWPair(Value value, SmallVectorImpl<int64_t> &result) {
+  if (!matchConstantIntList(value, result))
+    return false;
+  if (result.size() == 1)
+    result.push_back(result.front());
+  return result.size() == 2;
+}
+
+// Returns `pair` as an attribute, or null if it is the default (both
+// elements equal to `defaultValue`) so that the attribute can be omitted.
+static ArrayAttr getOptionalHWAttr(Builder &builder, ArrayRef<int64_t> pair,
+                                   int64_t defaultValue) {
+  if (llvm::all_of(pair, [&](int64_t v) { return v == defaultValue; }))
+    return nullptr;
+  return builder.getI64ArrayAttr(pair);
+}
+
+static bool isRankedF32Tensor(Type type, int64_t rank = -1) {
+  auto tensorType = type.dyn_cast<RankedTensorType>();
+  return tensorType && tensorType.getElementType().isF32() &&
+         (rank == -1 || tensorType.getRank() == rank);
+}
+
+// Normalizes a PyTorch dimension index, which may count from the back.
+static bool normalizeDim(int64_t &dim, int64_t rank) {
+  if (dim < 0)
+    dim += rank;
+  return dim >= 0 && dim < rank;
+}
+
 namespace {
 
 /// The ATen AddOp actually has three arguments:
@@ -66,6 +127,282 @@ public:
   }
 };
 
+/// relu(x) = clamp(x, min=0)
+class ConvertATenRelu : public OpRewritePattern<aten::ReluOp> {
+  using OpRewritePattern::OpRewritePattern;
+  LogicalResult matchAndRewrite(aten::ReluOp srcOp,
+                                PatternRewriter &rewriter) const override {
+    Type resultType = srcOp.getResult().getType();
+    if (!isRankedF32Tensor(resultType) ||
+        srcOp.self().getType() != resultType)
+      return rewriter.notifyMatchFailure(srcOp, "unsupported types");
+    rewriter.replaceOpWithNewOp<tcf::ClampOp>(
+        srcOp, resultType, srcOp.self(), rewriter.getF32FloatAttr(0.0f),
+        /*max=*/nullptr);
+    return success();
+  }
+};
+
+/// hardtanh(x, min_val, max_val) = clamp(x, min_val, max_val)
+class ConvertATenHardtanh : public OpRewritePattern<aten::HardtanhOp> {
+  using OpRewritePattern::OpRewritePattern;
+  LogicalResult matchAndRewrite(aten::HardtanhOp srcOp,
+                                PatternRewriter &rewriter) const override {
+    Type resultType = srcOp.getResult().getType();
+    if (!isRankedF32Tensor(resultType) ||
+        srcOp.self().getType() != resultType)
+      return rewriter.notifyMatchFailure(srcOp, "unsupported types");
+    double minVal, maxVal;
+    if (!matchConstantNumber(srcOp.min_val(), minVal) ||
+        !matchConstantNumber(srcOp.max_val(), maxVal))
+      return rewriter.notifyMatchFailure(srcOp, "non-constant bounds");
+    rewriter.replaceOpWithNewOp<tcf::ClampOp>(
+        srcOp, resultType, srcOp.self(), rewriter.getF32FloatAttr(minVal),
+        rewriter.getF32FloatAttr(maxVal));
+    return success();
+  }
+};
+
+class ConvertATenSigmoid : public OpRewritePattern<aten::SigmoidOp> {
+  using OpRewritePattern::OpRewritePattern;
+  LogicalResult matchAndRewrite(aten::SigmoidOp srcOp,
+                                PatternRewriter &rewriter) const override {
+    Type resultType = srcOp.getResult().getType();
+    if (!isRankedF32Tensor(resultType) ||
+        srcOp.self().getType() != resultType)
+      return rewriter.notifyMatchFailure(srcOp, "unsupported types");
+    rewriter.replaceOpWithNewOp<tcf::SigmoidOp>(srcOp, resultType,
+                                                srcOp.self());
+    return success();
+  }
+};
+
+/// addmm(self, mat1, mat2, beta, alpha) = beta * self + alpha * (mat1 @ mat2)
+/// Only the default beta == alpha == 1 maps directly onto TCF.
+class ConvertATenAddmm : public OpRewritePattern<aten::AddmmOp> {
+  using OpRewritePattern::OpRewritePattern;
+  LogicalResult matchAndRewrite(aten::AddmmOp srcOp,
+                                PatternRewriter &rewriter) const override {
+    double beta, alpha;
+    if (!matchConstantNumber(srcOp.beta(), beta) ||
+        !matchConstantNumber(srcOp.alpha(), alpha) || beta != 1.0 ||
+        alpha != 1.0)
+      return rewriter.notifyMatchFailure(
+          srcOp, "aten.addmm to tcf currently only supports beta == 1 and "
+                 "alpha == 1");
+    if (!isRankedF32Tensor(srcOp.mat1().getType(), 2) ||
+        !isRankedF32Tensor(srcOp.mat2().getType(), 2) ||
+        !isRankedF32Tensor(srcOp.self().getType()))
+      return rewriter.notifyMatchFailure(srcOp, "unsupported types");
+    auto mat1Type = srcOp.mat1().getType().cast<RankedTensorType>();
+    auto mat2Type = srcOp.mat2().getType().cast<RankedTensorType>();
+    auto matmulType = RankedTensorType::get(
+        {mat1Type.getDimSize(0), mat2Type.getDimSize(1)},
+        rewriter.getF32Type());
+    Value matmul = rewriter.create<tcf::MatmulOp>(
+        srcOp.getLoc(), matmulType, srcOp.mat1(), srcOp.mat2());
+    rewriter.replaceOpWithNewOp<tcf::AddOp>(
+        srcOp, srcOp.getResult().getType(), matmul, srcOp.self());
+    return success();
+  }
+};
+
+/// Non-transposed, ungrouped 2-D convolutions with constant parameters.
+/// Anything else is left for the generic lowering.
+class ConvertATenConvolution : public OpRewritePattern<aten::ConvolutionOp> {
+  using OpRewritePattern::OpRewritePattern;
+  LogicalResult matchAndRewrite(aten::ConvolutionOp srcOp,
+                                PatternRewriter &rewriter) const override {
+    Type resultType = srcOp.getResult().getType();
+    if (!isRankedF32Tensor(srcOp.input().getType(), 4) ||
+        !isRankedF32Tensor(srcOp.weight().getType(), 4) ||
+        !isRankedF32Tensor(resultType, 4))
+      return rewriter.notifyMatchFailure(srcOp, "expected 2-D convolution");
+    Value bias = srcOp.bias();
+    if (bias.getType().isa<Basicpy::NoneType>())
+      bias = nullptr;
+    else if (!isRankedF32Tensor(bias.getType(), 1))
+      return rewriter.notifyMatchFailure(srcOp, "unsupported bias type");
+
+    SmallVector<int64_t, 2> stride, padding, dilation, outputPadding;
+    bool transposed;
+    int64_t groups;
+    if (!matchConstantHWPair(srcOp.stride(), stride) ||
+        !matchConstantHWPair(srcOp.padding(), padding) ||
+        !matchConstantHWPair(srcOp.dilation(), dilation) ||
+        !matchConstantBool(srcOp.transposed(), transposed) ||
+        !matchConstantInt(srcOp.groups(), groups))
+      return rewriter.notifyMatchFailure(srcOp, "non-constant parameters");
+    if (transposed || groups != 1)
+      return rewriter.notifyMatchFailure(
+          srcOp, "transposed and grouped convolutions are not supported");
+
+    rewriter.replaceOpWithNewOp<tcf::ConvNCHWOp>(
+        srcOp, resultType, srcOp.input(), srcOp.weight(), bias,
+        getOptionalHWAttr(rewriter, stride, 1),
+        getOptionalHWAttr(rewriter, dilation, 1),
+        getOptionalHWAttr(rewriter, padding, 0));
+    return success();
+  }
+};
+
+/// batch_norm(input, weight, bias, running_mean, running_var, training,
+///            momentum, eps, cudnn_enabled)
+/// In inference mode (training == false) this only reads the running
+/// statistics and maps onto tcf.batch_norm_inference.
+class ConvertATenBatchNorm : public OpRewritePattern<aten::BatchNormOp> {
+  using OpRewritePattern::OpRewritePattern;
+  LogicalResult matchAndRewrite(aten::BatchNormOp srcOp,
+                                PatternRewriter &rewriter) const override {
+    bool training;
+    double eps;
+    if (!matchConstantBool(srcOp.arg5(), training) || training)
+      return rewriter.notifyMatchFailure(srcOp, "only inference is supported");
+    if (!matchConstantNumber(srcOp.arg7(), eps))
+      return rewriter.notifyMatchFailure(srcOp, "non-constant epsilon");
+    // The saved statistics are only meaningful for training.
+    if (!srcOp.getResult(1).use_empty() || !srcOp.getResult(2).use_empty())
+      return rewriter.notifyMatchFailure(srcOp, "saved statistics are used");
+    Type resultType = srcOp.getResult(0).getType();
+    if (!isRankedF32Tensor(srcOp.arg0().getType()) ||
+        srcOp.arg0().getType() != resultType)
+      return rewriter.notifyMatchFailure(srcOp, "unsupported input type");
+    for (Value param : {srcOp.arg1(), srcOp.arg2(), srcOp.arg3(), srcOp.arg4()})
+      if (!isRankedF32Tensor(param.getType(), 1))
+        return rewriter.notifyMatchFailure(srcOp,
+                                           "expected per-channel parameters");
+
+    Value batchNorm = rewriter.create<tcf::BatchNormInferenceOp>(
+        srcOp.getLoc(), resultType, srcOp.arg0(), srcOp.arg1(), srcOp.arg2(),
+        srcOp.arg3(), srcOp.arg4(), rewriter.getF32FloatAttr(eps));
+    rewriter.replaceOp(srcOp, {batchNorm, Value(), Value()});
+    return success();
+  }
+};
+
+/// max_pool2d(self, kernel_size, stride, padding, dilation, ceil_mode)
+class ConvertATenMaxPool2d : public OpRewritePattern<aten::MaxPool2dOp> {
+  using OpRewritePattern::OpRewritePattern;
+  LogicalResult matchAndRewrite(aten::MaxPool2dOp srcOp,
+                                PatternRewriter &rewriter) const override {
+    Type resultType = srcOp.getResult().getType();
+    if (!isRankedF32Tensor(srcOp.arg0().getType(), 4) ||
+        !isRankedF32Tensor(resultType, 4))
+      return rewriter.notifyMatchFailure(srcOp, "expected NCHW input");
+    SmallVector<int64_t, 2> kernelSize, stride, padding, dilation;
+    bool ceilMode;
+    if (!matchConstantHWPair(srcOp.arg1(), kernelSize) ||
+        !matchConstantIntList(srcOp.arg2(), stride) ||
+        !matchConstantHWPair(srcOp.arg3(), padding) ||
+        !matchConstantHWPair(srcOp.arg4(), dilation) ||
+        !matchConstantBool(srcOp.arg5(), ceilMode))
+      return rewriter.notifyMatchFailure(srcOp, "non-constant parameters");
+    // An empty stride defaults to the kernel size.
+    if (stride.empty())
+      stride = kernelSize;
+    else if (stride.size() == 1)
+      stride.push_back(stride.front());
+    if (stride.size() != 2 || ceilMode)
+      return rewriter.notifyMatchFailure(srcOp, "unsupported parameters");
+
+    rewriter.replaceOpWithNewOp<tcf::MaxPoolNCHWOp>(
+        srcOp, resultType, srcOp.arg0(), rewriter.getI64ArrayAttr(kernelSize),
+        rewriter.getI64ArrayAttr(stride), rewriter.getI64ArrayAttr(padding),
+        rewriter.getI64ArrayAttr(dilation));
+    return success();
+  }
+};
+
+/// Adaptive average pooling to a 1x1 output, i.e. global average pooling,
+/// is a mean over the spatial dimensions.
+class ConvertATenAdaptiveAvgPool2d
+    : public OpRewritePattern<aten::AdaptiveAvgPool2dOp> {
+  using OpRewritePattern::OpRewritePattern;
+  LogicalResult matchAndRewrite(aten::AdaptiveAvgPool2dOp srcOp,
+                                PatternRewriter &rewriter) const override {
+    Type resultType = srcOp.getResult().getType();
+    if (!isRankedF32Tensor(srcOp.self().getType(), 4) ||
+        !isRankedF32Tensor(resultType, 4))
+      return rewriter.notifyMatchFailure(srcOp, "expected NCHW input");
+    SmallVector<int64_t, 2> outputSize;
+    if (!matchConstantHWPair(srcOp.output_size(), outputSize) ||
+        outputSize[0] != 1 || outputSize[1] != 1)
+      return rewriter.notifyMatchFailure(srcOp,
+                                         "only 1x1 outputs are supported");
+    rewriter.replaceOpWithNewOp<tcf::MeanOp>(
+        srcOp, resultType, srcOp.self(), rewriter.getI64ArrayAttr({2, 3}),
+        rewriter.getBoolAttr(true));
+    return success();
+  }
+};
+
+/// sum(self, dim, keepdim)
+class ConvertATenSum : public OpRewritePattern<aten::SumOp> {
+  using OpRewritePattern::OpRewritePattern;
+  LogicalResult matchAndRewrite(aten::SumOp srcOp,
+                                PatternRewriter &rewriter) const override {
+    Type resultType = srcOp.getResult().getType();
+    if (!isRankedF32Tensor(srcOp.self().getType()) ||
+        !isRankedF32Tensor(resultType))
+      return rewriter.notifyMatchFailure(srcOp, "unsupported types");
+    int64_t rank = srcOp.self().getType().cast<RankedTensorType>().getRank();
+    SmallVector<int64_t, 4> dims;
+    bool keepDim;
+    if (!matchConstantIntList(srcOp.dim(), dims) || dims.empty() ||
+        !matchConstantBool(srcOp.keepdim(), keepDim))
+      return rewriter.notifyMatchFailure(srcOp, "non-constant parameters");
+    for (int64_t &dim : dims)
+      if (!normalizeDim(dim, rank))
+        return rewriter.notifyMatchFailure(srcOp, "dim out of range");
+    rewriter.replaceOpWithNewOp<tcf::SumOp>(
+        srcOp, resultType, srcOp.self(), rewriter.getI64ArrayAttr(dims),
+        rewriter.getBoolAttr(keepDim));
+    return success();
+  }
+};
+
+/// mean(self) reduces over all dimensions.
+class ConvertATenMean : public OpRewritePattern<aten::MeanOp> {
+  using OpRewritePattern::OpRewritePattern;
+  LogicalResult matchAndRewrite(aten::MeanOp srcOp,
+                                PatternRewriter &rewriter) const override {
+    Type resultType = srcOp.getResult().getType();
+    if (!isRankedF32Tensor(srcOp.self().getType()) ||
+        !isRankedF32Tensor(resultType, 0))
+      return rewriter.notifyMatchFailure(srcOp, "unsupported types");
+    int64_t rank = srcOp.self().getType().cast<RankedTensorType>().getRank();
+    SmallVector<int64_t, 4> dims;
+    for (int64_t dim = 0; dim < rank; dim++)
+      dims.push_back(dim);
+    rewriter.replaceOpWithNewOp<tcf::MeanOp>(
+        srcOp, resultType, srcOp.self(), rewriter.getI64ArrayAttr(dims),
+        rewriter.getBoolAttr(false));
+    return success();
+  }
+};
+
+/// log_softmax(self, dim, half_to_float)
+class ConvertATenLogSoftmax : public OpRewritePattern<aten::LogSoftmaxOp> {
+  using OpRewritePattern::OpRewritePattern;
+  LogicalResult matchAndRewrite(aten::LogSoftmaxOp srcOp,
+                                PatternRewriter &rewriter) const override {
+    Type resultType = srcOp.getResult().getType();
+    if (!isRankedF32Tensor(resultType) ||
+        srcOp.self().getType() != resultType)
+      return rewriter.notifyMatchFailure(srcOp, "unsupported types");
+    int64_t dim;
+    bool halfToFloat;
+    if (!matchConstantInt(srcOp.dim(), dim) ||
+        !matchConstantBool(srcOp.half_to_float(), halfToFloat) || halfToFloat)
+      return rewriter.notifyMatchFailure(srcOp, "unsupported parameters");
+    if (!normalizeDim(dim, resultType.cast<RankedTensorType>().getRank()))
+      return rewriter.notifyMatchFailure(srcOp, "dim out of range");
+    rewriter.replaceOpWithNewOp<tcf::LogSoftmaxOp>(
+        srcOp, resultType, srcOp.self(), rewriter.getI64IntegerAttr(dim));
+    return success();
+  }
+};
+
 } // namespace
 
 void mlir::NPCOMP::populateCoreATenToTCFPatterns(
@@ -75,4 +412,12 @@ void mlir::NPCOMP::populateCoreATenToTCFPatterns(
   patterns.insert<ConvertBinaryElementwise<aten::MaximumOp, tcf::MaxOp>>(
       context);
   patterns.insert<ConvertBinaryElementwise<aten::MmOp, tcf::MatmulOp>>(context);
+  patterns.insert<ConvertATenRelu, ConvertATenHardtanh, ConvertATenSigmoid>(
+      context);
+  patterns.insert<ConvertATenAddmm>(context);
+  patterns.insert<ConvertATenConvolution>(context);
+  patterns.insert<ConvertATenBatchNorm>(context);
+  patterns.insert<ConvertATenMaxPool2d, ConvertATenAdaptiveAvgPool2d>(context);
+  patterns.insert<ConvertATenSum, ConvertATenMean>(context);
+  patterns.insert<ConvertATenLogSoftmax>(context);
 }
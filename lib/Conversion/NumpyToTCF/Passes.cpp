@@ -9,6 +9,7 @@
 #include "npcomp/Conversion/NumpyToTCF/Passes.h"
 
 #include "../PassDetail.h"
+#include "mlir/Dialect/StandardOps/IR/Ops.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
 #include "npcomp/Dialect/Numpy/IR/NumpyOps.h"
 #include "npcomp/Dialect/TCF/IR/TCFDialect.h"
@@ -42,10 +43,74 @@ private:
 };
 } // namespace
 
+namespace {
+template <typename TargetTcfOp>
+class ConvertUnaryBuiltinUfuncCallOp
+    : public OpRewritePattern<Numpy::BuiltinUfuncCallOp> {
+public:
+  ConvertUnaryBuiltinUfuncCallOp(MLIRContext *context, StringRef qualifiedName,
+                                 PatternBenefit benefit = 1)
+      : OpRewritePattern(context, benefit), qualifiedName(qualifiedName) {}
+  LogicalResult matchAndRewrite(Numpy::BuiltinUfuncCallOp op,
+                                PatternRewriter &rewriter) const override {
+    if (op.qualified_name() != qualifiedName)
+      return failure();
+    if (op.inputs().size() != 1)
+      return failure();
+
+    // Unary TCF ops preserve their operand type, so a less refined result
+    // type is recovered with a cast.
+    Value operand = op.inputs()[0];
+    Type resultType = op.getResult().getType();
+    if (operand.getType() == resultType) {
+      rewriter.replaceOpWithNewOp<TargetTcfOp>(op, resultType, operand);
+      return success();
+    }
+    if (!TensorCastOp::areCastCompatible(operand.getType(), resultType))
+      return rewriter.notifyMatchFailure(op, "incompatible result type");
+    Value result =
+        rewriter.create<TargetTcfOp>(op.getLoc(), operand.getType(), operand);
+    rewriter.replaceOpWithNewOp<TensorCastOp>(op, result, resultType);
+    return success();
+  }
+
+private:
+  StringRef qualifiedName;
+};
+} // namespace
+
+namespace {
+class ConvertCompareBuiltinUfuncCallOp
+    : public OpRewritePattern<Numpy::BuiltinUfuncCallOp> {
+public:
+  ConvertCompareBuiltinUfuncCallOp(MLIRContext *context,
+                                   StringRef qualifiedName, StringRef predicate,
+                                   PatternBenefit benefit = 1)
+      : OpRewritePattern(context, benefit), qualifiedName(qualifiedName),
+        predicate(predicate) {}
+  LogicalResult matchAndRewrite(Numpy::BuiltinUfuncCallOp op,
+                                PatternRewriter &rewriter) const override {
+    if (op.qualified_name() != qualifiedName)
+      return failure();
+    if (op.inputs().size() != 2)
+      return failure();
+
+    rewriter.replaceOpWithNewOp<tcf::CompareOp>(
+        op, op.getResult().getType(), rewriter.getStringAttr(predicate),
+        op.inputs()[0], op.inputs()[1]);
+    return success();
+  }
+
+private:
+  StringRef qualifiedName;
+  StringRef predicate;
+};
+} // namespace
+
 namespace {
 class ConvertNumpyToTCF : public ConvertNumpyToTCFBase<ConvertNumpyToTCF> {
   void getDependentDialects(DialectRegistry &registry) const override {
-    registry.insert<NPCOMP::tcf::TCFDialect>();
+    registry.insert<NPCOMP::tcf::TCFDialect, StandardOpsDialect>();
   }
 
   void runOnOperation() override {
@@ -55,6 +120,42 @@ class ConvertNumpyToTCF : public ConvertNumpyToTCFBase<ConvertNumpyToTCF> {
     OwningRewritePatternList patterns;
     patterns.insert<ConvertBinaryBuiltinUfuncCallOp<tcf::AddOp>>(context,
                                                                  "numpy.add");
+    patterns.insert<ConvertBinaryBuiltinUfuncCallOp<tcf::SubOp>>(
+        context, "numpy.subtract");
+    patterns.insert<ConvertBinaryBuiltinUfuncCallOp<tcf::MulOp>>(
+        context, "numpy.multiply");
+    // numpy.divide is an alias of numpy.true_divide, and the ufunc is
+    // registered under the latter name.
+    patterns.insert<ConvertBinaryBuiltinUfuncCallOp<tcf::DivOp>>(
+        context, "numpy.true_divide");
+    patterns.insert<ConvertBinaryBuiltinUfuncCallOp<tcf::DivOp>>(
+        context, "numpy.divide");
+    patterns.insert<ConvertBinaryBuiltinUfuncCallOp<tcf::MaxOp>>(
+        context, "numpy.maximum");
+    patterns.insert<ConvertBinaryBuiltinUfuncCallOp<tcf::MinOp>>(
+        context, "numpy.minimum");
+
+    patterns.insert<ConvertUnaryBuiltinUfuncCallOp<tcf::ExpOp>>(context,
+                                                                "numpy.exp");
+    patterns.insert<ConvertUnaryBuiltinUfuncCallOp<tcf::LogOp>>(context,
+                                                                "numpy.log");
+    patterns.insert<ConvertUnaryBuiltinUfuncCallOp<tcf::SqrtOp>>(context,
+                                                                 "numpy.sqrt");
+    patterns.insert<ConvertUnaryBuiltinUfuncCallOp<tcf::TanhOp>>(context,
+                                                                 "numpy.tanh");
+
+    patterns.insert<ConvertCompareBuiltinUfuncCallOp>(context, "numpy.equal",
+                                                      "eq");
+    patterns.insert<ConvertCompareBuiltinUfuncCallOp>(
+        context, "numpy.not_equal", "ne");
+    patterns.insert<ConvertCompareBuiltinUfuncCallOp>(context, "numpy.less",
+                                                      "lt");
+    patterns.insert<ConvertCompareBuiltinUfuncCallOp>(
+        context, "numpy.less_equal", "le");
+    patterns.insert<ConvertCompareBuiltinUfuncCallOp>(context,
+                                                      "numpy.greater", "gt");
+    patterns.insert<ConvertCompareBuiltinUfuncCallOp>(
+        context, "numpy.greater_equal", "ge");
     (void)applyPatternsAndFoldGreedily(func, std::move(patterns));
   }
 };
@@ -10,6 +10,7 @@
 
 #include "../PassDetail.h"
 #include "mlir/Dialect/Linalg/IR/LinalgOps.h"
+#include "mlir/Dialect/Math/IR/Math.h"
 #include "mlir/Dialect/Shape/IR/Shape.h"
 #include "mlir/Dialect/StandardOps/IR/Ops.h"
 #include "mlir/Dialect/Tensor/IR/Tensor.h"
@@ -23,6 +24,53 @@
 using namespace mlir;
 using namespace mlir::NPCOMP;
 
+static Value createIndexConstant(OpBuilder &builder, Location loc,
+                                 int64_t value) {
+  return builder.create<ConstantOp>(
+      loc, builder.getIntegerAttr(builder.getIndexType(), value));
+}
+
+// Returns the [height, width] pair held in `attr`, or `defaultValue` for
+// both if the attribute is absent. Returns an empty vector if the attribute
+// is malformed.
+static SmallVector<int64_t, 2> getHWPair(ArrayAttr attr, int64_t defaultValue) {
+  if (!attr)
+    return {defaultValue, defaultValue};
+  if (attr.size() != 2 || !llvm::all_of(attr, [](Attribute element) {
+        return element.isa<IntegerAttr>();
+      }))
+    return {};
+  return {attr[0].cast<IntegerAttr>().getInt(),
+          attr[1].cast<IntegerAttr>().getInt()};
+}
+
+// Computes the output size of a sliding window along one dimension:
+//   (size + 2 * padding - dilation * (kernelSize - 1) - 1) / stride + 1
+// With the default stride/dilation/padding this folds to
+// `size - (kernelSize - 1)`.
+static Value computeWindowedOutputSize(OpBuilder &builder, Location loc,
+                                       Value size, Value kernelSize,
+                                       int64_t stride, int64_t dilation,
+                                       int64_t padding) {
+  Value cI1 = createIndexConstant(builder, loc, 1);
+  Value cI2 = createIndexConstant(builder, loc, 2);
+  Value strideValue = createIndexConstant(builder, loc, stride);
+  Value dilationValue = createIndexConstant(builder, loc, dilation);
+  Value paddingValue = createIndexConstant(builder, loc, padding);
+  auto twicePadding = builder.create<MulIOp>(loc, paddingValue, cI2);
+  auto sizePlusTwicePadding = builder.create<AddIOp>(loc, size, twicePadding);
+  auto kernelSizeMinusOne = builder.create<SubIOp>(loc, kernelSize, cI1);
+  auto dilatedKernelSize =
+      builder.create<MulIOp>(loc, dilationValue, kernelSizeMinusOne);
+  auto outSizeUnstridedPlusOne =
+      builder.create<SubIOp>(loc, sizePlusTwicePadding, dilatedKernelSize);
+  auto outSizeUnstrided =
+      builder.create<SubIOp>(loc, outSizeUnstridedPlusOne, cI1);
+  auto outSizeMinusOne =
+      builder.create<UnsignedDivIOp>(loc, outSizeUnstrided, strideValue);
+  return builder.create<AddIOp>(loc, outSizeMinusOne, cI1);
+}
+
 static SmallVector<Value, 6> bypassResultShapes(Operation *op,
                                                 OpBuilder &builder) {
 
@@ -35,55 +83,124 @@ static SmallVector<Value, 6> bypassResultShapes(Operation *op,
   }
   // TODO: This only supports the NCHW data format. Consider other formats and lower ranks.
   if (auto conv2dNCHW = dyn_cast<tcf::ConvNCHWOp>(op)) {
-    // TODO: Replace hard-coded stride/dilation/padding constant-ops.
     // TODO: Consider migrating this SSA shape-computing graph to a complex op or use the `mlir-linalg-ods-gen` approach and define a `*.tc` spec file.
-    auto cI0 = builder.create<ConstantOp>(op->getLoc(), builder.getIntegerAttr(builder.getIndexType(), 0));
-    auto cI1 = builder.create<ConstantOp>(op->getLoc(), builder.getIntegerAttr(builder.getIndexType(), 1));
-    auto cI2 = builder.create<ConstantOp>(op->getLoc(), builder.getIntegerAttr(builder.getIndexType(), 2));
-    auto stride = cI1;
-    auto dilation = cI1;
-    auto padding = cI0;
-    auto strideHeight = stride;
-    auto strideWidth = stride;
-    auto dilationHeight = dilation;
-    auto dilationWidth = dilation;
-    auto paddingHeight = padding;
-    auto paddingWidth = padding;
+    auto strides = getHWPair(conv2dNCHW.stridesAttr(), 1);
+    auto dilations = getHWPair(conv2dNCHW.dilationsAttr(), 1);
+    auto padding = getHWPair(conv2dNCHW.paddingAttr(), 0);
     auto batch = builder.create<DimOp>(op->getLoc(), conv2dNCHW.in(), 0);
     auto height = builder.create<DimOp>(op->getLoc(), conv2dNCHW.in(), 2);
     auto width = builder.create<DimOp>(op->getLoc(), conv2dNCHW.in(), 3);
     auto filterOutChannels = builder.create<DimOp>(op->getLoc(), conv2dNCHW.filter(), 0);
     auto filterHeight = builder.create<DimOp>(op->getLoc(), conv2dNCHW.filter(), 2);
     auto filterWidth = builder.create<DimOp>(op->getLoc(), conv2dNCHW.filter(), 3);
-    // Output height
-    auto twicePaddingHeight = builder.create<MulIOp>(op->getLoc(), paddingHeight, cI2);
-    auto heightPlusTwicePadding = builder.create<SubIOp>(op->getLoc(), height, twicePaddingHeight);
-    auto filterHeightMinusOne = builder.create<SubIOp>(op->getLoc(), filterHeight, cI1);
-    auto dilationFilterHeight = builder.create<MulIOp>(op->getLoc(), dilationHeight, filterHeightMinusOne);
-    auto outHeightUnstridedPlusOne = builder.create<SubIOp>(op->getLoc(), heightPlusTwicePadding, dilationFilterHeight);
-    auto outHeightUnstrided = builder.create<SubIOp>(op->getLoc(), outHeightUnstridedPlusOne, cI1);
-    auto outHeightMinusOne = builder.create<UnsignedDivIOp>(op->getLoc(), outHeightUnstrided, strideHeight);
-    auto outHeight = builder.create<AddIOp>(op->getLoc(), outHeightMinusOne, cI1);
-    // Output width
-    auto twicePaddingWidth = builder.create<MulIOp>(op->getLoc(), paddingWidth, cI2);
-    auto widthPlusTwicePadding = builder.create<SubIOp>(op->getLoc(), width, twicePaddingWidth);
-    auto filterWidthMinusOne = builder.create<SubIOp>(op->getLoc(), filterWidth, cI1);
-    auto dilationFilterWidth = builder.create<MulIOp>(op->getLoc(), dilationWidth, filterWidthMinusOne);
-    auto outWidthUnstridedPlusOne = builder.create<SubIOp>(op->getLoc(), widthPlusTwicePadding, dilationFilterWidth);
-    auto outWidthUnstrided = builder.create<SubIOp>(op->getLoc(), outWidthUnstridedPlusOne, cI1);
-    auto outWidthMinusOne = builder.create<UnsignedDivIOp>(op->getLoc(), outWidthUnstrided, strideWidth);
-    auto outWidth = builder.create<AddIOp>(op->getLoc(), outWidthMinusOne, cI1);
+    Value outHeight = computeWindowedOutputSize(
+        builder, op->getLoc(), height, filterHeight, strides[0], dilations[0],
+        padding[0]);
+    Value outWidth = computeWindowedOutputSize(
+        builder, op->getLoc(), width, filterWidth, strides[1], dilations[1],
+        padding[1]);
     // Output shape
     auto shape = builder.create<tensor::FromElementsOp>(
         op->getLoc(),
         ValueRange({batch, filterOutChannels, outHeight, outWidth}));
     return {shape};
   }
+  if (auto maxPool = dyn_cast<tcf::MaxPoolNCHWOp>(op)) {
+    auto kernelSize = getHWPair(maxPool.kernel_size(), 1);
+    auto strides = getHWPair(maxPool.strides(), 1);
+    auto dilations = getHWPair(maxPool.dilations(), 1);
+    auto padding = getHWPair(maxPool.padding(), 0);
+    auto batch = builder.create<DimOp>(op->getLoc(), maxPool.in(), 0);
+    auto channels = builder.create<DimOp>(op->getLoc(), maxPool.in(), 1);
+    auto height = builder.create<DimOp>(op->getLoc(), maxPool.in(), 2);
+    auto width = builder.create<DimOp>(op->getLoc(), maxPool.in(), 3);
+    Value outHeight = computeWindowedOutputSize(
+        builder, op->getLoc(), height,
+        createIndexConstant(builder, op->getLoc(), kernelSize[0]), strides[0],
+        dilations[0], padding[0]);
+    Value outWidth = computeWindowedOutputSize(
+        builder, op->getLoc(), width,
+        createIndexConstant(builder, op->getLoc(), kernelSize[1]), strides[1],
+        dilations[1], padding[1]);
+    auto shape = builder.create<tensor::FromElementsOp>(
+        op->getLoc(), ValueRange({batch, channels, outHeight, outWidth}));
+    return {shape};
+  }
 
   // No shape transfer function.
   return {};
 }
 
+// Returns the extents of the ranked tensor `tensor`.
+static SmallVector<Value, 6> getExtents(OpBuilder &builder, Location loc,
+                                        Value tensor) {
+  SmallVector<Value, 6> extents;
+  int64_t rank = tensor.getType().cast<RankedTensorType>().getRank();
+  for (int64_t i = 0; i < rank; i++)
+    extents.push_back(builder.create<DimOp>(loc, tensor, i));
+  return extents;
+}
+
+// Creates a tensor of type `type` and extents `extents` filled with `value`,
+// suitable as the init tensor of a linalg op.
+static Value createSplatted(OpBuilder &builder, Location loc, Type type,
+                            const APFloat &value, ValueRange extents) {
+  Type elementType = type.cast<RankedTensorType>().getElementType();
+  Value fillVal = builder.create<ConstantOp>(
+      loc, builder.getFloatAttr(elementType, value));
+  Value shape = builder.create<tensor::FromElementsOp>(
+      loc, builder.getIndexType(), extents);
+  return builder.create<tcp::SplattedOp>(loc, type, fillVal, shape);
+}
+
+static Value createSplatted(OpBuilder &builder, Location loc, Type type,
+                            double value, ValueRange extents) {
+  return createSplatted(builder, loc, type, APFloat(static_cast<float>(value)),
+                        extents);
+}
+
+// Pads the spatial dimensions of an NCHW tensor by `padding` on both sides.
+static Value padSpatialDims(OpBuilder &builder, Location loc, Value input,
+                            ArrayRef<int64_t> padding, const APFloat &fill) {
+  auto inputType = input.getType().cast<RankedTensorType>();
+  Value c0 = createIndexConstant(builder, loc, 0);
+  Value expansion = builder.create<tensor::FromElementsOp>(
+      loc, ValueRange({c0, c0, createIndexConstant(builder, loc, padding[0]),
+                       createIndexConstant(builder, loc, padding[1])}));
+  SmallVector<int64_t, 4> paddedShape(inputType.getShape().begin(),
+                                      inputType.getShape().end());
+  for (int i = 0; i < 2; i++)
+    if (paddedShape[2 + i] != ShapedType::kDynamicSize)
+      paddedShape[2 + i] += 2 * padding[i];
+  auto paddedType =
+      RankedTensorType::get(paddedShape, inputType.getElementType());
+  Value fillVal = builder.create<ConstantOp>(
+      loc, builder.getFloatAttr(inputType.getElementType(), fill));
+  return builder.create<tcp::PadOp>(loc, paddedType, input, expansion,
+                                    expansion, fillVal);
+}
+
+// Creates a linalg.generic applying `computeElement` to each element of
+// `operand`.
+static Value createElementwiseGeneric(
+    OpBuilder &builder, Location loc, Value operand,
+    function_ref<Value(OpBuilder &, Location, Value)> computeElement) {
+  auto type = operand.getType().cast<RankedTensorType>();
+  Value init = createSplatted(builder, loc, type, 0.0,
+                              getExtents(builder, loc, operand));
+  AffineMap identity = builder.getMultiDimIdentityMap(type.getRank());
+  SmallVector<StringRef, 6> iterators(type.getRank(),
+                                      getParallelIteratorTypeName());
+  auto generic = builder.create<linalg::GenericOp>(
+      loc, TypeRange(type), ValueRange(operand), ValueRange(init),
+      ArrayRef<AffineMap>({identity, identity}), iterators,
+      [&](OpBuilder &b, Location nestedLoc, ValueRange args) {
+        b.create<linalg::YieldOp>(nestedLoc,
+                                  computeElement(b, nestedLoc, args[0]));
+      });
+  return generic.getResult(0);
+}
+
 namespace {
 class ConvertMatmul : public OpRewritePattern<tcf::MatmulOp> {
 public:
@@ -129,6 +246,13 @@ public:
   using OpRewritePattern::OpRewritePattern;
   LogicalResult matchAndRewrite(tcf::ConvNCHWOp op,
                                 PatternRewriter &rewriter) const override {
+    auto strides = getHWPair(op.stridesAttr(), 1);
+    auto dilations = getHWPair(op.dilationsAttr(), 1);
+    auto padding = getHWPair(op.paddingAttr(), 0);
+    if (strides.empty() || dilations.empty() || padding.empty())
+      return rewriter.notifyMatchFailure(
+          op, "expected [height, width] strides/dilations/padding");
+
     // Create the constraints, and the assuming region.
     Value inputCin  = rewriter.create<DimOp>(op.getLoc(), op.in(), 1);
     Value inputH   = rewriter.create<DimOp>(op.getLoc(), op.in(), 2);
@@ -136,6 +260,29 @@ public:
     Value filterCin = rewriter.create<DimOp>(op.getLoc(), op.filter(), 1);
     Value filterKH = rewriter.create<DimOp>(op.getLoc(), op.filter(), 2);
     Value filterKW = rewriter.create<DimOp>(op.getLoc(), op.filter(), 3);
+    // The window must fit in the padded input. Padding and dilation are only
+    // materialized when they are not the defaults.
+    auto padExtent = [&](Value extent, int64_t amount) -> Value {
+      if (amount == 0)
+        return extent;
+      return rewriter.create<AddIOp>(
+          op.getLoc(), extent,
+          createIndexConstant(rewriter, op.getLoc(), 2 * amount));
+    };
+    auto dilateExtent = [&](Value extent, int64_t dilation) -> Value {
+      if (dilation == 1)
+        return extent;
+      Value c1 = createIndexConstant(rewriter, op.getLoc(), 1);
+      Value extentMinusOne = rewriter.create<SubIOp>(op.getLoc(), extent, c1);
+      Value dilated = rewriter.create<MulIOp>(
+          op.getLoc(), extentMinusOne,
+          createIndexConstant(rewriter, op.getLoc(), dilation));
+      return rewriter.create<AddIOp>(op.getLoc(), dilated, c1);
+    };
+    inputH = padExtent(inputH, padding[0]);
+    inputW = padExtent(inputW, padding[1]);
+    filterKH = dilateExtent(filterKH, dilations[0]);
+    filterKW = dilateExtent(filterKW, dilations[1]);
     Value matchingCin =
         rewriter.create<CmpIOp>(op.getLoc(), CmpIPredicate::eq, inputCin, filterCin);
     Value validFilterH =
@@ -148,8 +295,19 @@ public:
         op.getLoc(), validFilterH, "input height must be greater than or equal to filter KH-dimension");
     Value witnessFilterW = rewriter.create<shape::CstrRequireOp>(
         op.getLoc(), validFilterW, "input width must be greater than or equal to filter KW-dimension");
+    SmallVector<Value, 4> witnesses = {witnessCin, witnessFilterH,
+                                       witnessFilterW};
+    if (op.bias()) {
+      Value biasSize = rewriter.create<DimOp>(op.getLoc(), op.bias(), 0);
+      Value filterCout = rewriter.create<DimOp>(op.getLoc(), op.filter(), 0);
+      Value matchingCout = rewriter.create<CmpIOp>(
+          op.getLoc(), CmpIPredicate::eq, biasSize, filterCout);
+      witnesses.push_back(rewriter.create<shape::CstrRequireOp>(
+          op.getLoc(), matchingCout,
+          "bias size must equal the filter out-channels"));
+    }
     Value assumingAll = rewriter.create<shape::AssumingAllOp>(
-        op.getLoc(), witnessCin.getType(), ValueRange({witnessCin, witnessFilterH, witnessFilterW}));
+        op.getLoc(), witnessCin.getType(), witnesses);
     auto assuming = rewriter.create<shape::AssumingOp>(
         op.getLoc(), ArrayRef<Type>{op.getType()}, assumingAll);
 
@@ -162,12 +320,68 @@ public:
     Value shape = bypassResultShapes(op, rewriter)[0];
     Value initTensor =
         rewriter.create<tcp::SplattedOp>(op.getLoc(), op.getType(), c0, shape);
+    MLIRContext *context = rewriter.getContext();
+    // The convolution accumulates into its init tensor, so start from the
+    // bias broadcast along the output channels rather than adding it after.
+    if (op.bias()) {
+      AffineMap channelMap =
+          AffineMap::get(4, 0, getAffineDimExpr(1, context), context);
+      initTensor =
+          rewriter
+              .create<linalg::GenericOp>(
+                  op.getLoc(), TypeRange(op.getType()), ValueRange(op.bias()),
+                  ValueRange(initTensor),
+                  ArrayRef<AffineMap>(
+                      {channelMap, rewriter.getMultiDimIdentityMap(4)}),
+                  SmallVector<StringRef, 4>(4, getParallelIteratorTypeName()),
+                  [](OpBuilder &b, Location loc, ValueRange args) {
+                    b.create<linalg::YieldOp>(loc, args[0]);
+                  })
+              .getResult(0);
+    }
+    Value input = op.in();
+    if (padding[0] != 0 || padding[1] != 0)
+      input = padSpatialDims(rewriter, op.getLoc(), input, padding,
+                             APFloat(0.0f));
 
-    // Create the ConvNCHW.
-    auto conv2dNCHW = rewriter.create<linalg::ConvNCHWOp>(
-        op.getLoc(), TypeRange(op.getType()),
-        ValueRange({op.in(), op.filter()}), ValueRange(initTensor));
-    rewriter.create<shape::AssumingYieldOp>(op.getLoc(), conv2dNCHW.getResults());
+    Value result;
+    if (llvm::all_of(strides, [](int64_t v) { return v == 1; }) &&
+        llvm::all_of(dilations, [](int64_t v) { return v == 1; })) {
+      // Create the ConvNCHW.
+      auto conv2dNCHW = rewriter.create<linalg::ConvNCHWOp>(
+          op.getLoc(), TypeRange(op.getType()),
+          ValueRange({input, op.filter()}), ValueRange(initTensor));
+      result = conv2dNCHW.getResult(0);
+    } else {
+      // linalg.conv_2d_nchw has no strides/dilations, so spell the
+      // convolution out as a generic op over
+      // (n, f, oh, ow) x (c, kh, kw).
+      AffineExpr n, f, oh, ow, c, kh, kw;
+      bindDims(context, n, f, oh, ow, c, kh, kw);
+      AffineMap inputMap = AffineMap::get(
+          7, 0,
+          {n, c, oh * strides[0] + kh * dilations[0],
+           ow * strides[1] + kw * dilations[1]},
+          context);
+      AffineMap filterMap = AffineMap::get(7, 0, {f, c, kh, kw}, context);
+      AffineMap outputMap = AffineMap::get(7, 0, {n, f, oh, ow}, context);
+      SmallVector<StringRef, 7> iterators(4, getParallelIteratorTypeName());
+      iterators.append(3, getReductionIteratorTypeName());
+      result = rewriter
+                   .create<linalg::GenericOp>(
+                       op.getLoc(), TypeRange(op.getType()),
+                       ValueRange({input, op.filter()}), ValueRange(initTensor),
+                       ArrayRef<AffineMap>({inputMap, filterMap, outputMap}),
+                       iterators,
+                       [](OpBuilder &b, Location loc, ValueRange args) {
+                         Value product =
+                             b.create<MulFOp>(loc, args[0], args[1]);
+                         Value sum = b.create<AddFOp>(loc, args[2], product);
+                         b.create<linalg::YieldOp>(loc, sum);
+                       })
+                   .getResult(0);
+    }
+    rewriter.create<shape::AssumingYieldOp>(op.getLoc(), result);
 
     // Finally, replace with the results of the shape.assuming
     rewriter.replaceOp(op, assuming.getResults());
@@ -176,12 +390,447 @@ public:
 };
 } // namespace
 
+namespace {
+class ConvertMaxPoolNCHW : public OpRewritePattern<tcf::MaxPoolNCHWOp> {
+public:
+  using OpRewritePattern::OpRewritePattern;
+  LogicalResult matchAndRewrite(tcf::MaxPoolNCHWOp op,
+                                PatternRewriter &rewriter) const override {
+    auto kernelSize = getHWPair(op.kernel_size(), 1);
+    auto strides = getHWPair(op.strides(), 1);
+    auto dilations = getHWPair(op.dilations(), 1);
+    auto padding = getHWPair(op.padding(), 0);
+    if (kernelSize.empty() || strides.empty() || dilations.empty() ||
+        padding.empty())
+      return rewriter.notifyMatchFailure(
+          op, "expected [height, width] kernel_size/strides/dilations/padding");
+    Location loc = op.getLoc();
+
+    // Create the constraints, and the assuming region.
+    SmallVector<Value, 2> witnesses;
+    for (int i = 0; i < 2; i++) {
+      Value paddedExtent = rewriter.create<AddIOp>(
+          loc, rewriter.create<DimOp>(loc, op.in(), 2 + i),
+          createIndexConstant(rewriter, loc, 2 * padding[i]));
+      Value window = createIndexConstant(
+          rewriter, loc, dilations[i] * (kernelSize[i] - 1) + 1);
+      Value fits = rewriter.create<CmpIOp>(loc, CmpIPredicate::uge,
+                                           paddedExtent, window);
+      witnesses.push_back(rewriter.create<shape::CstrRequireOp>(
+          loc, fits,
+          i == 0 ? "input height must be greater than or equal to the pooling "
+                   "window height"
+                 : "input width must be greater than or equal to the pooling "
+                   "window width"));
+    }
+    Value assumingAll = rewriter.create<shape::AssumingAllOp>(
+        loc, witnesses[0].getType(), witnesses);
+    auto assuming = rewriter.create<shape::AssumingOp>(
+        loc, ArrayRef<Type>{op.getType()}, assumingAll);
+
+    // Build the region body.
+    rewriter.createBlock(&assuming.doRegion());
+    APFloat negativeInfinity =
+        APFloat::getInf(APFloat::IEEEsingle(), /*Negative=*/true);
+    Value shape = bypassResultShapes(op, rewriter)[0];
+    Value negativeInfinityVal = rewriter.create<ConstantOp>(
+        loc, rewriter.getF32FloatAttr(negativeInfinity.convertToFloat()));
+    Value initTensor = rewriter.create<tcp::SplattedOp>(
+        loc, op.getType(), negativeInfinityVal, shape);
+    Value input = op.in();
+    if (padding[0] != 0 || padding[1] != 0)
+      input = padSpatialDims(rewriter, loc, input, padding, negativeInfinity);
+    // The window dimensions only appear in compound index expressions of the
+    // input, so give linalg an operand of the window's shape to derive their
+    // loop bounds from.
+    auto windowType = RankedTensorType::get({kernelSize[0], kernelSize[1]},
+                                            rewriter.getF32Type());
+    Attribute zero = rewriter.getF32FloatAttr(0.0);
+    Value window = rewriter.create<ConstantOp>(
+        loc, DenseElementsAttr::get(windowType, zero));
+
+    MLIRContext *context = rewriter.getContext();
+    AffineExpr n, c, oh, ow, kh, kw;
+    bindDims(context, n, c, oh, ow, kh, kw);
+    AffineMap inputMap = AffineMap::get(
+        6, 0,
+        {n, c, oh * strides[0] + kh * dilations[0],
+         ow * strides[1] + kw * dilations[1]},
+        context);
+    AffineMap windowMap = AffineMap::get(6, 0, {kh, kw}, context);
+    AffineMap outputMap = AffineMap::get(6, 0, {n, c, oh, ow}, context);
+    SmallVector<StringRef, 6> iterators(4, getParallelIteratorTypeName());
+    iterators.append(2, getReductionIteratorTypeName());
+    auto maxPool = rewriter.create<linalg::GenericOp>(
+        loc, TypeRange(op.getType()), ValueRange({input, window}),
+        ValueRange(initTensor),
+        ArrayRef<AffineMap>({inputMap, windowMap, outputMap}), iterators,
+        [](OpBuilder &b, Location loc, ValueRange args) {
+          // Take the element if it is greater or NaN, so that a NaN in the
+          // window propagates as in PyTorch. Once the accumulator is NaN,
+          // no comparison with it is true and it stays NaN.
+          Value greater =
+              b.create<CmpFOp>(loc, CmpFPredicate::OGT, args[0], args[2]);
+          Value isNaN =
+              b.create<CmpFOp>(loc, CmpFPredicate::UNO, args[0], args[0]);
+          Value takeElement = b.create<OrOp>(loc, greater, isNaN);
+          Value max = b.create<SelectOp>(loc, takeElement, args[0], args[2]);
+          b.create<linalg::YieldOp>(loc, max);
+        });
+    rewriter.create<shape::AssumingYieldOp>(loc, maxPool.getResult(0));
+
+    rewriter.replaceOp(op, assuming.getResults());
+    return success();
+  }
+};
+} // namespace
+
+namespace {
+class ConvertClamp : public OpRewritePattern<tcf::ClampOp> {
+public:
+  using OpRewritePattern::OpRewritePattern;
+  LogicalResult matchAndRewrite(tcf::ClampOp op,
+                                PatternRewriter &rewriter) const override {
+    if (!op.getType().isa<RankedTensorType>())
+      return rewriter.notifyMatchFailure(op, "expected ranked tensor");
+    FloatAttr minAttr = op.minAttr();
+    FloatAttr maxAttr = op.maxAttr();
+    Value result = createElementwiseGeneric(
+        rewriter, op.getLoc(), op.operand(),
+        [&](OpBuilder &b, Location loc, Value element) {
+          Type elementType = element.getType();
+          if (minAttr) {
+            Value min = b.create<ConstantOp>(
+                loc, b.getFloatAttr(elementType, minAttr.getValueAsDouble()));
+            Value less =
+                b.create<CmpFOp>(loc, CmpFPredicate::OLT, element, min);
+            element = b.create<SelectOp>(loc, less, min, element);
+          }
+          if (maxAttr) {
+            Value max = b.create<ConstantOp>(
+                loc, b.getFloatAttr(elementType, maxAttr.getValueAsDouble()));
+            Value greater =
+                b.create<CmpFOp>(loc, CmpFPredicate::OGT, element, max);
+            element = b.create<SelectOp>(loc, greater, max, element);
+          }
+          return element;
+        });
+    rewriter.replaceOp(op, result);
+    return success();
+  }
+};
+} // namespace
+
+namespace {
+class ConvertSigmoid : public OpRewritePattern<tcf::SigmoidOp> {
+public:
+  using OpRewritePattern::OpRewritePattern;
+  LogicalResult matchAndRewrite(tcf::SigmoidOp op,
+                                PatternRewriter &rewriter) const override {
+    if (!op.getType().isa<RankedTensorType>())
+      return rewriter.notifyMatchFailure(op, "expected ranked tensor");
+    Value result = createElementwiseGeneric(
+        rewriter, op.getLoc(), op.operand(),
+        [](OpBuilder &b, Location loc, Value element) -> Value {
+          Value one =
+              b.create<ConstantOp>(loc, b.getFloatAttr(element.getType(), 1.0));
+          Value negated = b.create<NegFOp>(loc, element);
+          Value exp = b.create<math::ExpOp>(loc, negated);
+          Value denominator = b.create<AddFOp>(loc, one, exp);
+          return b.create<DivFOp>(loc, one, denominator);
+        });
+    rewriter.replaceOp(op, result);
+    return success();
+  }
+};
+} // namespace
+
+namespace {
+// Lowers tcf.sum and tcf.mean. The reduction itself produces a tensor
+// without the reduced dimensions; a second, purely parallel op then divides
+// by the element count (for means) and/or reinserts the unit dimensions (for
+// keep_dims).
+template <typename SourceOp>
+class ConvertReduction : public OpRewritePattern<SourceOp> {
+public:
+  using OpRewritePattern<SourceOp>::OpRewritePattern;
+  LogicalResult matchAndRewrite(SourceOp op,
+                                PatternRewriter &rewriter) const override {
+    constexpr bool isMean = std::is_same<SourceOp, tcf::MeanOp>::value;
+    Location loc = op.getLoc();
+    MLIRContext *context = rewriter.getContext();
+    auto inputType = op.operand().getType().template cast<RankedTensorType>();
+    auto resultType = op.getType().template cast<RankedTensorType>();
+    int64_t rank = inputType.getRank();
+    SmallVector<bool, 6> isReduced(rank, false);
+    for (Attribute axis : op.axes()) {
+      int64_t axisValue = axis.cast<IntegerAttr>().getInt();
+      if (axisValue < 0 || axisValue >= rank)
+        return rewriter.notifyMatchFailure(op, "axis out of range");
+      isReduced[axisValue] = true;
+    }
+
+    SmallVector<Value, 6> extents = getExtents(rewriter, loc, op.operand());
+    SmallVector<Value, 6> reducedExtents;
+    SmallVector<int64_t, 6> reducedShape;
+    SmallVector<AffineExpr, 6> reducedExprs;
+    SmallVector<StringRef, 6> iterators;
+    for (int64_t i = 0; i < rank; i++) {
+      if (isReduced[i]) {
+        iterators.push_back(getReductionIteratorTypeName());
+        continue;
+      }
+      iterators.push_back(getParallelIteratorTypeName());
+      reducedExtents.push_back(extents[i]);
+      reducedShape.push_back(inputType.getDimSize(i));
+      reducedExprs.push_back(getAffineDimExpr(i, context));
+    }
+    bool needsFinalize = isMean || op.keep_dims();
+    Type reducedType =
+        needsFinalize
+            ? RankedTensorType::get(reducedShape, inputType.getElementType())
+            : op.getType();
+    AffineMap reducedMap = AffineMap::get(rank, 0, reducedExprs, context);
+    Value init =
+        createSplatted(rewriter, loc, reducedType, 0.0, reducedExtents);
+    Value reduced =
+        rewriter
+            .create<linalg::GenericOp>(
+                loc, TypeRange(reducedType), ValueRange(op.operand()),
+                ValueRange(init),
+                ArrayRef<AffineMap>(
+                    {rewriter.getMultiDimIdentityMap(rank), reducedMap}),
+                iterators,
+                [](OpBuilder &b, Location loc, ValueRange args) {
+                  Value sum = b.create<AddFOp>(loc, args[1], args[0]);
+                  b.create<linalg::YieldOp>(loc, sum);
+                })
+            .getResult(0);
+    if (!needsFinalize) {
+      rewriter.replaceOp(op, reduced);
+      return success();
+    }
+
+    Value count;
+    if (isMean) {
+      Value numElements = createIndexConstant(rewriter, loc, 1);
+      for (int64_t i = 0; i < rank; i++)
+        if (isReduced[i])
+          numElements = rewriter.create<MulIOp>(loc, numElements, extents[i]);
+      Value numElementsI64 = rewriter.create<IndexCastOp>(
+          loc, numElements, rewriter.getIntegerType(64));
+      count = rewriter.create<SIToFPOp>(loc, numElementsI64,
+                                        inputType.getElementType());
+    }
+    SmallVector<Value, 6> resultExtents;
+    AffineMap inputMap;
+    if (op.keep_dims()) {
+      Value c1 = createIndexConstant(rewriter, loc, 1);
+      for (int64_t i = 0; i < rank; i++)
+        resultExtents.push_back(isReduced[i] ? c1 : extents[i]);
+      inputMap = reducedMap;
+    } else {
+      resultExtents = reducedExtents;
+      inputMap = rewriter.getMultiDimIdentityMap(reducedExtents.size());
+    }
+    Value resultInit =
+        createSplatted(rewriter, loc, resultType, 0.0, resultExtents);
+    auto finalize = rewriter.create<linalg::GenericOp>(
+        loc, TypeRange(resultType), ValueRange(reduced), ValueRange(resultInit),
+        ArrayRef<AffineMap>(
+            {inputMap, rewriter.getMultiDimIdentityMap(resultType.getRank())}),
+        SmallVector<StringRef, 6>(resultType.getRank(),
+                                  getParallelIteratorTypeName()),
+        [&](OpBuilder &b, Location loc, ValueRange args) {
+          Value element = args[0];
+          if (count)
+            element = b.create<DivFOp>(loc, element, count);
+          b.create<linalg::YieldOp>(loc, element);
+        });
+    rewriter.replaceOp(op, finalize.getResults());
+    return success();
+  }
+};
+} // namespace
+
+namespace {
+class ConvertLogSoftmax : public OpRewritePattern<tcf::LogSoftmaxOp> {
+public:
+  using OpRewritePattern::OpRewritePattern;
+  LogicalResult matchAndRewrite(tcf::LogSoftmaxOp op,
+                                PatternRewriter &rewriter) const override {
+    Location loc = op.getLoc();
+    MLIRContext *context = rewriter.getContext();
+    auto type = op.getType().cast<RankedTensorType>();
+    int64_t rank = type.getRank();
+    int64_t axis = op.axisAttr().getInt();
+    if (axis < 0 || axis >= rank)
+      return rewriter.notifyMatchFailure(op, "axis out of range");
+
+    SmallVector<Value, 6> extents = getExtents(rewriter, loc, op.operand());
+    SmallVector<Value, 6> reducedExtents;
+    SmallVector<int64_t, 6> reducedShape;
+    SmallVector<AffineExpr, 6> reducedExprs;
+    SmallVector<StringRef, 6> reductionIterators;
+    for (int64_t i = 0; i < rank; i++) {
+      if (i == axis) {
+        reductionIterators.push_back(getReductionIteratorTypeName());
+        continue;
+      }
+      reductionIterators.push_back(getParallelIteratorTypeName());
+      reducedExtents.push_back(extents[i]);
+      reducedShape.push_back(type.getDimSize(i));
+      reducedExprs.push_back(getAffineDimExpr(i, context));
+    }
+    auto reducedType =
+        RankedTensorType::get(reducedShape, type.getElementType());
+    AffineMap identity = rewriter.getMultiDimIdentityMap(rank);
+    AffineMap reducedMap = AffineMap::get(rank, 0, reducedExprs, context);
+
+    // m = max(x, axis)
+    Value maxInit = createSplatted(
+        rewriter, loc, reducedType,
+        APFloat::getInf(APFloat::IEEEsingle(), /*Negative=*/true),
+        reducedExtents);
+    Value max = rewriter
+                    .create<linalg::GenericOp>(
+                        loc, TypeRange(reducedType), ValueRange(op.operand()),
+                        ValueRange(maxInit),
+                        ArrayRef<AffineMap>({identity, reducedMap}),
+                        reductionIterators,
+                        [](OpBuilder &b, Location loc, ValueRange args) {
+                          Value greater = b.create<CmpFOp>(
+                              loc, CmpFPredicate::OGT, args[0], args[1]);
+                          Value max = b.create<SelectOp>(loc, greater, args[0],
+                                                         args[1]);
+                          b.create<linalg::YieldOp>(loc, max);
+                        })
+                    .getResult(0);
+    // s = sum(exp(x - m), axis)
+    Value sumInit =
+        createSplatted(rewriter, loc, reducedType, 0.0, reducedExtents);
+    Value sum =
+        rewriter
+            .create<linalg::GenericOp>(
+                loc, TypeRange(reducedType), ValueRange({op.operand(), max}),
+                ValueRange(sumInit),
+                ArrayRef<AffineMap>({identity, reducedMap, reducedMap}),
+                reductionIterators,
+                [](OpBuilder &b, Location loc, ValueRange args) {
+                  Value shifted = b.create<SubFOp>(loc, args[0], args[1]);
+                  Value exp = b.create<math::ExpOp>(loc, shifted);
+                  Value sum = b.create<AddFOp>(loc, args[2], exp);
+                  b.create<linalg::YieldOp>(loc, sum);
+                })
+            .getResult(0);
+    // result = x - m - log(s)
+    Value init = createSplatted(rewriter, loc, type, 0.0, extents);
+    auto logSoftmax = rewriter.create<linalg::GenericOp>(
+        loc, TypeRange(type), ValueRange({op.operand(), max, sum}),
+        ValueRange(init),
+        ArrayRef<AffineMap>({identity, reducedMap, reducedMap, identity}),
+        SmallVector<StringRef, 6>(rank, getParallelIteratorTypeName()),
+        [](OpBuilder &b, Location loc, ValueRange args) {
+          Value shifted = b.create<SubFOp>(loc, args[0], args[1]);
+          Value logSum = b.create<math::LogOp>(loc, args[2]);
+          Value result = b.create<SubFOp>(loc, shifted, logSum);
+          b.create<linalg::YieldOp>(loc, result);
+        });
+    rewriter.replaceOp(op, logSoftmax.getResults());
+    return success();
+  }
+};
+} // namespace
+
+namespace {
+class ConvertBatchNormInference
+    : public OpRewritePattern<tcf::BatchNormInferenceOp> {
+public:
+  using OpRewritePattern::OpRewritePattern;
+  LogicalResult matchAndRewrite(tcf::BatchNormInferenceOp op,
+                                PatternRewriter &rewriter) const override {
+    Location loc = op.getLoc();
+    MLIRContext *context = rewriter.getContext();
+    auto type = op.getType().cast<RankedTensorType>();
+    int64_t rank = type.getRank();
+    if (rank < 2)
+      return rewriter.notifyMatchFailure(op, "expected a channel dimension");
+
+    // Create the constraints, and the assuming region.
+    Value channels = rewriter.create<DimOp>(loc, op.in(), 1);
+    SmallVector<Value, 4> witnesses;
+    for (Value param : {op.scale(), op.offset(), op.mean(), op.variance()}) {
+      Value size = rewriter.create<DimOp>(loc, param, 0);
+      Value matching =
+          rewriter.create<CmpIOp>(loc, CmpIPredicate::eq, size, channels);
+      witnesses.push_back(rewriter.create<shape::CstrRequireOp>(
+          loc, matching,
+          "batch norm parameters must have one element per channel"));
+    }
+    Value assumingAll = rewriter.create<shape::AssumingAllOp>(
+        loc, witnesses[0].getType(), witnesses);
+    auto assuming = rewriter.create<shape::AssumingOp>(
+        loc, ArrayRef<Type>{op.getType()}, assumingAll);
+    rewriter.createBlock(&assuming.doRegion());
+
+    // Fold the statistics into a per-channel multiplier and shift first, so
+    // the per-element work is a single multiply-add:
+    //   multiplier = scale / sqrt(variance + epsilon)
+    //   shift = offset - mean * multiplier
+    auto paramType = op.scale().getType();
+    Value paramInit = createSplatted(rewriter, loc, paramType, 0.0, channels);
+    AffineMap paramIdentity = rewriter.getMultiDimIdentityMap(1);
+    double epsilon = op.epsilon().convertToDouble();
+    auto params = rewriter.create<linalg::GenericOp>(
+        loc, TypeRange({paramType, paramType}),
+        ValueRange({op.scale(), op.offset(), op.mean(), op.variance()}),
+        ValueRange({paramInit, paramInit}),
+        SmallVector<AffineMap, 6>(6, paramIdentity),
+        SmallVector<StringRef, 1>(1, getParallelIteratorTypeName()),
+        [&](OpBuilder &b, Location loc, ValueRange args) {
+          Value scale = args[0], offset = args[1], mean = args[2],
+                variance = args[3];
+          Value epsilonVal = b.create<ConstantOp>(
+              loc, b.getFloatAttr(variance.getType(), epsilon));
+          Value invStd = b.create<math::RsqrtOp>(
+              loc, b.create<AddFOp>(loc, variance, epsilonVal));
+          Value multiplier = b.create<MulFOp>(loc, scale, invStd);
+          Value shift = b.create<SubFOp>(
+              loc, offset, b.create<MulFOp>(loc, mean, multiplier));
+          b.create<linalg::YieldOp>(loc, ValueRange({multiplier, shift}));
+        });
+
+    Value init = createSplatted(rewriter, loc, type, 0.0,
+                                getExtents(rewriter, loc, op.in()));
+    AffineMap identity = rewriter.getMultiDimIdentityMap(rank);
+    AffineMap channelMap =
+        AffineMap::get(rank, 0, getAffineDimExpr(1, context), context);
+    auto batchNorm = rewriter.create<linalg::GenericOp>(
+        loc, TypeRange(type),
+        ValueRange({op.in(), params.getResult(0), params.getResult(1)}),
+        ValueRange(init),
+        ArrayRef<AffineMap>({identity, channelMap, channelMap, identity}),
+        SmallVector<StringRef, 6>(rank, getParallelIteratorTypeName()),
+        [](OpBuilder &b, Location loc, ValueRange args) {
+          Value scaled = b.create<MulFOp>(loc, args[0], args[1]);
+          Value result = b.create<AddFOp>(loc, scaled, args[2]);
+          b.create<linalg::YieldOp>(loc, result);
+        });
+    rewriter.create<shape::AssumingYieldOp>(loc, batchNorm.getResult(0));
+
+    rewriter.replaceOp(op, assuming.getResults());
+    return success();
+  }
+};
+} // namespace
+
 namespace {
 class ConvertTCFToLinalg : public ConvertTCFToLinalgBase<ConvertTCFToLinalg> {
 public:
   void getDependentDialects(DialectRegistry &registry) const override {
-    registry
-        .insert<shape::ShapeDialect, tcp::TCPDialect, tensor::TensorDialect>();
+    registry.insert<linalg::LinalgDialect, math::MathDialect,
+                    shape::ShapeDialect, tcp::TCPDialect,
+                    tensor::TensorDialect>();
   }
 
   void runOnOperation() override {
@@ -193,6 +842,12 @@ public:
     OwningRewritePatternList patterns;
     patterns.insert<ConvertMatmul>(context);
     patterns.insert<ConvertConvNCHW>(context);
+    patterns.insert<ConvertMaxPoolNCHW>(context);
+    patterns.insert<ConvertClamp, ConvertSigmoid>(context);
+    patterns.insert<ConvertReduction<tcf::SumOp>,
+                    ConvertReduction<tcf::MeanOp>>(context);
+    patterns.insert<ConvertLogSoftmax>(context);
+    patterns.insert<ConvertBatchNormInference>(context);
     return std::move(patterns);
   }
 };
@@ -13,11 +13,14 @@
 #include "mlir/Dialect/Shape/IR/Shape.h"
 #include "mlir/Dialect/StandardOps/IR/Ops.h"
 #include "mlir/Dialect/Traits.h"
+#include "mlir/IR/BlockAndValueMapping.h"
 #include "mlir/Transforms/DialectConversion.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
 #include "npcomp/Dialect/TCF/IR/TCFOps.h"
 #include "npcomp/Dialect/TCP/IR/TCPDialect.h"
 #include "npcomp/Dialect/TCP/IR/TCPOps.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/StringSwitch.h"
 
 using namespace mlir;
 using namespace mlir::NPCOMP;
@@ -27,6 +30,50 @@ static RankedTensorType getExtentTensorType(Builder &builder) {
                                builder.getIndexType());
 }
 
+static CmpFPredicate getCmpFPredicate(tcf::CompareOp op) {
+  return llvm::StringSwitch<CmpFPredicate>(op.predicate())
+      .Case("eq", CmpFPredicate::OEQ)
+      .Case("ne", CmpFPredicate::UNE)
+      .Case("lt", CmpFPredicate::OLT)
+      .Case("le", CmpFPredicate::OLE)
+      .Case("gt", CmpFPredicate::OGT)
+      .Case("ge", CmpFPredicate::OGE);
+}
+
+// Creates the std op computing `op` on operands that have already been
+// broadcast to the same shape.
+static Value createBinaryElementwiseOp(Operation *op, Type resultType,
+                                       Value lhs, Value rhs,
+                                       OpBuilder &rewriter) {
+  Location loc = op->getLoc();
+  if (isa<tcf::AddOp>(op))
+    return rewriter.create<AddFOp>(loc, resultType, lhs, rhs);
+  if (isa<tcf::SubOp>(op))
+    return rewriter.create<SubFOp>(loc, resultType, lhs, rhs);
+  if (isa<tcf::MulOp>(op))
+    return rewriter.create<MulFOp>(loc, resultType, lhs, rhs);
+  if (isa<tcf::DivOp>(op))
+    return rewriter.create<DivFOp>(loc, resultType, lhs, rhs);
+  if (isa<tcf::MaxOp>(op) || isa<tcf::MinOp>(op)) {
+    // XXX: remove TCP dep
+    // XXX: remove TCP ops from TCP
+    // Like numpy.maximum/minimum, a NaN in either operand is propagated. The
+    // ordered comparison is false if `rhs` is NaN, selecting it, and `lhs` is
+    // selected if it is NaN itself.
+    auto predicate =
+        isa<tcf::MaxOp>(op) ? CmpFPredicate::OGT : CmpFPredicate::OLT;
+    Value compare = rewriter.create<CmpFOp>(loc, predicate, lhs, rhs);
+    Value lhsIsNaN = rewriter.create<CmpFOp>(loc, CmpFPredicate::UNO, lhs, lhs);
+    Value pred = rewriter.create<OrOp>(loc, compare, lhsIsNaN);
+    return rewriter.create<SelectOp>(loc, pred, lhs, rhs);
+  }
+  if (auto compare = dyn_cast<tcf::CompareOp>(op))
+    return rewriter.create<CmpFOp>(loc, getCmpFPredicate(compare), lhs, rhs);
+  op->dump();
+  llvm::report_fatal_error(
+      "unhandled op (see dump above): TCF->Std binary elementwise");
+}
+
 // Non-templated version of the body of ConvertBinaryElementwise to keep things
 // simple.
 static LogicalResult
@@ -41,6 +88,17 @@ matchAndRewriteBinaryElementwise(Operation *op, PatternRewriter &rewriter) {
   if (!lhsType || !rhsType)
     return rewriter.notifyMatchFailure(op, "requires ranked tensors");
 
+  // Operands of the same static shape, or the same value, need no
+  // broadcasting and cannot fail, so emit the std op directly. Besides being
+  // less IR, this keeps chains of elementwise ops free of shape.assuming
+  // regions, so that they fuse into a single linalg.generic once converted to
+  // linalg. Dynamically shaped chains are handled by fuseElementwiseChain.
+  if (lhs == rhs || (lhsType == rhsType && lhsType.hasStaticShape())) {
+    rewriter.replaceOp(op, createBinaryElementwiseOp(op, result.getType(), lhs,
+                                                     rhs, rewriter));
+    return success();
+  }
+
   Value lhsShape = rewriter.create<shape::ShapeOfOp>(loc, lhs);
   Value rhsShape = rewriter.create<shape::ShapeOfOp>(loc, rhs);
 
@@ -68,25 +126,8 @@ matchAndRewriteBinaryElementwise(Operation *op, PatternRewriter &rewriter) {
       loc, resultType, lhs, broadcastedShape);
   Value rhsBroadcasted = rewriter.create<tcp::BroadcastToOp>(
       loc, resultType, rhs, broadcastedShape);
-  Value binaryOpResult;
-  if (isa<tcf::AddOp>(op)) {
-    binaryOpResult = rewriter.create<AddFOp>(loc, result.getType(),
-                                             lhsBroadcasted, rhsBroadcasted);
-  } else if (isa<tcf::MaxOp>(op)) {
-    // XXX: remove TCP dep
-    // XXX: remove TCP ops from TCP
-    auto pred = rewriter.create<CmpFOp>(loc, CmpFPredicate::OGT, lhsBroadcasted,
-                                        rhsBroadcasted);
-    binaryOpResult =
-        rewriter.create<SelectOp>(loc, pred, lhsBroadcasted, rhsBroadcasted);
-  } else if (isa<tcf::MulOp>(op)) {
-    binaryOpResult = rewriter.create<MulFOp>(loc, result.getType(),
-                                             lhsBroadcasted, rhsBroadcasted);
-  } else {
-    op->dump();
-    llvm::report_fatal_error(
-        "unhandled op (see dump above): TCF->Std binary elementwise");
-  }
+  Value binaryOpResult = createBinaryElementwiseOp(
+      op, result.getType(), lhsBroadcasted, rhsBroadcasted, rewriter);
   rewriter.create<shape::AssumingYieldOp>(loc, binaryOpResult);
 
   // Finally, replace with the results of the shape.assuming
@@ -106,17 +147,26 @@ public:
 };
 } // namespace
 
+static Value createUnaryElementwiseOp(Operation *op, Value operand,
+                                      OpBuilder &rewriter) {
+  Location loc = op->getLoc();
+  if (isa<tcf::ExpOp>(op))
+    return rewriter.create<math::ExpOp>(loc, operand);
+  if (isa<tcf::TanhOp>(op))
+    return rewriter.create<math::TanhOp>(loc, operand);
+  if (isa<tcf::LogOp>(op))
+    return rewriter.create<math::LogOp>(loc, operand);
+  if (isa<tcf::SqrtOp>(op))
+    return rewriter.create<math::SqrtOp>(loc, operand);
+  op->dump();
+  llvm::report_fatal_error(
+      "unhandled op (see dump above): TCF->TCP unary elementwise");
+}
+
 static LogicalResult
 matchAndRewriteUnaryElementwise(Operation *op, PatternRewriter &rewriter) {
-  if (isa<tcf::ExpOp>(op)) {
-    rewriter.replaceOpWithNewOp<math::ExpOp>(op, op->getOperand(0));
-  } else if (isa<tcf::TanhOp>(op)) {
-    rewriter.replaceOpWithNewOp<math::TanhOp>(op, op->getOperand(0));
-  } else {
-    op->dump();
-    llvm::report_fatal_error(
-        "unhandled op (see dump above): TCF->TCP unary elementwise");
-  }
+  rewriter.replaceOp(
+      op, createUnaryElementwiseOp(op, op->getOperand(0), rewriter));
   return success();
 }
 
@@ -132,6 +182,136 @@ public:
 };
 } // namespace
 
+//===----------------------------------------------------------------------===//
+// Fusion of dynamically shaped elementwise chains
+//===----------------------------------------------------------------------===//
+
+// Converted one at a time, each binary op on dynamically shaped operands gets
+// its own broadcast check and shape.assuming region, and the region
+// boundaries keep the ops from fusing. Instead, a chain of elementwise ops on
+// operands of the same type is converted as a whole: the operands coming from
+// outside the chain (its leaves) are checked and broadcast to their common
+// shape once, and the chain is computed on them in a single shape.assuming
+// region. This is equivalent because elementwise ops commute with
+// broadcasting.
+
+// Returns the type of the operands of `op` if it is an elementwise TCF op
+// whose operands all have the same ranked type, or null.
+static RankedTensorType getChainOperandType(Operation *op) {
+  if (!isa<tcf::AddOp, tcf::SubOp, tcf::MulOp, tcf::DivOp, tcf::MaxOp,
+           tcf::MinOp, tcf::CompareOp, tcf::ExpOp, tcf::TanhOp, tcf::LogOp,
+           tcf::SqrtOp>(op))
+    return nullptr;
+  auto type = op->getOperand(0).getType().dyn_cast<RankedTensorType>();
+  if (!type || llvm::any_of(op->getOperandTypes(), [&](Type operandType) {
+        return operandType != type;
+      }))
+    return nullptr;
+  return type;
+}
+
+// Returns the op computing `operand` of the chain op `user` if it belongs to
+// the same chain, that is, if its result is used only by `user`.
+static Operation *getChainProducer(Value operand, Operation *user) {
+  Operation *producer = operand.getDefiningOp();
+  if (!producer || !operand.hasOneUse() ||
+      producer->getBlock() != user->getBlock() ||
+      getChainOperandType(producer) != operand.getType())
+    return nullptr;
+  return producer;
+}
+
+static bool isChainRoot(Operation *op) {
+  if (!getChainOperandType(op))
+    return false;
+  Value result = op->getResult(0);
+  if (!result.hasOneUse())
+    return true;
+  Operation *user = *result.getUsers().begin();
+  return !getChainOperandType(user) || !getChainProducer(result, user);
+}
+
+// Collects the ops of the chain ending at `op`, producers first, and the
+// values they use from outside the chain.
+static void collectChain(Operation *op, SmallVectorImpl<Operation *> &ops,
+                         llvm::SetVector<Value> &leaves) {
+  for (Value operand : op->getOperands()) {
+    if (Operation *producer = getChainProducer(operand, op))
+      collectChain(producer, ops, leaves);
+    else
+      leaves.insert(operand);
+  }
+  ops.push_back(op);
+}
+
+static void fuseElementwiseChain(Operation *root) {
+  RankedTensorType type = getChainOperandType(root);
+  SmallVector<Operation *, 8> ops;
+  llvm::SetVector<Value> leaves;
+  collectChain(root, ops, leaves);
+  // Statically shaped ops are emitted without a check by the patterns, and a
+  // chain of unary ops needs no broadcasting.
+  if (type.hasStaticShape() || ops.size() < 2 ||
+      llvm::none_of(ops,
+                    [](Operation *op) { return op->getNumOperands() == 2; }))
+    return;
+
+  OpBuilder builder(root);
+  Location loc = root->getLoc();
+  Value result = root->getResult(0);
+  BlockAndValueMapping mapping;
+  shape::AssumingOp assuming;
+  if (leaves.size() > 1) {
+    SmallVector<Value, 4> shapes;
+    for (Value leaf : leaves)
+      shapes.push_back(builder.create<shape::ShapeOfOp>(loc, leaf));
+    // The shapes are broadcastable together exactly when every pair of them
+    // is.
+    SmallVector<Value, 6> witnesses;
+    for (int i = 0, e = shapes.size(); i < e; i++)
+      for (int j = i + 1; j < e; j++)
+        witnesses.push_back(builder.create<shape::CstrBroadcastableOp>(
+            loc, shapes[i], shapes[j]));
+    Value assumingAll = builder.create<shape::AssumingAllOp>(
+        loc, witnesses[0].getType(), witnesses);
+    assuming = builder.create<shape::AssumingOp>(
+        loc, ArrayRef<Type>{result.getType()}, assumingAll);
+
+    builder.createBlock(&assuming.doRegion());
+    Value broadcastedShape = shapes[0];
+    for (Value shape : llvm::drop_begin(shapes, 1))
+      broadcastedShape = builder.create<shape::BroadcastOp>(
+          loc, getExtentTensorType(builder), broadcastedShape, shape,
+          /*error=*/nullptr);
+    // All leaves have type `type`, so that is also their broadcasted type.
+    for (Value leaf : leaves)
+      mapping.map(leaf, builder.create<tcp::BroadcastToOp>(loc, type, leaf,
+                                                           broadcastedShape));
+  }
+
+  for (Operation *op : ops) {
+    Value newResult;
+    if (op->getNumOperands() == 2)
+      newResult = createBinaryElementwiseOp(
+          op, op->getResult(0).getType(),
+          mapping.lookupOrDefault(op->getOperand(0)),
+          mapping.lookupOrDefault(op->getOperand(1)), builder);
+    else
+      newResult = createUnaryElementwiseOp(
+          op, mapping.lookupOrDefault(op->getOperand(0)), builder);
+    mapping.map(op->getResult(0), newResult);
+  }
+
+  Value fused = mapping.lookup(result);
+  if (assuming) {
+    builder.create<shape::AssumingYieldOp>(loc, fused);
+    fused = assuming.getResult(0);
+  }
+  result.replaceAllUsesWith(fused);
+  for (Operation *op : llvm::reverse(ops))
+    op->erase();
+}
+
 namespace {
 class ConvertTCFToStd : public ConvertTCFToStdBase<ConvertTCFToStd> {
 public:
@@ -140,6 +320,13 @@ public:
   }
 
   void runOnOperation() override {
+    SmallVector<Operation *, 8> roots;
+    getOperation().walk([&](Operation *op) {
+      if (isChainRoot(op))
+        roots.push_back(op);
+    });
+    for (Operation *root : roots)
+      fuseElementwiseChain(root);
     (void)applyPatternsAndFoldGreedily(getOperation(), getPatterns());
   }
 
@@ -147,10 +334,16 @@ public:
     MLIRContext *context = &getContext();
     OwningRewritePatternList patterns;
     patterns.insert<ConvertUnaryElementwise<tcf::ExpOp>,
-                    ConvertUnaryElementwise<tcf::TanhOp>>(context);
+                    ConvertUnaryElementwise<tcf::TanhOp>,
+                    ConvertUnaryElementwise<tcf::LogOp>,
+                    ConvertUnaryElementwise<tcf::SqrtOp>>(context);
     patterns.insert<ConvertBinaryElementwise<tcf::AddOp>,
+                    ConvertBinaryElementwise<tcf::SubOp>,
+                    ConvertBinaryElementwise<tcf::MulOp>,
+                    ConvertBinaryElementwise<tcf::DivOp>,
                     ConvertBinaryElementwise<tcf::MaxOp>,
-                    ConvertBinaryElementwise<tcf::MulOp>>(context);
+                    ConvertBinaryElementwise<tcf::MinOp>,
+                    ConvertBinaryElementwise<tcf::CompareOp>>(context);
     return std::move(patterns);
   }
 };
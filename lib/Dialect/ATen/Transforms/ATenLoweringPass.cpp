@@ -9,6 +9,7 @@
 #include "PassDetail.h"
 
 #include "npcomp/Dialect/ATen/IR/ATenDialect.h"
+#include "npcomp/Dialect/Basicpy/IR/BasicpyDialect.h"
 #include "npcomp/Dialect/ATen/Transforms/ATenToStd.h"
 #include "npcomp/Dialect/ATen/Transforms/Passes.h"
 
@@ -34,6 +35,7 @@
 
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringSwitch.h"
 #include "llvm/IR/DerivedTypes.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/Type.h"
@@ -69,13 +71,17 @@ static Value typeCast(PatternRewriter &builder, Value val, Type destTy) {
 }
 
 /// Given a MemRefType, return a new MemRefType with the same rank, but
-/// unknown shape.
+/// unknown shape and a fully dynamic strided layout. Library functions are
+/// declared with these types so that strided views (see the view lowerings
+/// below) can be passed to them as well as plain buffers. The descriptor seen
+/// through the C interface is the same for every layout.
 static MemRefType getShapeErasedMemRefType(MemRefType type) {
-  std::vector<int64_t> shape = type.getShape();
-  for (size_t i = 0, e = shape.size(); i < e; i++) {
-    shape[i] = -1;
-  }
-  return MemRefType::get(shape, type.getElementType(), type.getAffineMaps(),
+  int64_t dynamic = MemRefType::getDynamicStrideOrOffset();
+  SmallVector<int64_t, 4> shape(type.getRank(), -1);
+  SmallVector<int64_t, 4> strides(type.getRank(), dynamic);
+  AffineMap layout =
+      makeStridedLinearLayoutMap(strides, dynamic, type.getContext());
+  return MemRefType::get(shape, type.getElementType(), layout,
                          type.getMemorySpace());
 }
 
@@ -201,6 +207,10 @@ static FuncOp getATenFn(ModuleOp module, std::string mangledFunctionName,
   if (!fn) {
     fn = FuncOp::create(builder.getUnknownLoc(), mangledFunctionName, fnTy);
     fn.setVisibility(SymbolTable::Visibility::Private);
+    // Memref arguments are passed to the implementation as pointers to
+    // descriptors (see lib/RefBackend/ATenKernels), which gives the library a
+    // stable C ABI independent of how the descriptors get exploded.
+    fn->setAttr("llvm.emit_c_interface", builder.getUnitAttr());
     module.push_back(fn);
   }
 
@@ -276,6 +286,56 @@ public:
   }
 };
 
+// The C types of the scalar parameters of each library function (see
+// lib/RefBackend/ATenKernels/Kernels.cpp), in order: 'f' for float and 'i' for
+// int32_t. ATen `Scalar`s such as alpha and threshold are floats, as in ATen
+// itself. Unlisted functions, and parameters past the end of the list, take
+// int32_t.
+static StringRef getScalarParameterKinds(StringRef functionName) {
+  return llvm::StringSwitch<StringRef>(functionName)
+      .Case("add", "f")
+      .Case("addmm", "ff")
+      .Case("addmm_prepacked", "ff")
+      .Case("batch_norm", "iffi")
+      .Case("native_batch_norm", "iff")
+      .Case("conv2d_backward_update", "iiiiiiif")
+      .Case("mm_update", "f")
+      .Case("threshold_backward", "f")
+      .Default("");
+}
+
+// Converts a scalar operand to the i32 or f32 parameter type that the library
+// function declares, regardless of the type it was imported with, so that all
+// callers of a mangled name agree with its single C signature.
+static Value normalizeScalarOperand(PatternRewriter &builder, Value val,
+                                    bool toFloat) {
+  Location loc = val.getLoc();
+  Type type = val.getType();
+  Type i32 = builder.getIntegerType(32);
+  Type f32 = builder.getF32Type();
+  if (auto intTy = type.dyn_cast<IntegerType>()) {
+    if (intTy.getWidth() == 1)
+      val = builder.create<ZeroExtendIOp>(loc, val, i32);
+    else if (intTy.getWidth() < 32)
+      val = builder.create<SignExtendIOp>(loc, val, i32);
+    else if (intTy.getWidth() > 32 && !toFloat)
+      val = builder.create<TruncateIOp>(loc, val, i32);
+    if (toFloat)
+      val = builder.create<SIToFPOp>(loc, val, f32);
+    return val;
+  }
+  if (auto floatTy = type.dyn_cast<FloatType>()) {
+    if (!toFloat)
+      return builder.create<FPToSIOp>(loc, val, i32);
+    if (floatTy.getWidth() < 32)
+      return builder.create<FPExtOp>(loc, val, f32);
+    if (floatTy.getWidth() > 32)
+      return builder.create<FPTruncOp>(loc, val, f32);
+    return val;
+  }
+  return val;
+}
+
 // Replace the given operation with a call to the given function.
 // The function is assumed to accept memrefs and scalar types and return
 // Memrefs. Here the result types are converted back to the result types of op,
@@ -301,7 +361,19 @@ LogicalResult rewriteWithVoidFunctionCallExplicit(
       erasedOpTys.push_back(t);
   }
 
-  std::vector<Value> newOps = callops;
+  std::vector<Value> newOps;
+  StringRef scalarKinds = getScalarParameterKinds(functionName);
+  unsigned scalarIndex = 0;
+  for (Value o : callops) {
+    if (!o.getType().isIntOrFloat()) {
+      newOps.push_back(o);
+      continue;
+    }
+    bool toFloat =
+        scalarIndex < scalarKinds.size() && scalarKinds[scalarIndex] == 'f';
+    newOps.push_back(normalizeScalarOperand(rewriter, o, toFloat));
+    scalarIndex++;
+  }
   SmallVector<Value, 8> newResults;
 
   // Result types of the original operation, converted to memrefs.
@@ -361,6 +433,11 @@ LogicalResult rewriteWithFunctionCall(Operation *op, ArrayRef<Value> operands,
       callops.push_back(memRefTypeCast(rewriter, o));
     } else if (t.isa<IntegerType>() || t.isa<FloatType>()) {
       callops.push_back(o);
+    } else if (t.isa<Basicpy::NoneType>()) {
+      // An absent optional operand (e.g. `Tensor? weight`) is simply left out
+      // of the call. Since only memrefs are mangled, the function name still
+      // identifies which operands are present.
+      continue;
     } else if (t.isa<ATenListType>()) {
       // FIXME: lots of assumptions here.
       auto unpack = [](auto &op, auto &v) -> void {
@@ -381,6 +458,164 @@ LogicalResult rewriteWithFunctionCall(Operation *op, ArrayRef<Value> operands,
                                              functionName);
 }
 
+// The static shape, strides and offset of a memref.
+struct StaticStridedLayout {
+  SmallVector<int64_t, 4> sizes;
+  SmallVector<int64_t, 4> strides;
+  int64_t offset;
+};
+
+static Optional<StaticStridedLayout> getStaticStridedLayout(Value memref) {
+  auto type = memref.getType().dyn_cast<MemRefType>();
+  if (!type || !type.hasStaticShape())
+    return None;
+  StaticStridedLayout layout;
+  if (failed(getStridesAndOffset(type, layout.strides, layout.offset)))
+    return None;
+  if (ShapedType::isDynamicStrideOrOffset(layout.offset) ||
+      llvm::any_of(layout.strides, ShapedType::isDynamicStrideOrOffset))
+    return None;
+  layout.sizes.assign(type.getShape().begin(), type.getShape().end());
+  return layout;
+}
+
+// Compute the strides that let a tensor with the given sizes and strides be
+// viewed with `newSizes` without copying, following PyTorch's
+// `at::detail::computeStride`: runs of dimensions that are contiguous with
+// respect to each other (a "chunk") may be split and merged freely. Returns
+// None if the reshape needs a copy.
+static Optional<SmallVector<int64_t, 4>>
+computeReshapeStrides(ArrayRef<int64_t> sizes, ArrayRef<int64_t> strides,
+                      ArrayRef<int64_t> newSizes) {
+  SmallVector<int64_t, 4> newStrides(newSizes.size(), 1);
+  int64_t numElements = 1;
+  for (int64_t size : sizes)
+    numElements *= size;
+  if (sizes.empty() || numElements == 0) {
+    // Any strides will do; use the row-major ones.
+    int64_t stride = 1;
+    for (int64_t d = static_cast<int64_t>(newSizes.size()) - 1; d >= 0; d--) {
+      newStrides[d] = stride;
+      stride *= std::max<int64_t>(newSizes[d], 1);
+    }
+    return newStrides;
+  }
+
+  int64_t viewDim = static_cast<int64_t>(newSizes.size()) - 1;
+  int64_t chunkBaseStride = strides.back();
+  int64_t tensorElements = 1;
+  int64_t viewElements = 1;
+  for (int64_t d = static_cast<int64_t>(sizes.size()) - 1; d >= 0; d--) {
+    tensorElements *= sizes[d];
+    // At the start of the tensor, or at the boundary of a chunk, the view
+    // dimensions seen so far must exactly cover the chunk.
+    if (d == 0 || (sizes[d - 1] != 1 &&
+                   strides[d - 1] != tensorElements * chunkBaseStride)) {
+      while (viewDim >= 0 &&
+             (viewElements < tensorElements || newSizes[viewDim] == 1)) {
+        newStrides[viewDim] = viewElements * chunkBaseStride;
+        viewElements *= newSizes[viewDim];
+        viewDim--;
+      }
+      if (viewElements != tensorElements)
+        return None;
+      if (d > 0) {
+        chunkBaseStride = strides[d - 1];
+        tensorElements = 1;
+        viewElements = 1;
+      }
+    }
+  }
+  if (viewDim != -1)
+    return None;
+  return newStrides;
+}
+
+// Copy `source` into a new buffer with the identity layout.
+static Value createContiguousCopy(PatternRewriter &rewriter, Location loc,
+                                  Value source) {
+  auto sourceTy = source.getType().cast<MemRefType>();
+  auto resultTy =
+      MemRefType::get(sourceTy.getShape(), sourceTy.getElementType());
+  Value result = rewriter.create<AllocOp>(loc, resultTy);
+
+  using namespace edsc;
+  ScopedContext scope(rewriter, loc);
+  if (resultTy.getRank() == 0) {
+    std_store(std_load(source), result);
+    return result;
+  }
+  SmallVector<Value, 4> lbs, ubs, steps;
+  for (int64_t size : resultTy.getShape()) {
+    lbs.push_back(std_constant_index(0));
+    ubs.push_back(std_constant_index(size));
+    steps.push_back(std_constant_index(1));
+  }
+  loopNestBuilder(lbs, ubs, steps, [&](ValueRange ivs) {
+    std_store(std_load(source, ivs), result, ivs);
+  });
+  return result;
+}
+
+// Whether the result of `op` is only used by ATen ops. Those all accept
+// strided memrefs: library calls take fully dynamic strided operands, and
+// views compose. Other users (notably `return`) expect the identity layout
+// that tensors are converted to, and a fresh buffer rather than an alias.
+static bool isOnlyUsedByATenOps(Operation *op) {
+  Dialect *atenDialect = op->getDialect();
+  return llvm::all_of(op->getResult(0).getUsers(), [&](Operation *user) {
+    return user->getDialect() == atenDialect &&
+           !isa<mlir::NPCOMP::aten::TypeCastOp>(user);
+  });
+}
+
+// Replace `op` with a `memref_reinterpret_cast` of `source`, i.e. a view of
+// the same buffer with new sizes, strides and (absolute) offset. Nothing is
+// copied unless the view escapes to a user that cannot take it.
+static LogicalResult replaceWithView(Operation *op,
+                                     ConversionPatternRewriter &rewriter,
+                                     Value source, ArrayRef<int64_t> sizes,
+                                     ArrayRef<int64_t> strides,
+                                     int64_t offset) {
+  Location loc = op->getLoc();
+  auto sourceTy = source.getType().cast<MemRefType>();
+  AffineMap layout =
+      makeStridedLinearLayoutMap(strides, offset, rewriter.getContext());
+  // Use the identity layout if the view happens to be contiguous.
+  MemRefType viewTy = canonicalizeStridedLayout(MemRefType::get(
+      sizes, sourceTy.getElementType(), layout, sourceTy.getMemorySpace()));
+  Value view = rewriter.create<MemRefReinterpretCastOp>(
+      loc, viewTy, source, offset, sizes, strides, ValueRange{}, ValueRange{},
+      ValueRange{});
+  if (!isOnlyUsedByATenOps(op))
+    view = createContiguousCopy(rewriter, loc, view);
+  rewriter.replaceOp(op, view);
+  return success();
+}
+
+// The static layout of the (converted) source operand of a view op. Sources
+// whose layout is not known statically are first copied into a contiguous
+// buffer.
+static Optional<StaticStridedLayout>
+getViewSourceLayout(Operation *op, ConversionPatternRewriter &rewriter,
+                    Value &source) {
+  if (auto layout = getStaticStridedLayout(source))
+    return layout;
+  auto sourceTy = source.getType().dyn_cast<MemRefType>();
+  if (!sourceTy || !sourceTy.hasStaticShape())
+    return None;
+  source = createContiguousCopy(rewriter, op->getLoc(), source);
+  return getStaticStridedLayout(source);
+}
+
+static Optional<SmallVector<int64_t, 4>> getStaticResultShape(Operation *op) {
+  auto type = op->getResult(0).getType().dyn_cast<RankedTensorType>();
+  if (!type || !type.hasStaticShape())
+    return None;
+  return SmallVector<int64_t, 4>(type.getShape().begin(),
+                                 type.getShape().end());
+}
+
 /// Lower Add
 template <typename Op>
 class ATenFunctionCallConversion : public ConversionPattern {
@@ -426,12 +661,15 @@ public:
         return success();
       }
     }
-    // FIXME: support float types
-    // if(t.isa<FloatType>()) {
-    //   APFloat f = *(a.float_value_begin());
-    //   rewriter.replaceOp(op, constFloat(f));
-    //   return success();
-    // }
+    if (t.isa<FloatType>()) {
+      auto a = op->getAttrOfType<FloatAttr>("value");
+      if (!a)
+        return failure();
+      SmallVector<Value, 8> newValues{
+          rewriter.create<mlir::ConstantOp>(loc, a)};
+      rewriter.replaceOp(op, newValues);
+      return success();
+    }
     return failure();
   }
 };
@@ -464,7 +702,24 @@ public:
   }
 };
 
-/// Lower AsStrided
+/// Lower AddmmPrepacked
+class AddmmPrepackedOpConversion : public ConversionPattern {
+public:
+  explicit AddmmPrepackedOpConversion(MLIRContext *context)
+      : ConversionPattern(
+            mlir::NPCOMP::aten::AddmmPrepackedOp::getOperationName(), 1,
+            context) {}
+
+  LogicalResult
+  matchAndRewrite(Operation *op, ArrayRef<Value> operands,
+                  ConversionPatternRewriter &rewriter) const override {
+    return rewriteWithFunctionCall(op, operands, rewriter, "addmm_prepacked");
+  }
+};
+
+/// Lower AsStrided to a view of the underlying buffer. As in PyTorch, the
+/// strides and offset are relative to the storage rather than to the input
+/// view; the offset defaults to the input's.
 class AsStridedOpConversion : public ConversionPattern {
 public:
   explicit AsStridedOpConversion(MLIRContext *context)
@@ -474,55 +729,40 @@ public:
   LogicalResult
   matchAndRewrite(Operation *op, ArrayRef<Value> operands,
                   ConversionPatternRewriter &rewriter) const override {
-    auto loc = op->getLoc();
-    edsc::ScopedContext scope(rewriter, loc);
+    auto sizes = getStaticResultShape(op);
+    if (!sizes)
+      return failure();
 
-    Value xVal = memRefTypeCast(rewriter, operands[0]);
-
-    // construct the shape argument
-    std::vector<Value> shape;
-    std::vector<int64_t> result_shape;
-    auto co0 =
-        cast<mlir::NPCOMP::aten::ConstantOp>(operands[1].getDefiningOp());
-    DenseElementsAttr a0 =
-        co0->template getAttrOfType<DenseElementsAttr>("value");
-    for (auto i : a0.getAttributeValues())
-      shape.push_back(rewriter.create<mlir::ConstantOp>(co0.getLoc(), i));
-
-    // pad out the shape with -1 to make it 4d
-    while (shape.size() < 4)
-      shape.push_back(constInt(-1, 32));
-
-    // construct the stride argument
-    std::vector<Value> stride;
-    auto co1 =
-        cast<mlir::NPCOMP::aten::ConstantOp>(operands[2].getDefiningOp());
-    DenseElementsAttr a1 =
-        co1->template getAttrOfType<DenseElementsAttr>("value");
-    for (auto i : a1.getAttributeValues())
-      stride.push_back(rewriter.create<mlir::ConstantOp>(co1.getLoc(), i));
-
-    // pad out the stride with -1 to make it 4d
-    while (stride.size() < 4)
-      stride.push_back(constInt(-1, 32));
-
-    APInt offset(32, 0);
+    auto co = dyn_cast_or_null<mlir::NPCOMP::aten::ConstantOp>(
+        operands[2].getDefiningOp());
+    if (!co)
+      return failure();
+    auto strideAttr = co->getAttrOfType<DenseElementsAttr>("value");
+    if (!strideAttr)
+      return failure();
+    SmallVector<int64_t, 4> strides;
+    for (APInt stride : strideAttr.getIntValues())
+      strides.push_back(stride.getSExtValue());
+    if (strides.size() != sizes->size())
+      return failure();
+
+    Value source = operands[0];
+    auto sourceLayout = getViewSourceLayout(op, rewriter, source);
+    if (!sourceLayout)
+      return failure();
+    int64_t offset = sourceLayout->offset;
     if (operands.size() > 3) {
-      auto co2 =
-          cast<mlir::NPCOMP::aten::ConstantOp>(operands[3].getDefiningOp());
-      auto ia2 = co2->getAttrOfType<IntegerAttr>("value");
-      offset = ia2.getValue();
+      // The offset may already have been converted to a std constant.
+      Operation *offsetOp = operands[3].getDefiningOp();
+      if (!isa_and_nonnull<mlir::ConstantOp, mlir::NPCOMP::aten::ConstantOp>(
+              offsetOp))
+        return failure();
+      auto offsetAttr = offsetOp->getAttrOfType<IntegerAttr>("value");
+      if (!offsetAttr)
+        return failure();
+      offset = offsetAttr.getInt();
     }
-
-    SmallVector<Value, 8> callops{
-        xVal,      shape[0],
-        shape[1],  shape[2],
-        shape[3],  stride[0],
-        stride[1], stride[2],
-        stride[3], constInt(offset.getSExtValue(), 32)};
-
-    return rewriteWithVoidFunctionCallExplicit(op, callops, operands, rewriter,
-                                               "as_strided");
+    return replaceWithView(op, rewriter, source, *sizes, strides, offset);
   }
 };
 
@@ -569,6 +809,22 @@ public:
   }
 };
 
+/// Lower conv2d backward with a fused weight update
+class ConvolutionBackwardUpdateOpConversion : public ConversionPattern {
+public:
+  explicit ConvolutionBackwardUpdateOpConversion(MLIRContext *context)
+      : ConversionPattern(
+            mlir::NPCOMP::aten::ConvolutionBackwardUpdateOp::getOperationName(),
+            1, context) {}
+
+  LogicalResult
+  matchAndRewrite(Operation *op, ArrayRef<Value> operands,
+                  ConversionPatternRewriter &rewriter) const override {
+    return rewriteWithFunctionCall(op, operands, rewriter,
+                                   "conv2d_backward_update");
+  }
+};
+
 /// Lower Div
 class DivOpConversion : public ConversionPattern {
 public:
@@ -672,6 +928,35 @@ public:
   }
 };
 
+/// Lower MM with a fused parameter update
+class MMUpdateOpConversion : public ConversionPattern {
+public:
+  explicit MMUpdateOpConversion(MLIRContext *context)
+      : ConversionPattern(mlir::NPCOMP::aten::MmUpdateOp::getOperationName(), 1,
+                          context) {}
+
+  LogicalResult
+  matchAndRewrite(Operation *op, ArrayRef<Value> operands,
+                  ConversionPatternRewriter &rewriter) const override {
+    return rewriteWithFunctionCall(op, operands, rewriter, "mm_update");
+  }
+};
+
+/// Lower MM by a prepacked constant
+class MMPrepackedOpConversion : public ConversionPattern {
+public:
+  explicit MMPrepackedOpConversion(MLIRContext *context)
+      : ConversionPattern(
+            mlir::NPCOMP::aten::MmPrepackedOp::getOperationName(), 1,
+            context) {}
+
+  LogicalResult
+  matchAndRewrite(Operation *op, ArrayRef<Value> operands,
+                  ConversionPatternRewriter &rewriter) const override {
+    return rewriteWithFunctionCall(op, operands, rewriter, "mm_prepacked");
+  }
+};
+
 /// Lower Mul
 class MulOpConversion : public ConversionPattern {
 public:
@@ -793,7 +1078,7 @@ public:
   }
 };
 
-/// Lower transpose
+/// Lower transpose to a view with the sizes and strides swapped.
 class TransposeOpConversion : public ConversionPattern {
 public:
   explicit TransposeOpConversion(MLIRContext *context)
@@ -803,42 +1088,89 @@ public:
   LogicalResult
   matchAndRewrite(Operation *op, ArrayRef<Value> operands,
                   ConversionPatternRewriter &rewriter) const override {
-    return rewriteWithFunctionCall(op, operands, rewriter, "t");
+    Value source = operands[0];
+    auto layout = getViewSourceLayout(op, rewriter, source);
+    if (!layout || layout->sizes.size() > 2)
+      return failure();
+    // aten.t is the identity on tensors of rank < 2.
+    if (layout->sizes.size() == 2) {
+      std::swap(layout->sizes[0], layout->sizes[1]);
+      std::swap(layout->strides[0], layout->strides[1]);
+    }
+    return replaceWithView(op, rewriter, source, layout->sizes,
+                           layout->strides, layout->offset);
   }
 };
 
-/// Lower view
-class ViewOpConversion : public ConversionPattern {
+/// Lower ops that only change the shape of their first operand (view,
+/// flatten, squeeze, unsqueeze) to a view with the result shape, which is
+/// static and makes the remaining operands redundant. When the source strides
+/// do not allow the new shape (e.g. viewing a transpose), the source is copied
+/// into a contiguous buffer first, which PyTorch would reject for `view` but
+/// does for `reshape`.
+template <typename Op>
+class ReshapeOpConversion : public ConversionPattern {
 public:
-  explicit ViewOpConversion(MLIRContext *context)
-      : ConversionPattern(mlir::NPCOMP::aten::ViewOp::getOperationName(), 1,
-                          context) {}
+  explicit ReshapeOpConversion(MLIRContext *context)
+      : ConversionPattern(Op::getOperationName(), 1, context) {}
 
   LogicalResult
   matchAndRewrite(Operation *op, ArrayRef<Value> operands,
                   ConversionPatternRewriter &rewriter) const override {
-    auto loc = op->getLoc();
-    edsc::ScopedContext scope(rewriter, loc);
-
-    Value xVal = memRefTypeCast(rewriter, operands[0]);
-
-    // construct the shape argument
-    SmallVector<Value, 8> shape;
-    auto co =
-        dyn_cast<mlir::NPCOMP::aten::ConstantOp>(operands[1].getDefiningOp());
-    DenseElementsAttr a =
-        co->template getAttrOfType<DenseElementsAttr>("value");
-    for (auto i : a.getAttributeValues())
-      shape.push_back(rewriter.create<mlir::ConstantOp>(co.getLoc(), i));
+    auto sizes = getStaticResultShape(op);
+    if (!sizes)
+      return failure();
+    Value source = operands[0];
+    auto layout = getViewSourceLayout(op, rewriter, source);
+    if (!layout)
+      return failure();
+    auto strides =
+        computeReshapeStrides(layout->sizes, layout->strides, *sizes);
+    if (!strides) {
+      source = createContiguousCopy(rewriter, op->getLoc(), source);
+      layout = getStaticStridedLayout(source);
+      strides = computeReshapeStrides(layout->sizes, layout->strides, *sizes);
+      assert(strides && "contiguous tensors can always be reshaped");
+    }
+    return replaceWithView(op, rewriter, source, *sizes, *strides,
+                           layout->offset);
+  }
+};
 
-    // pad out the shape with -1 to make it 4d
-    while (shape.size() < 4)
-      shape.push_back(constInt(-1, 32));
+/// Lower expand to a view in which the broadcast dimensions have a stride of
+/// zero, so that each source element is read in place for every copy.
+class ExpandOpConversion : public ConversionPattern {
+public:
+  explicit ExpandOpConversion(MLIRContext *context)
+      : ConversionPattern(mlir::NPCOMP::aten::ExpandOp::getOperationName(), 1,
+                          context) {}
 
-    SmallVector<Value, 8> callops{xVal, shape[0], shape[1], shape[2], shape[3]};
+  LogicalResult
+  matchAndRewrite(Operation *op, ArrayRef<Value> operands,
+                  ConversionPatternRewriter &rewriter) const override {
+    auto sizes = getStaticResultShape(op);
+    if (!sizes)
+      return failure();
+    Value source = operands[0];
+    auto layout = getViewSourceLayout(op, rewriter, source);
+    if (!layout || layout->sizes.size() > sizes->size())
+      return failure();
 
-    return rewriteWithVoidFunctionCallExplicit(op, callops, operands, rewriter,
-                                               "view");
+    // New leading dimensions, and existing unit dimensions that get expanded,
+    // are broadcast.
+    int64_t leading = sizes->size() - layout->sizes.size();
+    SmallVector<int64_t, 4> strides(leading, 0);
+    for (size_t i = 0, e = layout->sizes.size(); i < e; i++) {
+      int64_t size = (*sizes)[leading + i];
+      if (layout->sizes[i] == size)
+        strides.push_back(layout->strides[i]);
+      else if (layout->sizes[i] == 1)
+        strides.push_back(0);
+      else
+        return failure();
+    }
+    return replaceWithView(op, rewriter, source, *sizes, strides,
+                           layout->offset);
   }
 };
 
@@ -856,7 +1188,7 @@ MemRefType convertTensorType(TensorType tensor) {
 /// FIXME: Audit this for completeness
 struct ATenLoweringPass : public ATenLoweringBase<ATenLoweringPass> {
   void getDependentDialects(DialectRegistry &registry) const override {
-    registry.insert<LLVM::LLVMDialect, StandardOpsDialect>();
+    registry.insert<LLVM::LLVMDialect, StandardOpsDialect, scf::SCFDialect>();
   }
 
   void runOnOperation() override {
@@ -876,11 +1208,18 @@ struct ATenLoweringPass : public ATenLoweringBase<ATenLoweringPass> {
         ConstantOpConversion, AddOpConversion, ConvolutionOpConversion,
         ReLUOpConversion, TransposeOpConversion, BatchNormOpConversion,
         NativeBatchNormOpConversion, MaxPoolOpConversion,
-        MaxPool2dWithIndicesOpConversion, AddmmOpConversion, ViewOpConversion,
-        MulOpConversion, MMOpConversion, AsStridedOpConversion,
+        MaxPool2dWithIndicesOpConversion, AddmmOpConversion,
+        ReshapeOpConversion<mlir::NPCOMP::aten::ViewOp>,
+        ReshapeOpConversion<mlir::NPCOMP::aten::FlattenOp>,
+        ReshapeOpConversion<mlir::NPCOMP::aten::SqueezeOp>,
+        ReshapeOpConversion<mlir::NPCOMP::aten::UnsqueezeOp>,
+        ExpandOpConversion, MulOpConversion, MMOpConversion,
+        MMUpdateOpConversion, MMPrepackedOpConversion,
+        AddmmPrepackedOpConversion, AsStridedOpConversion,
         LogSoftmaxOpConversion, ThresholdBackwardOpConversion,
         MaxPool2dWithIndicesBackwardOpConversion,
-        ConvolutionBackwardOpConversion, NllLossForwardOpConversion,
+        ConvolutionBackwardOpConversion,
+        ConvolutionBackwardUpdateOpConversion, NllLossForwardOpConversion,
         NllLossBackwardOpConversion, NllLoss2dForwardOpConversion,
         NllLoss2dBackwardOpConversion, LogSoftmaxOpConversion,
         LogSoftmaxBackwardDataOpConversion, DivOpConversion>(context);
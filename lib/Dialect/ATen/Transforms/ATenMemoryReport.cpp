@@ -0,0 +1,106 @@
+//===- ATenMemoryReport.cpp -------------------------------------*- C++ -*-===//
+//
+// This file is licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "PassDetail.h"
+
+#include "mlir/IR/BuiltinOps.h"
+#include "npcomp/Dialect/ATen/Transforms/MemoryPlan.h"
+#include "npcomp/Dialect/ATen/Transforms/Passes.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/JSON.h"
+
+#define DEBUG_TYPE "aten-memory-report"
+
+using namespace mlir;
+using namespace mlir::NPCOMP::aten;
+
+namespace {
+
+static std::string getLayerName(Operation *op) {
+  if (auto attr = op->getAttrOfType<StringAttr>("layer_name"))
+    return attr.getValue().str();
+  return op->getName().getStringRef().str();
+}
+
+static std::string getValueName(Value value) {
+  if (auto arg = value.dyn_cast<BlockArgument>())
+    return "arg" + std::to_string(arg.getArgNumber());
+  auto result = value.cast<OpResult>();
+  std::string name = getLayerName(result.getOwner());
+  if (result.getResultNumber())
+    name += "#" + std::to_string(result.getResultNumber());
+  return name;
+}
+
+/// Report the memory use of the `graph` function: the bytes live at each
+/// op, the peak, and a plan that packs the intermediate tensors into one
+/// arena.
+struct ATenMemoryReportPass
+    : public ATenMemoryReportBase<ATenMemoryReportPass> {
+  void runOnOperation() override {
+    markAllAnalysesPreserved();
+
+    auto module = getOperation();
+    auto graph = module.lookupSymbol<mlir::FuncOp>("graph");
+    if (!graph) {
+      emitError(mlir::UnknownLoc::get(module.getContext()),
+                "MemoryReportPass failed: can't find a graph function\n");
+      signalPassFailure();
+      return;
+    }
+
+    const MemoryPlan &plan = getChildAnalysis<MemoryPlan>(graph);
+    const BlockLiveness &liveness = plan.getLiveness();
+    ArrayRef<Operation *> ops = liveness.getOps();
+    ArrayRef<LiveRange> ranges = liveness.getRanges();
+
+    llvm::json::Array liveBytes;
+    for (unsigned i = 0, e = ops.size(); i + 1 < e; i++) {
+      liveBytes.push_back(llvm::json::Object{
+          {"layer", getLayerName(ops[i])},
+          {"live_bytes", static_cast<int64_t>(liveness.getLiveBytes()[i])},
+      });
+    }
+
+    std::vector<llvm::json::Array> bufferValues(plan.getBuffers().size());
+    for (unsigned i = 0, e = ranges.size(); i < e; i++)
+      if (Optional<unsigned> buffer = plan.getBufferIndex(i))
+        bufferValues[*buffer].push_back(getValueName(ranges[i].value));
+    llvm::json::Array buffers;
+    for (auto buffer : llvm::enumerate(plan.getBuffers())) {
+      buffers.push_back(llvm::json::Object{
+          {"offset", static_cast<int64_t>(buffer.value().offset)},
+          {"bytes", static_cast<int64_t>(buffer.value().bytes)},
+          {"values", std::move(bufferValues[buffer.index()])},
+      });
+    }
+
+    llvm::json::Object top{
+        {"live_bytes", std::move(liveBytes)},
+        {"peak_bytes", static_cast<int64_t>(liveness.getPeakBytes())},
+        {"arena_bytes", static_cast<int64_t>(plan.getArenaBytes())},
+        {"reused_bytes", static_cast<int64_t>(plan.getReusedBytes())},
+        {"buffers", std::move(buffers)},
+        {"dynamic_values", liveness.getNumDynamicRanges()},
+    };
+    if (!ops.empty())
+      top["peak_layer"] = getLayerName(ops[liveness.getPeakIndex()]);
+
+    std::string report;
+    llvm::raw_string_ostream ss(report);
+    ss << llvm::formatv("{0:2}", llvm::json::Value(std::move(top))) << "\n";
+    graph.emitWarning(ss.str());
+  }
+};
+
+} // namespace
+
+std::unique_ptr<OperationPass<ModuleOp>>
+mlir::NPCOMP::aten::createATenMemoryReportPass() {
+  return std::make_unique<ATenMemoryReportPass>();
+}
@@ -15,9 +15,14 @@
 
 #include "mlir/Pass/Pass.h"
 #include "npcomp/Dialect/ATen/IR/ATenDialect.h"
+#include "npcomp/Dialect/ATen/Transforms/OpCostAnalysis.h"
 #include "npcomp/Dialect/ATen/Transforms/Passes.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <iostream>
+#include <thread>
 #include <vector>
 
 #define DEBUG_TYPE "aten-op-stats"
@@ -27,6 +32,80 @@ using namespace mlir::NPCOMP::aten;
 
 namespace {
 
+static unsigned getNumBenchmarkThreads() {
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+/// Measure the sustained single precision throughput of the host in GFLOP/s.
+/// Every hardware thread runs independent multiply-add chains over a small
+/// array that stays in L1 and that the compiler vectorizes.
+static double measurePeakGFlops() {
+  constexpr int kLanes = 64;
+  constexpr int kIterations = 1 << 20;
+  unsigned numThreads = getNumBenchmarkThreads();
+  std::vector<float> sinks(numThreads);
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned t = 0; t < numThreads; t++) {
+    threads.emplace_back([&sinks, t] {
+      float acc[kLanes], mul[kLanes];
+      for (int i = 0; i < kLanes; i++) {
+        acc[i] = 0.0f;
+        mul[i] = 1.0f - i * 1e-7f;
+      }
+      for (int it = 0; it < kIterations; it++)
+        for (int i = 0; i < kLanes; i++)
+          acc[i] = acc[i] * mul[i] + 1e-7f;
+      float sum = 0.0f;
+      for (float a : acc)
+        sum += a;
+      sinks[t] = sum;
+    });
+  }
+  for (std::thread &thread : threads)
+    thread.join();
+  double flops = 2.0 * kLanes * kIterations * numThreads;
+  return flops / secondsSince(start) / 1e9;
+}
+
+/// Measure the sustained memory bandwidth of the host in GB/s, counting both
+/// bytes read and bytes written. Every hardware thread copies its own pair of
+/// buffers, together much larger than the last level cache.
+static double measurePeakGBps() {
+  constexpr size_t kTotalBytes = size_t(256) << 20;
+  constexpr int kRepetitions = 4;
+  unsigned numThreads = getNumBenchmarkThreads();
+  size_t bytesPerThread =
+      std::max<size_t>(size_t(1) << 20, kTotalBytes / 2 / numThreads);
+  std::vector<double> seconds(numThreads);
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < numThreads; t++) {
+    threads.emplace_back([&seconds, bytesPerThread, t] {
+      // Touch the buffers from this thread first so that their pages are
+      // local to it.
+      std::vector<char> src(bytesPerThread, 1), dst(bytesPerThread, 0);
+      std::memcpy(dst.data(), src.data(), bytesPerThread);
+      auto start = std::chrono::steady_clock::now();
+      for (int r = 0; r < kRepetitions; r++) {
+        src[r] = static_cast<char>(r);
+        std::memcpy(dst.data(), src.data(), bytesPerThread);
+      }
+      seconds[t] = secondsSince(start);
+    });
+  }
+  for (std::thread &thread : threads)
+    thread.join();
+  double slowest = *std::max_element(seconds.begin(), seconds.end());
+  double bytes = 2.0 * bytesPerThread * kRepetitions * numThreads;
+  return bytes / slowest / 1e9;
+}
+
 /// Query operations through the StatisticsOpInterface and print the result
 /// in a human-readable way.  This replicates the functionality in various
 /// network analysis tools and is a stepping stone toward using the information
@@ -50,11 +129,10 @@ public:
                      "parameters_in", "ops:MAC", "ops:==", "ops:>", "ops:*",
                      "ops:+", "ops:/", "ops:sqrt", "ops:-", "grad"}) {}
 
-  std::string emitJSONReport() {
+  std::string emitJSONReport(FuncOp graph) {
 
     llvm::json::Object top;
 
-    auto graph = getOperation().lookupSymbol<mlir::FuncOp>("graph");
     graph.walk([&](Operation *op) {
       if (auto stats =
               mlir::dyn_cast<mlir::NPCOMP::StatisticsOpInterface>(op)) {
@@ -91,6 +169,84 @@ public:
     return ss.str();
   }
 
+  /// Rank the layers of the graph by their roofline time estimate
+  ///   time = max(flops / peak_flops, bytes / peak_bandwidth)
+  /// A layer is memory bound if its arithmetic intensity (flops per byte) is
+  /// below the machine's ridge point (peak_flops / peak_bandwidth).
+  std::string emitRooflineReport(FuncOp graph) {
+    double gflops = peakGFlops > 0 ? double(peakGFlops) : measurePeakGFlops();
+    double gbps = peakGBps > 0 ? double(peakGBps) : measurePeakGBps();
+    double ridgePoint = gflops / gbps;
+
+    struct Layer {
+      std::string name;
+      std::string opName;
+      double flops;
+      double bytes;
+      double parameterBytes;
+      double seconds;
+    };
+    std::vector<Layer> layers;
+    llvm::json::Array unmodeled;
+    double totalSeconds = 0.0;
+
+    OpCostAnalysis &costs = getAnalysis<OpCostAnalysis>();
+    graph.walk([&](Operation *op) {
+      OpCost cost = costs.getCost(op);
+      if (!cost.known) {
+        unmodeled.push_back(opToName[op]);
+        return;
+      }
+      // Views, constants and scalar ops cost nothing.
+      if (cost.isFree())
+        return;
+      double flops = cost.getTotalFlops();
+      double bytes = cost.getBytesMoved();
+      double seconds = std::max(flops / (gflops * 1e9), bytes / (gbps * 1e9));
+      layers.push_back({opToName[op], op->getName().getStringRef().str(),
+                        flops, bytes, double(cost.parameterBytes), seconds});
+      totalSeconds += seconds;
+    });
+
+    std::stable_sort(layers.begin(), layers.end(),
+                     [](const Layer &a, const Layer &b) {
+                       return a.seconds > b.seconds;
+                     });
+
+    llvm::json::Array layersJSON;
+    for (const Layer &layer : layers) {
+      double intensity = layer.bytes > 0 ? layer.flops / layer.bytes : 0.0;
+      bool computeBound = layer.bytes == 0 || intensity >= ridgePoint;
+      layersJSON.push_back(llvm::json::Object{
+          {"layer", layer.name},
+          {"op", layer.opName},
+          {"parameter_bytes", static_cast<int64_t>(layer.parameterBytes)},
+          {"flops", static_cast<int64_t>(layer.flops)},
+          {"bytes", static_cast<int64_t>(layer.bytes)},
+          {"arithmetic_intensity", intensity},
+          {"attainable_gflops",
+           computeBound ? gflops : intensity * gbps},
+          {"bound", computeBound ? "compute" : "memory"},
+          {"estimated_time_us", layer.seconds * 1e6},
+          {"time_percent", 100.0 * layer.seconds / totalSeconds},
+      });
+    }
+
+    llvm::json::Object top{
+        {"machine", llvm::json::Object{{"peak_gflops", gflops},
+                                       {"peak_bandwidth_gbps", gbps},
+                                       {"ridge_point", ridgePoint}}},
+        {"layers", std::move(layersJSON)},
+        {"total_estimated_time_us", totalSeconds * 1e6},
+        {"unmodeled_layers", std::move(unmodeled)},
+    };
+    llvm::json::Value topv(std::move(top));
+    std::string ret;
+    llvm::raw_string_ostream ss(ret);
+    ss << llvm::formatv("{0:2}", topv) << "\n";
+    return ss.str();
+  }
+
   void runOnOperation() override {
 
     // I don't change anything
@@ -118,7 +274,8 @@ public:
       currentLayer++;
     });
 
-    std::string report = emitJSONReport();
+    std::string report =
+        roofline ? emitRooflineReport(graph) : emitJSONReport(graph);
     if (output) {
       *output = report;
     } else {
@@ -0,0 +1,267 @@
+//===- FoldBatchNormPass.cpp ------------------------------------*- C++ -*-===//
+//
+// This file is licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Folds inference-mode batch normalization into the convolution or addmm that
+// produces its input. With constant parameters, batch norm is a per-channel
+// affine map
+//
+//   y[c] = x[c] * scale[c] + shift[c]
+//   scale = weight / sqrt(running_var + eps)
+//   shift = bias - running_mean * scale
+//
+// which distributes into the preceding op's weights (scaling each output
+// channel) and bias, so the batch norm, and its extra pass over the
+// activations, disappears from the graph.
+//
+//===----------------------------------------------------------------------===//
+
+#include "PassDetail.h"
+
+#include "mlir/Dialect/StandardOps/IR/Ops.h"
+#include "mlir/IR/Matchers.h"
+#include "mlir/IR/PatternMatch.h"
+#include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+#include "npcomp/Dialect/ATen/IR/ATenConstantUtils.h"
+#include "npcomp/Dialect/ATen/IR/ATenDialect.h"
+#include "npcomp/Dialect/ATen/Transforms/Passes.h"
+#include "npcomp/Dialect/Basicpy/IR/BasicpyDialect.h"
+#include "npcomp/Dialect/Numpy/IR/NumpyOps.h"
+
+#include <cmath>
+
+#define DEBUG_TYPE "aten-fold-batch-norm"
+
+using namespace mlir;
+using namespace mlir::NPCOMP;
+using namespace mlir::NPCOMP::aten;
+
+namespace {
+
+// Matches a constant f32 tensor, returning its elements and type.
+static bool matchConstantTensorValues(Value value,
+                                      SmallVectorImpl<double> &values,
+                                      RankedTensorType &type) {
+  DenseFPElementsAttr attr = matchConstantTensor(value);
+  if (!attr)
+    return false;
+  type = attr.getType().cast<RankedTensorType>();
+  for (const APFloat &element : attr)
+    values.push_back(element.convertToFloat());
+  return true;
+}
+
+// Matches a constant 1-D tensor with `size` elements, or an absent optional
+// tensor, which stands for `defaultValue` in every element.
+static bool matchConstantChannelVector(Value value, int64_t size,
+                                       double defaultValue,
+                                       SmallVectorImpl<double> &values) {
+  if (value.getType().isa<Basicpy::NoneType>()) {
+    values.assign(size, defaultValue);
+    return true;
+  }
+  RankedTensorType type;
+  if (!matchConstantTensorValues(value, values, type))
+    return false;
+  return type.getRank() == 1 && type.getDimSize(0) == size;
+}
+
+static Value createConstantTensor(PatternRewriter &rewriter, Location loc,
+                                  ArrayRef<int64_t> shape,
+                                  ArrayRef<double> values) {
+  SmallVector<float, 16> floats(values.begin(), values.end());
+  auto type = RankedTensorType::get(shape, rewriter.getF32Type());
+  return rewriter.create<mlir::ConstantOp>(
+      loc, DenseElementsAttr::get(type, llvm::makeArrayRef(floats)));
+}
+
+// The per-channel scale and shift that an inference batch norm applies.
+struct ChannelAffine {
+  SmallVector<double, 16> scale;
+  SmallVector<double, 16> shift;
+};
+
+// Whether only the normalized result of a batch norm is used. The saved mean
+// and inverse standard deviation have no replacement once it is folded.
+static bool hasOnlyOutputUsed(Operation *bn) {
+  return bn->getNumResults() == 3 && bn->getResult(1).use_empty() &&
+         bn->getResult(2).use_empty();
+}
+
+// Matches batch norm ops (`batch_norm` and `native_batch_norm` share their
+// leading operands) that can be folded into their producer: inference mode
+// and constant parameters.
+template <typename BatchNormOpTy>
+static bool matchFoldableBatchNorm(BatchNormOpTy op, int64_t numChannels,
+                                   ChannelAffine &affine) {
+  Operation *bn = op.getOperation();
+  if (bn->getNumOperands() < 8)
+    return false;
+  bool training;
+  double eps;
+  if (!matchConstantBool(bn->getOperand(5), training) || training ||
+      !matchConstantNumber(bn->getOperand(7), eps))
+    return false;
+
+  SmallVector<double, 16> weight, bias, mean, var;
+  if (!matchConstantChannelVector(bn->getOperand(1), numChannels, 1.0,
+                                  weight) ||
+      !matchConstantChannelVector(bn->getOperand(2), numChannels, 0.0, bias) ||
+      !matchConstantChannelVector(bn->getOperand(3), numChannels, 0.0, mean) ||
+      !matchConstantChannelVector(bn->getOperand(4), numChannels, 1.0, var))
+    return false;
+
+  for (int64_t c = 0; c < numChannels; c++) {
+    double scale = weight[c] / std::sqrt(var[c] + eps);
+    affine.scale.push_back(scale);
+    affine.shift.push_back(bias[c] - mean[c] * scale);
+  }
+  return true;
+}
+
+static int64_t getNumChannels(Value batchNormInput) {
+  auto type = batchNormInput.getType().dyn_cast<RankedTensorType>();
+  if (!type || type.getRank() < 2 || type.isDynamicDim(1))
+    return -1;
+  return type.getDimSize(1);
+}
+
+/// conv(x, W, b) -> batch_norm  ==>  conv(x, W * scale, b * scale + shift)
+template <typename BatchNormOpTy>
+class FoldBatchNormIntoConvolution : public OpRewritePattern<BatchNormOpTy> {
+public:
+  using OpRewritePattern<BatchNormOpTy>::OpRewritePattern;
+  LogicalResult matchAndRewrite(BatchNormOpTy op,
+                                PatternRewriter &rewriter) const override {
+    if (!hasOnlyOutputUsed(op))
+      return failure();
+    Value input = op.getOperation()->getOperand(0);
+    auto conv = input.getDefiningOp<ConvolutionOp>();
+    if (!conv || !input.hasOneUse())
+      return failure();
+    // Transposed convolution weights are [C_in, C_out / groups, ...], which
+    // would need a different scaling.
+    bool transposed;
+    if (!matchConstantBool(conv.transposed(), transposed) || transposed)
+      return failure();
+
+    int64_t numChannels = getNumChannels(input);
+    ChannelAffine affine;
+    if (numChannels < 0 || !matchFoldableBatchNorm(op, numChannels, affine))
+      return failure();
+
+    SmallVector<double, 16> weight, bias;
+    RankedTensorType weightType;
+    if (!matchConstantTensorValues(conv.weight(), weight, weightType) ||
+        weightType.getRank() < 1 || weightType.getDimSize(0) != numChannels ||
+        !matchConstantChannelVector(conv.bias(), numChannels, 0.0, bias))
+      return failure();
+
+    // Weights are [C_out, ...], so each output channel is a contiguous run.
+    int64_t perChannel = weight.size() / numChannels;
+    for (int64_t c = 0; c < numChannels; c++) {
+      for (int64_t i = 0; i < perChannel; i++)
+        weight[c * perChannel + i] *= affine.scale[c];
+      bias[c] = bias[c] * affine.scale[c] + affine.shift[c];
+    }
+
+    Location loc = op.getLoc();
+    Value newWeight =
+        createConstantTensor(rewriter, loc, weightType.getShape(), weight);
+    Value newBias = createConstantTensor(rewriter, loc, {numChannels}, bias);
+    rewriter.updateRootInPlace(conv, [&]() {
+      conv.weightMutable().assign(newWeight);
+      conv.biasMutable().assign(newBias);
+    });
+    rewriter.replaceOp(op, {conv.getResult(), Value(), Value()});
+    return success();
+  }
+};
+
+/// addmm(b, x, W) -> batch_norm  ==>  addmm(b * scale + shift, x, W * scale)
+///
+/// Only the unscaled form (beta == 1) that nn.Linear produces is handled; a
+/// general alpha is fine since it commutes with the column scaling.
+template <typename BatchNormOpTy>
+class FoldBatchNormIntoAddmm : public OpRewritePattern<BatchNormOpTy> {
+public:
+  using OpRewritePattern<BatchNormOpTy>::OpRewritePattern;
+  LogicalResult matchAndRewrite(BatchNormOpTy op,
+                                PatternRewriter &rewriter) const override {
+    if (!hasOnlyOutputUsed(op))
+      return failure();
+    Value input = op.getOperation()->getOperand(0);
+    auto addmm = input.getDefiningOp<AddmmOp>();
+    if (!addmm || !input.hasOneUse())
+      return failure();
+    double beta;
+    if (!matchConstantNumber(addmm.beta(), beta) || beta != 1.0)
+      return failure();
+
+    int64_t numChannels = getNumChannels(input);
+    ChannelAffine affine;
+    if (numChannels < 0 || !matchFoldableBatchNorm(op, numChannels, affine))
+      return failure();
+
+    // mat2 is [K, C_out]; it is commonly the transpose of an nn.Linear
+    // weight, which is then scaled along its rows instead.
+    Value mat2 = addmm.mat2();
+    auto transpose = mat2.getDefiningOp<TOp>();
+    if (transpose)
+      mat2 = transpose.self();
+    SmallVector<double, 16> weight, bias;
+    RankedTensorType weightType;
+    if (!matchConstantTensorValues(mat2, weight, weightType) ||
+        weightType.getRank() != 2 ||
+        weightType.getDimSize(transpose ? 0 : 1) != numChannels ||
+        !matchConstantChannelVector(addmm.self(), numChannels, 0.0, bias))
+      return failure();
+
+    int64_t rows = weightType.getDimSize(0);
+    int64_t cols = weightType.getDimSize(1);
+    for (int64_t i = 0; i < rows; i++)
+      for (int64_t j = 0; j < cols; j++)
+        weight[i * cols + j] *= affine.scale[transpose ? i : j];
+    for (int64_t c = 0; c < numChannels; c++)
+      bias[c] = bias[c] * affine.scale[c] + affine.shift[c];
+
+    Location loc = op.getLoc();
+    Value newWeight =
+        createConstantTensor(rewriter, loc, weightType.getShape(), weight);
+    if (transpose)
+      newWeight = rewriter.create<TOp>(loc, transpose.getType(), newWeight);
+    Value newBias = createConstantTensor(rewriter, loc, {numChannels}, bias);
+    rewriter.updateRootInPlace(addmm, [&]() {
+      addmm.selfMutable().assign(newBias);
+      addmm.mat2Mutable().assign(newWeight);
+    });
+    rewriter.replaceOp(op, {addmm.getResult(), Value(), Value()});
+    return success();
+  }
+};
+
+class ATenFoldBatchNormPass
+    : public ATenFoldBatchNormBase<ATenFoldBatchNormPass> {
+  void runOnOperation() override {
+    MLIRContext *context = &getContext();
+    OwningRewritePatternList patterns;
+    patterns.insert<FoldBatchNormIntoConvolution<BatchNormOp>,
+                    FoldBatchNormIntoConvolution<NativeBatchNormOp>,
+                    FoldBatchNormIntoAddmm<BatchNormOp>,
+                    FoldBatchNormIntoAddmm<NativeBatchNormOp>>(context);
+    if (failed(
+            applyPatternsAndFoldGreedily(getOperation(), std::move(patterns))))
+      signalPassFailure();
+  }
+};
+
+} // namespace
+
+std::unique_ptr<OperationPass<FuncOp>>
+mlir::NPCOMP::aten::createATenFoldBatchNormPass() {
+  return std::make_unique<ATenFoldBatchNormPass>();
+}
@@ -0,0 +1,138 @@
+//===- FuseOptimizerUpdatePass.cpp ------------------------------*- C++ -*-===//
+//
+// This file is licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Fuses the in-place parameter updates of captured training steps into the
+// backward kernels that produce their gradients. An SGD step is
+//
+//   %g = aten.mm(...)                          (or convolution_backward #1)
+//   %s = aten.mul_(%g, c)                      (optional, e.g. loss scaling)
+//   %p2 = aten.add_(%p, %s, alpha)             (p -= lr * g)
+//
+// which writes out the full gradient only to read it back once. When every
+// step of the chain is the only use of the gradient and the scalars are
+// constant, it becomes a single `aten.mm_update` (resp.
+// `aten.convolution_backward_update`) computing `p + alpha * c * g` in the
+// epilogue of the kernel.
+//
+//===----------------------------------------------------------------------===//
+
+#include "PassDetail.h"
+
+#include "mlir/Dialect/StandardOps/IR/Ops.h"
+#include "mlir/IR/Matchers.h"
+#include "mlir/IR/PatternMatch.h"
+#include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+#include "npcomp/Dialect/ATen/IR/ATenConstantUtils.h"
+#include "npcomp/Dialect/ATen/IR/ATenDialect.h"
+#include "npcomp/Dialect/ATen/Transforms/Passes.h"
+
+#define DEBUG_TYPE "aten-fuse-optimizer-update"
+
+using namespace mlir;
+using namespace mlir::NPCOMP;
+using namespace mlir::NPCOMP::aten;
+
+namespace {
+
+/// p.add_(g * c..., alpha)  ==>  mm_update / convolution_backward_update
+class FuseUpdateIntoBackward : public OpRewritePattern<AddUnderOp> {
+public:
+  using OpRewritePattern::OpRewritePattern;
+  LogicalResult matchAndRewrite(AddUnderOp op,
+                                PatternRewriter &rewriter) const override {
+    double alpha;
+    if (!matchConstantNumber(op.alpha(), alpha))
+      return failure();
+    Value param = op.self();
+    if (param.getType() != op.getType())
+      return failure();
+
+    // Walk up the chain of scalings to the gradient.
+    SmallVector<Operation *, 2> scalings;
+    Value grad = op.other();
+    while (auto mul = grad.getDefiningOp<MulUnderOp>()) {
+      double scale;
+      if (!grad.hasOneUse() || !matchConstantNumber(mul.other(), scale))
+        return failure();
+      alpha *= scale;
+      scalings.push_back(mul);
+      grad = mul.self();
+    }
+    if (!grad.hasOneUse() || grad.getType() != param.getType())
+      return failure();
+
+    Operation *producer = grad.getDefiningOp();
+    auto mm = dyn_cast_or_null<MmOp>(producer);
+    auto backward = dyn_cast_or_null<ConvolutionBackwardOp>(producer);
+    if (!mm && !(backward && grad == backward.grad_weight()))
+      return failure();
+    // The weight gradient of convolution_backward has no replacement in the
+    // fused op, so its only use must be the chain that is erased.
+    if (backward && !backward.grad_weight().hasOneUse())
+      return failure();
+    // The other results of convolution_backward may be used before the
+    // update, so the fused op takes its place, where the parameter must
+    // already be defined. An mm is simply sunk to the update.
+    if (backward && !isDefinedBefore(param, backward))
+      return failure();
+
+    Location loc = op.getLoc();
+    rewriter.setInsertionPoint(backward ? producer : op.getOperation());
+    Value alphaValue = rewriter.create<mlir::ConstantOp>(
+        loc, rewriter.getF32FloatAttr(static_cast<float>(alpha)));
+    if (mm) {
+      Value update = rewriter.create<MmUpdateOp>(
+          loc, op.getType(), param, mm.self(), mm.mat2(), alphaValue);
+      rewriter.replaceOp(op, update);
+      for (Operation *scaling : scalings)
+        rewriter.eraseOp(scaling);
+      rewriter.eraseOp(mm);
+    } else {
+      SmallVector<Value, 12> operands(backward.getOperands());
+      operands.push_back(param);
+      operands.push_back(alphaValue);
+      auto fused = rewriter.create<ConvolutionBackwardUpdateOp>(
+          loc, backward.getResultTypes(), operands);
+      rewriter.replaceOp(op, fused.updated_weight());
+      for (Operation *scaling : scalings)
+        rewriter.eraseOp(scaling);
+      assert(backward.grad_weight().use_empty() &&
+             "weight gradient used outside of the fused chain");
+      rewriter.replaceOp(backward,
+                         {fused.grad_input(), Value(), fused.grad_bias()});
+    }
+    return success();
+  }
+
+private:
+  // Whether `value` is available before `op` in straight-line code.
+  static bool isDefinedBefore(Value value, Operation *op) {
+    if (Operation *def = value.getDefiningOp())
+      return def->getBlock() == op->getBlock() && def->isBeforeInBlock(op);
+    return value.getParentRegion()->isAncestor(op->getParentRegion());
+  }
+};
+
+class ATenFuseOptimizerUpdatePass
+    : public ATenFuseOptimizerUpdateBase<ATenFuseOptimizerUpdatePass> {
+  void runOnOperation() override {
+    MLIRContext *context = &getContext();
+    OwningRewritePatternList patterns;
+    patterns.insert<FuseUpdateIntoBackward>(context);
+    if (failed(
+            applyPatternsAndFoldGreedily(getOperation(), std::move(patterns))))
+      signalPassFailure();
+  }
+};
+
+} // namespace
+
+std::unique_ptr<OperationPass<FuncOp>>
+mlir::NPCOMP::aten::createATenFuseOptimizerUpdatePass() {
+  return std::make_unique<ATenFuseOptimizerUpdatePass>();
+}
@@ -10,11 +10,11 @@
 
 #include "npcomp/Dialect/ATen/IR/ATenDialect.h"
 #include "npcomp/Dialect/ATen/Transforms/LivenessReport.h"
+#include "npcomp/Dialect/ATen/Transforms/MemoryPlan.h"
 
-#include "mlir/Analysis/Liveness.h"
 #include "mlir/Dialect/StandardOps/IR/Ops.h"
-#include "mlir/IR/Builders.h"
 #include "mlir/IR/BuiltinOps.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/JSON.h"
 
@@ -52,33 +52,17 @@ std::string LivenessReport::emitJSONReport() {
   resolveLiveness();
   llvm::json::Object top;
   auto graph = module.lookupSymbol<mlir::FuncOp>("graph");
+  if (!graph)
+    return "{}\n";
 
-  std::map<Operation *, std::vector<Value>> liveAt;
+  llvm::DenseMap<Operation *, std::vector<Value>> liveAt;
+  for (auto &p : livenessIntervals)
+    for (Operation *o : p.second)
+      liveAt[o].push_back(p.first);
 
-  graph.walk([&](Operation *op) {
-    for (Value result : op->getResults()) {
-      for (auto &p : livenessIntervals) {
-        Value v = p.first;
-        if (v == result) {
-          std::vector<Operation *> &oplist = p.second;
-          for (auto *o : oplist)
-            liveAt[o].push_back(result);
-        }
-      }
-    }
-  });
-
-  auto argList = graph.getBody().getBlocks().front().getArguments();
-  for (Value &arg : argList) {
-    for (auto &p : livenessIntervals) {
-      Value v = p.first;
-      if (v == arg) {
-        std::vector<Operation *> &oplist = p.second;
-        for (auto *o : oplist)
-          liveAt[o].push_back(arg);
-      }
-    }
-  }
+  auto ret = cast<ReturnOp>(graph.getBody().front().getTerminator());
+  llvm::DenseSet<Value> returned(ret.getOperands().begin(),
+                                 ret.getOperands().end());
 
   graph.walk([&](Operation *op) {
     llvm::json::Object layerDetail;
@@ -90,30 +74,20 @@ std::string LivenessReport::emitJSONReport() {
     int64_t returnVol = 0;
     for (auto v : vlist) {
       int64_t vol = getTensorVolume(v.getType());
-      if (v.getDefiningOp()) {
-        if (auto a =
-                v.getDefiningOp()->getAttrOfType<StringAttr>("layer_name")) {
-          auto ld = layerDetail.getInteger(a.getValue().str());
-          if (ld)
-            layerDetail[a.getValue().str()] = *ld + vol;
-          else
-            layerDetail[a.getValue().str()] = vol;
-        } else {
+      if (Operation *def = v.getDefiningOp()) {
+        auto a = def->getAttrOfType<StringAttr>("layer_name");
+        if (!a)
           llvm_unreachable("unknown type");
-        }
-      } else if (std::find(argList.begin(), argList.end(), v) !=
-                 argList.end()) {
-        parameterVol += vol;
+        auto ld = layerDetail.getInteger(a.getValue().str());
+        if (ld)
+          layerDetail[a.getValue().str()] = *ld + vol;
+        else
+          layerDetail[a.getValue().str()] = vol;
       } else {
-        llvm_unreachable("unknown type");
-      }
-      auto ret = cast<ReturnOp>(op->getBlock()->getTerminator());
-      for (auto oper : ret.getOperands()) {
-        if (oper == v) {
-          returnVol += vol;
-          break;
-        }
+        parameterVol += vol;
       }
+      if (returned.count(v))
+        returnVol += vol;
     }
     if (parameterVol) {
       layerDetail["parameters"] = parameterVol;
@@ -125,16 +99,14 @@ std::string LivenessReport::emitJSONReport() {
   });
 
   llvm::json::Value topv(std::move(top));
-  std::string ret;
-  llvm::raw_string_ostream ss(ret);
+  std::string retStr;
+  llvm::raw_string_ostream ss(retStr);
   ss << llvm::formatv("{0:2}", topv) << "\n";
   return ss.str();
 }
 
 void LivenessReport::resolveLiveness() {
-
-  auto context = module.getContext();
-  auto loc = mlir::UnknownLoc::get(context);
+  livenessIntervals.clear();
 
   // check that a function called "graph" exists
   auto graph = module.lookupSymbol<mlir::FuncOp>("graph");
@@ -144,83 +116,29 @@ void LivenessReport::resolveLiveness() {
     return;
   }
 
-  // put each aten operation into its own basic block,
-  // so that we can use standard liveness
-  Region &bodyRegion = graph.getBody();
-  Block *entryBB = &bodyRegion.getBlocks().front();
-  Block *BB = entryBB;
-  std::vector<Block *> new_blocks;
-  while (true) {
-    std::vector<Operation *> ops;
-    for (Operation &op : BB->getOperations())
-      ops.push_back(&op);
-
-    // skip over constant ops
-    int idx = 0;
-    while (dyn_cast<mlir::NPCOMP::aten::ConstantOp>(ops[idx]))
-      idx++;
-
-    if (dyn_cast<ReturnOp>(ops[idx]))
-      break;
-
-    Block *newBB = BB->splitBlock(ops[idx + 1]);
-    new_blocks.push_back(newBB);
-
-    mlir::OpBuilder builder = mlir::OpBuilder::atBlockBegin(BB);
-    builder.create<BranchOp>(loc, newBB);
-    BB = newBB;
-  }
-
-  // dump transformed function
-  // graph.dump();
-
-  // run MLIR Liveness analysis
-  auto liveness = Liveness(graph);
-
-  for (BlockArgument &arg :
-       graph.getBody().getBlocks().front().getArguments()) {
-    auto liveOps = liveness.resolveLiveness(arg);
-    for (Operation *o : liveOps) {
-      livenessIntervals[arg].push_back(o);
-    }
-  }
-
-  graph.walk([&](Operation *op) {
-    auto attr = op->getAttrOfType<StringAttr>("layer_name");
-    if (!attr)
+  // A value is live from its definition (or the start of the function, for
+  // arguments) through the last use of it or of a view of it. Arguments
+  // report every op they are live at; results only the named layers.
+  BlockLiveness liveness(graph.getBody().front());
+  ArrayRef<Operation *> ops = liveness.getOps();
+  auto addInterval = [&](Value v, unsigned start, bool onlyLayers) {
+    Optional<unsigned> range = liveness.getRangeIndex(v);
+    if (!range)
       return;
-
-    for (Value v : op->getResults()) {
-      auto liveOps = liveness.resolveLiveness(v);
-      for (Operation *o : liveOps)
-        if (auto a = o->getAttrOfType<StringAttr>("layer_name"))
-          livenessIntervals[v].push_back(o);
-    }
-  });
-
-  // undo the BB insert
-  auto *deadBr = bodyRegion.getBlocks().front().getTerminator();
-  for (Block *b : new_blocks) {
-
-    auto *br = b->getTerminator();
-    std::vector<Operation *> ops;
-    for (auto &op : b->getOperations())
-      ops.push_back(&op);
-
-    for (auto *op : ops) {
-      if (op == br && !dyn_cast<ReturnOp>(op)) {
-        op->erase();
-        continue;
-      }
-      op->moveBefore(deadBr);
-    }
+    unsigned end = liveness.getRanges()[*range].end;
+    for (unsigned i = start; i <= end; i++)
+      if (!onlyLayers || ops[i]->getAttrOfType<StringAttr>("layer_name"))
+        livenessIntervals[v].push_back(ops[i]);
+  };
+
+  for (BlockArgument arg : graph.getArguments())
+    addInterval(arg, 0, /*onlyLayers=*/false);
+  for (Operation *op : ops) {
+    if (!op->getAttrOfType<StringAttr>("layer_name"))
+      continue;
+    for (Value v : op->getResults())
+      addInterval(v, liveness.getIndex(op), /*onlyLayers=*/true);
   }
-  deadBr->erase();
-
-  for (Block *b : new_blocks)
-    b->erase();
-
-  // graph.dump();
 }
 
 } // namespace aten
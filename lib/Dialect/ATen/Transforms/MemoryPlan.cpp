@@ -0,0 +1,198 @@
+//===- MemoryPlan.cpp -------------------------------------------*- C++ -*-===//
+//
+// This file is licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "npcomp/Dialect/ATen/Transforms/MemoryPlan.h"
+
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/Operation.h"
+#include "npcomp/Dialect/ATen/Transforms/OpCostAnalysis.h"
+#include "npcomp/Dialect/Numpy/IR/NumpyDialect.h"
+#include "llvm/ADT/StringSwitch.h"
+#include "llvm/Support/Debug.h"
+
+#include <map>
+
+#define DEBUG_TYPE "aten-memory-plan"
+
+using namespace mlir;
+using namespace mlir::NPCOMP;
+using namespace mlir::NPCOMP::aten;
+
+static bool isTensorLike(Type type) {
+  return type.isa<ShapedType, Numpy::NdArrayType>();
+}
+
+// Ops whose result is a view of their first operand rather than new storage.
+static bool isViewOp(Operation *op) {
+  return llvm::StringSwitch<bool>(op->getName().getStringRef())
+      .Cases("aten.t", "aten.view", "aten.flatten", "aten.squeeze",
+             "aten.unsqueeze", "aten.expand", "aten.as_strided", true)
+      .Cases("std.memref_cast", "std.memref_reinterpret_cast", "std.subview",
+             "std.tensor_cast", "linalg.reshape", "linalg.tensor_reshape",
+             true)
+      .Default(false);
+}
+
+static bool isConstantOp(Operation *op) {
+  return op->hasTrait<OpTrait::ConstantLike>() ||
+         op->getName().getStringRef() == "aten.constant";
+}
+
+static uint64_t alignTo(uint64_t bytes, uint64_t alignment) {
+  return (bytes + alignment - 1) / alignment * alignment;
+}
+
+//===----------------------------------------------------------------------===//
+// BlockLiveness
+//===----------------------------------------------------------------------===//
+
+BlockLiveness::BlockLiveness(Block &block) {
+  for (Operation &op : block) {
+    opIndex[&op] = ops.size();
+    ops.push_back(&op);
+  }
+  Operation *terminator = ops.empty() ? nullptr : ops.back();
+
+  auto addRange = [&](Value value, LiveRange::Kind kind, unsigned start) {
+    Optional<uint64_t> bytes = getStaticSizeInBytes(value.getType());
+    if (!bytes)
+      numDynamicRanges++;
+    rangeIndex[value] = ranges.size();
+    ranges.push_back({value, kind, start, start, bytes ? *bytes : 0, false});
+  };
+  // Extend the range of `value` to cover its uses, given by their ancestors
+  // in the block.
+  auto addUses = [&](Value value, unsigned range) {
+    for (Operation *user : value.getUsers()) {
+      Operation *ancestor = block.findAncestorOpInBlock(*user);
+      if (!ancestor)
+        continue;
+      ranges[range].end = std::max(ranges[range].end, opIndex[ancestor]);
+      if (ancestor == terminator)
+        ranges[range].escapes = true;
+    }
+  };
+
+  for (BlockArgument arg : block.getArguments()) {
+    if (!isTensorLike(arg.getType()))
+      continue;
+    addRange(arg, LiveRange::Kind::Argument, 0);
+    addUses(arg, ranges.size() - 1);
+  }
+  for (unsigned i = 0, e = ops.size(); i < e; i++) {
+    Operation *op = ops[i];
+    if (isViewOp(op) && op->getNumOperands() && op->getNumResults() == 1) {
+      auto it = rangeIndex.find(op->getOperand(0));
+      if (it != rangeIndex.end()) {
+        rangeIndex[op->getResult(0)] = it->second;
+        addUses(op->getResult(0), it->second);
+        continue;
+      }
+    }
+    LiveRange::Kind kind = isConstantOp(op) ? LiveRange::Kind::Constant
+                                            : LiveRange::Kind::Intermediate;
+    for (Value result : op->getResults()) {
+      if (!isTensorLike(result.getType()))
+        continue;
+      addRange(result, kind, i);
+      addUses(result, ranges.size() - 1);
+    }
+  }
+
+  // Sum the live bytes at each op with a difference array over the ranges.
+  std::vector<int64_t> delta(ops.size() + 1, 0);
+  for (const LiveRange &range : ranges) {
+    if (range.kind == LiveRange::Kind::Constant || ops.empty())
+      continue;
+    delta[range.start] += range.bytes;
+    delta[range.end + 1] -= range.bytes;
+  }
+  liveBytes.resize(ops.size());
+  int64_t live = 0;
+  for (unsigned i = 0, e = ops.size(); i < e; i++) {
+    live += delta[i];
+    liveBytes[i] = live;
+    if (liveBytes[i] > peakBytes) {
+      peakBytes = liveBytes[i];
+      peakIndex = i;
+    }
+  }
+}
+
+Optional<unsigned> BlockLiveness::getRangeIndex(Value value) const {
+  auto it = rangeIndex.find(value);
+  if (it == rangeIndex.end())
+    return llvm::None;
+  return it->second;
+}
+
+//===----------------------------------------------------------------------===//
+// MemoryPlan
+//===----------------------------------------------------------------------===//
+
+MemoryPlan::MemoryPlan(Operation *op)
+    : liveness(op->getRegion(0).front()) {
+  ArrayRef<LiveRange> ranges = liveness.getRanges();
+  unsigned numOps = liveness.getOps().size();
+  rangeToBuffer.assign(ranges.size(), -1);
+
+  // Bucket the planned ranges by the op where they start and end.
+  std::vector<std::vector<unsigned>> starting(numOps), ending(numOps);
+  for (unsigned i = 0, e = ranges.size(); i < e; i++) {
+    const LiveRange &range = ranges[i];
+    if (range.kind != LiveRange::Kind::Intermediate || range.escapes ||
+        range.bytes == 0)
+      continue;
+    starting[range.start].push_back(i);
+    ending[range.end].push_back(i);
+    plannedBytes += alignTo(range.bytes, kAlignment);
+  }
+
+  // Free buffers by size.
+  std::multimap<uint64_t, unsigned> freeBuffers;
+  for (unsigned i = 0; i < numOps; i++) {
+    // The results of an op are allocated while its operands are still live,
+    // so they never share storage.
+    for (unsigned r : starting[i]) {
+      uint64_t bytes = alignTo(ranges[r].bytes, kAlignment);
+      unsigned buffer;
+      auto fit = freeBuffers.lower_bound(bytes);
+      if (fit != freeBuffers.end()) {
+        buffer = fit->second;
+        freeBuffers.erase(fit);
+      } else if (!freeBuffers.empty()) {
+        auto largest = std::prev(freeBuffers.end());
+        buffer = largest->second;
+        freeBuffers.erase(largest);
+        buffers[buffer].bytes = bytes;
+      } else {
+        buffer = buffers.size();
+        buffers.push_back({0, bytes});
+      }
+      rangeToBuffer[r] = buffer;
+    }
+    for (unsigned r : ending[i]) {
+      unsigned buffer = rangeToBuffer[r];
+      freeBuffers.emplace(buffers[buffer].bytes, buffer);
+    }
+  }
+
+  for (Buffer &buffer : buffers) {
+    buffer.offset = arenaBytes;
+    arenaBytes += buffer.bytes;
+  }
+  LLVM_DEBUG(llvm::dbgs() << "planned " << plannedBytes << " bytes into "
+                          << buffers.size() << " buffers, " << arenaBytes
+                          << " bytes\n");
+}
+
+Optional<unsigned> MemoryPlan::getBufferIndex(unsigned rangeIndex) const {
+  if (rangeToBuffer[rangeIndex] < 0)
+    return llvm::None;
+  return rangeToBuffer[rangeIndex];
+}
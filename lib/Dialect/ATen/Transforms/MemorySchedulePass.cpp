@@ -0,0 +1,233 @@
+//===- MemorySchedulePass.cpp -----------------------------------*- C++ -*-===//
+//
+// This file is licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Reorders the ops of straight-line functions to reduce the peak bytes of
+// live tensors. Captured graphs are in the order the trace dispatched them,
+// which can compute an activation long before it is needed, or keep one
+// alive while unrelated branches run.
+//
+// This is greedy list scheduling over the data dependencies: among the ops
+// whose operands are all available, run the one that grows memory the least,
+// i.e. the bytes it allocates minus the bytes of the tensors it is the last
+// user of. Ties keep the original order. Ops with side effects stay in their
+// original relative order.
+//
+//===----------------------------------------------------------------------===//
+
+#include "PassDetail.h"
+
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
+#include "npcomp/Dialect/ATen/Transforms/MemoryPlan.h"
+#include "npcomp/Dialect/ATen/Transforms/Passes.h"
+
+#include <queue>
+
+#define DEBUG_TYPE "aten-memory-schedule"
+
+using namespace mlir;
+using namespace mlir::NPCOMP;
+using namespace mlir::NPCOMP::aten;
+
+namespace {
+
+// Whether `op` may move past the other ops that need not stay ordered. TCF
+// ops have no memory effects, only error semantics, so moving them changes
+// at most which of several errors is reported.
+static bool isReorderable(Operation *op) {
+  return wouldOpBeTriviallyDead(op) || op->getName().getDialect() == "tcf";
+}
+
+/// Computes a memory-minimizing order for the non-terminator ops of a block,
+/// simulating live bytes with the same model as BlockLiveness.
+class MemoryScheduler {
+public:
+  MemoryScheduler(Block &block, const BlockLiveness &liveness)
+      : liveness(liveness), ops(liveness.getOps().drop_back()) {
+    ArrayRef<LiveRange> ranges = liveness.getRanges();
+    unsigned numOps = ops.size();
+    usedRanges.resize(numOps);
+    createdRanges.resize(numOps);
+    successors.resize(numOps);
+    numPredecessors.assign(numOps, 0);
+    rangeUsers.resize(ranges.size());
+    usesLeft.assign(ranges.size(), 0);
+
+    for (unsigned r = 0, e = ranges.size(); r < e; r++) {
+      Operation *def = ranges[r].value.getDefiningOp();
+      if (def && liveness.getIndex(def) < numOps)
+        createdRanges[liveness.getIndex(def)].push_back(r);
+    }
+
+    int lastImpure = -1;
+    for (unsigned i = 0; i < numOps; i++) {
+      // Values of the block used by the op or by ops nested in it.
+      SmallVector<unsigned, 8> preds;
+      ops[i]->walk([&](Operation *nested) {
+        for (Value operand : nested->getOperands()) {
+          if (Optional<unsigned> r = liveness.getRangeIndex(operand))
+            usedRanges[i].push_back(*r);
+          Operation *def = operand.getDefiningOp();
+          if (def && def->getBlock() == &block)
+            preds.push_back(liveness.getIndex(def));
+        }
+      });
+      if (!isReorderable(ops[i])) {
+        if (lastImpure >= 0)
+          preds.push_back(lastImpure);
+        lastImpure = i;
+      }
+      llvm::sort(preds);
+      preds.erase(std::unique(preds.begin(), preds.end()), preds.end());
+      for (unsigned pred : preds) {
+        successors[pred].push_back(i);
+        numPredecessors[i]++;
+      }
+      SmallVectorImpl<unsigned> &used = usedRanges[i];
+      llvm::sort(used);
+      used.erase(std::unique(used.begin(), used.end()), used.end());
+      for (unsigned r : used) {
+        rangeUsers[r].push_back(i);
+        usesLeft[r]++;
+      }
+    }
+  }
+
+  /// Return the new order of the ops, and the peak bytes it reaches.
+  std::vector<Operation *> schedule(uint64_t &peakBytes) {
+    ArrayRef<LiveRange> ranges = liveness.getRanges();
+    std::vector<Operation *> order;
+    scheduled.assign(ops.size(), false);
+    int64_t live = 0;
+    for (unsigned r = 0, e = ranges.size(); r < e; r++)
+      if (ranges[r].kind == LiveRange::Kind::Argument &&
+          (usesLeft[r] || ranges[r].escapes))
+        live += ranges[r].bytes;
+    peakBytes = live;
+
+    for (unsigned i = 0, e = ops.size(); i < e; i++)
+      if (numPredecessors[i] == 0)
+        push(i);
+
+    while (!ready.empty()) {
+      auto top = ready.top();
+      ready.pop();
+      unsigned i = top.second;
+      if (scheduled[i])
+        continue;
+      // Other ops may have become the last users of some of its operands
+      // since it was queued, making it cheaper.
+      int64_t delta = getDelta(i);
+      if (delta != top.first) {
+        ready.push({delta, i});
+        continue;
+      }
+
+      scheduled[i] = true;
+      order.push_back(ops[i]);
+      for (unsigned r : createdRanges[i])
+        live += getBytes(r);
+      peakBytes = std::max<uint64_t>(peakBytes, live);
+      for (unsigned r : usedRanges[i]) {
+        if (--usesLeft[r] == 0 && !ranges[r].escapes)
+          live -= getBytes(r);
+        else if (usesLeft[r] == 1 && !ranges[r].escapes)
+          // The remaining user now frees this tensor.
+          for (unsigned user : rangeUsers[r])
+            if (!scheduled[user] && numPredecessors[user] == 0)
+              push(user);
+      }
+      for (unsigned r : createdRanges[i])
+        if (usesLeft[r] == 0 && !ranges[r].escapes)
+          live -= getBytes(r);
+      for (unsigned succ : successors[i])
+        if (--numPredecessors[succ] == 0)
+          push(succ);
+    }
+    assert(order.size() == ops.size() && "dependence cycle in a block");
+    return order;
+  }
+
+private:
+  int64_t getBytes(unsigned r) const {
+    const LiveRange &range = liveness.getRanges()[r];
+    return range.kind == LiveRange::Kind::Constant ? 0 : range.bytes;
+  }
+
+  /// The growth of live bytes after running op `i`.
+  int64_t getDelta(unsigned i) const {
+    ArrayRef<LiveRange> ranges = liveness.getRanges();
+    int64_t delta = 0;
+    for (unsigned r : createdRanges[i])
+      if (usesLeft[r] != 0 || ranges[r].escapes)
+        delta += getBytes(r);
+    for (unsigned r : usedRanges[i])
+      if (usesLeft[r] == 1 && !ranges[r].escapes)
+        delta -= getBytes(r);
+    return delta;
+  }
+
+  void push(unsigned i) { ready.push({getDelta(i), i}); }
+
+  const BlockLiveness &liveness;
+  ArrayRef<Operation *> ops;
+  std::vector<SmallVector<unsigned, 4>> usedRanges;
+  std::vector<SmallVector<unsigned, 2>> createdRanges;
+  std::vector<SmallVector<unsigned, 4>> successors;
+  std::vector<unsigned> numPredecessors;
+  std::vector<SmallVector<unsigned, 4>> rangeUsers;
+  std::vector<unsigned> usesLeft;
+  std::vector<bool> scheduled;
+  // Ready ops by (delta, original index), smallest first.
+  using Entry = std::pair<int64_t, unsigned>;
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> ready;
+};
+
+class ATenMemorySchedulePass
+    : public ATenMemoryScheduleBase<ATenMemorySchedulePass> {
+  void runOnOperation() override {
+    FuncOp func = getOperation();
+    if (func.isExternal() || !llvm::hasSingleElement(func.getBody()))
+      return;
+    Block &block = func.getBody().front();
+    if (block.empty() || !block.back().isKnownTerminator())
+      return;
+
+    BlockLiveness liveness(block);
+    uint64_t before = liveness.getPeakBytes();
+    uint64_t after = before;
+    MemoryScheduler scheduler(block, liveness);
+    uint64_t scheduledPeak;
+    std::vector<Operation *> order = scheduler.schedule(scheduledPeak);
+    // The greedy choice can lose on unlucky graphs; keep the original order
+    // unless the new one is better.
+    if (scheduledPeak < before) {
+      Operation *terminator = block.getTerminator();
+      for (Operation *op : order)
+        op->moveBefore(terminator);
+      after = BlockLiveness(block).getPeakBytes();
+      if (after >= before) {
+        for (Operation *op : liveness.getOps().drop_back())
+          op->moveBefore(terminator);
+        after = before;
+      }
+    }
+    if (after == before)
+      markAllAnalysesPreserved();
+    if (report)
+      func.emitRemark() << "peak live tensor bytes: " << before << " -> "
+                        << after;
+  }
+};
+
+} // namespace
+
+std::unique_ptr<OperationPass<FuncOp>>
+mlir::NPCOMP::aten::createATenMemorySchedulePass() {
+  return std::make_unique<ATenMemorySchedulePass>();
+}
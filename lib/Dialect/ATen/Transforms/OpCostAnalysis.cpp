@@ -0,0 +1,633 @@
+//===- OpCostAnalysis.cpp ---------------------------------------*- C++ -*-===//
+//
+// This file is licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// A static cost model for ATen, TCF and linalg ops. Costs depend only on the
+// op and its types, so they are computed once per op and shared by every
+// consumer (the op report, fusion, tiling and scheduling heuristics).
+//
+// Ops are matched by name so that the ATen ops, whose operands are positional
+// in PyTorch's schemas, and the TCF ops, which model the same computations,
+// share one description.
+//
+//===----------------------------------------------------------------------===//
+
+#include "npcomp/Dialect/ATen/Transforms/OpCostAnalysis.h"
+
+#include "mlir/Dialect/Linalg/IR/LinalgOps.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/Matchers.h"
+#include "npcomp/Dialect/ATen/IR/ATenConstantUtils.h"
+#include "npcomp/Dialect/ATen/IR/ATenDialect.h"
+#include "npcomp/Dialect/Numpy/IR/NumpyDialect.h"
+#include "npcomp/Dialect/Numpy/IR/NumpyOps.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/StringSwitch.h"
+
+#define DEBUG_TYPE "aten-op-cost"
+
+using namespace mlir;
+using namespace mlir::NPCOMP;
+using namespace mlir::NPCOMP::aten;
+
+StringRef aten::getFlopKindName(FlopKind kind) {
+  switch (kind) {
+  case FlopKind::MAC:
+    return "mac";
+  case FlopKind::Add:
+    return "add";
+  case FlopKind::Mul:
+    return "mul";
+  case FlopKind::Div:
+    return "div";
+  case FlopKind::Compare:
+    return "compare";
+  case FlopKind::Transcendental:
+    return "transcendental";
+  case FlopKind::Other:
+    return "other";
+  }
+  llvm_unreachable("unknown flop kind");
+}
+
+uint64_t OpCost::getTotalFlops() const {
+  uint64_t total = (*this)[FlopKind::MAC];
+  for (uint64_t count : flops)
+    total += count;
+  return total;
+}
+
+double OpCost::getArithmeticIntensity() const {
+  uint64_t bytes = getBytesMoved();
+  return bytes ? static_cast<double>(getTotalFlops()) / bytes : 0.0;
+}
+
+OpCost &OpCost::operator+=(const OpCost &other) {
+  for (unsigned i = 0; i < kNumFlopKinds; i++)
+    flops[i] += other.flops[i];
+  bytesRead += other.bytesRead;
+  bytesWritten += other.bytesWritten;
+  parameterBytes += other.parameterBytes;
+  known = known && other.known;
+  return *this;
+}
+
+namespace {
+
+// Whether `value` is a constant tensor, such as an imported parameter.
+static bool isConstantTensor(Value value) {
+  Attribute attr = getConstantValue(lookThroughParameterCopy(value));
+  return attr && attr.isa<ElementsAttr>();
+}
+
+// Return the product of a constant integer list, given as an array attribute
+// or as the value of a list constant, or None if it is not one.
+static Optional<uint64_t> getProduct(Attribute attr) {
+  uint64_t product = 1;
+  if (auto array = attr.dyn_cast_or_null<ArrayAttr>()) {
+    for (Attribute element : array) {
+      auto intAttr = element.dyn_cast<IntegerAttr>();
+      if (!intAttr)
+        return llvm::None;
+      product *= intAttr.getInt();
+    }
+    return product;
+  }
+  if (auto elements = attr.dyn_cast_or_null<DenseIntElementsAttr>()) {
+    for (const APInt &element : elements)
+      product *= element.getSExtValue();
+    return product;
+  }
+  return llvm::None;
+}
+
+static Optional<uint64_t> getElementBytes(Type type) {
+  if (type.isIndex())
+    return 8;
+  if (type.isIntOrFloat())
+    return (type.getIntOrFloatBitWidth() + 7) / 8;
+  if (auto complex = type.dyn_cast<ComplexType>())
+    if (auto bytes = getElementBytes(complex.getElementType()))
+      return 2 * *bytes;
+  return llvm::None;
+}
+
+/// Accumulates the cost of one op from the static types of its operands and
+/// results. Any dynamic shape the model depends on makes the cost unknown.
+class CostBuilder {
+public:
+  /// Return the tensor-like type of `value` (tensors, memrefs and numpy
+  /// arrays), or null for scalars, lists and None.
+  ShapedType getShapedType(Value value) {
+    Type type = value.getType();
+    if (auto array = type.dyn_cast<Numpy::NdArrayType>())
+      return array.toTensorType();
+    return type.dyn_cast<ShapedType>();
+  }
+
+  /// Return the number of elements of `value`, or 0 if it is not tensor-like.
+  uint64_t getVolume(Value value) {
+    ShapedType type = getShapedType(value);
+    if (!type)
+      return 0;
+    if (!type.hasStaticShape()) {
+      cost.known = false;
+      return 0;
+    }
+    return type.getNumElements();
+  }
+
+  int64_t getDimSize(Value value, unsigned dim) {
+    ShapedType type = getShapedType(value);
+    if (!type || !type.hasRank() || dim >= type.getRank() ||
+        type.isDynamicDim(dim)) {
+      cost.known = false;
+      return 0;
+    }
+    return type.getDimSize(dim);
+  }
+
+  /// Return the product of the dimensions of `value` from `dim` on.
+  uint64_t getTrailingVolume(Value value, unsigned dim) {
+    ShapedType type = getShapedType(value);
+    if (!type || !type.hasRank() || dim > type.getRank()) {
+      cost.known = false;
+      return 0;
+    }
+    uint64_t volume = 1;
+    for (unsigned i = dim, e = type.getRank(); i < e; i++)
+      volume *= getDimSize(value, i);
+    return volume;
+  }
+
+  uint64_t getBytes(Value value, uint64_t numElements) {
+    ShapedType type = getShapedType(value);
+    if (!type || numElements == 0)
+      return 0;
+    Optional<uint64_t> elementBytes = getElementBytes(type.getElementType());
+    if (!elementBytes) {
+      cost.known = false;
+      return 0;
+    }
+    return numElements * *elementBytes;
+  }
+
+  /// Read `numElements` elements of `value`, by default all of them.
+  void read(Value value, bool isParameter = false,
+            Optional<uint64_t> numElements = llvm::None) {
+    uint64_t bytes =
+        getBytes(value, numElements ? *numElements : getVolume(value));
+    cost.bytesRead += bytes;
+    if (isParameter || isConstantTensor(value))
+      cost.parameterBytes += bytes;
+  }
+  void write(Value value) {
+    cost.bytesWritten += getBytes(value, getVolume(value));
+  }
+
+  /// Read every tensor operand, treating those at `parameterOperands` as
+  /// parameters.
+  void readOperands(Operation *op, ArrayRef<unsigned> parameterOperands = {}) {
+    for (auto operand : llvm::enumerate(op->getOperands()))
+      read(operand.value(), llvm::is_contained(parameterOperands,
+                                               (unsigned)operand.index()));
+  }
+  void writeResults(Operation *op) {
+    for (Value result : op->getResults())
+      write(result);
+  }
+
+  void count(FlopKind kind, uint64_t count) { cost[kind] += count; }
+
+  OpCost getCost() const { return cost.known ? cost : OpCost::getUnknown(); }
+
+private:
+  OpCost cost;
+};
+
+/// The arithmetic performed per result element by an elementwise op.
+struct ElementwiseFlops {
+  FlopKind kind;
+  unsigned count;
+};
+
+static Optional<ElementwiseFlops> getElementwiseFlops(StringRef name) {
+  using Result = Optional<ElementwiseFlops>;
+  ElementwiseFlops add{FlopKind::Add, 1}, mul{FlopKind::Mul, 1},
+      div{FlopKind::Div, 1}, compare{FlopKind::Compare, 1},
+      clamp{FlopKind::Compare, 2}, transcendental{FlopKind::Transcendental, 1},
+      other{FlopKind::Other, 1};
+  return llvm::StringSwitch<Result>(name)
+      .Cases("aten.add", "aten.add_", "aten.sub", "aten.sub_", "aten.neg",
+             "tcf.add", "tcf.sub", add)
+      .Cases("aten.mul", "aten.mul_", "tcf.mul", mul)
+      .Cases("aten.div", "aten.div_", "aten.true_divide", "aten.floor_divide",
+             "aten.remainder", "aten.reciprocal", "tcf.div", div)
+      .Cases("aten.maximum", "aten.minimum", "aten.relu", "aten.relu_",
+             "aten.abs", "aten.sign", "aten.threshold_backward", "tcf.max",
+             "tcf.min", "tcf.compare", compare)
+      .Cases("aten.hardtanh", "aten.hardtanh_", "aten.hardtanh_backward",
+             "tcf.clamp", clamp)
+      .Cases("aten.exp", "aten.expm1", "aten.log", "aten.log10", "aten.log1p",
+             "aten.log2", "aten.sqrt", "aten.rsqrt", "aten.sigmoid",
+             transcendental)
+      .Cases("aten.sin", "aten.cos", "aten.tan", "aten.asin", "aten.acos",
+             "aten.atan", "aten.atan2", "aten.sinh", "aten.cosh", "aten.tanh",
+             transcendental)
+      .Cases("aten.erf", "aten.erfc", "aten.erfinv", "aten.digamma",
+             "aten.lgamma", "tcf.exp", "tcf.tanh", "tcf.log", "tcf.sqrt",
+             "tcf.sigmoid", transcendental)
+      .Cases("aten.ceil", "aten.floor", "aten.round", "aten.trunc",
+             "aten.frac", "aten.conj", "aten.angle", other)
+      .Default(llvm::None);
+}
+
+/// Ops that only change how a tensor is viewed, or that produce constants.
+static bool isFreeOp(StringRef name) {
+  return llvm::StringSwitch<bool>(name)
+      .Cases("aten.t", "aten.view", "aten.flatten", "aten.squeeze",
+             "aten.unsqueeze", "aten.expand", "aten.as_strided", "aten.size",
+             "aten.constant", "aten.type_cast", true)
+      .Default(false);
+}
+
+// Batch norm over an [N, C, ...] input, either computing the batch
+// statistics (training) or using the running ones.
+static void countBatchNorm(CostBuilder &b, Value input, bool training) {
+  uint64_t volume = b.getVolume(input);
+  uint64_t channels = b.getDimSize(input, 1);
+  if (training) {
+    // Sum and sum of squares for the statistics, then the mean and variance
+    // of each channel.
+    b.count(FlopKind::Add, 2 * volume + channels);
+    b.count(FlopKind::Mul, volume + 2 * channels);
+  }
+  // Per channel 1 / sqrt(var + eps); per element (x - mean) * rstd * w + b.
+  b.count(FlopKind::Add, channels);
+  b.count(FlopKind::Transcendental, channels);
+  b.count(FlopKind::Div, channels);
+  b.count(FlopKind::Add, 2 * volume);
+  b.count(FlopKind::Mul, 2 * volume);
+}
+
+// log_softmax: max, subtract, exp and sum along the axis, then a log per row
+// (ignored) and a final subtract.
+static void countLogSoftmax(CostBuilder &b, Value input) {
+  uint64_t volume = b.getVolume(input);
+  b.count(FlopKind::Compare, volume);
+  b.count(FlopKind::Add, 3 * volume);
+  b.count(FlopKind::Transcendental, volume);
+}
+
+// Return whether `op` is modeled, accumulating its cost into `b`.
+static bool computeATenOrTCFCost(Operation *op, CostBuilder &b) {
+  StringRef name = op->getName().getStringRef();
+  if (isFreeOp(name))
+    return true;
+
+  if (Optional<ElementwiseFlops> elementwise = getElementwiseFlops(name)) {
+    b.readOperands(op);
+    b.writeResults(op);
+    for (Value result : op->getResults())
+      b.count(elementwise->kind, elementwise->count * b.getVolume(result));
+    return true;
+  }
+
+  // Matrix multiplies: [M, K] x [K, N].
+  if (name == "aten.mm" || name == "aten.mm_prepacked" ||
+      name == "tcf.matmul") {
+    // Neither operand is a parameter by position: both are activations in
+    // attention scores (q @ k^T), and the lhs is the weight in W @ x. So only
+    // constant operands count, as for other ops.
+    Value lhs = op->getOperand(0), result = op->getResult(0);
+    b.readOperands(op);
+    b.writeResults(op);
+    b.count(FlopKind::MAC, b.getVolume(result) * b.getDimSize(lhs, 1));
+    return true;
+  }
+  if (name == "aten.addmm" || name == "aten.addmm_prepacked" ||
+      name == "aten.mm_update") {
+    // mm_update(param, lhs, rhs, alpha) has the layout of addmm, but only
+    // the updated parameter is a parameter.
+    Value mat1 = op->getOperand(1), result = op->getResult(0);
+    if (name != "aten.mm_update")
+      b.readOperands(op, /*parameterOperands=*/{0, 2});
+    else
+      b.readOperands(op, /*parameterOperands=*/{0});
+    b.writeResults(op);
+    b.count(FlopKind::MAC, b.getVolume(result) * b.getDimSize(mat1, 1));
+    b.count(FlopKind::Add, b.getVolume(result));
+    return true;
+  }
+
+  // Convolutions. Weights are [C_out, C_in / groups, K...], so each output
+  // element takes one MAC per element of a filter, which accounts for the
+  // groups. Transposed convolutions instead scatter each input element.
+  if (name == "aten.convolution" || name == "tcf.conv_2d_nchw") {
+    Value input = op->getOperand(0), weight = op->getOperand(1);
+    Value result = op->getResult(0);
+    bool transposed = false;
+    if (name == "aten.convolution")
+      matchConstantBool(op->getOperand(6), transposed);
+    b.readOperands(op, /*parameterOperands=*/{1, 2});
+    b.writeResults(op);
+    b.count(FlopKind::MAC, b.getVolume(transposed ? input : result) *
+                               b.getTrailingVolume(weight, 1));
+    if (op->getNumOperands() > 2 && b.getShapedType(op->getOperand(2)))
+      b.count(FlopKind::Add, b.getVolume(result));
+    return true;
+  }
+  if (name == "aten.convolution_backward" ||
+      name == "aten.convolution_backward_update") {
+    // Both the input and weight gradients take as many MACs as the forward
+    // convolution; the bias gradient sums the output gradient. A fused
+    // update reads the parameter (operand 10) and adds the scaled gradient
+    // to it.
+    Value gradOutput = op->getOperand(0), weight = op->getOperand(2);
+    bool update = name == "aten.convolution_backward_update";
+    if (update)
+      b.readOperands(op, /*parameterOperands=*/{2, 10});
+    else
+      b.readOperands(op, /*parameterOperands=*/{2});
+    b.writeResults(op);
+    b.count(FlopKind::MAC, 2 * b.getVolume(gradOutput) *
+                               b.getTrailingVolume(weight, 1));
+    b.count(FlopKind::Add, b.getVolume(gradOutput));
+    if (update)
+      b.count(FlopKind::MAC, b.getVolume(weight));
+    return true;
+  }
+
+  if (name == "aten.batch_norm" || name == "aten.native_batch_norm") {
+    bool training = true;
+    matchConstantBool(op->getOperand(5), training);
+    b.readOperands(op, /*parameterOperands=*/{1, 2, 3, 4});
+    b.writeResults(op);
+    countBatchNorm(b, op->getOperand(0), training);
+    return true;
+  }
+  if (name == "tcf.batch_norm_inference") {
+    b.readOperands(op, /*parameterOperands=*/{1, 2, 3, 4});
+    b.writeResults(op);
+    countBatchNorm(b, op->getOperand(0), /*training=*/false);
+    return true;
+  }
+  if (name == "aten.native_batch_norm_backward") {
+    Value input = op->getOperand(1);
+    uint64_t volume = b.getVolume(input);
+    uint64_t channels = b.getDimSize(input, 1);
+    b.readOperands(op, /*parameterOperands=*/{2, 3, 4});
+    b.writeResults(op);
+    // Gradients of the scale and shift, then of the input through the
+    // normalization and the batch statistics.
+    b.count(FlopKind::Mul, 3 * volume + 6 * channels);
+    b.count(FlopKind::Add, 4 * volume);
+    b.count(FlopKind::Transcendental, channels);
+    return true;
+  }
+
+  // Pooling.
+  if (name == "aten.max_pool2d" || name == "aten.max_pool2d_with_indices" ||
+      name == "tcf.max_pool_2d_nchw") {
+    Optional<uint64_t> window =
+        name.startswith("tcf.") ? getProduct(op->getAttr("kernel_size"))
+                                : getProduct(getConstantValue(op->getOperand(1)));
+    if (!window)
+      return false;
+    b.readOperands(op);
+    b.writeResults(op);
+    b.count(FlopKind::Compare, b.getVolume(op->getResult(0)) * (*window - 1));
+    return true;
+  }
+  if (name == "aten.max_pool2d_with_indices_backward") {
+    // Scatter-adds each output gradient to the input position it came from;
+    // the forward input only provides the shape.
+    Value gradOutput = op->getOperand(0);
+    b.read(gradOutput);
+    b.read(op->getOperand(7));
+    b.writeResults(op);
+    b.count(FlopKind::Add, b.getVolume(gradOutput));
+    return true;
+  }
+  if (name == "aten._adaptive_avg_pool2d") {
+    b.read(op->getOperand(0));
+    b.writeResults(op);
+    b.count(FlopKind::Add, b.getVolume(op->getOperand(0)));
+    b.count(FlopKind::Div, b.getVolume(op->getResult(0)));
+    return true;
+  }
+  if (name == "aten._adaptive_avg_pool2d_backward") {
+    // Spreads each output gradient, divided by its window size, over the
+    // input.
+    b.read(op->getOperand(0));
+    b.writeResults(op);
+    b.count(FlopKind::Div, b.getVolume(op->getOperand(0)));
+    b.count(FlopKind::Add, b.getVolume(op->getResult(0)));
+    return true;
+  }
+
+  // Reductions.
+  if (name == "aten.sum" || name == "aten.mean" || name == "tcf.sum" ||
+      name == "tcf.mean") {
+    b.read(op->getOperand(0));
+    b.writeResults(op);
+    b.count(FlopKind::Add, b.getVolume(op->getOperand(0)));
+    if (name.endswith("mean"))
+      b.count(FlopKind::Div, b.getVolume(op->getResult(0)));
+    return true;
+  }
+  if (name == "aten.log_softmax" || name == "tcf.log_softmax") {
+    b.read(op->getOperand(0));
+    b.writeResults(op);
+    countLogSoftmax(b, op->getOperand(0));
+    return true;
+  }
+  if (name == "aten.log_softmax_backward_data") {
+    // grad - exp(output) * sum(grad)
+    Value gradOutput = op->getOperand(0);
+    b.read(gradOutput);
+    b.read(op->getOperand(1));
+    b.writeResults(op);
+    uint64_t volume = b.getVolume(gradOutput);
+    b.count(FlopKind::Transcendental, volume);
+    b.count(FlopKind::Mul, volume);
+    b.count(FlopKind::Add, 2 * volume);
+    return true;
+  }
+
+  // Indexing and losses, which only touch the selected elements.
+  if (name == "aten.gather") {
+    Value result = op->getResult(0);
+    b.read(op->getOperand(0), /*isParameter=*/false, b.getVolume(result));
+    b.read(op->getOperand(2));
+    b.writeResults(op);
+    return true;
+  }
+  if (name == "aten.nll_loss_forward" || name == "aten.nll_loss2d_forward") {
+    // One selected log-probability (and weight) per target, summed.
+    Value target = op->getOperand(1), weight = op->getOperand(2);
+    uint64_t numTargets = b.getVolume(target);
+    b.read(op->getOperand(0), /*isParameter=*/false, numTargets);
+    b.read(target);
+    b.read(weight);
+    b.writeResults(op);
+    b.count(FlopKind::Add, numTargets);
+    if (b.getShapedType(weight))
+      b.count(FlopKind::Mul, numTargets);
+    return true;
+  }
+  if (name == "aten.nll_loss_backward" || name == "aten.nll_loss2d_backward") {
+    // Zero fills the gradient and writes one element per target.
+    Value target = op->getOperand(2), weight = op->getOperand(3);
+    uint64_t numTargets = b.getVolume(target);
+    b.read(op->getOperand(0));
+    b.read(target);
+    b.read(weight);
+    b.read(op->getOperand(6));
+    b.writeResults(op);
+    b.count(FlopKind::Mul, numTargets);
+    return true;
+  }
+  if (name == "aten.copy.inplace") {
+    b.read(op->getOperand(1));
+    b.write(op->getOperand(0));
+    return true;
+  }
+  return false;
+}
+
+static Optional<FlopKind> getScalarFlopKind(StringRef name) {
+  return llvm::StringSwitch<Optional<FlopKind>>(name)
+      .Cases("std.addf", "std.subf", "std.addi", "std.subi", "std.negf",
+             FlopKind::Add)
+      .Cases("std.mulf", "std.muli", FlopKind::Mul)
+      .Cases("std.divf", "std.remf", "std.divi_signed", "std.divi_unsigned",
+             "std.remi_signed", "std.remi_unsigned", FlopKind::Div)
+      .Cases("std.cmpf", "std.cmpi", "std.select", "std.absf", FlopKind::Compare)
+      .Cases("std.ceilf", "std.floorf", "std.copysign", "std.sitofp",
+             "std.fptosi", "std.fpext", "std.fptrunc", FlopKind::Other)
+      .Default(llvm::None);
+}
+
+// Count the arithmetic of one iteration of a linalg op's body. A multiply
+// feeding an add is a MAC.
+static void countLinalgBody(Block &body, uint64_t iterations, CostBuilder &b) {
+  llvm::SmallPtrSet<Operation *, 4> fused;
+  for (Operation &op : body) {
+    StringRef name = op.getName().getStringRef();
+    if (name != "std.addf" && name != "std.addi")
+      continue;
+    StringRef mulName = name == "std.addf" ? "std.mulf" : "std.muli";
+    for (Value operand : op.getOperands()) {
+      Operation *producer = operand.getDefiningOp();
+      if (producer && producer->getBlock() == &body &&
+          producer->getName().getStringRef() == mulName &&
+          producer->hasOneUse()) {
+        fused.insert(producer);
+        fused.insert(&op);
+        break;
+      }
+    }
+  }
+  for (Operation &op : body) {
+    StringRef name = op.getName().getStringRef();
+    if (fused.count(&op)) {
+      if (name == "std.mulf" || name == "std.muli")
+        b.count(FlopKind::MAC, iterations);
+      continue;
+    }
+    if (Optional<FlopKind> kind = getScalarFlopKind(name))
+      b.count(*kind, iterations);
+    else if (name.startswith("math.") || name == "std.exp" ||
+             name == "std.log" || name == "std.sqrt" || name == "std.rsqrt" ||
+             name == "std.tanh")
+      b.count(FlopKind::Transcendental, iterations);
+  }
+}
+
+static OpCost computeLinalgCost(linalg::LinalgOp linalgOp) {
+  CostBuilder b;
+  Operation *op = linalgOp.getOperation();
+  unsigned numInputs = linalgOp.getNumInputs();
+  for (Value input : linalgOp.getInputs())
+    b.read(input);
+
+  // Outputs are only read if the body uses their current value (e.g. as the
+  // accumulator of a reduction).
+  Block *body = op->getNumRegions() && !op->getRegion(0).empty()
+                    ? &op->getRegion(0).front()
+                    : nullptr;
+  for (auto output : llvm::enumerate(linalgOp.getOutputs())) {
+    if (body && !body->getArgument(numInputs + output.index()).use_empty())
+      b.read(output.value());
+    b.write(output.value());
+  }
+
+  if (body) {
+    auto shape = linalgOp.getStaticShape();
+    AffineMap shapesToLoops = linalgOp.getShapesToLoopsMap();
+    if (!shapesToLoops ||
+        llvm::any_of(shape, [](int64_t size) { return size < 0; }))
+      return OpCost::getUnknown();
+    uint64_t iterations = 1;
+    for (int64_t size : shapesToLoops.compose(shape))
+      iterations *= size;
+    countLinalgBody(*body, iterations, b);
+  }
+  return b.getCost();
+}
+
+} // namespace
+
+Optional<uint64_t> aten::getStaticSizeInBytes(Type type) {
+  if (auto array = type.dyn_cast<Numpy::NdArrayType>())
+    type = array.toTensorType();
+  auto shaped = type.dyn_cast<ShapedType>();
+  if (!shaped || !shaped.hasStaticShape())
+    return llvm::None;
+  Optional<uint64_t> elementBytes = getElementBytes(shaped.getElementType());
+  if (!elementBytes)
+    return llvm::None;
+  return shaped.getNumElements() * *elementBytes;
+}
+
+OpCost aten::computeOpCost(Operation *op) {
+  if (auto linalgOp = dyn_cast<linalg::LinalgOp>(op))
+    return computeLinalgCost(linalgOp);
+
+  Dialect *dialect = op->getDialect();
+  StringRef dialectName = dialect ? dialect->getNamespace() : "";
+  if (dialectName != "aten" && dialectName != "tcf")
+    return OpCost();
+
+  CostBuilder b;
+  if (!computeATenOrTCFCost(op, b)) {
+    LLVM_DEBUG(llvm::dbgs() << "no cost model for " << op->getName() << "\n");
+    return OpCost::getUnknown();
+  }
+  return b.getCost();
+}
+
+OpCostAnalysis::OpCostAnalysis(Operation *root) {
+  root->walk([&](Operation *op) {
+    if (op == root)
+      return;
+    OpCost cost = computeOpCost(op);
+    if (cost.isFree())
+      return;
+    total += cost;
+    costs.try_emplace(op, cost);
+  });
+}
+
+OpCost OpCostAnalysis::getCost(Operation *op) const {
+  auto it = costs.find(op);
+  if (it != costs.end())
+    return it->second;
+  return computeOpCost(op);
+}
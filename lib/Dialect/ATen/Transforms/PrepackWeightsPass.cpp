@@ -0,0 +1,177 @@
+//===- PrepackWeightsPass.cpp -----------------------------------*- C++ -*-===//
+//
+// This file is licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Evaluates layout transforms of constant weights at compile time, so that
+// the packed form is stored as the constant and the transform disappears
+// from the generated code.
+//
+// Transposes are always packed. With `gemm-panels`, the rhs of aten.mm and
+// aten.addmm is also packed into the NR-wide, KC-deep panels that the sgemm
+// of the ATen kernel library otherwise repacks it into on every call (see
+// GemmLayout.h), and the op is replaced by its `_prepacked` form. That saves
+// an O(K * N) copy per call, which matters when M is small (e.g. inference
+// with batch size 1). It is opt-in, as only the ATen kernel library
+// implements the `_prepacked` ops.
+//
+// Only weights that have a single use are packed, as packing a shared
+// weight would keep both the original and the packed constant alive.
+//
+//===----------------------------------------------------------------------===//
+
+#include "PassDetail.h"
+
+#include "mlir/Dialect/StandardOps/IR/Ops.h"
+#include "mlir/IR/Matchers.h"
+#include "mlir/IR/PatternMatch.h"
+#include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+#include "npcomp/Dialect/ATen/IR/ATenConstantUtils.h"
+#include "npcomp/Dialect/ATen/IR/ATenDialect.h"
+#include "npcomp/Dialect/ATen/Transforms/Passes.h"
+#include "npcomp/Dialect/Numpy/IR/NumpyOps.h"
+#include "npcomp/RefBackend/ATenKernels/GemmLayout.h"
+
+#define DEBUG_TYPE "aten-prepack-weights"
+
+using namespace mlir;
+using namespace mlir::NPCOMP;
+using namespace mlir::NPCOMP::aten;
+
+namespace {
+
+// Matches a constant f32 matrix that is used only once, looking through
+// parameter copies.
+static DenseFPElementsAttr matchSingleUseConstantMatrix(Value value) {
+  DenseFPElementsAttr weight = matchConstantTensor(value);
+  if (!weight || weight.getType().getRank() != 2)
+    return nullptr;
+  for (;;) {
+    if (!value.hasOneUse())
+      return nullptr;
+    Value source = lookThroughParameterCopy(value);
+    if (source == value)
+      return weight;
+    // Check the intermediate array too.
+    if (!value.getDefiningOp<Numpy::CopyToTensorOp>().source().hasOneUse())
+      return nullptr;
+    value = source;
+  }
+}
+
+/// t(constant W)  ==>  constant W^T
+class PrepackTranspose : public OpRewritePattern<TOp> {
+public:
+  using OpRewritePattern::OpRewritePattern;
+  LogicalResult matchAndRewrite(TOp op,
+                                PatternRewriter &rewriter) const override {
+    DenseFPElementsAttr weight = matchSingleUseConstantMatrix(op.self());
+    if (!weight)
+      return failure();
+    int64_t rows = weight.getType().getDimSize(0);
+    int64_t cols = weight.getType().getDimSize(1);
+    auto transposedType =
+        RankedTensorType::get({cols, rows}, rewriter.getF32Type());
+    // The result must be a tensor of exactly the transposed type for the
+    // constant to replace it.
+    if (op.getType() != transposedType)
+      return failure();
+
+    SmallVector<float, 16> values(weight.getValues<float>());
+    SmallVector<float, 16> transposed(values.size());
+    for (int64_t i = 0; i < rows; i++)
+      for (int64_t j = 0; j < cols; j++)
+        transposed[j * rows + i] = values[i * cols + j];
+    rewriter.replaceOpWithNewOp<mlir::ConstantOp>(
+        op, DenseElementsAttr::get(transposedType,
+                                   llvm::makeArrayRef(transposed)));
+    return success();
+  }
+};
+
+// Returns the constant `weight` [K, N] packed into sgemm panels, or null if
+// `resultType` is not the [M, N] f32 result of multiplying by it.
+static Value createPackedGemmWeight(PatternRewriter &rewriter, Location loc,
+                                    DenseFPElementsAttr weight,
+                                    Type resultType) {
+  int64_t K = weight.getType().getDimSize(0);
+  int64_t N = weight.getType().getDimSize(1);
+  auto type = resultType.dyn_cast<RankedTensorType>();
+  if (!type || type.getRank() != 2 || type.getDimSize(1) != N ||
+      !type.getElementType().isF32())
+    return nullptr;
+
+  SmallVector<float, 16> values(weight.getValues<float>());
+  SmallVector<float, 16> packed(refbackrt::aten::getPackedGemmBSize(K, N),
+                                0.0f);
+  for (int64_t k = 0; k < K; k++)
+    for (int64_t n = 0; n < N; n++)
+      packed[refbackrt::aten::getPackedGemmBIndex(K, N, k, n)] =
+          values[k * N + n];
+  auto packedType = RankedTensorType::get({static_cast<int64_t>(packed.size())},
+                                          rewriter.getF32Type());
+  return rewriter.create<mlir::ConstantOp>(
+      loc, DenseElementsAttr::get(packedType, llvm::makeArrayRef(packed)));
+}
+
+/// mm(x, constant W)  ==>  mm_prepacked(x, constant pack(W))
+class PrepackMm : public OpRewritePattern<MmOp> {
+public:
+  using OpRewritePattern::OpRewritePattern;
+  LogicalResult matchAndRewrite(MmOp op,
+                                PatternRewriter &rewriter) const override {
+    DenseFPElementsAttr weight = matchSingleUseConstantMatrix(op.mat2());
+    if (!weight)
+      return failure();
+    Value packed =
+        createPackedGemmWeight(rewriter, op.getLoc(), weight, op.getType());
+    if (!packed)
+      return failure();
+    rewriter.replaceOpWithNewOp<MmPrepackedOp>(op, op.getType(), op.self(),
+                                               packed);
+    return success();
+  }
+};
+
+/// addmm(b, x, constant W)  ==>  addmm_prepacked(b, x, constant pack(W))
+class PrepackAddmm : public OpRewritePattern<AddmmOp> {
+public:
+  using OpRewritePattern::OpRewritePattern;
+  LogicalResult matchAndRewrite(AddmmOp op,
+                                PatternRewriter &rewriter) const override {
+    DenseFPElementsAttr weight = matchSingleUseConstantMatrix(op.mat2());
+    if (!weight)
+      return failure();
+    Value packed =
+        createPackedGemmWeight(rewriter, op.getLoc(), weight, op.getType());
+    if (!packed)
+      return failure();
+    rewriter.replaceOpWithNewOp<AddmmPrepackedOp>(
+        op, op.getType(), op.self(), op.mat1(), packed, op.beta(), op.alpha());
+    return success();
+  }
+};
+
+class ATenPrepackWeightsPass
+    : public ATenPrepackWeightsBase<ATenPrepackWeightsPass> {
+  void runOnOperation() override {
+    MLIRContext *context = &getContext();
+    OwningRewritePatternList patterns;
+    patterns.insert<PrepackTranspose>(context);
+    if (gemmPanels)
+      patterns.insert<PrepackMm, PrepackAddmm>(context);
+    if (failed(
+            applyPatternsAndFoldGreedily(getOperation(), std::move(patterns))))
+      signalPassFailure();
+  }
+};
+
+} // namespace
+
+std::unique_ptr<OperationPass<FuncOp>>
+mlir::NPCOMP::aten::createATenPrepackWeightsPass() {
+  return std::make_unique<ATenPrepackWeightsPass>();
+}
@@ -0,0 +1,251 @@
+//===- RematerializePass.cpp ------------------------------------*- C++ -*-===//
+//
+// This file is licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Recomputes cheap activations next to their late uses instead of keeping
+// them live. In captured training graphs, every forward activation needed by
+// the backward pass is live across the point where the two meet, which is
+// where the peak usually is.
+//
+// Each step looks at the op where the live bytes peak, and picks a tensor
+// live across it but not used by it, whose defining op is cheap (its
+// arithmetic intensity is low, as for relu, batch norm or other elementwise
+// ops). The op is cloned before the first use after the peak, and those uses
+// are redirected to the clone. Operands of the clone that would otherwise be
+// dead at the peak are either recomputed too, if they are cheap, or counted
+// against the bytes saved. Steps repeat until the peak is within the budget
+// or no tensor can be recomputed profitably.
+//
+//===----------------------------------------------------------------------===//
+
+#include "PassDetail.h"
+
+#include "mlir/IR/BlockAndValueMapping.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
+#include "npcomp/Dialect/ATen/Transforms/MemoryPlan.h"
+#include "npcomp/Dialect/ATen/Transforms/OpCostAnalysis.h"
+#include "npcomp/Dialect/ATen/Transforms/Passes.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/Support/Debug.h"
+
+#define DEBUG_TYPE "aten-rematerialize"
+
+using namespace mlir;
+using namespace mlir::NPCOMP;
+using namespace mlir::NPCOMP::aten;
+
+namespace {
+
+/// The longest chain of ops recomputed for one tensor.
+static constexpr unsigned kMaxChainLength = 8;
+
+/// A way to rematerialize a tensor live across the peak.
+struct Candidate {
+  /// The range of the tensor.
+  unsigned range;
+  /// The ops to clone, in block order; the last one defines the tensor.
+  SmallVector<Operation *, 4> chain;
+  /// Where to insert the clones.
+  Operation *insertionPoint;
+  /// The bytes freed at the peak.
+  int64_t gain;
+  /// The FLOPs recomputed.
+  uint64_t flops;
+};
+
+class Rematerializer {
+public:
+  Rematerializer(Block &block, double maxIntensity)
+      : block(block), liveness(block), maxIntensity(maxIntensity) {}
+
+  const BlockLiveness &getLiveness() const { return liveness; }
+
+  /// Find the best candidate at the current peak, if any.
+  Optional<Candidate> findCandidate() {
+    Optional<Candidate> best;
+    ArrayRef<LiveRange> ranges = liveness.getRanges();
+    unsigned peak = liveness.getPeakIndex();
+    for (unsigned r = 0, e = ranges.size(); r < e; r++) {
+      const LiveRange &range = ranges[r];
+      if (range.kind != LiveRange::Kind::Intermediate || range.escapes ||
+          range.bytes == 0 || range.start >= peak || range.end <= peak)
+        continue;
+      Optional<Candidate> candidate = evaluate(r);
+      if (!candidate || candidate->gain <= 0)
+        continue;
+      if (!best || candidate->gain > best->gain ||
+          (candidate->gain == best->gain && candidate->flops < best->flops))
+        best = std::move(candidate);
+    }
+    return best;
+  }
+
+  /// Apply `candidate`, invalidating the liveness.
+  void apply(const Candidate &candidate) {
+    unsigned peak = liveness.getPeakIndex();
+    Value value = liveness.getRanges()[candidate.range].value;
+    OpBuilder builder(candidate.insertionPoint);
+    BlockAndValueMapping mapping;
+    for (Operation *op : candidate.chain)
+      builder.clone(*op, mapping);
+    Value clone = mapping.lookup(value);
+    value.replaceUsesWithIf(clone, [&](OpOperand &use) {
+      Operation *ancestor = block.findAncestorOpInBlock(*use.getOwner());
+      return ancestor && liveness.getIndex(ancestor) > peak;
+    });
+  }
+
+private:
+  /// Whether `op` is cheap to run twice.
+  bool isCheap(Operation *op) {
+    if (op->getNumRegions() || !(wouldOpBeTriviallyDead(op) ||
+                                 op->getName().getDialect() == "tcf"))
+      return false;
+    OpCost cost = computeOpCost(op);
+    return cost.known && cost.getArithmeticIntensity() <= maxIntensity;
+  }
+
+  Optional<Candidate> evaluate(unsigned r) {
+    ArrayRef<LiveRange> ranges = liveness.getRanges();
+    ArrayRef<uint64_t> liveBytes = liveness.getLiveBytes();
+    unsigned peak = liveness.getPeakIndex();
+    Value value = ranges[r].value;
+    Operation *def = value.getDefiningOp();
+
+    // The uses after the peak must all be direct: views of the tensor would
+    // keep the old storage alive.
+    unsigned firstLateUse = ranges[r].end;
+    for (OpOperand &use : value.getUses()) {
+      Operation *ancestor = block.findAncestorOpInBlock(*use.getOwner());
+      unsigned index = liveness.getIndex(ancestor);
+      if (index == peak)
+        return llvm::None;
+      if (index > peak)
+        firstLateUse = std::min(firstLateUse, index);
+      for (Value result : use.getOwner()->getResults())
+        if (liveness.getRangeIndex(result) == r)
+          return llvm::None;
+    }
+    if (!isCheap(def))
+      return llvm::None;
+
+    Candidate candidate{r, {}, liveness.getOps()[firstLateUse],
+                        static_cast<int64_t>(ranges[r].bytes), 0};
+    // Collect the chain of ops to recompute, and the operands it keeps
+    // alive until the clones.
+    llvm::SetVector<Operation *> chain;
+    llvm::SetVector<unsigned> extended;
+    SmallVector<Operation *, 4> worklist{def};
+    chain.insert(def);
+    while (!worklist.empty()) {
+      Operation *op = worklist.pop_back_val();
+      for (Value operand : op->getOperands()) {
+        Optional<unsigned> o = liveness.getRangeIndex(operand);
+        if (!o || ranges[*o].kind == LiveRange::Kind::Constant ||
+            ranges[*o].end >= firstLateUse || ranges[*o].escapes)
+          continue;
+        Operation *operandDef = operand.getDefiningOp();
+        if (ranges[*o].end < peak && ranges[*o].value == operand &&
+            operandDef && chain.size() < kMaxChainLength &&
+            isCheap(operandDef)) {
+          if (chain.insert(operandDef))
+            worklist.push_back(operandDef);
+          continue;
+        }
+        extended.insert(*o);
+      }
+    }
+    // Operands recomputed along the way need not be kept.
+    for (unsigned o : extended.takeVector())
+      if (!chain.count(ranges[o].value.getDefiningOp()))
+        extended.insert(o);
+
+    // Extending an operand costs its bytes at every op it is extended over,
+    // where the tensor itself is no longer live; that must stay below the
+    // current peak. The clones of the chain are live briefly before the late
+    // use.
+    uint64_t peakBytes = liveness.getPeakBytes();
+    std::vector<int64_t> extra(firstLateUse + 1, 0);
+    for (unsigned o : extended) {
+      for (unsigned i = ranges[o].end + 1; i <= firstLateUse; i++)
+        extra[i] += ranges[o].bytes;
+      if (ranges[o].end < peak)
+        candidate.gain -= ranges[o].bytes;
+    }
+    for (Operation *op : chain)
+      if (op != def)
+        for (Value result : op->getResults())
+          if (Optional<unsigned> o = liveness.getRangeIndex(result))
+            extra[firstLateUse] += ranges[*o].bytes;
+    for (unsigned i = peak + 1; i < firstLateUse; i++)
+      extra[i] -= ranges[r].bytes;
+    for (unsigned i = peak + 1; i <= firstLateUse; i++)
+      if (static_cast<int64_t>(liveBytes[i]) + extra[i] >=
+          static_cast<int64_t>(peakBytes))
+        return llvm::None;
+
+    candidate.chain.assign(chain.begin(), chain.end());
+    llvm::sort(candidate.chain, [&](Operation *a, Operation *b) {
+      return liveness.getIndex(a) < liveness.getIndex(b);
+    });
+    for (Operation *op : candidate.chain)
+      candidate.flops += computeOpCost(op).getTotalFlops();
+    return candidate;
+  }
+
+  Block &block;
+  BlockLiveness liveness;
+  double maxIntensity;
+};
+
+class ATenRematerializePass
+    : public ATenRematerializeBase<ATenRematerializePass> {
+  void runOnOperation() override {
+    FuncOp func = getOperation();
+    if (func.isExternal() || !llvm::hasSingleElement(func.getBody()))
+      return;
+    Block &block = func.getBody().front();
+
+    uint64_t before = BlockLiveness(block).getPeakBytes();
+    uint64_t after = before;
+    unsigned numCloned = 0;
+    // Each step lowers the live bytes at one op below the current peak, so
+    // the peak never grows; bound the steps in case it stays on a plateau.
+    for (unsigned step = 0, e = block.getOperations().size(); step < e;
+         step++) {
+      Rematerializer rematerializer(block, maxIntensity);
+      after = rematerializer.getLiveness().getPeakBytes();
+      if (after <= budget)
+        break;
+      Optional<Candidate> candidate = rematerializer.findCandidate();
+      if (!candidate)
+        break;
+      LLVM_DEBUG(llvm::dbgs()
+                 << "recomputing " << candidate->chain.size()
+                 << " ops to save " << candidate->gain << " bytes at the "
+                 << "peak of " << after << " bytes\n");
+      rematerializer.apply(*candidate);
+      numCloned += candidate->chain.size();
+      after = BlockLiveness(block).getPeakBytes();
+    }
+
+    if (!numCloned)
+      markAllAnalysesPreserved();
+    if (report)
+      func.emitRemark() << "peak live tensor bytes: " << before << " -> "
+                        << after << ", recomputed " << numCloned << " ops";
+  }
+};
+
+} // namespace
+
+std::unique_ptr<OperationPass<FuncOp>>
+mlir::NPCOMP::aten::createATenRematerializePass() {
+  return std::make_unique<ATenRematerializePass>();
+}
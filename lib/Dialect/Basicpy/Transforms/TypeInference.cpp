@@ -15,6 +15,7 @@
 #include "npcomp/Dialect/Basicpy/IR/BasicpyOps.h"
 #include "npcomp/Dialect/Basicpy/Transforms/Passes.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/ilist.h"
 #include "llvm/Support/Allocator.h"
 #include "llvm/Support/Debug.h"
@@ -164,6 +165,8 @@ public:
 
   simple_ilist<TypeEquation> &getEquations() { return equations; }
 
+  unsigned getNumVars() { return nextOrdinal; }
+
   TypeNode *lookupVarOrdinal(unsigned ordinal) {
     assert(ordinal < ordinalToVarNode.size());
     return ordinalToVarNode[ordinal];
@@ -196,109 +199,117 @@ private:
 
 /// (Very) simple type unification. This really isn't advanced enough for
 /// anything beyond simple, unambiguous programs.
-/// It is also terribly inefficient.
+///
+/// Type variables are kept in a union-find forest (with path compression and
+/// union by rank), where each class root records the constant type node the
+/// class is bound to, if any, so that conflicts can be reported at the
+/// expression it came from. Since type nodes are either constants or
+/// variables (there are no type constructors), a variable can never occur
+/// inside another type and no occurs check is needed.
 class TypeUnifier {
 public:
-  using SubstMap = llvm::DenseMap<unsigned, TypeNode *>;
-
-  Optional<SubstMap> unifyEquations(TypeEquations &equations) {
-    Optional<SubstMap> subst;
-    subst.emplace();
+  TypeUnifier(unsigned numVars)
+      : parent(numVars), rank(numVars, 0), boundNode(numVars, nullptr),
+        classSize(numVars, 1) {
+    for (unsigned i = 0; i < numVars; ++i)
+      parent[i] = i;
+  }
 
+  LogicalResult unifyEquations(TypeEquations &equations) {
     for (auto &eq : equations.getEquations()) {
-      subst = unify(eq.getLeft(), eq.getRight(), std::move(subst));
-      if (!subst) {
-        break;
-      }
+      if (failed(unify(eq.getLeft(), eq.getRight())))
+        return failure();
     }
+    return success();
+  }
 
-    return subst;
+  /// Gets the constant type that the variable with the given ordinal was
+  /// resolved to, or null if it was not bound to one.
+  Type resolveVar(unsigned ordinal) {
+    TypeNode *bound = boundNode[find(ordinal)];
+    return bound ? bound->getConstType() : nullptr;
   }
 
-  Type resolveSubst(TypeNode *typeNode, const Optional<SubstMap> &subst) {
-    if (!subst)
-      return nullptr;
-    if (typeNode->getDiscrim() == TypeNode::Discrim::CONST_TYPE) {
-      return typeNode->getConstType();
-    }
-    if (typeNode->getDiscrim() == TypeNode::Discrim::VAR_ORDINAL) {
-      auto foundIt = subst->find(typeNode->getVarOrdinal());
-      if (foundIt != subst->end()) {
-        return resolveSubst(foundIt->second, subst);
-      } else {
-        return nullptr;
-      }
-    }
-    return nullptr;
+  /// Whether the variable was unified with anything at all.
+  bool isConstrained(unsigned ordinal) {
+    unsigned root = find(ordinal);
+    return boundNode[root] || classSize[root] > 1;
   }
 
-  Optional<SubstMap> unify(TypeNode *typeX, TypeNode *typeY,
-                           Optional<SubstMap> subst) {
+private:
+  LogicalResult unify(TypeNode *typeX, TypeNode *typeY) {
     LLVM_DEBUG(llvm::dbgs() << "+ UNIFY: " << *typeX << ", " << *typeY << "\n");
-    if (!subst) {
-      emitError(typeX->getDef().getLoc()) << "cannot unify type";
-      emitRemark(typeY->getDef().getLoc()) << "conflicting expression here";
-      return None;
-    } else if (*typeX == *typeY) {
-      return subst;
-    } else if (typeX->getDiscrim() == TypeNode::Discrim::VAR_ORDINAL) {
-      return unifyVariable(typeX, typeY, std::move(*subst));
-    } else if (typeY->getDiscrim() == TypeNode::Discrim::VAR_ORDINAL) {
-      return unifyVariable(typeY, typeX, std::move(*subst));
-    } else {
-      LLVM_DEBUG(llvm::dbgs() << "  Unify fallthrough\n");
-      return None;
-    }
+    bool isVarX = typeX->getDiscrim() == TypeNode::Discrim::VAR_ORDINAL;
+    bool isVarY = typeY->getDiscrim() == TypeNode::Discrim::VAR_ORDINAL;
+    if (isVarX && isVarY)
+      return unionVars(typeX->getVarOrdinal(), typeY->getVarOrdinal());
+    if (isVarX)
+      return bindVar(typeX->getVarOrdinal(), typeY);
+    if (isVarY)
+      return bindVar(typeY->getVarOrdinal(), typeX);
+    if (typeX->getConstType() == typeY->getConstType())
+      return success();
+    LLVM_DEBUG(llvm::dbgs() << "  Unify fallthrough\n");
+    return reportConflict(typeX, typeY);
   }
 
-  Optional<SubstMap> unifyVariable(TypeNode *varNode, TypeNode *typeNode,
-                                   SubstMap subst) {
-    assert(varNode->getDiscrim() == TypeNode::Discrim::VAR_ORDINAL);
-    LLVM_DEBUG(llvm::dbgs() << "  - UNIFY VARIABLE: " << *varNode << " <- "
-                            << *typeNode << "\n");
-    // Var node in subst?
-    auto it = subst.find(varNode->getVarOrdinal());
-    if (it != subst.end()) {
-      TypeNode *found = it->second;
-      LLVM_DEBUG(llvm::dbgs() << "    --> FOUND VAR: " << *found << "\n");
-      return unify(found, typeNode, std::move(subst));
-    }
-
-    // Type node in subst?
-    if (typeNode->getDiscrim() == TypeNode::Discrim::VAR_ORDINAL) {
-      it = subst.find(typeNode->getVarOrdinal());
-      if (it != subst.end()) {
-        TypeNode *found = it->second;
-        LLVM_DEBUG(llvm::dbgs() << "    --> FOUND TYPE: " << *found << "\n");
-        return unify(varNode, found, std::move(subst));
-      }
-    }
-
-    // Does the variable appear in the type?
-    if (occursCheck(varNode, typeNode, subst)) {
-      LLVM_DEBUG(llvm::dbgs() << "FAILED OCCURS_CHECK\n");
-      return None;
+  LogicalResult bindVar(unsigned ordinal, TypeNode *constNode) {
+    TypeNode *&bound = boundNode[find(ordinal)];
+    if (!bound) {
+      bound = constNode;
+      return success();
     }
+    if (bound->getConstType() == constNode->getConstType())
+      return success();
+    return reportConflict(constNode, bound);
+  }
 
-    // varNode is not yet in subst and cannot simplify typeNode. Extend.
-    subst[varNode->getVarOrdinal()] = typeNode;
-    return std::move(subst);
+  LogicalResult unionVars(unsigned x, unsigned y) {
+    unsigned rootX = find(x);
+    unsigned rootY = find(y);
+    if (rootX == rootY)
+      return success();
+    TypeNode *boundX = boundNode[rootX];
+    TypeNode *boundY = boundNode[rootY];
+    if (boundX && boundY && boundX->getConstType() != boundY->getConstType())
+      return reportConflict(boundY, boundX);
+
+    if (rank[rootX] < rank[rootY])
+      std::swap(rootX, rootY);
+    else if (rank[rootX] == rank[rootY])
+      rank[rootX] += 1;
+    parent[rootY] = rootX;
+    classSize[rootX] += classSize[rootY];
+    boundNode[rootX] = boundX ? boundX : boundY;
+    return success();
   }
 
-  bool occursCheck(TypeNode *varNode, TypeNode *typeNode, SubstMap &subst) {
-    if (*varNode == *typeNode)
-      return true;
+  /// Reports that the constant type of `node` conflicts with that of
+  /// `conflicting`, which its type was unified with, at the expressions that
+  /// defined them.
+  LogicalResult reportConflict(TypeNode *node, TypeNode *conflicting) {
+    emitError(node->getDef().getLoc()) << "cannot unify type";
+    emitRemark(conflicting->getDef().getLoc()) << "conflicting expression here";
+    return failure();
+  }
 
-    if (typeNode->getDiscrim() == TypeNode::Discrim::VAR_ORDINAL) {
-      unsigned typeOrdinal = typeNode->getVarOrdinal();
-      auto foundIt = subst.find(typeOrdinal);
-      if (foundIt != subst.end()) {
-        return occursCheck(varNode, foundIt->second, subst);
-      }
+  unsigned find(unsigned ordinal) {
+    unsigned root = ordinal;
+    while (parent[root] != root)
+      root = parent[root];
+    // Path compression.
+    while (parent[ordinal] != root) {
+      unsigned next = parent[ordinal];
+      parent[ordinal] = root;
+      ordinal = next;
     }
-
-    return false;
+    return root;
   }
+
+  SmallVector<unsigned, 16> parent;
+  SmallVector<unsigned, 16> rank;
+  SmallVector<TypeNode *, 16> boundNode;
+  SmallVector<unsigned, 16> classSize;
 };
 
 class TypeEquationPopulator {
@@ -444,26 +455,26 @@ public:
     (void)p.runOnFunction(func);
     LLVM_DEBUG(equations.report(llvm::dbgs()));
 
-    TypeUnifier unifier;
-    auto substMap = unifier.unifyEquations(equations);
-    if (!substMap) {
+    TypeUnifier unifier(equations.getNumVars());
+    if (failed(unifier.unifyEquations(equations))) {
       func.emitError() << "type inference failed";
       return signalPassFailure();
     }
 
-    // Apply substitutions.
-    LLVM_DEBUG(llvm::dbgs() << "Unification subst:\n");
-    LLVM_DEBUG(for (auto it
-                    : *substMap) {
-      llvm::dbgs() << "  " << it.first << " -> " << *it.second << "\n";
-    });
-    for (auto it : *substMap) {
-      TypeNode *varNode = equations.lookupVarOrdinal(it.first);
-      Type resolvedType = unifier.resolveSubst(it.second, substMap);
+    // Apply the resolved types.
+    for (unsigned ordinal = 0, e = equations.getNumVars(); ordinal < e;
+         ++ordinal) {
+      // Leave variables that did not participate in any equation alone.
+      if (!unifier.isConstrained(ordinal))
+        continue;
+      TypeNode *varNode = equations.lookupVarOrdinal(ordinal);
+      Type resolvedType = unifier.resolveVar(ordinal);
       if (!resolvedType) {
         emitError(varNode->getDef().getLoc()) << "unable to infer type";
         continue;
       }
+      LLVM_DEBUG(llvm::dbgs() << "  " << ordinal << " -> " << resolvedType
+                              << "\n");
       varNode->getDef().setType(resolvedType);
     }
 
@@ -73,9 +73,9 @@ public:
                                 PatternRewriter &rewriter) const override {
     auto createArrayOp =
         dyn_cast_or_null<CreateArrayFromTensorOp>(op.source().getDefiningOp());
-    if (createArrayOp && createArrayOp.dest().hasOneUse()) {
-      rewriter.replaceOp(op, createArrayOp.source());
-    }
+    if (!createArrayOp || !createArrayOp.dest().hasOneUse())
+      return failure();
+    rewriter.replaceOp(op, createArrayOp.source());
     return success();
   }
 };
@@ -0,0 +1,120 @@
+//===- ElideArrayCopies.cpp - Elide ndarray round trip copies ----*- C++-*-===//
+//
+// This file is licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "PassDetail.h"
+
+#include "mlir/IR/BuiltinOps.h"
+#include "npcomp/Dialect/Numpy/IR/NumpyDialect.h"
+#include "npcomp/Dialect/Numpy/IR/NumpyOps.h"
+#include "npcomp/Dialect/Numpy/Transforms/Passes.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/MathExtras.h"
+
+#define DEBUG_TYPE "numpy-elide-array-copies"
+
+using namespace mlir;
+using namespace mlir::NPCOMP::Numpy;
+
+// Returns the size of a tensor of `type` in bytes, if it is statically known.
+static Optional<uint64_t> getStaticSizeInBytes(Type type) {
+  auto tensorType = type.dyn_cast<RankedTensorType>();
+  if (!tensorType || !tensorType.hasStaticShape() ||
+      !tensorType.getElementType().isIntOrFloat())
+    return llvm::None;
+  uint64_t elementBytes =
+      llvm::divideCeil(tensorType.getElementTypeBitWidth(), 8);
+  return tensorType.getNumElements() * elementBytes;
+}
+
+// Returns the copies of the array created by `createOp` that observe the
+// value of its source tensor.
+//
+// The array is fresh, so nothing but its SSA value refers to it. Any use that
+// is not a copy_to_tensor may modify it in place or let it escape (after
+// which anything may modify it), so we only trust copies that execute before
+// all such uses. Uses in other blocks of the region run after the creating
+// block has been left (a back edge re-creates the array), and uses nested in
+// ops of the creating block run when that op does.
+static SmallVector<CopyToTensorOp, 4>
+findElidableCopies(CreateArrayFromTensorOp createOp) {
+  Block *block = createOp->getBlock();
+  SmallVector<CopyToTensorOp, 4> copies;
+  Operation *firstClobber = nullptr;
+  bool clobberedElsewhere = false;
+  for (Operation *user : createOp.dest().getUsers()) {
+    if (auto copy = dyn_cast<CopyToTensorOp>(user)) {
+      copies.push_back(copy);
+      continue;
+    }
+    Operation *ancestor = block->findAncestorOpInBlock(*user);
+    if (!ancestor) {
+      clobberedElsewhere = true;
+      continue;
+    }
+    if (!firstClobber || ancestor->isBeforeInBlock(firstClobber))
+      firstClobber = ancestor;
+  }
+
+  Type tensorType = createOp.source().getType();
+  llvm::erase_if(copies, [&](CopyToTensorOp copy) {
+    if (copy.getType() != tensorType)
+      return true;
+    // With no clobbering uses at all, the array is immutable.
+    if (!firstClobber && !clobberedElsewhere)
+      return false;
+    // Otherwise, a copy must be in the creating block before any clobber.
+    if (copy->getBlock() != block)
+      return true;
+    return firstClobber && firstClobber->isBeforeInBlock(copy);
+  });
+  return copies;
+}
+
+namespace {
+
+class ElideArrayCopiesPass
+    : public NumpyElideArrayCopiesBase<ElideArrayCopiesPass> {
+  void runOnOperation() override {
+    FuncOp func = getOperation();
+    int64_t numElided = 0;
+    int64_t numDynamic = 0;
+    uint64_t bytesElided = 0;
+
+    SmallVector<CreateArrayFromTensorOp, 8> createOps;
+    func.walk([&](CreateArrayFromTensorOp op) { createOps.push_back(op); });
+    for (CreateArrayFromTensorOp createOp : createOps) {
+      for (CopyToTensorOp copy : findElidableCopies(createOp)) {
+        LLVM_DEBUG(llvm::dbgs() << "eliding " << copy << "\n");
+        if (Optional<uint64_t> bytes = getStaticSizeInBytes(copy.getType()))
+          bytesElided += *bytes;
+        else
+          numDynamic++;
+        numElided++;
+        copy.replaceAllUsesWith(createOp.source());
+        copy.erase();
+      }
+      if (createOp.dest().use_empty())
+        createOp.erase();
+    }
+
+    if (!numElided)
+      markAllAnalysesPreserved();
+    if (report) {
+      func.emitRemark() << "elided " << numElided << " array copies of "
+                        << bytesElided << " bytes (" << numDynamic
+                        << " of dynamic size)";
+    }
+  }
+};
+
+} // namespace
+
+std::unique_ptr<OperationPass<FuncOp>>
+mlir::NPCOMP::Numpy::createElideArrayCopiesPass() {
+  return std::make_unique<ElideArrayCopiesPass>();
+}
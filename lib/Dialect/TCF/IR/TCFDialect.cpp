@@ -7,6 +7,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "npcomp/Dialect/TCF/IR/TCFDialect.h"
+#include "mlir/Dialect/StandardOps/IR/Ops.h"
 #include "npcomp/Dialect/TCF/IR/TCFOps.h"
 
 using namespace mlir;
@@ -18,3 +19,12 @@ void TCFDialect::initialize() {
 #include "npcomp/Dialect/TCF/IR/TCFOps.cpp.inc"
       >();
 }
+
+Operation *TCFDialect::materializeConstant(OpBuilder &builder, Attribute value,
+                                           Type type, Location loc) {
+  // Folded tensors are materialized as std.constant, like every other tensor
+  // constant that reaches TCF.
+  if (value.isa<ElementsAttr>() && ConstantOp::isBuildableWith(value, type))
+    return builder.create<ConstantOp>(loc, type, value);
+  return nullptr;
+}
@@ -8,8 +8,220 @@
 
 #include "npcomp/Dialect/TCF/IR/TCFOps.h"
 
+#include "mlir/IR/BuiltinAttributes.h"
+
+#include <cmath>
+
 using namespace mlir;
 using namespace mlir::NPCOMP::tcf;
 
+//===----------------------------------------------------------------------===//
+// Constant folding
+//===----------------------------------------------------------------------===//
+//
+// Ops whose operands are all constants are evaluated at compile time, so that
+// computations on weights (e.g. scaling, or activations of constant biases)
+// are done once instead of on every call.
+//
+// Only f32 tensors of static shape are folded. Ops whose operands do not meet
+// the op's requirements (e.g. non-broadcastable shapes) are left alone, since
+// they must abort the program at runtime.
+
+// Returns the elements of a constant f32 operand.
+static Optional<SmallVector<float, 16>> getF32Elements(Attribute attr) {
+  auto elements = attr.dyn_cast_or_null<DenseFPElementsAttr>();
+  if (!elements || !elements.getType().getElementType().isF32())
+    return llvm::None;
+  return llvm::to_vector<16>(elements.getValues<float>());
+}
+
+// Returns the type of the folded result if it is a static-shaped f32 tensor.
+static RankedTensorType getFoldableResultType(Type type) {
+  auto tensorType = type.dyn_cast<RankedTensorType>();
+  if (!tensorType || !tensorType.hasStaticShape() ||
+      !tensorType.getElementType().isF32())
+    return nullptr;
+  return tensorType;
+}
+
+// Evaluates `fn` elementwise over `operands`, broadcasting them to the shape
+// of `resultType` with numpy rules.
+static Attribute
+foldElementwise(Type resultType, ArrayRef<Attribute> operands,
+                function_ref<float(ArrayRef<float>)> fn) {
+  RankedTensorType type = getFoldableResultType(resultType);
+  if (!type)
+    return nullptr;
+  ArrayRef<int64_t> shape = type.getShape();
+  int64_t rank = shape.size();
+
+  SmallVector<SmallVector<float, 16>, 2> values;
+  // The stride of each result dimension in each operand; broadcast
+  // dimensions have stride 0.
+  SmallVector<SmallVector<int64_t, 4>, 2> strides;
+  for (Attribute operand : operands) {
+    Optional<SmallVector<float, 16>> elements = getF32Elements(operand);
+    if (!elements)
+      return nullptr;
+    ArrayRef<int64_t> operandShape =
+        operand.cast<DenseElementsAttr>().getType().getShape();
+    int64_t operandRank = operandShape.size();
+    if (operandRank > rank)
+      return nullptr;
+    SmallVector<int64_t, 4> operandStrides(rank, 0);
+    int64_t stride = 1;
+    for (int64_t i = operandRank - 1; i >= 0; i--) {
+      int64_t dim = i + rank - operandRank;
+      if (operandShape[i] == shape[dim])
+        operandStrides[dim] = stride;
+      else if (operandShape[i] != 1)
+        return nullptr;
+      stride *= operandShape[i];
+    }
+    values.push_back(std::move(*elements));
+    strides.push_back(std::move(operandStrides));
+  }
+  // The operands must broadcast to exactly the result shape.
+  for (int64_t dim = 0; dim < rank; dim++) {
+    if (shape[dim] != 1 && llvm::all_of(strides, [&](ArrayRef<int64_t> s) {
+          return s[dim] == 0;
+        }))
+      return nullptr;
+  }
+
+  SmallVector<float, 16> result;
+  result.reserve(type.getNumElements());
+  SmallVector<int64_t, 4> index(rank, 0);
+  SmallVector<float, 2> args(operands.size());
+  for (int64_t i = 0, e = type.getNumElements(); i < e; i++) {
+    for (size_t j = 0; j < operands.size(); j++) {
+      int64_t offset = 0;
+      for (int64_t dim = 0; dim < rank; dim++)
+        offset += index[dim] * strides[j][dim];
+      args[j] = values[j][offset];
+    }
+    result.push_back(fn(args));
+    // Advance the multi-dimensional index.
+    for (int64_t dim = rank - 1; dim >= 0; dim--) {
+      if (++index[dim] < shape[dim])
+        break;
+      index[dim] = 0;
+    }
+  }
+  return DenseElementsAttr::get(type, llvm::makeArrayRef(result));
+}
+
+OpFoldResult AddOp::fold(ArrayRef<Attribute> operands) {
+  return foldElementwise(getType(), operands,
+                         [](ArrayRef<float> x) { return x[0] + x[1]; });
+}
+
+OpFoldResult MaxOp::fold(ArrayRef<Attribute> operands) {
+  return foldElementwise(getType(), operands, [](ArrayRef<float> x) {
+    return x[0] > x[1] || std::isnan(x[0]) ? x[0] : x[1];
+  });
+}
+
+OpFoldResult MulOp::fold(ArrayRef<Attribute> operands) {
+  return foldElementwise(getType(), operands,
+                         [](ArrayRef<float> x) { return x[0] * x[1]; });
+}
+
+OpFoldResult SubOp::fold(ArrayRef<Attribute> operands) {
+  return foldElementwise(getType(), operands,
+                         [](ArrayRef<float> x) { return x[0] - x[1]; });
+}
+
+OpFoldResult DivOp::fold(ArrayRef<Attribute> operands) {
+  return foldElementwise(getType(), operands,
+                         [](ArrayRef<float> x) { return x[0] / x[1]; });
+}
+
+OpFoldResult MinOp::fold(ArrayRef<Attribute> operands) {
+  return foldElementwise(getType(), operands, [](ArrayRef<float> x) {
+    return x[0] < x[1] || std::isnan(x[0]) ? x[0] : x[1];
+  });
+}
+
+OpFoldResult ExpOp::fold(ArrayRef<Attribute> operands) {
+  return foldElementwise(getType(), operands,
+                         [](ArrayRef<float> x) { return std::exp(x[0]); });
+}
+
+OpFoldResult TanhOp::fold(ArrayRef<Attribute> operands) {
+  return foldElementwise(getType(), operands,
+                         [](ArrayRef<float> x) { return std::tanh(x[0]); });
+}
+
+OpFoldResult LogOp::fold(ArrayRef<Attribute> operands) {
+  return foldElementwise(getType(), operands,
+                         [](ArrayRef<float> x) { return std::log(x[0]); });
+}
+
+OpFoldResult SqrtOp::fold(ArrayRef<Attribute> operands) {
+  return foldElementwise(getType(), operands,
+                         [](ArrayRef<float> x) { return std::sqrt(x[0]); });
+}
+
+OpFoldResult SigmoidOp::fold(ArrayRef<Attribute> operands) {
+  return foldElementwise(getType(), operands, [](ArrayRef<float> x) {
+    return 1.0f / (1.0f + std::exp(-x[0]));
+  });
+}
+
+OpFoldResult ClampOp::fold(ArrayRef<Attribute> operands) {
+  Optional<float> min, max;
+  if (minAttr())
+    min = minAttr().getValueAsDouble();
+  if (maxAttr())
+    max = maxAttr().getValueAsDouble();
+  return foldElementwise(getType(), operands, [&](ArrayRef<float> x) {
+    float result = x[0];
+    if (min)
+      result = std::max(result, *min);
+    if (max)
+      result = std::min(result, *max);
+    return result;
+  });
+}
+
+// Folding a matmul costs M * N * K multiply-adds at compile time, so only
+// matmuls up to this size are folded.
+static constexpr int64_t kMaxFoldedMatmulMACs = 1 << 24;
+
+OpFoldResult MatmulOp::fold(ArrayRef<Attribute> operands) {
+  RankedTensorType type = getFoldableResultType(getType());
+  Optional<SmallVector<float, 16>> lhsValues = getF32Elements(operands[0]);
+  Optional<SmallVector<float, 16>> rhsValues = getF32Elements(operands[1]);
+  if (!type || !lhsValues || !rhsValues)
+    return nullptr;
+  ArrayRef<int64_t> lhsShape =
+      operands[0].cast<DenseElementsAttr>().getType().getShape();
+  ArrayRef<int64_t> rhsShape =
+      operands[1].cast<DenseElementsAttr>().getType().getShape();
+  int64_t m = lhsShape[0], k = lhsShape[1], n = rhsShape[1];
+  if (rhsShape[0] != k || type.getDimSize(0) != m || type.getDimSize(1) != n ||
+      m * n * k > kMaxFoldedMatmulMACs)
+    return nullptr;
+  SmallVector<float, 16> result(m * n, 0.0f);
+  for (int64_t i = 0; i < m; i++)
+    for (int64_t p = 0; p < k; p++)
+      for (int64_t j = 0; j < n; j++)
+        result[i * n + j] += (*lhsValues)[i * k + p] * (*rhsValues)[p * n + j];
+  return DenseElementsAttr::get(type, llvm::makeArrayRef(result));
+}
+
+//===----------------------------------------------------------------------===//
+// CompareOp
+//===----------------------------------------------------------------------===//
+
+static LogicalResult verify(CompareOp op) {
+  if (!llvm::is_contained(ArrayRef<StringRef>{"eq", "ne", "lt", "le", "gt",
+                                              "ge"},
+                          op.predicate()))
+    return op.emitError() << "unknown predicate '" << op.predicate() << "'";
+  return success();
+}
+
 #define GET_OP_CLASSES
 #include "npcomp/Dialect/TCF/IR/TCFOps.cpp.inc"
@@ -0,0 +1,107 @@
+//===- FreezeGlobalSlots.cpp -------------------------------------*- C++-*-===//
+//
+// This file is licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "PassDetail.h"
+
+#include "mlir/IR/BlockAndValueMapping.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
+#include "npcomp/Dialect/Basicpy/IR/BasicpyDialect.h"
+#include "npcomp/Dialect/Numpy/IR/NumpyOps.h"
+#include "npcomp/Dialect/Torch/IR/TorchDialect.h"
+#include "npcomp/Dialect/Torch/IR/TorchOps.h"
+#include "npcomp/Dialect/Torch/Transforms/Passes.h"
+#include "llvm/ADT/StringMap.h"
+
+using namespace mlir;
+using namespace mlir::NPCOMP;
+using namespace mlir::NPCOMP::Torch;
+
+// Types whose values cannot be mutated, so that a copy of the value is
+// indistinguishable from the value in the slot.
+static bool isImmutableType(Type type) {
+  return type.isa<IntegerType, FloatType, Basicpy::BoolType,
+                  Basicpy::BytesType, Basicpy::NoneType, Basicpy::StrType>();
+}
+
+// Returns true if the initializer of `slot` can be recomputed at each use:
+// it is free of side effects and the value it yields does not depend on
+// object identity.
+static bool isFreezableInitializer(GlobalSlotOp slot) {
+  if (slot.initializer().empty())
+    return false;
+  Block &body = slot.initializer().front();
+  for (Operation &op : body.without_terminator()) {
+    auto effects = dyn_cast<MemoryEffectOpInterface>(&op);
+    if (!effects || !effects.hasNoEffect())
+      return false;
+  }
+  Value initialValue =
+      cast<GlobalSlotInitOp>(body.getTerminator()).initialValue();
+  // Tensors are mutable, but an ndarray created from a tensor value can be
+  // recreated at each use if every use only reads it; see below.
+  return isImmutableType(initialValue.getType()) ||
+         initialValue.getDefiningOp<Numpy::CreateArrayFromTensorOp>();
+}
+
+namespace {
+// See the pass documentation for `torch-freeze-global-slots`.
+class FreezeGlobalSlotsPass
+    : public FreezeGlobalSlotsBase<FreezeGlobalSlotsPass> {
+  void runOnOperation() override {
+    ModuleOp module = getOperation();
+
+    // Candidates are the private slots with freezable initializers. Public
+    // slots can be set from outside the module.
+    llvm::StringMap<GlobalSlotOp> candidates;
+    for (auto slot : module.getOps<GlobalSlotOp>())
+      if (slot.isPrivate() && isFreezableInitializer(slot))
+        candidates[slot.sym_name()] = slot;
+
+    // Slots that are set, or whose ndarray is used other than by copying it
+    // into a tensor (which could mutate it in place), are not frozen.
+    llvm::StringMap<SmallVector<GlobalSlotGetOp, 4>> getsBySlot;
+    module.walk([&](Operation *op) {
+      if (auto set = dyn_cast<GlobalSlotSetOp>(op)) {
+        candidates.erase(set.slot());
+      } else if (auto get = dyn_cast<GlobalSlotGetOp>(op)) {
+        if (!isImmutableType(get.getType()) &&
+            llvm::any_of(get->getUsers(), [](Operation *user) {
+              return !isa<Numpy::CopyToTensorOp>(user);
+            }))
+          candidates.erase(get.slot());
+        else
+          getsBySlot[get.slot()].push_back(get);
+      }
+    });
+
+    // Replace each get with a copy of the initializer, exposing the value to
+    // folding, and erase the slot.
+    for (auto &entry : candidates) {
+      GlobalSlotOp slot = entry.getValue();
+      Block &body = slot.initializer().front();
+      for (GlobalSlotGetOp get : getsBySlot[entry.getKey()]) {
+        OpBuilder builder(get);
+        BlockAndValueMapping mapping;
+        for (Operation &op : body.without_terminator())
+          builder.clone(op, mapping);
+        get.replaceAllUsesWith(mapping.lookup(
+            cast<GlobalSlotInitOp>(body.getTerminator()).initialValue()));
+        get.erase();
+      }
+      slot.erase();
+    }
+  }
+};
+} // namespace
+
+std::unique_ptr<OperationPass<ModuleOp>>
+mlir::NPCOMP::Torch::createFreezeGlobalSlotsPass() {
+  return std::make_unique<FreezeGlobalSlotsPass>();
+}
@@ -0,0 +1,178 @@
+//===- LowerGlobalSlots.cpp --------------------------------------*- C++-*-===//
+//
+// This file is licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "PassDetail.h"
+
+#include "mlir/Dialect/Linalg/IR/LinalgOps.h"
+#include "mlir/Dialect/StandardOps/IR/Ops.h"
+#include "mlir/IR/BlockAndValueMapping.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/Matchers.h"
+#include "npcomp/Dialect/Numpy/IR/NumpyDialect.h"
+#include "npcomp/Dialect/Numpy/IR/NumpyOps.h"
+#include "npcomp/Dialect/Torch/IR/TorchDialect.h"
+#include "npcomp/Dialect/Torch/IR/TorchOps.h"
+#include "npcomp/Dialect/Torch/Transforms/Passes.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringSet.h"
+
+using namespace mlir;
+using namespace mlir::NPCOMP;
+using namespace mlir::NPCOMP::Torch;
+
+// The runtime runs this function once when the module is loaded.
+// This must match the name in JITModule.
+static constexpr char kModuleInitializerName[] = "__npcomp_module_init";
+
+// Returns the tensor that the initializer of a tensor slot wraps in an
+// ndarray, if it has a static shape (which the global needs).
+static Value getInitialTensor(GlobalSlotOp slot) {
+  if (slot.initializer().empty())
+    return nullptr;
+  auto init =
+      cast<GlobalSlotInitOp>(slot.initializer().front().getTerminator());
+  auto create =
+      init.initialValue().getDefiningOp<Numpy::CreateArrayFromTensorOp>();
+  if (!create)
+    return nullptr;
+  auto type = create.source().getType().dyn_cast<RankedTensorType>();
+  if (!type || !type.hasStaticShape())
+    return nullptr;
+  return create.source();
+}
+
+namespace {
+// See the pass documentation for `torch-lower-global-slots`.
+class LowerGlobalSlotsPass : public LowerGlobalSlotsBase<LowerGlobalSlotsPass> {
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<linalg::LinalgDialect, Numpy::NumpyDialect>();
+  }
+
+  void runOnOperation() override {
+    ModuleOp module = getOperation();
+    OpBuilder builder(module.getContext());
+    moduleInitializer = nullptr;
+
+    // The slots that are ever set cannot be constant.
+    llvm::StringSet<> mutatedSlots;
+    module.walk([&](GlobalSlotSetOp op) { mutatedSlots.insert(op.slot()); });
+
+    llvm::StringMap<MemRefType> memrefTypes;
+    for (auto slot :
+         llvm::make_early_inc_range(module.getOps<GlobalSlotOp>())) {
+      Value initialTensor = getInitialTensor(slot);
+      if (!initialTensor)
+        continue;
+      auto tensorType = initialTensor.getType().cast<RankedTensorType>();
+      auto memrefType =
+          MemRefType::get(tensorType.getShape(), tensorType.getElementType());
+      bool isMutated = mutatedSlots.count(slot.sym_name());
+
+      // Constant initializers (which is how tensors are imported) become the
+      // initial value of the global and are loaded with the module. Others
+      // are computed by the module initializer.
+      Attribute initialValue = builder.getUnitAttr();
+      Attribute constant;
+      if (matchPattern(initialTensor, m_Constant(&constant))) {
+        // Weights imported by reference are mapped read-only.
+        if (isMutated && constant.isa<OpaqueElementsAttr>()) {
+          slot.emitError() << "global slot imported by reference is mutated";
+          return signalPassFailure();
+        }
+        initialValue = constant;
+      } else {
+        Location loc = slot.getLoc();
+        OpBuilder initBuilder = getModuleInitializerBuilder(module);
+        BlockAndValueMapping mapping;
+        for (Operation &op : slot.initializer().front().without_terminator())
+          initBuilder.clone(op, mapping);
+        Value memref = initBuilder.create<TensorToMemrefOp>(
+            loc, memrefType, mapping.lookup(initialTensor));
+        Value global = initBuilder.create<GetGlobalMemrefOp>(loc, memrefType,
+                                                             slot.sym_name());
+        initBuilder.create<linalg::CopyOp>(loc, memref, global);
+      }
+
+      builder.setInsertionPoint(slot);
+      builder.create<GlobalMemrefOp>(
+          slot.getLoc(), slot.sym_nameAttr(), slot.sym_visibilityAttr(),
+          TypeAttr::get(memrefType), initialValue,
+          !isMutated && !initialValue.isa<UnitAttr>() ? builder.getUnitAttr()
+                                                      : UnitAttr());
+      memrefTypes[slot.sym_name()] = memrefType;
+      slot.erase();
+    }
+
+    // Reads of slots that are never set load the global in place. Reads of
+    // mutated slots copy it out, since a later set writes into the global and
+    // must not change the value that was read. Writes copy into the global.
+    SmallVector<GlobalSlotGetOp, 16> gets;
+    SmallVector<GlobalSlotSetOp, 16> sets;
+    module.walk([&](GlobalSlotGetOp op) { gets.push_back(op); });
+    module.walk([&](GlobalSlotSetOp op) { sets.push_back(op); });
+    for (GlobalSlotGetOp op : gets) {
+      auto it = memrefTypes.find(op.slot());
+      if (it == memrefTypes.end())
+        continue;
+      builder.setInsertionPoint(op);
+      Value global = builder.create<GetGlobalMemrefOp>(op.getLoc(), it->second,
+                                                       op.slot());
+      if (mutatedSlots.count(op.slot())) {
+        Value copy = builder.create<AllocOp>(op.getLoc(), it->second);
+        builder.create<linalg::CopyOp>(op.getLoc(), global, copy);
+        global = copy;
+      }
+      Value tensor = builder.create<TensorLoadOp>(op.getLoc(), global);
+      Value ndarray = builder.create<Numpy::CreateArrayFromTensorOp>(
+          op.getLoc(), op.getType(), tensor);
+      op.replaceAllUsesWith(ndarray);
+      op.erase();
+    }
+    for (GlobalSlotSetOp op : sets) {
+      auto it = memrefTypes.find(op.slot());
+      if (it == memrefTypes.end())
+        continue;
+      MemRefType memrefType = it->second;
+      builder.setInsertionPoint(op);
+      Value tensor = builder.create<Numpy::CopyToTensorOp>(
+          op.getLoc(),
+          RankedTensorType::get(memrefType.getShape(),
+                                memrefType.getElementType()),
+          op.value());
+      Value memref =
+          builder.create<TensorToMemrefOp>(op.getLoc(), memrefType, tensor);
+      Value global = builder.create<GetGlobalMemrefOp>(op.getLoc(), memrefType,
+                                                       op.slot());
+      builder.create<linalg::CopyOp>(op.getLoc(), memref, global);
+      op.erase();
+    }
+  }
+
+  // Returns a builder at the end of the module initializer, creating it if
+  // needed.
+  OpBuilder getModuleInitializerBuilder(ModuleOp module) {
+    if (!moduleInitializer) {
+      OpBuilder builder(module.getBody()->getTerminator());
+      moduleInitializer = builder.create<FuncOp>(
+          module.getLoc(), kModuleInitializerName,
+          builder.getFunctionType({}, {}));
+      Block *body = moduleInitializer.addEntryBlock();
+      OpBuilder::atBlockEnd(body).create<ReturnOp>(module.getLoc());
+    }
+    return OpBuilder(moduleInitializer.getBody().front().getTerminator());
+  }
+
+  FuncOp moduleInitializer;
+};
+} // namespace
+
+std::unique_ptr<OperationPass<ModuleOp>>
+mlir::NPCOMP::Torch::createLowerGlobalSlotsPass() {
+  return std::make_unique<LowerGlobalSlotsPass>();
+}
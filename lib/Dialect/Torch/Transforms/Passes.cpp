@@ -7,6 +7,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "npcomp/Dialect/Torch/Transforms/Passes.h"
+#include "mlir/Pass/PassManager.h"
 
 //===----------------------------------------------------------------------===//
 // Pass registration
@@ -17,4 +18,20 @@ namespace {
 #include "npcomp/Dialect/Torch/Transforms/Passes.h.inc"
 } // end namespace
 
-void mlir::NPCOMP::registerTorchPasses() { ::registerPasses(); }
+void mlir::NPCOMP::registerTorchPasses() {
+  ::registerPasses();
+  mlir::PassPipelineRegistration<>(
+      "torch-globalized-module-pipeline",
+      "Pipeline globalizing the object graph of a TorchScript module.",
+      mlir::NPCOMP::Torch::createGlobalizedModulePipeline);
+}
+
+void mlir::NPCOMP::Torch::createGlobalizedModulePipeline(OpPassManager &pm) {
+  pm.addPass(createGlobalizeObjectGraphPass());
+  // The ClassAnnotator decides which slots are private. Those that are also
+  // never set are the weights of the module, which later folding
+  // specializes on once they are constants.
+  pm.addPass(createFreezeGlobalSlotsPass());
+  // The remaining tensor slots become globals of the compiled module.
+  pm.addPass(createLowerGlobalSlotsPass());
+}
@@ -0,0 +1,232 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// A portable, cache-blocked SGEMM in the style of the GotoBLAS/BLIS
+// algorithm:
+//
+//   for each NC-wide column block of B (jc)
+//     for each KC-deep slice of the reduction (pc)
+//       pack B[pc, jc] into NR-wide panels            (~L3)
+//       pack all M rows of A[:, pc] into MR-tall panels
+//       for each (MC block of A, NR panel of B) tile, in parallel
+//         for each MR panel of the MC block           (~L2 per MC block)
+//           microkernel: MR x NR accumulators over KC (registers / L1)
+//
+// Unlike the classic algorithm, A is packed once per KC slice rather than one
+// MC block at a time. The tiles of an MC block that use different panels of B
+// then share its packed copy instead of each repacking it, which keeps the
+// parallel loop free of redundant packing. Each tile still only streams its
+// own MC x KC block of packed A, which is what has to stay in L2.
+//
+// The microkernel is written so that the inner loop over NR is a fixed-length
+// loop over contiguous packed data with no aliasing, which compilers
+// vectorize to the native SIMD width (SSE/AVX/NEON) without intrinsics.
+//
+// When B is a constant weight, `-aten-prepack-weights` can pack all of it at
+// compile time in the layout of GemmLayout.h, and sgemmPrepackedB then skips
+// packing B entirely.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Gemm.h"
+#include "Parallel.h"
+
+#include "npcomp/RefBackend/ATenKernels/GemmLayout.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace refbackrt::aten;
+
+// See GemmLayout.h for the choice of blocking parameters.
+static constexpr std::int64_t MR = kGemmMR;
+static constexpr std::int64_t NR = kGemmNR;
+static constexpr std::int64_t KC = kGemmKC;
+static constexpr std::int64_t MC = kGemmMC;
+static constexpr std::int64_t NC = kGemmNC;
+
+static std::int64_t roundUp(std::int64_t x, std::int64_t multiple) {
+  return roundUpGemmBlock(x, multiple);
+}
+
+// Pack rows [0, mc) x columns [0, kc) of op(A) into MR-tall panels, each
+// stored k-major (MR consecutive floats per k). Rows past `mc` are zero
+// padded so the microkernel never needs a remainder path.
+static void packA(bool transA, const float *A, std::int64_t lda,
+                  std::int64_t mc, std::int64_t kc, float *packed) {
+  std::int64_t numPanels = (mc + MR - 1) / MR;
+  parallelFor(0, numPanels, 16, [&](std::int64_t begin, std::int64_t end) {
+    for (std::int64_t panel = begin; panel < end; panel++) {
+      float *dst = packed + panel * MR * kc;
+      std::int64_t i0 = panel * MR;
+      std::int64_t rows = std::min(MR, mc - i0);
+      for (std::int64_t k = 0; k < kc; k++) {
+        for (std::int64_t r = 0; r < rows; r++) {
+          std::int64_t i = i0 + r;
+          dst[k * MR + r] = transA ? A[k * lda + i] : A[i * lda + k];
+        }
+        for (std::int64_t r = rows; r < MR; r++)
+          dst[k * MR + r] = 0.0f;
+      }
+    }
+  });
+}
+
+// Pack rows [0, kc) x columns [0, nc) of op(B) into NR-wide panels, each
+// stored k-major (NR consecutive floats per k), zero padding past `nc`.
+static void packB(bool transB, const float *B, std::int64_t ldb,
+                  std::int64_t kc, std::int64_t nc, float *packed) {
+  std::int64_t numPanels = (nc + NR - 1) / NR;
+  parallelFor(0, numPanels, 4, [&](std::int64_t begin, std::int64_t end) {
+    for (std::int64_t panel = begin; panel < end; panel++) {
+      float *dst = packed + panel * NR * kc;
+      std::int64_t j0 = panel * NR;
+      std::int64_t cols = std::min(NR, nc - j0);
+      for (std::int64_t k = 0; k < kc; k++) {
+        for (std::int64_t c = 0; c < cols; c++) {
+          std::int64_t j = j0 + c;
+          dst[k * NR + c] = transB ? B[j * ldb + k] : B[k * ldb + j];
+        }
+        for (std::int64_t c = cols; c < NR; c++)
+          dst[k * NR + c] = 0.0f;
+      }
+    }
+  });
+}
+
+// Compute an MR x NR tile of C from one packed panel of A and one of B, then
+// merge it into C (which has `rows` x `cols` valid entries).
+static void microKernel(std::int64_t kc, const float *__restrict a,
+                        const float *__restrict b, float alpha, float beta,
+                        float *C, std::int64_t ldc, std::int64_t rows,
+                        std::int64_t cols) {
+  // One accumulator row per row of the register block, spelled out so that
+  // they are kept in vector registers rather than spilled to the stack.
+  static_assert(MR == 6, "microkernel is written for MR == 6");
+  float acc[MR][NR];
+  for (std::int64_t i = 0; i < MR; i++)
+    for (std::int64_t j = 0; j < NR; j++)
+      acc[i][j] = 0.0f;
+  float *acc0 = acc[0], *acc1 = acc[1], *acc2 = acc[2], *acc3 = acc[3],
+        *acc4 = acc[4], *acc5 = acc[5];
+  for (std::int64_t p = 0; p < kc; p++) {
+    const float *ap = a + p * MR;
+    const float *bp = b + p * NR;
+    float a0 = ap[0], a1 = ap[1], a2 = ap[2], a3 = ap[3], a4 = ap[4],
+          a5 = ap[5];
+    for (std::int64_t j = 0; j < NR; j++) {
+      float bj = bp[j];
+      acc0[j] += a0 * bj;
+      acc1[j] += a1 * bj;
+      acc2[j] += a2 * bj;
+      acc3[j] += a3 * bj;
+      acc4[j] += a4 * bj;
+      acc5[j] += a5 * bj;
+    }
+  }
+  for (std::int64_t i = 0; i < rows; i++) {
+    float *c = C + i * ldc;
+    if (beta == 0.0f) {
+      for (std::int64_t j = 0; j < cols; j++)
+        c[j] = alpha * acc[i][j];
+    } else {
+      for (std::int64_t j = 0; j < cols; j++)
+        c[j] = beta * c[j] + alpha * acc[i][j];
+    }
+  }
+}
+
+static void scaleMatrix(std::int64_t M, std::int64_t N, float beta, float *C,
+                        std::int64_t ldc) {
+  for (std::int64_t i = 0; i < M; i++)
+    for (std::int64_t j = 0; j < N; j++)
+      C[i * ldc + j] = beta == 0.0f ? 0.0f : beta * C[i * ldc + j];
+}
+
+// Computes C = alpha * op(A) * op(B) + beta * C, taking the panels of B from
+// `prepackedB` if it is not null, and packing them from `B` otherwise.
+static void gemm(bool transA, bool transB, std::int64_t M, std::int64_t N,
+                 std::int64_t K, float alpha, const float *A, std::int64_t lda,
+                 const float *B, std::int64_t ldb, const float *prepackedB,
+                 float beta, float *C, std::int64_t ldc) {
+  if (M <= 0 || N <= 0)
+    return;
+  if (K <= 0 || alpha == 0.0f) {
+    scaleMatrix(M, N, beta, C, ldc);
+    return;
+  }
+
+  std::vector<float> packedA(roundUp(M, MR) * std::min(K, KC));
+  std::vector<float> packedBStorage;
+  if (!prepackedB)
+    packedBStorage.resize(roundUp(std::min(N, NC), NR) * std::min(K, KC));
+
+  for (std::int64_t jc = 0; jc < N; jc += NC) {
+    std::int64_t nc = std::min(NC, N - jc);
+    std::int64_t numNPanels = (nc + NR - 1) / NR;
+    for (std::int64_t pc = 0; pc < K; pc += KC) {
+      std::int64_t kc = std::min(KC, K - pc);
+      // Only the first slice of the reduction applies the caller's beta;
+      // later slices accumulate into the partial result.
+      float effectiveBeta = pc == 0 ? beta : 1.0f;
+
+      const float *packedB;
+      if (prepackedB) {
+        packedB = prepackedB + getPackedGemmBBlockOffset(K, N, jc, pc);
+      } else {
+        const float *Bslice =
+            transB ? B + jc * ldb + pc : B + pc * ldb + jc;
+        packB(transB, Bslice, ldb, kc, nc, packedBStorage.data());
+        packedB = packedBStorage.data();
+      }
+      const float *Aslice = transA ? A + pc * lda : A + pc;
+      packA(transA, Aslice, lda, M, kc, packedA.data());
+
+      // Parallelize over (MC block, NR panel) tiles of C. Keep at least
+      // ~64k multiply-adds per task so tiny products stay single-threaded.
+      std::int64_t numMBlocks = (M + MC - 1) / MC;
+      std::int64_t numTiles = numMBlocks * numNPanels;
+      std::int64_t grain = std::max<std::int64_t>(1, (1 << 16) / (MC * NR * kc));
+      parallelFor(0, numTiles, grain, [&](std::int64_t begin,
+                                          std::int64_t end) {
+        for (std::int64_t tile = begin; tile < end; tile++) {
+          std::int64_t mBlock = tile / numNPanels;
+          std::int64_t nPanel = tile % numNPanels;
+          std::int64_t jr = nPanel * NR;
+          std::int64_t cols = std::min(NR, nc - jr);
+          const float *b = packedB + nPanel * NR * kc;
+          std::int64_t icEnd = std::min(M, (mBlock + 1) * MC);
+          for (std::int64_t ir = mBlock * MC; ir < icEnd; ir += MR) {
+            const float *a = packedA.data() + (ir / MR) * MR * kc;
+            std::int64_t rows = std::min(MR, M - ir);
+            microKernel(kc, a, b, alpha, effectiveBeta,
+                        C + ir * ldc + jc + jr, ldc, rows, cols);
+          }
+        }
+      });
+    }
+  }
+}
+
+void refbackrt::aten::sgemm(bool transA, bool transB, std::int64_t M,
+                            std::int64_t N, std::int64_t K, float alpha,
+                            const float *A, std::int64_t lda, const float *B,
+                            std::int64_t ldb, float beta, float *C,
+                            std::int64_t ldc) {
+  gemm(transA, transB, M, N, K, alpha, A, lda, B, ldb, /*prepackedB=*/nullptr,
+       beta, C, ldc);
+}
+
+void refbackrt::aten::sgemmPrepackedB(bool transA, std::int64_t M,
+                                      std::int64_t N, std::int64_t K,
+                                      float alpha, const float *A,
+                                      std::int64_t lda, const float *packedB,
+                                      float beta, float *C, std::int64_t ldc) {
+  gemm(transA, /*transB=*/false, M, N, K, alpha, A, lda, /*B=*/nullptr,
+       /*ldb=*/0, packedB, beta, C, ldc);
+}
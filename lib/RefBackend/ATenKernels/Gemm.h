@@ -0,0 +1,40 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef NPCOMP_LIB_REFBACKEND_ATENKERNELS_GEMM_H
+#define NPCOMP_LIB_REFBACKEND_ATENKERNELS_GEMM_H
+
+#include <cstdint>
+
+namespace refbackrt {
+namespace aten {
+
+// Single precision general matrix multiply on row-major matrices:
+//   C = alpha * op(A) * op(B) + beta * C
+// where op(A) is [M, K], op(B) is [K, N] and C is [M, N]. `lda`, `ldb` and
+// `ldc` are the row strides of the matrices as stored (i.e. before applying
+// `transA` / `transB`). When `beta` is zero, C is not read.
+//
+// The implementation packs cache-sized blocks of both operands and runs a
+// register-blocked microkernel over them, in parallel across tiles of C.
+void sgemm(bool transA, bool transB, std::int64_t M, std::int64_t N,
+           std::int64_t K, float alpha, const float *A, std::int64_t lda,
+           const float *B, std::int64_t ldb, float beta, float *C,
+           std::int64_t ldc);
+
+// Like sgemm, with B [K, N] given as `packedB`, packed into the panels that
+// sgemm would otherwise pack on every call (see GemmLayout.h).
+void sgemmPrepackedB(bool transA, std::int64_t M, std::int64_t N,
+                     std::int64_t K, float alpha, const float *A,
+                     std::int64_t lda, const float *packedB, float beta,
+                     float *C, std::int64_t ldc);
+
+} // namespace aten
+} // namespace refbackrt
+
+#endif // NPCOMP_LIB_REFBACKEND_ATENKERNELS_GEMM_H
@@ -0,0 +1,1252 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// CPU implementations of the functions that the ATen lowering pass
+// (`-aten-to-std`) emits calls to.
+//
+// The ABI is defined by `getSimplyMangledFuncName` and `getATenFn` in
+// ATenLoweringPass.cpp:
+// - The symbol name is `<prefix>_<results>_<memref operands>_out`, where each
+//   memref is mangled as `<rank><elementtype>`, e.g. `4F32`. Scalar operands
+//   do not contribute to the name.
+// - The arguments are the operands of the original op in order (memrefs with
+//   erased shapes and fully dynamic strided layouts; integer lists as an i32
+//   holding the first element), followed by one memref per result, which the
+//   callee fills in.
+// - Each scalar is converted to the type its kernel declares here, as listed
+//   by `getScalarParameterKinds`: ATen `Scalar`s (alpha, beta, threshold) and
+//   floats are f32, integers and booleans are i32.
+// - Operands may be arbitrary strided views (including zero strides), since
+//   view ops are lowered without copying. Results are always fresh
+//   contiguous buffers.
+// - Declarations carry `llvm.emit_c_interface`, so memrefs arrive here as
+//   pointers to descriptors through `_mlir_ciface_<name>`.
+//
+// Each kernel is written once against the rank-erased `View` type; the macros
+// at the bottom of the file stamp out the rank specializations that the ABI
+// needs.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Gemm.h"
+#include "Parallel.h"
+#include "StridedMemRef.h"
+
+#include "npcomp/RefBackend/ATenKernels/GemmLayout.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+using namespace refbackrt::aten;
+
+// Minimum number of elements per task for simple elementwise loops. Below
+// this, the cost of waking up the thread pool dominates.
+static constexpr std::int64_t kElementwiseGrain = 1 << 15;
+
+//===----------------------------------------------------------------------===//
+// Shape utilities
+//===----------------------------------------------------------------------===//
+
+// Pad `view` to kMaxRank dimensions by prepending unit dimensions.
+template <typename T> static View<T> padToMaxRank(View<T> view) {
+  View<T> result;
+  result.data = view.data;
+  result.rank = kMaxRank;
+  int shift = kMaxRank - view.rank;
+  for (int i = 0; i < shift; i++) {
+    result.sizes[i] = 1;
+    result.strides[i] = 0;
+  }
+  for (int i = 0; i < view.rank; i++) {
+    result.sizes[shift + i] = view.sizes[i];
+    result.strides[shift + i] = view.strides[i];
+  }
+  return result;
+}
+
+// Broadcast `view` (numpy style, aligning trailing dimensions) to the shape of
+// `shape`, which must already be padded to kMaxRank. Broadcast dimensions get
+// a stride of zero.
+template <typename T, typename U>
+static View<T> broadcastTo(const char *kernel, View<T> view,
+                           const View<U> &shape) {
+  view = padToMaxRank(view);
+  for (int i = 0; i < kMaxRank; i++) {
+    if (view.sizes[i] == shape.sizes[i])
+      continue;
+    if (view.sizes[i] != 1)
+      fatalError(kernel, "operand shapes are not broadcast compatible");
+    view.sizes[i] = shape.sizes[i];
+    view.strides[i] = 0;
+  }
+  return view;
+}
+
+static void checkSameShape(const char *kernel, std::int64_t actual,
+                           std::int64_t expected) {
+  if (actual != expected)
+    fatalError(kernel, "unexpected operand shape");
+}
+
+//===----------------------------------------------------------------------===//
+// Elementwise
+//===----------------------------------------------------------------------===//
+
+// Apply `f` to each element of `out` (padded to kMaxRank), passing pointers to
+// the corresponding elements of `ins`. Contiguous operands take a flat loop
+// that the compiler vectorizes; otherwise the outer three dimensions are
+// parallelized and the innermost one is a tight strided loop.
+template <int N, typename F>
+static void forEachElement(View<float> out, View<float> (&ins)[N], F f) {
+  bool allContiguous = out.isContiguous();
+  for (int k = 0; k < N; k++)
+    allContiguous &= ins[k].isContiguous();
+  std::int64_t numElements = out.numElements();
+  if (numElements == 0)
+    return;
+
+  if (allContiguous) {
+    parallelFor(0, numElements, kElementwiseGrain,
+                [&](std::int64_t begin, std::int64_t end) {
+                  const float *inPtrs[N];
+                  for (int k = 0; k < N; k++)
+                    inPtrs[k] = ins[k].data;
+                  float *outPtr = out.data;
+                  for (std::int64_t i = begin; i < end; i++)
+                    f(outPtr + i, inPtrs, i);
+                });
+    return;
+  }
+
+  std::int64_t s1 = out.sizes[1], s2 = out.sizes[2];
+  std::int64_t inner = out.sizes[3];
+  std::int64_t outer = out.sizes[0] * s1 * s2;
+  std::int64_t grain = std::max<std::int64_t>(1, kElementwiseGrain / inner);
+  parallelFor(0, outer, grain, [&](std::int64_t begin, std::int64_t end) {
+    for (std::int64_t idx = begin; idx < end; idx++) {
+      std::int64_t i2 = idx % s2;
+      std::int64_t i1 = (idx / s2) % s1;
+      std::int64_t i0 = idx / (s1 * s2);
+      float *outRow = out.data + i0 * out.strides[0] + i1 * out.strides[1] +
+                      i2 * out.strides[2];
+      const float *inRows[N];
+      std::int64_t inStrides[N];
+      for (int k = 0; k < N; k++) {
+        inRows[k] = ins[k].data + i0 * ins[k].strides[0] +
+                    i1 * ins[k].strides[1] + i2 * ins[k].strides[2];
+        inStrides[k] = ins[k].strides[3];
+      }
+      std::int64_t outStride = out.strides[3];
+      for (std::int64_t j = 0; j < inner; j++) {
+        const float *inPtrs[N];
+        for (int k = 0; k < N; k++)
+          inPtrs[k] = inRows[k] + j * inStrides[k];
+        f(outRow + j * outStride, inPtrs, 0);
+      }
+    }
+  });
+}
+
+template <typename F>
+static void unaryOp(const char *kernel, View<float> out, View<float> in, F f) {
+  View<float> paddedOut = padToMaxRank(out);
+  View<float> ins[1] = {broadcastTo(kernel, in, paddedOut)};
+  forEachElement(paddedOut, ins,
+                 [&](float *o, const float *const *i, std::int64_t offset) {
+                   *o = f(i[0][offset]);
+                 });
+}
+
+template <typename F>
+static void binaryOp(const char *kernel, View<float> out, View<float> lhs,
+                     View<float> rhs, F f) {
+  View<float> paddedOut = padToMaxRank(out);
+  View<float> ins[2] = {broadcastTo(kernel, lhs, paddedOut),
+                        broadcastTo(kernel, rhs, paddedOut)};
+  forEachElement(paddedOut, ins,
+                 [&](float *o, const float *const *i, std::int64_t offset) {
+                   *o = f(i[0][offset], i[1][offset]);
+                 });
+}
+
+// Copy `in` into `out`, broadcasting as needed.
+static void copyInto(const char *kernel, View<float> out, View<float> in) {
+  if (out.isContiguous() && in.isContiguous() &&
+      in.numElements() == out.numElements()) {
+    std::int64_t n = out.numElements();
+    parallelFor(0, n, kElementwiseGrain,
+                [&](std::int64_t begin, std::int64_t end) {
+                  std::memcpy(out.data + begin, in.data + begin,
+                              (end - begin) * sizeof(float));
+                });
+    return;
+  }
+  unaryOp(kernel, out, in, [](float x) { return x; });
+}
+
+// Copy `in` into the contiguous view `out` of the same shape.
+template <typename T> static void gatherInto(View<T> out, View<T> in) {
+  View<T> src = padToMaxRank(in);
+  T *dst = out.data;
+  for (std::int64_t i0 = 0; i0 < src.sizes[0]; i0++)
+    for (std::int64_t i1 = 0; i1 < src.sizes[1]; i1++)
+      for (std::int64_t i2 = 0; i2 < src.sizes[2]; i2++)
+        for (std::int64_t i3 = 0; i3 < src.sizes[3]; i3++)
+          *dst++ = src.data[i0 * src.strides[0] + i1 * src.strides[1] +
+                            i2 * src.strides[2] + i3 * src.strides[3]];
+}
+
+static void gatherInto(View<float> out, View<float> in) {
+  copyInto("contiguous", out, in);
+}
+
+// Return `in` itself if it is contiguous (or absent), and otherwise a
+// row-major copy of it backed by `storage`. The compiler passes views such as
+// transposes and expands to kernels without materializing them, so kernels
+// whose loops assume the row-major layout call this on their inputs. Results
+// are always freshly allocated, contiguous buffers.
+template <typename T>
+static View<T> makeContiguous(View<T> in, std::vector<T> &storage) {
+  if (!in.data || in.isContiguous())
+    return in;
+  storage.resize(in.numElements());
+  View<T> out = in;
+  out.data = storage.data();
+  std::int64_t stride = 1;
+  for (int i = in.rank - 1; i >= 0; i--) {
+    out.strides[i] = stride;
+    stride *= in.sizes[i];
+  }
+  gatherInto(out, in);
+  return out;
+}
+
+static void add(View<float> out, View<float> lhs, View<float> rhs,
+                float alpha) {
+  if (alpha == 1.0f) {
+    binaryOp("add", out, lhs, rhs, [](float a, float b) { return a + b; });
+    return;
+  }
+  binaryOp("add", out, lhs, rhs,
+           [alpha](float a, float b) { return a + alpha * b; });
+}
+
+static void mul(View<float> out, View<float> lhs, View<float> rhs) {
+  binaryOp("mul", out, lhs, rhs, [](float a, float b) { return a * b; });
+}
+
+static void div(View<float> out, View<float> lhs, View<float> rhs) {
+  binaryOp("div", out, lhs, rhs, [](float a, float b) { return a / b; });
+}
+
+static void relu(View<float> out, View<float> in) {
+  unaryOp("relu", out, in, [](float x) { return x > 0.0f ? x : 0.0f; });
+}
+
+static void thresholdBackward(View<float> out, View<float> gradOutput,
+                              View<float> self, float threshold) {
+  binaryOp("threshold_backward", out, gradOutput, self,
+           [threshold](float grad, float x) {
+             return x <= threshold ? 0.0f : grad;
+           });
+}
+
+//===----------------------------------------------------------------------===//
+// Matrix multiplication
+//===----------------------------------------------------------------------===//
+
+namespace {
+// A matrix operand of sgemm, accepting either a row-major or a transposed
+// (column-major) layout without copying.
+struct GemmOperand {
+  const float *data;
+  bool trans;
+  std::int64_t ld;
+};
+} // namespace
+
+// Returns false if neither dimension of `m` has a unit stride. The stride of
+// a unit dimension is meaningless, so any leading dimension works for it. Zero
+// strides (from expand) are fine too, since sgemm only reads its inputs.
+static bool getGemmOperand(View<float> m, GemmOperand &operand) {
+  if (m.strides[1] == 1 || m.sizes[1] == 1) {
+    operand = {m.data, false, m.sizes[0] == 1 ? m.sizes[1] : m.strides[0]};
+    return true;
+  }
+  if (m.strides[0] == 1 || m.sizes[0] == 1) {
+    operand = {m.data, true, m.sizes[1] == 1 ? m.sizes[0] : m.strides[1]};
+    return true;
+  }
+  return false;
+}
+
+static void matmul(const char *kernel, View<float> out, View<float> lhs,
+                   View<float> rhs, float alpha, float beta) {
+  std::int64_t M = out.sizes[0], N = out.sizes[1], K = lhs.sizes[1];
+  checkSameShape(kernel, lhs.sizes[0], M);
+  checkSameShape(kernel, rhs.sizes[0], K);
+  checkSameShape(kernel, rhs.sizes[1], N);
+  if (out.strides[1] != 1 && N != 1)
+    fatalError(kernel, "result must be row-major");
+  std::vector<float> lhsStorage, rhsStorage;
+  GemmOperand a, b;
+  if (!getGemmOperand(lhs, a))
+    getGemmOperand(makeContiguous(lhs, lhsStorage), a);
+  if (!getGemmOperand(rhs, b))
+    getGemmOperand(makeContiguous(rhs, rhsStorage), b);
+  sgemm(a.trans, b.trans, M, N, K, alpha, a.data, a.ld, b.data, b.ld, beta,
+        out.data, std::max<std::int64_t>(out.strides[0], N));
+}
+
+static void mm(View<float> out, View<float> lhs, View<float> rhs) {
+  matmul("mm", out, lhs, rhs, 1.0f, 0.0f);
+}
+
+// Like matmul, with the [K, N] rhs packed at compile time into the panels of
+// sgemm (see GemmLayout.h) by -aten-prepack-weights.
+static void matmulPrepacked(const char *kernel, View<float> out,
+                            View<float> lhs, View<float> packedRhs,
+                            float alpha, float beta) {
+  std::int64_t M = out.sizes[0], N = out.sizes[1], K = lhs.sizes[1];
+  checkSameShape(kernel, lhs.sizes[0], M);
+  checkSameShape(kernel, packedRhs.sizes[0], getPackedGemmBSize(K, N));
+  if (packedRhs.strides[0] != 1)
+    fatalError(kernel, "packed operand must be contiguous");
+  if (out.strides[1] != 1 && N != 1)
+    fatalError(kernel, "result must be row-major");
+  std::vector<float> lhsStorage;
+  GemmOperand a;
+  if (!getGemmOperand(lhs, a))
+    getGemmOperand(makeContiguous(lhs, lhsStorage), a);
+  sgemmPrepackedB(a.trans, M, N, K, alpha, a.data, a.ld, packedRhs.data, beta,
+                  out.data, std::max<std::int64_t>(out.strides[0], N));
+}
+
+static void mmPrepacked(View<float> out, View<float> lhs,
+                        View<float> packedRhs) {
+  matmulPrepacked("mm_prepacked", out, lhs, packedRhs, 1.0f, 0.0f);
+}
+
+// out = param + alpha * lhs * rhs, with the update applied by the GEMM.
+static void mmUpdate(View<float> out, View<float> param, View<float> lhs,
+                     View<float> rhs, float alpha) {
+  copyInto("mm_update", out, param);
+  matmul("mm_update", out, lhs, rhs, alpha, 1.0f);
+}
+
+static void addmm(View<float> out, View<float> bias, View<float> lhs,
+                  View<float> rhs, float beta, float alpha) {
+  // As in PyTorch, a zero beta means the bias is ignored entirely (so NaNs in
+  // it do not propagate).
+  if (beta != 0.0f)
+    copyInto("addmm", out, bias);
+  matmul("addmm", out, lhs, rhs, alpha, beta);
+}
+
+static void addmmPrepacked(View<float> out, View<float> bias, View<float> lhs,
+                           View<float> packedRhs, float beta, float alpha) {
+  if (beta != 0.0f)
+    copyInto("addmm_prepacked", out, bias);
+  matmulPrepacked("addmm_prepacked", out, lhs, packedRhs, alpha, beta);
+}
+
+//===----------------------------------------------------------------------===//
+// Convolution
+//===----------------------------------------------------------------------===//
+
+namespace {
+// The geometry of a 2-D NCHW convolution. The ABI passes only the first
+// element of each list operand, so stride, padding and dilation are square.
+struct ConvGeometry {
+  std::int64_t N, C, H, W;    // Input.
+  std::int64_t K, KH, KW;     // Weight is [K, C / groups, KH, KW].
+  std::int64_t OH, OW;        // Output is [N, K, OH, OW].
+  std::int64_t stride, padding, dilation, groups;
+
+  std::int64_t cPerGroup() const { return C / groups; }
+  std::int64_t kPerGroup() const { return K / groups; }
+  // Rows of the im2col matrix for one group.
+  std::int64_t colRows() const { return cPerGroup() * KH * KW; }
+  std::int64_t colCols() const { return OH * OW; }
+  // Whether the im2col matrix is the input itself.
+  bool isPointwise() const {
+    return KH == 1 && KW == 1 && stride == 1 && padding == 0;
+  }
+};
+} // namespace
+
+// All operands must be contiguous.
+static ConvGeometry getConvGeometry(const char *kernel, View<float> input,
+                                    View<float> weight, View<float> output,
+                                    std::int32_t stride, std::int32_t padding,
+                                    std::int32_t dilation,
+                                    std::int32_t transposed,
+                                    std::int32_t groups) {
+  if (transposed)
+    fatalError(kernel, "transposed convolution is not supported");
+  ConvGeometry g;
+  g.N = input.sizes[0];
+  g.C = input.sizes[1];
+  g.H = input.sizes[2];
+  g.W = input.sizes[3];
+  g.K = weight.sizes[0];
+  g.KH = weight.sizes[2];
+  g.KW = weight.sizes[3];
+  g.OH = output.sizes[2];
+  g.OW = output.sizes[3];
+  g.stride = std::max<std::int32_t>(stride, 1);
+  g.padding = std::max<std::int32_t>(padding, 0);
+  g.dilation = std::max<std::int32_t>(dilation, 1);
+  g.groups = std::max<std::int32_t>(groups, 1);
+  if (g.C % g.groups != 0 || g.K % g.groups != 0)
+    fatalError(kernel, "channels must be divisible by groups");
+  checkSameShape(kernel, weight.sizes[1], g.cPerGroup());
+  checkSameShape(kernel, output.sizes[0], g.N);
+  checkSameShape(kernel, output.sizes[1], g.K);
+  return g;
+}
+
+// Unfold one group of one image ([cPerGroup, H, W]) into a
+// [cPerGroup * KH * KW, OH * OW] matrix.
+static void im2col(const ConvGeometry &g, const float *image, float *col) {
+  for (std::int64_t c = 0; c < g.cPerGroup(); c++) {
+    for (std::int64_t kh = 0; kh < g.KH; kh++) {
+      for (std::int64_t kw = 0; kw < g.KW; kw++) {
+        float *dst = col + ((c * g.KH + kh) * g.KW + kw) * g.colCols();
+        for (std::int64_t oh = 0; oh < g.OH; oh++) {
+          std::int64_t h = oh * g.stride - g.padding + kh * g.dilation;
+          float *dstRow = dst + oh * g.OW;
+          if (h < 0 || h >= g.H) {
+            std::fill(dstRow, dstRow + g.OW, 0.0f);
+            continue;
+          }
+          const float *srcRow = image + (c * g.H + h) * g.W;
+          for (std::int64_t ow = 0; ow < g.OW; ow++) {
+            std::int64_t w = ow * g.stride - g.padding + kw * g.dilation;
+            dstRow[ow] = (w >= 0 && w < g.W) ? srcRow[w] : 0.0f;
+          }
+        }
+      }
+    }
+  }
+}
+
+// The adjoint of im2col: accumulate a [cPerGroup * KH * KW, OH * OW] matrix
+// back into one group of one image.
+static void col2im(const ConvGeometry &g, const float *col, float *image) {
+  for (std::int64_t c = 0; c < g.cPerGroup(); c++) {
+    for (std::int64_t kh = 0; kh < g.KH; kh++) {
+      for (std::int64_t kw = 0; kw < g.KW; kw++) {
+        const float *src = col + ((c * g.KH + kh) * g.KW + kw) * g.colCols();
+        for (std::int64_t oh = 0; oh < g.OH; oh++) {
+          std::int64_t h = oh * g.stride - g.padding + kh * g.dilation;
+          if (h < 0 || h >= g.H)
+            continue;
+          float *dstRow = image + (c * g.H + h) * g.W;
+          const float *srcRow = src + oh * g.OW;
+          for (std::int64_t ow = 0; ow < g.OW; ow++) {
+            std::int64_t w = ow * g.stride - g.padding + kw * g.dilation;
+            if (w >= 0 && w < g.W)
+              dstRow[w] += srcRow[ow];
+          }
+        }
+      }
+    }
+  }
+}
+
+static void conv2d(View<float> output, View<float> input, View<float> weight,
+                   View<float> bias, std::int32_t stride,
+                   std::int32_t padding, std::int32_t dilation,
+                   std::int32_t transposed, std::int32_t outputPadding,
+                   std::int32_t groups) {
+  (void)outputPadding; // Only meaningful for transposed convolutions.
+  checkContiguous("conv2d", output.isContiguous());
+  std::vector<float> inputStorage, weightStorage;
+  input = makeContiguous(input, inputStorage);
+  weight = makeContiguous(weight, weightStorage);
+  ConvGeometry g = getConvGeometry("conv2d", input, weight, output, stride,
+                                   padding, dilation, transposed, groups);
+  bool hasBias = bias.data != nullptr;
+  if (hasBias)
+    checkSameShape("conv2d", bias.sizes[0], g.K);
+
+  // Images are independent; with a batch of one, the parallelism comes from
+  // inside the GEMM instead.
+  parallelFor(0, g.N, 1, [&](std::int64_t begin, std::int64_t end) {
+    std::vector<float> col;
+    if (!g.isPointwise())
+      col.resize(g.colRows() * g.colCols());
+    for (std::int64_t n = begin; n < end; n++) {
+      for (std::int64_t grp = 0; grp < g.groups; grp++) {
+        const float *image =
+            input.data + (n * g.C + grp * g.cPerGroup()) * g.H * g.W;
+        const float *colData = image;
+        if (!g.isPointwise()) {
+          im2col(g, image, col.data());
+          colData = col.data();
+        }
+        const float *w = weight.data + grp * g.kPerGroup() * g.colRows();
+        float *out =
+            output.data + (n * g.K + grp * g.kPerGroup()) * g.colCols();
+        // out[kPerGroup, OH * OW] = w[kPerGroup, colRows] * col
+        sgemm(false, false, g.kPerGroup(), g.colCols(), g.colRows(), 1.0f, w,
+              g.colRows(), colData, g.colCols(), 0.0f, out, g.colCols());
+      }
+      if (hasBias) {
+        for (std::int64_t k = 0; k < g.K; k++) {
+          float b = bias.data[k * bias.strides[0]];
+          float *out = output.data + (n * g.K + k) * g.colCols();
+          for (std::int64_t i = 0; i < g.colCols(); i++)
+            out[i] += b;
+        }
+      }
+    }
+  });
+}
+
+static void conv2dBackward(View<float> gradOutput, View<float> input,
+                           View<float> weight, std::int32_t stride,
+                           std::int32_t padding, std::int32_t dilation,
+                           std::int32_t transposed,
+                           std::int32_t outputPadding, std::int32_t groups,
+                           std::int32_t outputMask, View<float> gradInput,
+                           View<float> gradWeight, View<float> gradBias,
+                           View<float> param = View<float>(),
+                           float alpha = 1.0f) {
+  // The ABI only carries the first element of output_mask, and all three
+  // results are allocated by the caller regardless, so compute all of them.
+  (void)outputPadding;
+  (void)outputMask;
+  const char *kernel =
+      param.data ? "conv2d_backward_update" : "conv2d_backward";
+  checkContiguous(kernel, gradInput.isContiguous());
+  checkContiguous(kernel, gradWeight.isContiguous());
+  std::vector<float> gradOutputStorage, inputStorage, weightStorage;
+  gradOutput = makeContiguous(gradOutput, gradOutputStorage);
+  input = makeContiguous(input, inputStorage);
+  weight = makeContiguous(weight, weightStorage);
+  ConvGeometry g = getConvGeometry(kernel, input, weight, gradOutput, stride,
+                                   padding, dilation, transposed, groups);
+
+  // grad_bias[k] = sum over n, oh, ow of grad_output[n, k, oh, ow].
+  parallelFor(0, g.K, 1, [&](std::int64_t begin, std::int64_t end) {
+    for (std::int64_t k = begin; k < end; k++) {
+      double sum = 0.0;
+      for (std::int64_t n = 0; n < g.N; n++) {
+        const float *go = gradOutput.data + (n * g.K + k) * g.colCols();
+        for (std::int64_t i = 0; i < g.colCols(); i++)
+          sum += go[i];
+      }
+      gradBias.data[k * gradBias.strides[0]] = static_cast<float>(sum);
+    }
+  });
+
+  // grad_weight[grp] = sum over n of grad_output[n, grp] * col(n, grp)^T.
+  // The reduction over the batch is serial, each GEMM is parallel. With a
+  // fused update, the sum is scaled by alpha and accumulated into a copy of
+  // the parameter instead.
+  {
+    if (param.data)
+      copyInto(kernel, gradWeight, param);
+    std::vector<float> col(g.isPointwise() ? 0 : g.colRows() * g.colCols());
+    for (std::int64_t n = 0; n < g.N; n++) {
+      for (std::int64_t grp = 0; grp < g.groups; grp++) {
+        const float *image =
+            input.data + (n * g.C + grp * g.cPerGroup()) * g.H * g.W;
+        const float *colData = image;
+        if (!g.isPointwise()) {
+          im2col(g, image, col.data());
+          colData = col.data();
+        }
+        const float *go =
+            gradOutput.data + (n * g.K + grp * g.kPerGroup()) * g.colCols();
+        float *gw = gradWeight.data + grp * g.kPerGroup() * g.colRows();
+        sgemm(false, true, g.kPerGroup(), g.colRows(), g.colCols(), alpha, go,
+              g.colCols(), colData, g.colCols(),
+              n == 0 && !param.data ? 0.0f : 1.0f, gw, g.colRows());
+      }
+    }
+  }
+
+  // grad_input[n, grp] = col2im(w[grp]^T * grad_output[n, grp]).
+  std::fill(gradInput.data, gradInput.data + gradInput.numElements(), 0.0f);
+  parallelFor(0, g.N, 1, [&](std::int64_t begin, std::int64_t end) {
+    std::vector<float> colGrad(g.colRows() * g.colCols());
+    for (std::int64_t n = begin; n < end; n++) {
+      for (std::int64_t grp = 0; grp < g.groups; grp++) {
+        const float *w = weight.data + grp * g.kPerGroup() * g.colRows();
+        const float *go =
+            gradOutput.data + (n * g.K + grp * g.kPerGroup()) * g.colCols();
+        float *gi =
+            gradInput.data + (n * g.C + grp * g.cPerGroup()) * g.H * g.W;
+        if (g.isPointwise()) {
+          sgemm(true, false, g.colRows(), g.colCols(), g.kPerGroup(), 1.0f, w,
+                g.colRows(), go, g.colCols(), 0.0f, gi, g.colCols());
+          continue;
+        }
+        sgemm(true, false, g.colRows(), g.colCols(), g.kPerGroup(), 1.0f, w,
+              g.colRows(), go, g.colCols(), 0.0f, colGrad.data(),
+              g.colCols());
+        col2im(g, colGrad.data(), gi);
+      }
+    }
+  });
+}
+
+//===----------------------------------------------------------------------===//
+// Batch normalization
+//===----------------------------------------------------------------------===//
+
+// Normalizes over every dimension but the channel dimension (1). Running
+// statistics are inputs only: in training mode the batch statistics are
+// returned in `saveMean` / `saveInvstd` but the running buffers are not
+// updated, since the lowering treats the op as side-effect free.
+static void batchNorm(const char *kernel, View<float> input,
+                      View<float> weight, View<float> bias,
+                      View<float> runningMean, View<float> runningVar,
+                      std::int32_t training, float eps, View<float> output,
+                      View<float> saveMean, View<float> saveInvstd) {
+  checkContiguous(kernel, output.isContiguous());
+  std::vector<float> inputStorage;
+  input = makeContiguous(input, inputStorage);
+  std::int64_t N = input.sizes[0];
+  std::int64_t C = input.sizes[1];
+  std::int64_t inner = 1;
+  for (int i = 2; i < input.rank; i++)
+    inner *= input.sizes[i];
+  bool hasWeight = weight.data != nullptr;
+  bool hasBias = bias.data != nullptr;
+
+  parallelFor(0, C, 1, [&](std::int64_t begin, std::int64_t end) {
+    for (std::int64_t c = begin; c < end; c++) {
+      float mean, invstd;
+      if (training) {
+        // Two passes for numerical stability.
+        double sum = 0.0;
+        for (std::int64_t n = 0; n < N; n++) {
+          const float *x = input.data + (n * C + c) * inner;
+          for (std::int64_t i = 0; i < inner; i++)
+            sum += x[i];
+        }
+        double count = static_cast<double>(N * inner);
+        double m = count > 0 ? sum / count : 0.0;
+        double sq = 0.0;
+        for (std::int64_t n = 0; n < N; n++) {
+          const float *x = input.data + (n * C + c) * inner;
+          for (std::int64_t i = 0; i < inner; i++) {
+            double d = x[i] - m;
+            sq += d * d;
+          }
+        }
+        double var = count > 0 ? sq / count : 0.0;
+        mean = static_cast<float>(m);
+        invstd = static_cast<float>(1.0 / std::sqrt(var + eps));
+      } else {
+        mean = runningMean.data[c * runningMean.strides[0]];
+        invstd = 1.0f / std::sqrt(runningVar.data[c * runningVar.strides[0]] +
+                                  eps);
+      }
+      saveMean.data[c * saveMean.strides[0]] = mean;
+      saveInvstd.data[c * saveInvstd.strides[0]] = invstd;
+
+      // y = x * scale + shift
+      float w = hasWeight ? weight.data[c * weight.strides[0]] : 1.0f;
+      float b = hasBias ? bias.data[c * bias.strides[0]] : 0.0f;
+      float scale = w * invstd;
+      float shift = b - mean * scale;
+      for (std::int64_t n = 0; n < N; n++) {
+        const float *x = input.data + (n * C + c) * inner;
+        float *y = output.data + (n * C + c) * inner;
+        for (std::int64_t i = 0; i < inner; i++)
+          y[i] = x[i] * scale + shift;
+      }
+    }
+  });
+}
+
+//===----------------------------------------------------------------------===//
+// Pooling
+//===----------------------------------------------------------------------===//
+
+namespace {
+struct PoolGeometry {
+  std::int64_t planes, H, W, OH, OW;
+  std::int64_t kernel, stride, padding, dilation;
+};
+} // namespace
+
+static PoolGeometry getPoolGeometry(const char *kernel, View<float> input,
+                                    View<float> output,
+                                    std::int32_t kernelSize,
+                                    std::int32_t stride, std::int32_t padding,
+                                    std::int32_t dilation) {
+  checkContiguous(kernel, output.isContiguous());
+  checkSameShape(kernel, output.sizes[0], input.sizes[0]);
+  checkSameShape(kernel, output.sizes[1], input.sizes[1]);
+  PoolGeometry g;
+  g.planes = input.sizes[0] * input.sizes[1];
+  g.H = input.sizes[2];
+  g.W = input.sizes[3];
+  g.OH = output.sizes[2];
+  g.OW = output.sizes[3];
+  g.kernel = std::max<std::int32_t>(kernelSize, 1);
+  // An empty stride list means "same as the kernel size".
+  g.stride = stride > 0 ? stride : g.kernel;
+  g.padding = std::max<std::int32_t>(padding, 0);
+  g.dilation = std::max<std::int32_t>(dilation, 1);
+  return g;
+}
+
+// Ceil mode only affects the output shape, which is already baked into the
+// result buffer, so it is not needed here.
+static void maxPool2d(const char *kernel, View<float> input,
+                      std::int32_t kernelSize, std::int32_t stride,
+                      std::int32_t padding, std::int32_t dilation,
+                      View<float> output, std::int64_t *indices) {
+  std::vector<float> inputStorage;
+  input = makeContiguous(input, inputStorage);
+  PoolGeometry g = getPoolGeometry(kernel, input, output, kernelSize, stride,
+                                   padding, dilation);
+  std::int64_t grain =
+      std::max<std::int64_t>(1, kElementwiseGrain / (g.OH * g.OW + 1));
+  parallelFor(0, g.planes, grain, [&](std::int64_t begin, std::int64_t end) {
+    for (std::int64_t p = begin; p < end; p++) {
+      const float *in = input.data + p * g.H * g.W;
+      float *out = output.data + p * g.OH * g.OW;
+      std::int64_t *idx = indices ? indices + p * g.OH * g.OW : nullptr;
+      for (std::int64_t oh = 0; oh < g.OH; oh++) {
+        std::int64_t h0 = oh * g.stride - g.padding;
+        for (std::int64_t ow = 0; ow < g.OW; ow++) {
+          std::int64_t w0 = ow * g.stride - g.padding;
+          float best = -std::numeric_limits<float>::infinity();
+          std::int64_t bestIndex = -1;
+          for (std::int64_t kh = 0; kh < g.kernel; kh++) {
+            std::int64_t h = h0 + kh * g.dilation;
+            if (h < 0 || h >= g.H)
+              continue;
+            for (std::int64_t kw = 0; kw < g.kernel; kw++) {
+              std::int64_t w = w0 + kw * g.dilation;
+              if (w < 0 || w >= g.W)
+                continue;
+              float v = in[h * g.W + w];
+              // NaN propagates, as in PyTorch.
+              if (v > best || std::isnan(v) || bestIndex < 0) {
+                best = v;
+                bestIndex = h * g.W + w;
+                if (std::isnan(v))
+                  break;
+              }
+            }
+          }
+          out[oh * g.OW + ow] = best;
+          if (idx)
+            idx[oh * g.OW + ow] = bestIndex;
+        }
+      }
+    }
+  });
+}
+
+static void maxPool2dWithIndicesBackward(View<float> gradInput,
+                                         View<float> gradOutput,
+                                         View<float> self,
+                                         View<std::int64_t> indices) {
+  const char *kernel = "max_pool2d_with_indices_backward";
+  checkContiguous(kernel, gradInput.isContiguous());
+  std::vector<float> gradOutputStorage;
+  std::vector<std::int64_t> indicesStorage;
+  gradOutput = makeContiguous(gradOutput, gradOutputStorage);
+  indices = makeContiguous(indices, indicesStorage);
+  checkSameShape(kernel, gradInput.numElements(), self.numElements());
+  std::int64_t planes = gradInput.sizes[0] * gradInput.sizes[1];
+  std::int64_t inPlane = gradInput.sizes[2] * gradInput.sizes[3];
+  std::int64_t outPlane = gradOutput.sizes[2] * gradOutput.sizes[3];
+  parallelFor(0, planes, 1, [&](std::int64_t begin, std::int64_t end) {
+    for (std::int64_t p = begin; p < end; p++) {
+      float *gi = gradInput.data + p * inPlane;
+      const float *go = gradOutput.data + p * outPlane;
+      const std::int64_t *idx = indices.data + p * outPlane;
+      std::fill(gi, gi + inPlane, 0.0f);
+      for (std::int64_t i = 0; i < outPlane; i++)
+        if (idx[i] >= 0 && idx[i] < inPlane)
+          gi[idx[i]] += go[i];
+    }
+  });
+}
+
+//===----------------------------------------------------------------------===//
+// Softmax
+//===----------------------------------------------------------------------===//
+
+namespace {
+// A contiguous tensor viewed as [outer, dimSize, inner] around `dim`.
+struct ReductionShape {
+  std::int64_t outer = 1, dimSize = 1, inner = 1;
+};
+} // namespace
+
+static ReductionShape getReductionShape(const char *kernel, View<float> v,
+                                        std::int32_t dim) {
+  if (dim < 0)
+    dim += v.rank;
+  if (dim < 0 || dim >= std::max(v.rank, 1))
+    fatalError(kernel, "dimension out of range");
+  ReductionShape shape;
+  for (int i = 0; i < v.rank; i++) {
+    if (i < dim)
+      shape.outer *= v.sizes[i];
+    else if (i == dim)
+      shape.dimSize = v.sizes[i];
+    else
+      shape.inner *= v.sizes[i];
+  }
+  return shape;
+}
+
+static void logSoftmax(View<float> output, View<float> input, std::int32_t dim,
+                       std::int32_t halfToFloat) {
+  (void)halfToFloat;
+  const char *kernel = "log_softmax";
+  checkContiguous(kernel, output.isContiguous());
+  std::vector<float> inputStorage;
+  input = makeContiguous(input, inputStorage);
+  ReductionShape s = getReductionShape(kernel, input, dim);
+  std::int64_t grain =
+      std::max<std::int64_t>(1, kElementwiseGrain / (s.dimSize * s.inner + 1));
+  parallelFor(0, s.outer, grain, [&](std::int64_t begin, std::int64_t end) {
+    std::vector<float> maxVal(s.inner), sum(s.inner);
+    for (std::int64_t o = begin; o < end; o++) {
+      const float *in = input.data + o * s.dimSize * s.inner;
+      float *out = output.data + o * s.dimSize * s.inner;
+      // Reduce along `dim` for all `inner` positions at once so that the
+      // innermost loops run over contiguous memory.
+      std::fill(maxVal.begin(), maxVal.end(),
+                -std::numeric_limits<float>::infinity());
+      for (std::int64_t d = 0; d < s.dimSize; d++)
+        for (std::int64_t i = 0; i < s.inner; i++)
+          maxVal[i] = std::max(maxVal[i], in[d * s.inner + i]);
+      std::fill(sum.begin(), sum.end(), 0.0f);
+      for (std::int64_t d = 0; d < s.dimSize; d++)
+        for (std::int64_t i = 0; i < s.inner; i++)
+          sum[i] += std::exp(in[d * s.inner + i] - maxVal[i]);
+      for (std::int64_t i = 0; i < s.inner; i++)
+        sum[i] = maxVal[i] + std::log(sum[i]);
+      for (std::int64_t d = 0; d < s.dimSize; d++)
+        for (std::int64_t i = 0; i < s.inner; i++)
+          out[d * s.inner + i] = in[d * s.inner + i] - sum[i];
+    }
+  });
+}
+
+static void logSoftmaxBackwardData(View<float> gradInput,
+                                   View<float> gradOutput, View<float> output,
+                                   std::int32_t dim, View<float> self) {
+  (void)self;
+  const char *kernel = "log_softmax_backward_data";
+  checkContiguous(kernel, gradInput.isContiguous());
+  std::vector<float> gradOutputStorage, outputStorage;
+  gradOutput = makeContiguous(gradOutput, gradOutputStorage);
+  output = makeContiguous(output, outputStorage);
+  ReductionShape s = getReductionShape(kernel, output, dim);
+  std::int64_t grain =
+      std::max<std::int64_t>(1, kElementwiseGrain / (s.dimSize * s.inner + 1));
+  parallelFor(0, s.outer, grain, [&](std::int64_t begin, std::int64_t end) {
+    std::vector<float> sum(s.inner);
+    for (std::int64_t o = begin; o < end; o++) {
+      std::int64_t base = o * s.dimSize * s.inner;
+      const float *go = gradOutput.data + base;
+      const float *out = output.data + base;
+      float *gi = gradInput.data + base;
+      // grad_input = grad_output - exp(output) * sum(grad_output, dim)
+      std::fill(sum.begin(), sum.end(), 0.0f);
+      for (std::int64_t d = 0; d < s.dimSize; d++)
+        for (std::int64_t i = 0; i < s.inner; i++)
+          sum[i] += go[d * s.inner + i];
+      for (std::int64_t d = 0; d < s.dimSize; d++)
+        for (std::int64_t i = 0; i < s.inner; i++)
+          gi[d * s.inner + i] =
+              go[d * s.inner + i] - std::exp(out[d * s.inner + i]) * sum[i];
+    }
+  });
+}
+
+//===----------------------------------------------------------------------===//
+// Negative log likelihood loss
+//===----------------------------------------------------------------------===//
+
+namespace {
+// Values of the `reduction` operand (at::Reduction::Reduction).
+enum Reduction { ReductionNone = 0, ReductionMean = 1, ReductionSum = 2 };
+
+// A view of nll_loss operands with the class dimension moved out of the way:
+// `self` is [N, C, inner] and `target` is [N, inner], both contiguous.
+struct NllLossShape {
+  std::int64_t N, C, inner;
+};
+} // namespace
+
+static NllLossShape getNllLossShape(const char *kernel, View<float> self,
+                                    View<std::int64_t> target) {
+  NllLossShape s;
+  s.N = self.sizes[0];
+  s.C = self.sizes[1];
+  s.inner = 1;
+  for (int i = 2; i < self.rank; i++)
+    s.inner *= self.sizes[i];
+  checkSameShape(kernel, target.numElements(), s.N * s.inner);
+  return s;
+}
+
+static float classWeight(View<float> weight, std::int64_t c) {
+  return weight.data ? weight.data[c * weight.strides[0]] : 1.0f;
+}
+
+static void nllLossForward(const char *kernel, View<float> self,
+                           View<std::int64_t> target, View<float> weight,
+                           std::int32_t reduction, std::int32_t ignoreIndex,
+                           View<float> output, View<float> totalWeight) {
+  std::vector<float> selfStorage;
+  std::vector<std::int64_t> targetStorage;
+  self = makeContiguous(self, selfStorage);
+  target = makeContiguous(target, targetStorage);
+  NllLossShape s = getNllLossShape(kernel, self, target);
+  if (reduction == ReductionNone) {
+    checkContiguous(kernel, output.isContiguous());
+    checkSameShape(kernel, output.numElements(), s.N * s.inner);
+  }
+  double lossSum = 0.0, weightSum = 0.0;
+  for (std::int64_t n = 0; n < s.N; n++) {
+    for (std::int64_t i = 0; i < s.inner; i++) {
+      std::int64_t t = target.data[n * s.inner + i];
+      float loss = 0.0f;
+      if (t != ignoreIndex) {
+        if (t < 0 || t >= s.C)
+          fatalError(kernel, "target out of bounds");
+        float w = classWeight(weight, t);
+        loss = -w * self.data[(n * s.C + t) * s.inner + i];
+        lossSum += loss;
+        weightSum += w;
+      }
+      if (reduction == ReductionNone)
+        output.data[n * s.inner + i] = loss;
+    }
+  }
+  totalWeight.data[0] = static_cast<float>(weightSum);
+  if (reduction == ReductionMean)
+    output.data[0] = static_cast<float>(lossSum / weightSum);
+  else if (reduction == ReductionSum)
+    output.data[0] = static_cast<float>(lossSum);
+}
+
+static void nllLossBackward(const char *kernel, View<float> gradOutput,
+                            View<float> self, View<std::int64_t> target,
+                            View<float> weight, std::int32_t reduction,
+                            std::int32_t ignoreIndex, View<float> totalWeight,
+                            View<float> gradInput) {
+  std::vector<float> gradOutputStorage, selfStorage;
+  std::vector<std::int64_t> targetStorage;
+  gradOutput = makeContiguous(gradOutput, gradOutputStorage);
+  self = makeContiguous(self, selfStorage);
+  target = makeContiguous(target, targetStorage);
+  NllLossShape s = getNllLossShape(kernel, self, target);
+  checkContiguous(kernel, gradInput.isContiguous());
+  checkSameShape(kernel, gradInput.numElements(), self.numElements());
+  std::fill(gradInput.data, gradInput.data + gradInput.numElements(), 0.0f);
+  float scale = 1.0f;
+  if (reduction == ReductionMean)
+    scale = 1.0f / totalWeight.data[0];
+  for (std::int64_t n = 0; n < s.N; n++) {
+    for (std::int64_t i = 0; i < s.inner; i++) {
+      std::int64_t t = target.data[n * s.inner + i];
+      if (t == ignoreIndex)
+        continue;
+      if (t < 0 || t >= s.C)
+        fatalError(kernel, "target out of bounds");
+      float g = reduction == ReductionNone
+                    ? gradOutput.data[n * s.inner + i]
+                    : gradOutput.data[0];
+      gradInput.data[(n * s.C + t) * s.inner + i] =
+          -classWeight(weight, t) * g * scale;
+    }
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// ABI entry points
+//===----------------------------------------------------------------------===//
+
+#define MEMREF(rank) StridedMemRef<float, rank> *
+#define MEMREF_I64(rank) StridedMemRef<std::int64_t, rank> *
+
+// Elementwise binary ops are exported for matching ranks and for one operand
+// broadcast from any lower rank (including scalars).
+#define BINARY_OP_RANKS(DEFINE)                                                \
+  DEFINE(1, 1, 1)                                                              \
+  DEFINE(1, 1, 0) DEFINE(1, 0, 1)                                              \
+  DEFINE(2, 2, 2)                                                              \
+  DEFINE(2, 2, 1) DEFINE(2, 1, 2) DEFINE(2, 2, 0) DEFINE(2, 0, 2)              \
+  DEFINE(3, 3, 3)                                                              \
+  DEFINE(3, 3, 2) DEFINE(3, 2, 3) DEFINE(3, 3, 1) DEFINE(3, 1, 3)              \
+  DEFINE(3, 3, 0) DEFINE(3, 0, 3)                                              \
+  DEFINE(4, 4, 4)                                                              \
+  DEFINE(4, 4, 3) DEFINE(4, 3, 4) DEFINE(4, 4, 2) DEFINE(4, 2, 4)              \
+  DEFINE(4, 4, 1) DEFINE(4, 1, 4) DEFINE(4, 4, 0) DEFINE(4, 0, 4)
+
+#define RANKS_1_TO_4(DEFINE) DEFINE(1) DEFINE(2) DEFINE(3) DEFINE(4)
+
+extern "C" {
+
+#define DEFINE_ADD(R, A, B)                                                    \
+  void _mlir_ciface_add_##R##F32_##A##F32_##B##F32_out(                        \
+      MEMREF(A) lhs, MEMREF(B) rhs, float alpha, MEMREF(R) out) {              \
+    add(makeView(out), makeView(lhs), makeView(rhs), alpha);                   \
+  }
+BINARY_OP_RANKS(DEFINE_ADD)
+
+#define DEFINE_MUL(R, A, B)                                                    \
+  void _mlir_ciface_mul_##R##F32_##A##F32_##B##F32_out(                        \
+      MEMREF(A) lhs, MEMREF(B) rhs, MEMREF(R) out) {                           \
+    mul(makeView(out), makeView(lhs), makeView(rhs));                          \
+  }
+BINARY_OP_RANKS(DEFINE_MUL)
+
+#define DEFINE_DIV(R, A, B)                                                    \
+  void _mlir_ciface_div_##R##F32_##A##F32_##B##F32_out(                        \
+      MEMREF(A) lhs, MEMREF(B) rhs, MEMREF(R) out) {                           \
+    div(makeView(out), makeView(lhs), makeView(rhs));                          \
+  }
+BINARY_OP_RANKS(DEFINE_DIV)
+
+#define DEFINE_RELU(R)                                                         \
+  void _mlir_ciface_relu_##R##F32_##R##F32_out(MEMREF(R) in, MEMREF(R) out) {  \
+    relu(makeView(out), makeView(in));                                         \
+  }
+RANKS_1_TO_4(DEFINE_RELU)
+
+#define DEFINE_THRESHOLD_BACKWARD(R)                                           \
+  void _mlir_ciface_threshold_backward_##R##F32_##R##F32_##R##F32_out(         \
+      MEMREF(R) gradOutput, MEMREF(R) self, float threshold,                   \
+      MEMREF(R) out) {                                                         \
+    thresholdBackward(makeView(out), makeView(gradOutput), makeView(self),     \
+                      threshold);                                              \
+  }
+RANKS_1_TO_4(DEFINE_THRESHOLD_BACKWARD)
+
+void _mlir_ciface_mm_2F32_2F32_2F32_out(MEMREF(2) lhs, MEMREF(2) rhs,
+                                        MEMREF(2) out) {
+  mm(makeView(out), makeView(lhs), makeView(rhs));
+}
+
+void _mlir_ciface_mm_update_2F32_2F32_2F32_2F32_out(MEMREF(2) param,
+                                                    MEMREF(2) lhs,
+                                                    MEMREF(2) rhs, float alpha,
+                                                    MEMREF(2) out) {
+  mmUpdate(makeView(out), makeView(param), makeView(lhs), makeView(rhs),
+           alpha);
+}
+
+#define DEFINE_ADDMM(B)                                                        \
+  void _mlir_ciface_addmm_2F32_##B##F32_2F32_2F32_out(                         \
+      MEMREF(B) bias, MEMREF(2) lhs, MEMREF(2) rhs, float beta, float alpha,   \
+      MEMREF(2) out) {                                                         \
+    addmm(makeView(out), makeView(bias), makeView(lhs), makeView(rhs), beta,   \
+          alpha);                                                              \
+  }
+DEFINE_ADDMM(0)
+DEFINE_ADDMM(1)
+DEFINE_ADDMM(2)
+
+// The packed rhs is a flat buffer, so it is rank 1.
+void _mlir_ciface_mm_prepacked_2F32_2F32_1F32_out(MEMREF(2) lhs,
+                                                  MEMREF(1) packedRhs,
+                                                  MEMREF(2) out) {
+  mmPrepacked(makeView(out), makeView(lhs), makeView(packedRhs));
+}
+
+#define DEFINE_ADDMM_PREPACKED(B)                                              \
+  void _mlir_ciface_addmm_prepacked_2F32_##B##F32_2F32_1F32_out(               \
+      MEMREF(B) bias, MEMREF(2) lhs, MEMREF(1) packedRhs, float beta,          \
+      float alpha, MEMREF(2) out) {                                            \
+    addmmPrepacked(makeView(out), makeView(bias), makeView(lhs),               \
+                   makeView(packedRhs), beta, alpha);                          \
+  }
+DEFINE_ADDMM_PREPACKED(0)
+DEFINE_ADDMM_PREPACKED(1)
+DEFINE_ADDMM_PREPACKED(2)
+
+void _mlir_ciface_conv2d_4F32_4F32_4F32_1F32_out(
+    MEMREF(4) input, MEMREF(4) weight, MEMREF(1) bias, std::int32_t stride,
+    std::int32_t padding, std::int32_t dilation, std::int32_t transposed,
+    std::int32_t outputPadding, std::int32_t groups, MEMREF(4) out) {
+  conv2d(makeView(out), makeView(input), makeView(weight), makeView(bias),
+         stride, padding, dilation, transposed, outputPadding, groups);
+}
+
+// Without bias (the bias operand was None).
+void _mlir_ciface_conv2d_4F32_4F32_4F32_out(
+    MEMREF(4) input, MEMREF(4) weight, std::int32_t stride,
+    std::int32_t padding, std::int32_t dilation, std::int32_t transposed,
+    std::int32_t outputPadding, std::int32_t groups, MEMREF(4) out) {
+  conv2d(makeView(out), makeView(input), makeView(weight), View<float>(),
+         stride, padding, dilation, transposed, outputPadding, groups);
+}
+
+void _mlir_ciface_conv2d_backward_4F32_4F32_1F32_4F32_4F32_4F32_out(
+    MEMREF(4) gradOutput, MEMREF(4) input, MEMREF(4) weight,
+    std::int32_t stride, std::int32_t padding, std::int32_t dilation,
+    std::int32_t transposed, std::int32_t outputPadding, std::int32_t groups,
+    std::int32_t outputMask, MEMREF(4) gradInput, MEMREF(4) gradWeight,
+    MEMREF(1) gradBias) {
+  conv2dBackward(makeView(gradOutput), makeView(input), makeView(weight),
+                 stride, padding, dilation, transposed, outputPadding, groups,
+                 outputMask, makeView(gradInput), makeView(gradWeight),
+                 makeView(gradBias));
+}
+
+void _mlir_ciface_conv2d_backward_update_4F32_4F32_1F32_4F32_4F32_4F32_4F32_out(
+    MEMREF(4) gradOutput, MEMREF(4) input, MEMREF(4) weight,
+    std::int32_t stride, std::int32_t padding, std::int32_t dilation,
+    std::int32_t transposed, std::int32_t outputPadding, std::int32_t groups,
+    std::int32_t outputMask, MEMREF(4) param, float alpha, MEMREF(4) gradInput,
+    MEMREF(4) updatedWeight, MEMREF(1) gradBias) {
+  conv2dBackward(makeView(gradOutput), makeView(input), makeView(weight),
+                 stride, padding, dilation, transposed, outputPadding, groups,
+                 outputMask, makeView(gradInput), makeView(updatedWeight),
+                 makeView(gradBias), makeView(param), alpha);
+}
+
+#define DEFINE_BATCH_NORM(R)                                                   \
+  void _mlir_ciface_batch_norm_##R##F32_1F32_1F32_##R##F32_1F32_1F32_1F32_1F32_out( \
+      MEMREF(R) input, MEMREF(1) weight, MEMREF(1) bias,                       \
+      MEMREF(1) runningMean, MEMREF(1) runningVar, std::int32_t training,      \
+      float momentum, float eps, std::int32_t cudnnEnabled, MEMREF(R) out,     \
+      MEMREF(1) saveMean, MEMREF(1) saveInvstd) {                              \
+    (void)momentum;                                                            \
+    (void)cudnnEnabled;                                                        \
+    batchNorm("batch_norm", makeView(input), makeView(weight),                 \
+              makeView(bias), makeView(runningMean), makeView(runningVar),     \
+              training, eps, makeView(out), makeView(saveMean),                \
+              makeView(saveInvstd));                                           \
+  }                                                                            \
+  void                                                                         \
+      _mlir_ciface_native_batch_norm_##R##F32_1F32_1F32_##R##F32_1F32_1F32_1F32_1F32_out( \
+          MEMREF(R) input, MEMREF(1) weight, MEMREF(1) bias,                   \
+          MEMREF(1) runningMean, MEMREF(1) runningVar, std::int32_t training,  \
+          float momentum, float eps, MEMREF(R) out, MEMREF(1) saveMean,        \
+          MEMREF(1) saveInvstd) {                                              \
+    (void)momentum;                                                            \
+    batchNorm("native_batch_norm", makeView(input), makeView(weight),          \
+              makeView(bias), makeView(runningMean), makeView(runningVar),     \
+              training, eps, makeView(out), makeView(saveMean),                \
+              makeView(saveInvstd));                                           \
+  }
+DEFINE_BATCH_NORM(2)
+DEFINE_BATCH_NORM(3)
+DEFINE_BATCH_NORM(4)
+
+void _mlir_ciface_max_pool2d_4F32_4F32_out(MEMREF(4) input,
+                                           std::int32_t kernelSize,
+                                           std::int32_t stride,
+                                           std::int32_t padding,
+                                           std::int32_t dilation,
+                                           std::int32_t ceilMode,
+                                           MEMREF(4) out) {
+  (void)ceilMode;
+  maxPool2d("max_pool2d", makeView(input), kernelSize, stride, padding,
+            dilation, makeView(out), nullptr);
+}
+
+void _mlir_ciface_max_pool2d_with_indices_4F32_4I64_4F32_out(
+    MEMREF(4) input, std::int32_t kernelSize, std::int32_t stride,
+    std::int32_t padding, std::int32_t dilation, std::int32_t ceilMode,
+    MEMREF(4) out, MEMREF_I64(4) indices) {
+  (void)ceilMode;
+  View<std::int64_t> indicesView = makeView(indices);
+  checkContiguous("max_pool2d_with_indices", indicesView.isContiguous());
+  maxPool2d("max_pool2d_with_indices", makeView(input), kernelSize, stride,
+            padding, dilation, makeView(out), indicesView.data);
+}
+
+void _mlir_ciface_max_pool2d_with_indices_backward_4F32_4F32_4F32_4I64_out(
+    MEMREF(4) gradOutput, MEMREF(4) self, std::int32_t kernelSize,
+    std::int32_t stride, std::int32_t padding, std::int32_t dilation,
+    std::int32_t ceilMode, MEMREF_I64(4) indices, MEMREF(4) gradInput) {
+  // Everything needed is recorded in `indices`.
+  (void)kernelSize;
+  (void)stride;
+  (void)padding;
+  (void)dilation;
+  (void)ceilMode;
+  maxPool2dWithIndicesBackward(makeView(gradInput), makeView(gradOutput),
+                               makeView(self), makeView(indices));
+}
+
+#define DEFINE_LOG_SOFTMAX(R)                                                  \
+  void _mlir_ciface_log_softmax_##R##F32_##R##F32_out(                         \
+      MEMREF(R) input, std::int32_t dim, std::int32_t halfToFloat,             \
+      MEMREF(R) out) {                                                         \
+    logSoftmax(makeView(out), makeView(input), dim, halfToFloat);              \
+  }                                                                            \
+  void                                                                         \
+      _mlir_ciface_log_softmax_backward_data_##R##F32_##R##F32_##R##F32_##R##F32_out( \
+          MEMREF(R) gradOutput, MEMREF(R) output, std::int32_t dim,            \
+          MEMREF(R) self, MEMREF(R) gradInput) {                               \
+    logSoftmaxBackwardData(makeView(gradInput), makeView(gradOutput),          \
+                           makeView(output), dim, makeView(self));             \
+  }
+RANKS_1_TO_4(DEFINE_LOG_SOFTMAX)
+
+// nll_loss produces a 0-d result for the "mean" and "sum" reductions and a
+// result shaped like the target for "none". The weight operand is optional;
+// when it was None it is left out of the call (and the mangled name).
+#define DEFINE_NLL_LOSS(NAME, SELF, TARGET, OUT)                               \
+  void _mlir_ciface_##NAME##_forward_##OUT##F32_0F32_##SELF##F32_##TARGET##I64_1F32_out( \
+      MEMREF(SELF) self, MEMREF_I64(TARGET) target, MEMREF(1) weight,          \
+      std::int32_t reduction, std::int32_t ignoreIndex, MEMREF(OUT) output,    \
+      MEMREF(0) totalWeight) {                                                 \
+    nllLossForward(#NAME "_forward", makeView(self), makeView(target),         \
+                   makeView(weight), reduction, ignoreIndex, makeView(output), \
+                   makeView(totalWeight));                                     \
+  }                                                                            \
+  void _mlir_ciface_##NAME##_forward_##OUT##F32_0F32_##SELF##F32_##TARGET##I64_out( \
+      MEMREF(SELF) self, MEMREF_I64(TARGET) target, std::int32_t reduction,    \
+      std::int32_t ignoreIndex, MEMREF(OUT) output, MEMREF(0) totalWeight) {   \
+    nllLossForward(#NAME "_forward", makeView(self), makeView(target),         \
+                   View<float>(), reduction, ignoreIndex, makeView(output),    \
+                   makeView(totalWeight));                                     \
+  }                                                                            \
+  void                                                                         \
+      _mlir_ciface_##NAME##_backward_##SELF##F32_##OUT##F32_##SELF##F32_##TARGET##I64_1F32_0F32_out( \
+          MEMREF(OUT) gradOutput, MEMREF(SELF) self,                           \
+          MEMREF_I64(TARGET) target, MEMREF(1) weight,                         \
+          std::int32_t reduction, std::int32_t ignoreIndex,                    \
+          MEMREF(0) totalWeight, MEMREF(SELF) gradInput) {                     \
+    nllLossBackward(#NAME "_backward", makeView(gradOutput), makeView(self),   \
+                    makeView(target), makeView(weight), reduction,             \
+                    ignoreIndex, makeView(totalWeight), makeView(gradInput));  \
+  }                                                                            \
+  void                                                                         \
+      _mlir_ciface_##NAME##_backward_##SELF##F32_##OUT##F32_##SELF##F32_##TARGET##I64_0F32_out( \
+          MEMREF(OUT) gradOutput, MEMREF(SELF) self,                           \
+          MEMREF_I64(TARGET) target, std::int32_t reduction,                   \
+          std::int32_t ignoreIndex, MEMREF(0) totalWeight,                     \
+          MEMREF(SELF) gradInput) {                                            \
+    nllLossBackward(#NAME "_backward", makeView(gradOutput), makeView(self),   \
+                    makeView(target), View<float>(), reduction, ignoreIndex,   \
+                    makeView(totalWeight), makeView(gradInput));               \
+  }
+DEFINE_NLL_LOSS(nll_loss, 2, 1, 0)
+DEFINE_NLL_LOSS(nll_loss, 2, 1, 1)
+DEFINE_NLL_LOSS(nll_loss2d, 4, 3, 0)
+DEFINE_NLL_LOSS(nll_loss2d, 4, 3, 3)
+
+} // extern "C"
@@ -0,0 +1,166 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "Parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace refbackrt::aten;
+
+namespace {
+// Set on pool worker threads, and on the calling thread while it participates
+// in a parallel region. Used to serialize nested parallelFor calls.
+thread_local bool inParallelRegion = false;
+
+// A single parallel region: `numTasks` invocations of `task`, handed out
+// dynamically to whichever threads pick up the job.
+struct Job {
+  const std::function<void(std::int64_t)> *task;
+  std::int64_t numTasks;
+  std::atomic<std::int64_t> nextTask{0};
+
+  void runTasks() {
+    for (std::int64_t i = nextTask.fetch_add(1); i < numTasks;
+         i = nextTask.fetch_add(1))
+      (*task)(i);
+  }
+};
+
+class ThreadPool {
+public:
+  explicit ThreadPool(int numThreads) {
+    // The thread calling run() participates, so spawn one fewer worker.
+    for (int i = 1; i < numThreads; i++)
+      workers.emplace_back([this] { workerLoop(); });
+  }
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      shuttingDown = true;
+    }
+    wakeWorkers.notify_all();
+    for (std::thread &worker : workers)
+      worker.join();
+  }
+
+  int size() const { return static_cast<int>(workers.size()) + 1; }
+
+  // Runs `task(i)` for each i in [0, numTasks) and returns once all of them
+  // have completed. Concurrent callers are serialized.
+  void run(std::int64_t numTasks,
+           const std::function<void(std::int64_t)> &task) {
+    std::lock_guard<std::mutex> jobLock(jobMutex);
+    Job job;
+    job.task = &task;
+    job.numTasks = numTasks;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      currentJob = &job;
+      generation++;
+    }
+    wakeWorkers.notify_all();
+
+    inParallelRegion = true;
+    job.runTasks();
+    inParallelRegion = false;
+
+    // All tasks have been claimed at this point. Retract the job so that late
+    // wakers ignore it, and wait for the workers still running claimed tasks.
+    std::unique_lock<std::mutex> lock(mutex);
+    currentJob = nullptr;
+    jobDone.wait(lock, [this] { return busyWorkers == 0; });
+  }
+
+private:
+  void workerLoop() {
+    inParallelRegion = true;
+    std::uint64_t seenGeneration = 0;
+    while (true) {
+      Job *job;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        wakeWorkers.wait(lock, [&] {
+          return shuttingDown || generation != seenGeneration;
+        });
+        if (shuttingDown)
+          return;
+        seenGeneration = generation;
+        job = currentJob;
+        if (!job)
+          continue;
+        busyWorkers++;
+      }
+      job->runTasks();
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--busyWorkers == 0)
+          jobDone.notify_all();
+      }
+    }
+  }
+
+  std::vector<std::thread> workers;
+  // Serializes run() calls from different client threads.
+  std::mutex jobMutex;
+  // Guards all of the fields below.
+  std::mutex mutex;
+  std::condition_variable wakeWorkers;
+  std::condition_variable jobDone;
+  Job *currentJob = nullptr;
+  std::uint64_t generation = 0;
+  int busyWorkers = 0;
+  bool shuttingDown = false;
+};
+} // namespace
+
+static ThreadPool &getThreadPool() {
+  static ThreadPool pool(getNumThreads());
+  return pool;
+}
+
+int refbackrt::aten::getNumThreads() {
+  static int numThreads = [] {
+    if (const char *env = std::getenv("NPCOMP_NUM_THREADS")) {
+      int n = std::atoi(env);
+      if (n > 0)
+        return n;
+    }
+    return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  }();
+  return numThreads;
+}
+
+void refbackrt::aten::parallelFor(
+    std::int64_t begin, std::int64_t end, std::int64_t grainSize,
+    const std::function<void(std::int64_t, std::int64_t)> &fn) {
+  std::int64_t range = end - begin;
+  if (range <= 0)
+    return;
+  grainSize = std::max<std::int64_t>(grainSize, 1);
+  std::int64_t maxChunks = (range + grainSize - 1) / grainSize;
+  std::int64_t numChunks =
+      std::min<std::int64_t>(maxChunks, inParallelRegion ? 1 : getNumThreads());
+  if (numChunks <= 1) {
+    fn(begin, end);
+    return;
+  }
+  std::int64_t chunkSize = (range + numChunks - 1) / numChunks;
+  getThreadPool().run(numChunks, [&](std::int64_t chunk) {
+    std::int64_t chunkBegin = begin + chunk * chunkSize;
+    std::int64_t chunkEnd = std::min(end, chunkBegin + chunkSize);
+    if (chunkBegin < chunkEnd)
+      fn(chunkBegin, chunkEnd);
+  });
+}
@@ -0,0 +1,40 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Minimal multithreading support for the ATen kernels.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef NPCOMP_LIB_REFBACKEND_ATENKERNELS_PARALLEL_H
+#define NPCOMP_LIB_REFBACKEND_ATENKERNELS_PARALLEL_H
+
+#include <cstdint>
+#include <functional>
+
+namespace refbackrt {
+namespace aten {
+
+// Returns the number of threads that kernels may use. This is taken from the
+// NPCOMP_NUM_THREADS environment variable if set, and otherwise is the number
+// of hardware threads.
+int getNumThreads();
+
+// Invokes `fn(chunkBegin, chunkEnd)` over disjoint chunks covering
+// [begin, end), in parallel on a process-wide thread pool. Each chunk has at
+// least `grainSize` iterations (except possibly the last).
+//
+// Calls made from inside `fn` run serially on the calling thread, so kernels
+// can be freely composed (e.g. a conv parallelized over the batch dimension
+// calling into the GEMM, which is itself parallel).
+void parallelFor(std::int64_t begin, std::int64_t end, std::int64_t grainSize,
+                 const std::function<void(std::int64_t, std::int64_t)> &fn);
+
+} // namespace aten
+} // namespace refbackrt
+
+#endif // NPCOMP_LIB_REFBACKEND_ATENKERNELS_PARALLEL_H
@@ -0,0 +1,116 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Memref descriptors as passed to `llvm.emit_c_interface` functions, plus a
+// rank-erased view that the kernels operate on.
+//
+// Like the rest of the runtime, this deliberately does not depend on
+// `mlir/ExecutionEngine/CRunnerUtils.h`. The layouts here need to be kept in
+// sync with the ones produced by the StandardToLLVM lowering.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef NPCOMP_LIB_REFBACKEND_ATENKERNELS_STRIDEDMEMREF_H
+#define NPCOMP_LIB_REFBACKEND_ATENKERNELS_STRIDEDMEMREF_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+namespace refbackrt {
+namespace aten {
+
+// A ranked memref descriptor. Pointers to these are what the compiler passes
+// to `_mlir_ciface_*` functions.
+template <typename T, int Rank> struct StridedMemRef {
+  T *basePtr;
+  T *data;
+  std::int64_t offset;
+  std::int64_t sizes[Rank];
+  std::int64_t strides[Rank];
+};
+
+// Rank-0 memrefs have no size/stride arrays.
+template <typename T> struct StridedMemRef<T, 0> {
+  T *basePtr;
+  T *data;
+  std::int64_t offset;
+};
+
+// The kernels only ever handle rank <= kMaxRank.
+constexpr int kMaxRank = 4;
+
+// A rank-erased view of a memref. Kernels are written against this type so
+// that each kernel body is only compiled once regardless of how many rank
+// specializations the ABI exports. A default constructed view (null `data`)
+// stands for an absent optional operand.
+template <typename T> struct View {
+  T *data = nullptr;
+  int rank = 0;
+  std::int64_t sizes[kMaxRank] = {};
+  std::int64_t strides[kMaxRank] = {};
+
+  std::int64_t size(int dim) const { return sizes[dim]; }
+  std::int64_t stride(int dim) const { return strides[dim]; }
+
+  std::int64_t numElements() const {
+    std::int64_t n = 1;
+    for (int i = 0; i < rank; i++)
+      n *= sizes[i];
+    return n;
+  }
+
+  // Whether the view has the default row-major layout.
+  bool isContiguous() const {
+    std::int64_t expected = 1;
+    for (int i = rank - 1; i >= 0; i--) {
+      if (sizes[i] != 1 && strides[i] != expected)
+        return false;
+      expected *= sizes[i];
+    }
+    return true;
+  }
+};
+
+template <typename T, int Rank>
+View<T> makeView(const StridedMemRef<T, Rank> *memref) {
+  static_assert(Rank <= kMaxRank, "rank exceeds kMaxRank");
+  View<T> view;
+  view.data = memref->data + memref->offset;
+  view.rank = Rank;
+  for (int i = 0; i < Rank; i++) {
+    view.sizes[i] = memref->sizes[i];
+    view.strides[i] = memref->strides[i];
+  }
+  return view;
+}
+
+template <typename T> View<T> makeView(const StridedMemRef<T, 0> *memref) {
+  View<T> view;
+  view.data = memref->data + memref->offset;
+  view.rank = 0;
+  return view;
+}
+
+// Report an unrecoverable error from inside a kernel. Kernels have no way of
+// propagating errors back through the ABI, so this mirrors
+// `__npcomp_compiler_rt_abort_if`.
+[[noreturn]] inline void fatalError(const char *kernel, const char *msg) {
+  std::fprintf(stderr, "NPCOMP: aborting: %s: %s\n", kernel, msg);
+  std::exit(1);
+}
+
+inline void checkContiguous(const char *kernel, bool isContiguous) {
+  if (!isContiguous)
+    fatalError(kernel, "expected a contiguous memref");
+}
+
+} // namespace aten
+} // namespace refbackrt
+
+#endif // NPCOMP_LIB_REFBACKEND_ATENKERNELS_STRIDEDMEMREF_H
@@ -11,6 +11,12 @@
 #include "mlir/ExecutionEngine/OptUtils.h"
 #include "mlir/Target/LLVMIR.h"
 #include "npcomp/RefBackend/RefBackend.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+
+#include <mutex>
 
 using namespace refback;
 using namespace mlir;
@@ -36,7 +42,8 @@ void JITModule::buildBackendCompilationPipeline(PassManager &pm,
 
 llvm::Expected<std::unique_ptr<JITModule>>
 JITModule::fromCompiledModule(mlir::ModuleOp module,
-                              llvm::ArrayRef<llvm::StringRef> sharedLibs) {
+                              llvm::ArrayRef<llvm::StringRef> sharedLibs,
+                              llvm::StringRef weightsDirectory) {
   // Ensure LLVM Dialect -> LLVM IR translations are available.
   mlir::registerLLVMDialectTranslation(*module->getContext());
   // Build the JITModule.
@@ -55,9 +62,88 @@ JITModule::fromCompiledModule(mlir::ModuleOp module,
     return expectedAddress.takeError();
   ret->descriptor =
       reinterpret_cast<refbackrt::ModuleDescriptor *>(*expectedAddress);
+  if (Error error = ret->bindExternalWeights(weightsDirectory))
+    return std::move(error);
+  if (Error error = ret->runModuleInitializer())
+    return std::move(error);
   return std::move(ret);
 }
 
+// Returns the path of the blob of weight `key` in `weightsDirectory`, made
+// absolute and with the directory's symlinks resolved, so that every way of
+// naming the same file gives the same path.
+static llvm::SmallString<128> getWeightPath(llvm::StringRef weightsDirectory,
+                                            llvm::StringRef key) {
+  llvm::SmallString<128> path;
+  if (llvm::sys::fs::real_path(weightsDirectory, path)) {
+    path = weightsDirectory;
+    llvm::sys::fs::make_absolute(path);
+    llvm::sys::path::remove_dots(path, /*remove_dot_dot=*/true);
+  }
+  llvm::sys::path::append(path, key + ".bin");
+  return path;
+}
+
+// Returns the blob of weight `key`, sharing it with every other JITModule in
+// the process that uses the same file. The store is keyed on the file rather
+// than on `key`, because nothing guarantees that two weights directories
+// hold the same contents under the same key (e.g. when one of them has been
+// rewritten by a newer export).
+//
+// Only external weights, i.e. tensors that the importer wrote to a weights
+// directory, are shared this way. Constants embedded in a module, including
+// the raw-data globals of large ones, are part of its object code, so each
+// JITModule has its own copy of them.
+//
+// The store only holds weak references; a blob is unmapped when the last
+// JITModule using it is destroyed.
+static Expected<std::shared_ptr<const llvm::MemoryBuffer>>
+getSharedWeightBuffer(llvm::StringRef weightsDirectory, llvm::StringRef key,
+                      int64_t byteSize) {
+  static std::mutex mutex;
+  static llvm::StringMap<std::weak_ptr<const llvm::MemoryBuffer>> store;
+  llvm::SmallString<128> path = getWeightPath(weightsDirectory, key);
+  std::lock_guard<std::mutex> lock(mutex);
+  std::weak_ptr<const llvm::MemoryBuffer> &entry = store[path];
+  std::shared_ptr<const llvm::MemoryBuffer> buffer = entry.lock();
+  if (!buffer) {
+    // Large blobs are memory mapped, so weights are paged in on demand and
+    // shared with other processes using them.
+    auto newBuffer =
+        llvm::MemoryBuffer::getFile(path, /*FileSize=*/-1,
+                                    /*RequiresNullTerminator=*/false);
+    if (!newBuffer)
+      return make_string_error(Twine("could not open weight '") + path +
+                               "': " + newBuffer.getError().message());
+    buffer = std::move(*newBuffer);
+    entry = buffer;
+  }
+  if (static_cast<int64_t>(buffer->getBufferSize()) != byteSize)
+    return make_string_error(Twine("weight '") + buffer->getBufferIdentifier() +
+                             "' has " + Twine(buffer->getBufferSize()) +
+                             " bytes, expected " + Twine(byteSize));
+  return buffer;
+}
+
+Error JITModule::bindExternalWeights(llvm::StringRef weightsDirectory) {
+  int32_t numWeights = refbackrt::getNumExternalWeights(descriptor);
+  if (numWeights != 0 && weightsDirectory.empty())
+    return make_string_error("module has " + Twine(numWeights) +
+                             " external weights but no weights directory");
+  for (int32_t i = 0; i < numWeights; i++) {
+    refbackrt::ExternalWeightMetadata metadata =
+        refbackrt::getExternalWeightMetadata(descriptor, i);
+    llvm::StringRef key(metadata.key.data(), metadata.key.size());
+    auto buffer =
+        getSharedWeightBuffer(weightsDirectory, key, metadata.byteSize);
+    if (!buffer)
+      return buffer.takeError();
+    refbackrt::bindExternalWeight(descriptor, i, (*buffer)->getBufferStart());
+    weightBuffers.push_back(std::move(*buffer));
+  }
+  return Error::success();
+}
+
 // Converter for bridging to refbackrt llvm-lookalike data structures.
 static refbackrt::StringRef toRefbackrt(llvm::StringRef s) {
   return refbackrt::StringRef(s.data(), s.size());
@@ -73,6 +159,18 @@ static refbackrt::MutableArrayRef<T> toRefbackrt(llvm::MutableArrayRef<T> a) {
   return refbackrt::MutableArrayRef<T>(a.data(), a.size());
 }
 
+// The function that initializes module state, which the compiler creates
+// for global slots with computed initial values.
+static constexpr char kModuleInitializerName[] = "__npcomp_module_init";
+
+Error JITModule::runModuleInitializer() {
+  refbackrt::FunctionMetadata metadata;
+  if (refbackrt::failed(refbackrt::getMetadata(
+          descriptor, toRefbackrt(kModuleInitializerName), metadata)))
+    return Error::success();
+  return invoke(kModuleInitializerName, {}).takeError();
+}
+
 llvm::Expected<llvm::SmallVector<refbackrt::Ref<refbackrt::Tensor>, 6>>
 JITModule::invoke(llvm::StringRef functionName,
                   llvm::ArrayRef<refbackrt::Ref<refbackrt::Tensor>> inputs) {
@@ -14,10 +14,13 @@
 #include "mlir/Dialect/LLVMIR/LLVMDialect.h"
 #include "mlir/Dialect/Math/Transforms/Passes.h"
 #include "mlir/Dialect/StandardOps/Transforms/Passes.h"
+#include "mlir/IR/BuiltinAttributes.h"
 #include "mlir/Transforms/DialectConversion.h"
 
 #include "npcomp/Dialect/Refbackrt/IR/RefbackrtDialect.h"
 #include "npcomp/Dialect/Refbackrt/IR/RefbackrtOps.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringMap.h"
 
 using namespace mlir;
 using namespace mlir::NPCOMP;
@@ -55,6 +58,22 @@ static LLVMStructType getFuncDescriptorTy(MLIRContext *context) {
                                     });
 }
 
+// Get the LLVM type for refbackrt::WeightDescriptor.
+static LLVMStructType getWeightDescriptorTy(MLIRContext *context) {
+  return LLVMStructType::getLiteral(context,
+                                    {
+                                        // Key length.
+                                        IntegerType::get(context, 32),
+                                        // Key chars.
+                                        getInt8PointerType(context),
+                                        // Pointer to the data pointer.
+                                        LLVMPointerType::get(
+                                            getInt8PointerType(context)),
+                                        // Number of bytes.
+                                        IntegerType::get(context, 64),
+                                    });
+}
+
 // Get the LLVM type for refbackrt::ModuleDescriptor.
 static LLVMStructType getModuleDescriptorTy(MLIRContext *context) {
   return LLVMStructType::getLiteral(
@@ -63,6 +82,10 @@ static LLVMStructType getModuleDescriptorTy(MLIRContext *context) {
                    IntegerType::get(context, 32),
                    // FuncDescriptor *functionDescriptors;
                    LLVMPointerType::get(getFuncDescriptorTy(context)),
+                   // std::int32_t numWeightDescriptors;
+                   IntegerType::get(context, 32),
+                   // WeightDescriptor *weightDescriptors;
+                   LLVMPointerType::get(getWeightDescriptorTy(context)),
                });
 }
 
@@ -171,6 +194,227 @@ static void populateCompilerRuntimePatterns(ModuleOp module,
   }
 }
 
+//===----------------------------------------------------------------------===//
+// Lowering for external weights
+//===----------------------------------------------------------------------===//
+
+namespace {
+// A global_memref whose data is not in the module, but in a blob that the
+// runtime binds at load time.
+struct ExternalWeight {
+  // The key of the blob, the hex content hash of its data.
+  std::string key;
+  // The global holding the pointer to the data.
+  LLVM::GlobalOp slot;
+  int64_t byteSize;
+};
+} // namespace
+
+// Weights imported by reference are elements attributes opaque to the torch
+// dialect, whose value is the content hash that names their blob.
+static Optional<std::string> getExternalWeightKey(GlobalMemrefOp op) {
+  if (!op.initial_value())
+    return llvm::None;
+  auto opaque = op.initial_value()->dyn_cast<OpaqueElementsAttr>();
+  if (!opaque || opaque.getDialect()->getNamespace() != "torch")
+    return llvm::None;
+  return llvm::toHex(opaque.getValue());
+}
+
+// Replaces each global_memref of an external weight with a mutable global
+// holding a pointer to its data, which is null until the weight is bound.
+static llvm::StringMap<ExternalWeight>
+createExternalWeightSlots(ModuleOp module, LLVMTypeConverter &converter) {
+  llvm::StringMap<ExternalWeight> weights;
+  OpBuilder builder(module.getContext());
+  for (auto global :
+       llvm::make_early_inc_range(module.getOps<GlobalMemrefOp>())) {
+    Optional<std::string> key = getExternalWeightKey(global);
+    if (!key)
+      continue;
+    Location loc = global.getLoc();
+    MemRefType type = global.type();
+    auto dataPtrTy =
+        LLVMPointerType::get(converter.convertType(type.getElementType()));
+    builder.setInsertionPointToStart(module.getBody());
+    auto slot = builder.create<LLVM::GlobalOp>(
+        loc, dataPtrTy, /*isConstant=*/false, LLVM::Linkage::Internal,
+        (Twine("__npcomp_weight_") + global.sym_name()).str(),
+        /*value=*/Attribute());
+    builder.createBlock(&slot.initializer());
+    Value null = builder.create<LLVM::NullOp>(loc, dataPtrTy);
+    builder.create<LLVM::ReturnOp>(loc, null);
+    weights[global.sym_name()] =
+        ExternalWeight{*key, slot, type.getSizeInBits() / 8};
+    global.erase();
+  }
+  return weights;
+}
+
+// Wraps `data` in a descriptor for a global of static shape `type`.
+static Value createGlobalMemrefDescriptor(ConversionPatternRewriter &rewriter,
+                                          Location loc,
+                                          LLVMTypeConverter &converter,
+                                          MemRefType type, Value data) {
+  auto descriptor =
+      MemRefDescriptor::fromStaticShape(rewriter, loc, converter, type, data);
+  // Like other globals, the data must never be freed. Mark the allocated
+  // pointer the way the lowering of std.get_global_memref does.
+  Type indexType = converter.getIndexType();
+  Value deadBeef = rewriter.create<LLVM::ConstantOp>(
+      loc, indexType, rewriter.getIntegerAttr(indexType, 0xdeadbeef));
+  descriptor.setAllocatedPtr(
+      rewriter, loc,
+      rewriter.create<LLVM::IntToPtrOp>(loc, data.getType(), deadBeef));
+  return descriptor;
+}
+
+namespace {
+// Loads the data pointer of an external weight and wraps it in a memref
+// descriptor.
+class LowerExternalWeightGetGlobalMemref
+    : public OpConversionPattern<GetGlobalMemrefOp> {
+public:
+  LowerExternalWeightGetGlobalMemref(
+      LLVMTypeConverter &converter,
+      const llvm::StringMap<ExternalWeight> &weights)
+      : OpConversionPattern<GetGlobalMemrefOp>(&converter.getContext(),
+                                               /*benefit=*/2),
+        converter(converter), weights(weights) {}
+  LogicalResult
+  matchAndRewrite(GetGlobalMemrefOp op, ArrayRef<Value> operands,
+                  ConversionPatternRewriter &rewriter) const override {
+    auto it = weights.find(op.name());
+    if (it == weights.end())
+      return failure();
+    Location loc = op.getLoc();
+    auto slotAddress = rewriter.create<LLVM::AddressOfOp>(loc, it->second.slot);
+    Value data = rewriter.create<LLVM::LoadOp>(loc, slotAddress);
+    rewriter.replaceOp(
+        op, createGlobalMemrefDescriptor(rewriter, loc, converter,
+                                         op.getType().cast<MemRefType>(),
+                                         data));
+    return success();
+  }
+  LLVMTypeConverter &converter;
+  const llvm::StringMap<ExternalWeight> &weights;
+};
+} // namespace
+
+//===----------------------------------------------------------------------===//
+// Lowering for large constants
+//===----------------------------------------------------------------------===//
+
+// The upstream lowering of global_memref translates a dense initializer
+// element by element, building one llvm::Constant per element. For model
+// weights that dominates compile time and memory. Instead, we emit the
+// initializer as a single i8 array whose value is the attribute's raw data,
+// which translates to one llvm::ConstantDataArray and is emitted into the
+// object file as-is.
+//
+// An i8 array only has the alignment of i8, which LLVM raises for large
+// globals as an optimization on some targets but does not guarantee. The
+// globals are given an explicit alignment instead: a cache line, which is
+// also enough for the widest vector loads of any element type.
+static constexpr uint64_t kRawDataAlignment = 64;
+
+static bool shouldEmitAsRawData(GlobalMemrefOp op, int64_t threshold) {
+  if (!op.initial_value())
+    return false;
+  auto elements = op.initial_value()->dyn_cast<DenseElementsAttr>();
+  // Splats are stored as a single element, and i1's are bit-packed, so in
+  // neither case is the raw data the in-memory layout.
+  if (!elements || elements.isSplat())
+    return false;
+  Type elementType = op.type().getElementType();
+  if (!elementType.isIntOrFloat() ||
+      elementType.getIntOrFloatBitWidth() % 8 != 0)
+    return false;
+  return op.type().getSizeInBits() / 8 >= threshold;
+}
+
+// Replaces each large global_memref with an i8 array holding its raw data.
+//
+// TensorConstantBufferize already gives identical constants a single
+// global_memref, but constants that differ only in shape or element type
+// (e.g. a weight and its reshaped copy) still end up with one each. Private
+// constants with the same raw data share one global here.
+static llvm::StringMap<LLVM::GlobalOp> createRawDataGlobals(ModuleOp module,
+                                                            int64_t threshold) {
+  llvm::StringMap<LLVM::GlobalOp> rawDataGlobals;
+  // StringAttr's are uniqued, so they key the globals by contents.
+  DenseMap<Attribute, LLVM::GlobalOp> sharedGlobalsByData;
+  OpBuilder builder(module.getContext());
+  for (auto global :
+       llvm::make_early_inc_range(module.getOps<GlobalMemrefOp>())) {
+    if (!shouldEmitAsRawData(global, threshold))
+      continue;
+    ArrayRef<char> rawData =
+        global.initial_value()->cast<DenseElementsAttr>().getRawData();
+    auto data =
+        builder.getStringAttr(StringRef(rawData.data(), rawData.size()));
+    bool isShareable =
+        global.constant() && global.sym_visibility() == StringRef("private");
+    if (isShareable) {
+      auto it = sharedGlobalsByData.find(data);
+      if (it != sharedGlobalsByData.end()) {
+        rawDataGlobals[global.sym_name()] = it->second;
+        global.erase();
+        continue;
+      }
+    }
+    auto arrayTy = LLVMArrayType::get(IntegerType::get(module.getContext(), 8),
+                                      rawData.size());
+    builder.setInsertionPoint(global);
+    auto linkage = global.sym_visibility() == StringRef("private")
+                       ? LLVM::Linkage::Private
+                       : LLVM::Linkage::External;
+    auto rawDataGlobal = builder.create<LLVM::GlobalOp>(
+        global.getLoc(), arrayTy, global.constant(), linkage,
+        global.sym_name(), data);
+    rawDataGlobal->setAttr("alignment",
+                           builder.getI64IntegerAttr(kRawDataAlignment));
+    rawDataGlobals[global.sym_name()] = rawDataGlobal;
+    if (isShareable)
+      sharedGlobalsByData[data] = rawDataGlobal;
+    global.erase();
+  }
+  return rawDataGlobals;
+}
+
+namespace {
+// Casts the address of a raw data global to a pointer to its elements and
+// wraps it in a memref descriptor.
+class LowerRawDataGetGlobalMemref
+    : public OpConversionPattern<GetGlobalMemrefOp> {
+public:
+  LowerRawDataGetGlobalMemref(
+      LLVMTypeConverter &converter,
+      const llvm::StringMap<LLVM::GlobalOp> &rawDataGlobals)
+      : OpConversionPattern<GetGlobalMemrefOp>(&converter.getContext(),
+                                               /*benefit=*/2),
+        converter(converter), rawDataGlobals(rawDataGlobals) {}
+  LogicalResult
+  matchAndRewrite(GetGlobalMemrefOp op, ArrayRef<Value> operands,
+                  ConversionPatternRewriter &rewriter) const override {
+    auto it = rawDataGlobals.find(op.name());
+    if (it == rawDataGlobals.end())
+      return failure();
+    Location loc = op.getLoc();
+    auto type = op.getType().cast<MemRefType>();
+    auto dataPtrTy =
+        LLVMPointerType::get(converter.convertType(type.getElementType()));
+    auto address = rewriter.create<LLVM::AddressOfOp>(loc, it->second);
+    Value data = rewriter.create<LLVM::BitcastOp>(loc, dataPtrTy, address);
+    rewriter.replaceOp(
+        op, createGlobalMemrefDescriptor(rewriter, loc, converter, type, data));
+    return success();
+  }
+  LLVMTypeConverter &converter;
+  const llvm::StringMap<LLVM::GlobalOp> &rawDataGlobals;
+};
+} // namespace
+
 //===----------------------------------------------------------------------===//
 // Lowering for module metadata
 //===----------------------------------------------------------------------===//
@@ -261,7 +505,81 @@ createFuncDescriptorArray(ArrayRef<refbackrt::FuncMetadataOp> funcMetadatas,
   return funcDescriptorArrayGlobal;
 }
 
+static LLVM::GlobalOp
+createWeightDescriptorArray(ArrayRef<const ExternalWeight *> weights,
+                            OpBuilder &builder, Location loc) {
+  auto *context = builder.getContext();
+  auto llvmI32Ty = IntegerType::get(context, 32);
+  auto llvmI64Ty = IntegerType::get(context, 64);
+
+  SmallVector<LLVM::GlobalOp, 4> keyGlobals;
+  for (const ExternalWeight *weight : weights) {
+    auto arrayTy =
+        LLVMArrayType::get(IntegerType::get(context, 8), weight->key.size());
+    keyGlobals.push_back(builder.create<LLVM::GlobalOp>(
+        loc, arrayTy, /*isConstant=*/true, LLVM::Linkage::Internal,
+        (Twine(weight->slot.sym_name()) + "_key").str(),
+        builder.getStringAttr(weight->key)));
+  }
+
+  // This must match WeightDescriptor in the runtime.
+  auto weightDescriptorTy = getWeightDescriptorTy(context);
+  auto weightDescriptorArrayTy =
+      LLVMArrayType::get(weightDescriptorTy, weights.size());
+  auto weightDescriptorArrayGlobal = builder.create<LLVM::GlobalOp>(
+      loc, weightDescriptorArrayTy, /*isConstant=*/true,
+      LLVM::Linkage::Internal, "__npcomp_weight_descriptors",
+      /*value=*/Attribute());
+  OpBuilder::InsertionGuard guard(builder);
+  builder.createBlock(&weightDescriptorArrayGlobal.initializer());
+
+  Value weightDescriptorArray =
+      builder.create<LLVM::UndefOp>(loc, weightDescriptorArrayTy);
+  auto updateDescriptor = [&](Value value,
+                              std::initializer_list<int32_t> position) {
+    weightDescriptorArray = builder.create<LLVM::InsertValueOp>(
+        loc, weightDescriptorArray, value,
+        /*position=*/builder.getI32ArrayAttr(position));
+  };
+  auto c0 = builder.create<LLVM::ConstantOp>(loc, llvmI32Ty,
+                                             builder.getI32IntegerAttr(0));
+  for (auto weightAndIndex : llvm::enumerate(weights)) {
+    const ExternalWeight *weight = weightAndIndex.value();
+    int32_t index = weightAndIndex.index();
+
+    // Key length.
+    updateDescriptor(
+        builder.create<LLVM::ConstantOp>(
+            loc, llvmI32Ty, builder.getI32IntegerAttr(weight->key.size())),
+        {index, 0});
+
+    // Key chars.
+    auto keyArray =
+        builder.create<LLVM::AddressOfOp>(loc, keyGlobals[index]);
+    auto keyPtr = builder.create<LLVM::GEPOp>(
+        loc, getInt8PointerType(context), keyArray, ValueRange({c0, c0}));
+    updateDescriptor(keyPtr, {index, 1});
+
+    // Slot address.
+    auto slotAddress = builder.create<LLVM::AddressOfOp>(loc, weight->slot);
+    auto typeErasedSlotAddress = builder.create<LLVM::BitcastOp>(
+        loc, LLVMPointerType::get(getInt8PointerType(context)), slotAddress);
+    updateDescriptor(typeErasedSlotAddress, {index, 2});
+
+    // Number of bytes.
+    updateDescriptor(
+        builder.create<LLVM::ConstantOp>(
+            loc, llvmI64Ty, builder.getI64IntegerAttr(weight->byteSize)),
+        {index, 3});
+  }
+
+  builder.create<LLVM::ReturnOp>(loc, weightDescriptorArray);
+
+  return weightDescriptorArrayGlobal;
+}
+
 LLVM::GlobalOp createModuleDescriptor(LLVM::GlobalOp funcDescriptorArray,
+                                      LLVM::GlobalOp weightDescriptorArray,
                                       OpBuilder &builder, Location loc) {
   auto llvmI32Ty = IntegerType::get(builder.getContext(), 32);
   auto moduleDescriptorTy = getModuleDescriptorTy(builder.getContext());
@@ -299,6 +617,27 @@ LLVM::GlobalOp createModuleDescriptor(LLVM::GlobalOp funcDescriptorArray,
       loc, LLVMPointerType::get(getFuncDescriptorTy(builder.getContext())),
       funcDecriptorArrayAddress);
   updateDescriptor(rawFuncDescriptorPtr, {1});
+
+  // Modules without external weights have no descriptor array for them.
+  auto weightDescriptorPtrTy =
+      LLVMPointerType::get(getWeightDescriptorTy(builder.getContext()));
+  int32_t numWeights = 0;
+  Value rawWeightDescriptorPtr;
+  if (weightDescriptorArray) {
+    numWeights = weightDescriptorArray.getType()
+                     .cast<LLVMArrayType>()
+                     .getNumElements();
+    rawWeightDescriptorPtr = builder.create<LLVM::BitcastOp>(
+        loc, weightDescriptorPtrTy,
+        builder.create<LLVM::AddressOfOp>(loc, weightDescriptorArray));
+  } else {
+    rawWeightDescriptorPtr =
+        builder.create<LLVM::NullOp>(loc, weightDescriptorPtrTy);
+  }
+  updateDescriptor(builder.create<LLVM::ConstantOp>(
+                       loc, llvmI32Ty, builder.getI32IntegerAttr(numWeights)),
+                   {2});
+  updateDescriptor(rawWeightDescriptorPtr, {3});
   builder.create<LLVM::ReturnOp>(loc, moduleDescriptor);
 
   return moduleDescriptorGlobal;
@@ -308,7 +647,10 @@ namespace {
 class LowerModuleMetadata
     : public OpConversionPattern<refbackrt::ModuleMetadataOp> {
 public:
-  using OpConversionPattern::OpConversionPattern;
+  LowerModuleMetadata(MLIRContext *context,
+                      const llvm::StringMap<ExternalWeight> &weights)
+      : OpConversionPattern<refbackrt::ModuleMetadataOp>(context),
+        weights(weights) {}
   LogicalResult
   matchAndRewrite(refbackrt::ModuleMetadataOp op, ArrayRef<Value> operands,
                   ConversionPatternRewriter &rewriter) const override {
@@ -316,8 +658,20 @@ public:
         llvm::to_vector<6>(op.metadatas().getOps<refbackrt::FuncMetadataOp>());
     auto funcDescriptorArray =
         createFuncDescriptorArray(funcMetadatas, rewriter, op.getLoc());
-    auto moduleDescriptor =
-        createModuleDescriptor(funcDescriptorArray, rewriter, op.getLoc());
+    // Sort the weights so that the descriptors are deterministic.
+    SmallVector<const ExternalWeight *, 4> sortedWeights;
+    for (auto &entry : weights)
+      sortedWeights.push_back(&entry.getValue());
+    llvm::sort(sortedWeights,
+               [](const ExternalWeight *a, const ExternalWeight *b) {
+                 return a->slot.sym_name() < b->slot.sym_name();
+               });
+    LLVM::GlobalOp weightDescriptorArray;
+    if (!sortedWeights.empty())
+      weightDescriptorArray =
+          createWeightDescriptorArray(sortedWeights, rewriter, op.getLoc());
+    auto moduleDescriptor = createModuleDescriptor(
+        funcDescriptorArray, weightDescriptorArray, rewriter, op.getLoc());
 
     // TODO: create get module descriptor wrapper (or upgrade
     // mlir::ExecutionEngine to allow raw symbol lookup)
@@ -326,6 +680,7 @@ public:
     rewriter.eraseOp(op);
     return success();
   }
+  const llvm::StringMap<ExternalWeight> &weights;
 };
 } // namespace
 
@@ -464,13 +819,19 @@ class LowerToLLVM : public LowerToLLVMBase<LowerToLLVM> {
     auto *context = &getContext();
 
     LLVMTypeConverter converter(context);
+    llvm::StringMap<ExternalWeight> weights =
+        createExternalWeightSlots(module, converter);
+    llvm::StringMap<LLVM::GlobalOp> rawDataGlobals =
+        createRawDataGlobals(module, rawDataThreshold);
 
     OwningRewritePatternList patterns;
     LLVMConversionTarget target(*context);
     populateCompilerRuntimePatterns(module, patterns, converter);
     target.addLegalOp<ModuleOp, ModuleTerminatorOp>();
     populateStdToLLVMConversionPatterns(converter, patterns);
-    patterns.insert<LowerModuleMetadata>(context);
+    patterns.insert<LowerModuleMetadata>(context, weights);
+    patterns.insert<LowerExternalWeightGetGlobalMemref>(converter, weights);
+    patterns.insert<LowerRawDataGetGlobalMemref>(converter, rawDataGlobals);
 
     // TODO: Move these "std to std" legalizations to their own pass if we grow
     // lots of these patterns.
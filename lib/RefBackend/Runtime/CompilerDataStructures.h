@@ -40,12 +40,27 @@ struct FuncDescriptor {
   // argument.
 };
 
+// A weight imported by reference, whose data is bound at load time.
+struct WeightDescriptor {
+  // The length of the key.
+  std::int32_t keyLen;
+  // The key of the weight's blob, the hex content hash of its data.
+  const char *key;
+  // The pointer to the data used by the compiled code. It is null until the
+  // weight is bound.
+  void **slot;
+  // The number of bytes of the data.
+  std::int64_t byteSize;
+};
+
 // The top-level entry point of the module metadata emitted by the
 // compiler. Unlike all the other descriptors here, external code does handle
 // this type (albeit through an opaque pointer).
 struct ModuleDescriptor {
   std::int32_t numFuncDescriptors;
   FuncDescriptor *functionDescriptors;
+  std::int32_t numWeightDescriptors;
+  WeightDescriptor *weightDescriptors;
 };
 
 } // namespace refbackrt
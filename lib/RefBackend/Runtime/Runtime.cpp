@@ -176,6 +176,10 @@ void refbackrt::invoke(ModuleDescriptor *moduleDescriptor,
                        MutableArrayRef<Ref<Tensor>> outputs) {
   auto *descriptor = getFuncDescriptor(moduleDescriptor, functionName);
   assert(descriptor && "unknown function name");
+  for (int i = 0, e = moduleDescriptor->numWeightDescriptors; i < e; i++) {
+    assert(*moduleDescriptor->weightDescriptors[i].slot &&
+           "external weight was not bound");
+  }
   assert(inputs.size() < kMaxArity && "number of inputs exceeds kMaxArity");
   assert(outputs.size() < kMaxArity && "number of outputs exceeds kMaxArity");
 
@@ -292,3 +296,27 @@ LogicalResult refbackrt::getMetadata(ModuleDescriptor *moduleDescriptor,
   outMetadata.numOutputs = descriptor->numOutputs;
   return success();
 }
+
+std::int32_t refbackrt::getNumExternalWeights(
+    ModuleDescriptor *moduleDescriptor) {
+  return moduleDescriptor->numWeightDescriptors;
+}
+
+ExternalWeightMetadata
+refbackrt::getExternalWeightMetadata(ModuleDescriptor *moduleDescriptor,
+                                     std::int32_t index) {
+  assert(index < moduleDescriptor->numWeightDescriptors &&
+         "external weight index out of range");
+  auto &weightDescriptor = moduleDescriptor->weightDescriptors[index];
+  return ExternalWeightMetadata{
+      StringRef(weightDescriptor.key, weightDescriptor.keyLen),
+      weightDescriptor.byteSize};
+}
+
+void refbackrt::bindExternalWeight(ModuleDescriptor *moduleDescriptor,
+                                   std::int32_t index, const void *data) {
+  assert(index < moduleDescriptor->numWeightDescriptors &&
+         "external weight index out of range");
+  // The compiled code never writes to weights.
+  *moduleDescriptor->weightDescriptors[index].slot = const_cast<void *>(data);
+}
@@ -24,22 +24,39 @@ PropagationWorklist::PropagationWorklist(Environment &env) : env(env) {
   auto &contents = env.getConstraints();
   currentConstraints.reserve(contents.size() * 2);
   for (auto *c : contents) {
-    currentConstraints.insert(c);
+    if (currentConstraints.insert(c).second)
+      deltaConstraints.push_back(c);
   }
 }
 
 bool PropagationWorklist::commit() {
-  bool hadNew = newConstraintCount > 0;
-  newConstraintCount = 0;
-  return hadNew;
+  deltaConstraints.clear();
+  deltaConstraints.swap(newConstraints);
+  return !deltaConstraints.empty();
+}
+
+void PropagationWorklist::addConstraint(Constraint *c) {
+  if (currentConstraints.insert(c).second)
+    newConstraints.push_back(c);
+}
+
+void PropagationWorklist::addDerivedConstraint(ValueType *from, TypeNode *to) {
+  Constraint *newC = env.getContext().getConstraint(from, to);
+  if (currentConstraints.insert(newC).second) {
+    LLVM_DEBUG(llvm::dbgs() << "-->ADD TRANS CONSTRAINT: ";
+               newC->print(env.getContext(), llvm::dbgs());
+               llvm::dbgs() << "\n";);
+    newConstraints.push_back(newC);
+  }
 }
 
 void PropagationWorklist::propagateTransitivity() {
-  // Prepare for join.
-  constexpr size_t N = 8;
-  llvm::DenseMap<TypeVar *, llvm::SmallVector<ValueType *, N>> varToValueType;
-  llvm::DenseMap<TypeVar *, llvm::SmallVector<TypeNode *, N>> varToAny;
-  for (auto *c : currentConstraints) {
+  // Semi-naive evaluation: every pair of constraints that are both older than
+  // the delta was already joined in a previous round, so only pairs with at
+  // least one side in the delta can produce anything new.
+  // First extend the persistent join indexes with the delta, so that pairs
+  // where both sides are in the delta are also found below.
+  for (auto *c : deltaConstraints) {
     auto *lhsVar = llvm::dyn_cast<TypeVar>(c->getFrom());
     auto *rhsVar = llvm::dyn_cast<TypeVar>(c->getTo());
 
@@ -53,23 +70,22 @@ void PropagationWorklist::propagateTransitivity() {
     }
   }
 
-  // Expand join.
-  for (auto vtIt : varToValueType) {
-    auto &lhsSet = vtIt.second;
-    auto anyIt = varToAny.find(vtIt.first);
-    if (anyIt == varToAny.end())
-      continue;
-    auto &rhsSet = anyIt->second;
-
-    for (ValueType *lhsItem : lhsSet) {
-      for (TypeNode *rhsItem : rhsSet) {
-        Constraint *newC = env.getContext().getConstraint(lhsItem, rhsItem);
-        if (currentConstraints.insert(newC).second) {
-          LLVM_DEBUG(llvm::dbgs() << "-->ADD TRANS CONSTRAINT: ";
-                     newC->print(env.getContext(), llvm::dbgs());
-                     llvm::dbgs() << "\n";);
-          newConstraintCount += 1;
-        }
+  // Join the delta against the indexes. Derived constraints only land in
+  // newConstraints, so the indexes are stable while iterating.
+  for (auto *c : deltaConstraints) {
+    if (auto *lhsVar = llvm::dyn_cast<TypeVar>(c->getFrom())) {
+      auto vtIt = varToValueType.find(lhsVar);
+      if (vtIt != varToValueType.end()) {
+        for (ValueType *lhsItem : vtIt->second)
+          addDerivedConstraint(lhsItem, c->getTo());
+      }
+    }
+    if (auto *rhsVar = llvm::dyn_cast<TypeVar>(c->getTo())) {
+      auto *vt = llvm::dyn_cast<ValueType>(c->getFrom());
+      auto anyIt = varToAny.find(rhsVar);
+      if (vt && anyIt != varToAny.end()) {
+        for (TypeNode *rhsItem : anyIt->second)
+          addDerivedConstraint(vt, rhsItem);
       }
     }
   }
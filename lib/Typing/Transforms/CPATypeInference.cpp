@@ -19,7 +19,12 @@
 #include "npcomp/Typing/Analysis/CPA/Types.h"
 #include "npcomp/Typing/Support/CPAIrHelpers.h"
 #include "npcomp/Typing/Transforms/Passes.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/Parallel.h"
+
+#include <atomic>
+#include <mutex>
 
 #define DEBUG_TYPE "cpa-type-inference"
 
@@ -82,9 +87,54 @@ static void printReport(CPA::Environment &env, MLIRContext &mlirContext,
 
 namespace {
 
+/// Memoizes the result types of func_template instances, keyed by the
+/// selected overload and the argument types it is called with.
+///
+/// The per-function analyses that consult this run concurrently. Each of them
+/// owns its CPA::Context, so only this cache is shared between threads.
+class TemplateInstanceCache {
+public:
+  TemplateInstanceCache(ModuleOp module);
+
+  /// Stack of instances being analyzed on the current thread, used to stop
+  /// recursion through (mutually) recursive templates. Cutting the recursion
+  /// makes the result of every instance on the stack depend on which instance
+  /// of the cycle the analysis entered first, so those results are flagged
+  /// and not memoized.
+  using InstanceKey = std::pair<Operation *, Type>;
+  struct InstanceStackEntry {
+    InstanceKey key;
+    bool cutRecursion;
+  };
+  using InstanceStack = SmallVector<InstanceStackEntry, 4>;
+
+  /// Gets the type that a call to the template `callee` with `argTypes`
+  /// produces, or null if it cannot be determined.
+  Type getResultType(StringRef callee, ArrayRef<Type> argTypes,
+                     InstanceStack &stack);
+
+private:
+  FuncOp selectOverload(FuncTemplateOp funcTemplate, ArrayRef<Type> argTypes);
+  Type inferInstanceResultType(FuncOp overload, ArrayRef<Type> argTypes,
+                               InstanceStack &stack);
+
+  /// Immutable after construction.
+  llvm::StringMap<FuncTemplateOp> templates;
+
+  std::mutex mutex;
+  llvm::DenseMap<InstanceKey, Type> resultTypes;
+};
+
 class InitialConstraintGenerator {
 public:
-  InitialConstraintGenerator(CPA::Environment &env) : env(env) {}
+  InitialConstraintGenerator(CPA::Environment &env, bool emitDiagnostics)
+      : env(env), emitDiagnostics(emitDiagnostics) {}
+
+  /// Gets the func_template_call ops that were visited. Their results are
+  /// constrained once the types of their arguments are known.
+  llvm::SmallVectorImpl<FuncTemplateCallOp> &getTemplateCalls() {
+    return templateCalls;
+  }
 
   /// If a return op was visited, this will be one of them.
   Operation *getLastReturnOp() { return funcReturnOp; }
@@ -157,8 +207,9 @@ public:
       if (auto yieldOp = dyn_cast<scf::YieldOp>(childOp)) {
         auto scfParentOp = yieldOp->getParentOp();
         if (scfParentOp->getNumResults() != yieldOp.getNumOperands()) {
-          yieldOp.emitWarning()
-              << "cannot run type inference on yield due to arity mismatch";
+          if (emitDiagnostics)
+            yieldOp.emitWarning()
+                << "cannot run type inference on yield due to arity mismatch";
           return WalkResult::advance();
         }
         for (auto it :
@@ -171,6 +222,13 @@ public:
         addSubtypeConstraint(op.operand(), op.result(), op);
         return WalkResult::advance();
       }
+      if (auto op = dyn_cast<FuncTemplateCallOp>(childOp)) {
+        for (Value arg : op.args())
+          resolveValueType(arg);
+        resolveValueType(op.result());
+        templateCalls.push_back(op);
+        return WalkResult::advance();
+      }
       if (auto op = dyn_cast<BinaryExprOp>(childOp)) {
         // TODO: This should really be applying arithmetic promotion, not
         // strict equality.
@@ -198,7 +256,9 @@ public:
         if (childOp->getParentOp() == funcOp) {
           if (funcReturnOp) {
             if (funcReturnOp->getNumOperands() != childOp->getNumOperands()) {
-              childOp->emitOpError() << "different arity of function returns";
+              if (emitDiagnostics)
+                childOp->emitOpError()
+                    << "different arity of function returns";
               return WalkResult::interrupt();
             }
             for (auto it : llvm::zip(funcReturnOp->getOperands(),
@@ -215,7 +275,8 @@ public:
         }
       }
 
-      childOp->emitRemark() << "unhandled op in type inference";
+      if (emitDiagnostics)
+        childOp->emitRemark() << "unhandled op in type inference";
 
       return WalkResult::advance();
     });
@@ -227,83 +288,275 @@ private:
   // The last encountered ReturnLike op.
   Operation *funcReturnOp = nullptr;
   llvm::SmallVector<Operation *, 4> innerReturnLikeOps;
+  llvm::SmallVector<FuncTemplateCallOp, 4> templateCalls;
   CPA::Environment &env;
+  bool emitDiagnostics;
 };
 
-class CPAFunctionTypeInferencePass
-    : public CPAFunctionTypeInferenceBase<CPAFunctionTypeInferencePass> {
-public:
-  void runOnOperation() override {
-    FuncOp func = getOperation();
-    if (func.getBody().empty())
-      return;
-
-    CPA::Context cpaContext(CPA::createDefaultTypeMapHook());
-    auto &env = cpaContext.getCurrentEnvironment();
-
-    InitialConstraintGenerator p(env);
-    (void)p.runOnFunction(func);
+/// Gets the concrete IR type of `value` as currently known to the analysis,
+/// or null if it is not (yet) known.
+static Type getResolvedIrType(CPA::Context &cpaContext,
+                              MLIRContext &mlirContext, CPA::Environment &env,
+                              Value value) {
+  if (!value.getType().isa<UnknownType>())
+    return value.getType();
+  auto it = env.getValueTypeMap().find(value);
+  if (it == env.getValueTypeMap().end())
+    return nullptr;
+  CPA::GreedyTypeNodeVarResolver resolver(cpaContext, mlirContext,
+                                          /*loc=*/llvm::None);
+  if (failed(resolver.analyzeTypeNode(it->second)))
+    return nullptr;
+  Type type = it->second->constructIrType(cpaContext, resolver.getMappings(),
+                                          &mlirContext);
+  if (!type || type.isa<UnknownType>())
+    return nullptr;
+  return type;
+}
 
-    CPA::PropagationWorklist prop(env);
+/// Runs CPA type inference on a single function, updating the types of its
+/// values and its signature. If `emitDiagnostics` is false, failures are
+/// silent (used when speculatively analyzing template instances).
+static LogicalResult
+inferFunctionTypes(FuncOp func, TemplateInstanceCache &templateCache,
+                   TemplateInstanceCache::InstanceStack &stack,
+                   bool emitDiagnostics) {
+  if (func.getBody().empty())
+    return success();
+  MLIRContext &mlirContext = *func.getContext();
+
+  CPA::Context cpaContext(CPA::createDefaultTypeMapHook());
+  auto &env = cpaContext.getCurrentEnvironment();
+
+  InitialConstraintGenerator p(env, emitDiagnostics);
+  (void)p.runOnFunction(func);
+
+  // Propagate to a fixpoint, then constrain the results of template calls
+  // whose argument types became known, and repeat until no call makes
+  // progress.
+  CPA::PropagationWorklist prop(env);
+  llvm::SmallVector<FuncTemplateCallOp, 4> pendingCalls(
+      p.getTemplateCalls().begin(), p.getTemplateCalls().end());
+  while (true) {
     do {
       prop.propagateTransitivity();
     } while (prop.commit());
 
-    LLVM_DEBUG(printReport(env, getContext(), llvm::dbgs()));
-
-    // Apply updates.
-    // TODO: This is far too naive and is basically only valid for single-block
-    // functions that are not called. Generalize it.
-    for (auto &it : env.getValueTypeMap()) {
-      auto irValue = it.first;
-      auto typeNode = it.second;
-      auto loc = irValue.getLoc();
-      CPA::GreedyTypeNodeVarResolver resolver(cpaContext, getContext(),
-                                              irValue.getLoc());
-      if (failed(resolver.analyzeTypeNode(typeNode))) {
+    bool addedConstraints = false;
+    llvm::SmallVector<FuncTemplateCallOp, 4> stillPending;
+    for (FuncTemplateCallOp call : pendingCalls) {
+      llvm::SmallVector<Type, 4> argTypes;
+      for (Value arg : call.args()) {
+        Type argType = getResolvedIrType(cpaContext, mlirContext, env, arg);
+        if (!argType)
+          break;
+        argTypes.push_back(argType);
+      }
+      if (argTypes.size() != call.args().size()) {
+        stillPending.push_back(call);
+        continue;
+      }
+      Type resultType =
+          templateCache.getResultType(call.callee(), argTypes, stack);
+      if (!resultType)
+        continue;
+      prop.addConstraint(cpaContext.getConstraint(
+          cpaContext.mapIrType(resultType),
+          env.mapValueToType(call.result())));
+      addedConstraints = true;
+    }
+    pendingCalls = std::move(stillPending);
+    if (!addedConstraints)
+      break;
+    (void)prop.commit();
+  }
+
+  LLVM_DEBUG(printReport(env, mlirContext, llvm::dbgs()));
+
+  // Apply updates.
+  // TODO: This is far too naive and is basically only valid for single-block
+  // functions that are not called. Generalize it.
+  for (auto &it : env.getValueTypeMap()) {
+    auto irValue = it.first;
+    auto typeNode = it.second;
+    auto loc = irValue.getLoc();
+    CPA::GreedyTypeNodeVarResolver resolver(
+        cpaContext, mlirContext,
+        emitDiagnostics ? llvm::Optional<Location>(loc) : llvm::None);
+    if (failed(resolver.analyzeTypeNode(typeNode))) {
+      if (emitDiagnostics)
         mlir::emitRemark(loc)
             << "type inference did not converge to an "
             << "unambiguous type (this is a terribly unacceptable level of "
             << "detail in an error message)";
-        return signalPassFailure();
-      }
+      return failure();
+    }
 
-      if (resolver.getMappings().empty()) {
-        // The type is not generic/unknown, so it does not need to be updated.
-        continue;
-      }
+    if (resolver.getMappings().empty()) {
+      // The type is not generic/unknown, so it does not need to be updated.
+      continue;
+    }
 
-      auto newType = typeNode->constructIrType(
-          cpaContext, resolver.getMappings(), &getContext(), loc);
-      if (!newType) {
+    auto newType = typeNode->constructIrType(
+        cpaContext, resolver.getMappings(), &mlirContext,
+        emitDiagnostics ? llvm::Optional<Location>(loc) : llvm::None);
+    if (!newType) {
+      if (emitDiagnostics) {
         auto diag = mlir::emitRemark(loc);
         diag << "type inference converged but a concrete IR "
              << "type could not be constructed";
-        return signalPassFailure();
       }
-      irValue.setType(newType);
+      return failure();
     }
+    irValue.setType(newType);
+  }
+
+  // Now rewrite the function type based on actual types of entry block
+  // args and the final return op operands.
+  // Again, this is just a toy that will work for very simple, global
+  // functions.
+  auto entryBlockTypes = func.getBody().front().getArgumentTypes();
+  SmallVector<Type, 4> inputTypes(entryBlockTypes.begin(),
+                                  entryBlockTypes.end());
+  SmallVector<Type, 4> resultTypes;
+  if (p.getLastReturnOp()) {
+    auto resultRange = p.getLastReturnOp()->getOperandTypes();
+    resultTypes.append(resultRange.begin(), resultRange.end());
+  }
+  auto funcType = FunctionType::get(&mlirContext, inputTypes, resultTypes);
+  func.setType(funcType);
+  return success();
+}
+
+TemplateInstanceCache::TemplateInstanceCache(ModuleOp module) {
+  for (auto funcTemplate : module.getOps<FuncTemplateOp>())
+    templates[funcTemplate.getName()] = funcTemplate;
+}
+
+FuncOp TemplateInstanceCache::selectOverload(FuncTemplateOp funcTemplate,
+                                             ArrayRef<Type> argTypes) {
+  // The first overload whose signature accepts the arguments is selected.
+  for (auto overload : funcTemplate.getBody()->getOps<FuncOp>()) {
+    FunctionType type = overload.getType();
+    if (type.getNumInputs() != argTypes.size())
+      continue;
+    bool matches = llvm::all_of(
+        llvm::zip(type.getInputs(), argTypes), [](auto it) {
+          Type declared = std::get<0>(it);
+          return declared.isa<UnknownType>() || declared == std::get<1>(it);
+        });
+    if (matches)
+      return overload;
+  }
+  return nullptr;
+}
+
+Type TemplateInstanceCache::getResultType(StringRef callee,
+                                          ArrayRef<Type> argTypes,
+                                          InstanceStack &stack) {
+  auto templateIt = templates.find(callee);
+  if (templateIt == templates.end())
+    return nullptr;
+  FuncOp overload = selectOverload(templateIt->second, argTypes);
+  if (!overload)
+    return nullptr;
+
+  InstanceKey key{overload.getOperation(),
+                  FunctionType::get(overload.getContext(), argTypes, {})};
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = resultTypes.find(key);
+    if (it != resultTypes.end())
+      return it->second;
+  }
+  if (llvm::any_of(stack, [&](const InstanceStackEntry &entry) {
+        return entry.key == key;
+      })) {
+    for (InstanceStackEntry &entry : stack)
+      entry.cutRecursion = true;
+    return nullptr;
+  }
+
+  // Not holding the lock here: the instance may call other templates. Two
+  // threads may race to analyze the same instance, which is benign since only
+  // results that did not depend on a recursion cut are memoized, and those
+  // are the same whichever thread computes them.
+  stack.push_back({key, /*cutRecursion=*/false});
+  Type resultType = inferInstanceResultType(overload, argTypes, stack);
+  bool cutRecursion = stack.pop_back_val().cutRecursion;
+  if (cutRecursion)
+    return resultType;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  return resultTypes.try_emplace(key, resultType).first->second;
+}
 
-    // Now rewrite the function type based on actual types of entry block
-    // args and the final return op operands.
-    // Again, this is just a toy that will work for very simple, global
-    // functions.
-    auto entryBlockTypes = func.getBody().front().getArgumentTypes();
-    SmallVector<Type, 4> inputTypes(entryBlockTypes.begin(),
-                                    entryBlockTypes.end());
-    SmallVector<Type, 4> resultTypes;
-    if (p.getLastReturnOp()) {
-      auto resultRange = p.getLastReturnOp()->getOperandTypes();
-      resultTypes.append(resultRange.begin(), resultRange.end());
+Type TemplateInstanceCache::inferInstanceResultType(FuncOp overload,
+                                                    ArrayRef<Type> argTypes,
+                                                    InstanceStack &stack) {
+  FunctionType declaredType = overload.getType();
+  if (declaredType.getNumResults() != 1)
+    return nullptr;
+  if (!declaredType.getResult(0).isa<UnknownType>())
+    return declaredType.getResult(0);
+  if (overload.isExternal())
+    return nullptr;
+
+  // Specialize a detached copy of the overload to the argument types and
+  // analyze it like any other function.
+  FuncOp instance = overload.clone();
+  for (auto it : llvm::zip(instance.getArguments(), argTypes))
+    std::get<0>(it).setType(std::get<1>(it));
+  Type resultType;
+  if (succeeded(inferFunctionTypes(instance, *this, stack,
+                                   /*emitDiagnostics=*/false)) &&
+      instance.getType().getNumResults() == 1 &&
+      !instance.getType().getResult(0).isa<UnknownType>()) {
+    resultType = instance.getType().getResult(0);
+  }
+  instance.erase();
+  return resultType;
+}
+
+class CPAFunctionTypeInferencePass
+    : public CPAFunctionTypeInferenceBase<CPAFunctionTypeInferencePass> {
+public:
+  void runOnOperation() override {
+    ModuleOp module = getOperation();
+    TemplateInstanceCache templateCache(module);
+
+    // Functions nested in func_templates are only analyzed per instance.
+    auto funcs = llvm::to_vector<8>(module.getOps<FuncOp>());
+    std::atomic<bool> anyFailed(false);
+    auto inferFunc = [&](FuncOp func) {
+      TemplateInstanceCache::InstanceStack stack;
+      if (failed(inferFunctionTypes(func, templateCache, stack,
+                                    /*emitDiagnostics=*/true)))
+        anyFailed = true;
+    };
+
+    MLIRContext &context = getContext();
+    if (!context.isMultithreadingEnabled() || funcs.size() <= 1) {
+      for (FuncOp func : funcs)
+        inferFunc(func);
+    } else {
+      // Keep diagnostics in function order, as the pass manager does for
+      // function passes.
+      ParallelDiagnosticHandler diagHandler(&context);
+      llvm::parallelForEachN(0, funcs.size(), [&](size_t i) {
+        diagHandler.setOrderIDForThread(i);
+        inferFunc(funcs[i]);
+        diagHandler.eraseOrderIDForThread();
+      });
     }
-    auto funcType = FunctionType::get(&getContext(), inputTypes, resultTypes);
-    func.setType(funcType);
+    if (anyFailed)
+      return signalPassFailure();
   }
 };
 
 } // namespace
 
-std::unique_ptr<OperationPass<FuncOp>>
+std::unique_ptr<OperationPass<ModuleOp>>
 mlir::NPCOMP::Typing::createCPAFunctionTypeInferencePass() {
   return std::make_unique<CPAFunctionTypeInferencePass>();
 }
@@ -39,7 +39,12 @@ def is_enabled() -> bool:
 def get_runtime_libs():
   # The _refjit_resources directory is at the npcomp.compiler level.
   resources_dir = os.path.join(os.path.dirname(__file__))
-  return [os.path.join(resources_dir, "libNPCOMPCompilerRuntimeShlib.so")]
+  return [
+      os.path.join(resources_dir, "libNPCOMPCompilerRuntimeShlib.so"),
+      # Implementations of the functions called by ATen-level (-aten-to-std)
+      # lowerings.
+      os.path.join(resources_dir, "libNPCOMPATenKernelsShlib.so"),
+  ]
 
 
 class JitModuleInvoker:
@@ -15,8 +15,9 @@ __all__ = [
 ]
 
 FRONTEND_PASSES = (
-    "func(npcomp-cpa-type-inference)",
+    "npcomp-cpa-type-inference",
     "numpy-public-functions-to-tensor",
+    "func(numpy-elide-array-copies)",
     "func(convert-numpy-to-tcf)",
     "func(convert-scf-to-std)",
     "func(canonicalize)",
@@ -61,7 +62,8 @@ class CompilerBackend:
       # Backend.
       # Note that this is a separate pass manager purely to aid in debugging.
       pm = PassManager()
-      self._refjit.build_backend_compilation_pipeline(pm)
+      # Optimizing fuses chains of elementwise ufuncs into single loops.
+      self._refjit.build_backend_compilation_pipeline(pm, optimize=True)
       pm.run(imported_module)
       if self._debug:
         logging.debug("Backend IR:\n{}", imported_module)
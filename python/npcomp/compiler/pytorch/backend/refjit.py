@@ -18,9 +18,13 @@ __all__ = [
 
 TORCH_TO_TCF_PASSES = (
     "func(aten-recognize-kernels)",
+    "func(aten-fold-batch-norm)",
+    "func(aten-prepack-weights)",
     "func(convert-aten-to-tcf)",
     "numpy-public-functions-to-tensor",
+    "func(numpy-elide-array-copies)",
     "canonicalize",
+    "func(aten-memory-schedule)",
 )
 
 # Re-export.
@@ -34,8 +38,8 @@ class TorchJitModuleInvoker(refjit_backend.JitModuleInvoker):
     numpy_invoke = super().__getitem__(function_name)
 
     def invoke(*args):
-      args = tuple(
-          arg.numpy() if isinstance(arg, torch.Tensor) else arg for arg in args)
+      args = tuple(arg.detach().numpy() if isinstance(arg, torch.Tensor) else
+                   arg for arg in args)
       return numpy_invoke(*args)
 
     return invoke
@@ -49,12 +53,14 @@ class CompilerBackend:
     self._refjit = refjit_backend.get_refjit()
     self._debug = logging.debug_enabled()
 
-  def compile(self, imported_module: Module):
+  def compile(self, imported_module: Module, weights_dir: str = ""):
     """Compiles an imported module.
 
     Args:
       imported_module: The MLIR module consisting of funcs in the torch
         dialect.
+      weights_dir: The directory of the weights imported by reference, i.e.
+        the `weights_dir` of the ModuleBuilder, if any.
     Returns:
       An opaque, backend specific module object that can be passed to load.
       The object may actually be something more specific to the backend (i.e.
@@ -81,7 +87,7 @@ class CompilerBackend:
         logging.debug("Backend IR:\n{}", imported_module)
 
     jit_module = self._refjit.JITModule.from_compiled_module(
-        imported_module, refjit_backend.get_runtime_libs())
+        imported_module, refjit_backend.get_runtime_libs(), weights_dir)
     return jit_module
 
   def load(self, jit_module) -> TorchJitModuleInvoker:
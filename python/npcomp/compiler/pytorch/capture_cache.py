@@ -0,0 +1,158 @@
+#  Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+#  See https://llvm.org/LICENSE.txt for license information.
+#  SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+import functools
+
+import torch
+import torch_mlir
+
+from npcomp.compiler.pytorch.backend import refjit
+
+__all__ = [
+    "CaptureCache",
+]
+
+
+def _arg_key(arg):
+  """Returns the part of the cache key contributed by one call argument.
+
+  Tensors are keyed on the metadata that the capture specializes on. Anything
+  else is embedded into the captured function as a constant, so it is keyed
+  by value (and must be hashable).
+  """
+  if isinstance(arg, torch.Tensor):
+    return (torch.Tensor, tuple(arg.shape), arg.dtype, arg.device.type)
+  return (type(arg), arg)
+
+
+def _owner_key(fn):
+  """Returns the objects whose identity is part of the cache key of `fn`.
+
+  The lifted parameters of one closure instance or bound method receiver are
+  not valid for another. Neither closure cells nor arbitrary receivers are
+  hashable, so they are keyed by id, and the entry keeps them alive.
+  """
+  return (tuple(fn.__closure__ or ()), getattr(fn, "__self__", None))
+
+
+class _CapturedFunction:
+  """A compiled capture along with the tensors lifted to its arguments.
+
+  Also holds the closure cells and receiver of the captured function, whose
+  ids are part of the cache key, so that they cannot be reused by other
+  objects while the entry exists.
+  """
+  __slots__ = [
+      "owners",
+      "invoke",
+      "lifted_parameters",
+      "returns_sequence",
+  ]
+
+  def __init__(self, owners, invoke, lifted_parameters, returns_sequence):
+    self.owners = owners
+    self.invoke = invoke
+    self.lifted_parameters = lifted_parameters
+    self.returns_sequence = returns_sequence
+
+  def __call__(self, tensor_args):
+    results = self.invoke(*tensor_args, *self.lifted_parameters)
+    if not self.returns_sequence:
+      return torch.from_numpy(results)
+    if not isinstance(results, tuple):
+      results = (results,)
+    return tuple(torch.from_numpy(r) for r in results)
+
+
+class _EagerFunction:
+  """Stands in for a capture that updated tensors in place.
+
+  The compiled function only returns its results, so in-place updates (e.g.
+  of weights in an optimizer step) would not be applied on later calls.
+  Such functions are run eagerly instead.
+  """
+  __slots__ = ["owners"]
+
+  def __init__(self, owners):
+    self.owners = owners
+
+
+class CaptureCache:
+  """Caches acap captures of a function keyed on its code and input metadata.
+
+  The first call for a given key traces `fn` through the capture dispatcher,
+  compiles the result and returns the eagerly computed value. Later calls
+  with the same code object and argument shapes/dtypes invoke the compiled
+  function directly, without tracing or intercepting dispatch.
+
+  Tensors the function touches that are not arguments (i.e. weights held by
+  a closure, module or global) are lifted to trailing parameters rather than
+  embedded as constants. They are held by identity: in-place updates are
+  observed by later calls, rebinding the name to a new tensor is not. As with
+  any trace, data-dependent control flow is specialized to the first call.
+
+  A function that updates a lifted parameter or argument in place is not
+  compiled, since the compiled function would not apply the update; it is
+  run eagerly on every call instead.
+
+  Usage:
+    cache = CaptureCache()
+
+    @cache
+    def mm_relu(lhs, rhs):
+      return torch.relu(torch.mm(lhs, rhs))
+  """
+
+  def __init__(self, backend=None):
+    super().__init__()
+    self._backend = backend if backend is not None else refjit.CompilerBackend()
+    self._entries = dict()
+    self.hits = 0
+    self.misses = 0
+
+  def __call__(self, fn):
+
+    @functools.wraps(fn)
+    def wrapper(*args):
+      return self.invoke(fn, *args)
+
+    return wrapper
+
+  def invoke(self, fn, *args):
+    owners = _owner_key(fn)
+    key = (fn.__code__, tuple(id(owner) for owner in owners[0]), id(owners[1]),
+           tuple(_arg_key(arg) for arg in args))
+    tensor_args = [arg for arg in args if isinstance(arg, torch.Tensor)]
+    entry = self._entries.get(key)
+    if isinstance(entry, _EagerFunction):
+      self.misses += 1
+      return fn(*args)
+    if entry is not None:
+      self.hits += 1
+      return entry(tensor_args)
+
+    self.misses += 1
+    result, entry = self._capture(fn, owners, args, tensor_args)
+    self._entries[key] = entry
+    return result
+
+  def _capture(self, fn, owners, args, tensor_args):
+    name = fn.__name__
+    arg_versions = [arg._version for arg in tensor_args]
+    mb = torch_mlir.ModuleBuilder()
+    with mb.capture_function(name, tensor_args, lift_parameters=True) as f:
+      result = fn(*args)
+      returns_sequence = isinstance(result, (tuple, list))
+      f.returns(list(result) if returns_sequence else [result])
+    lifted_parameters = list(f.lifted_parameters)
+    # The version counters of the lifted parameters were recorded when they
+    # were lifted, before the captured ops ran.
+    versions = zip(tensor_args + lifted_parameters,
+                   arg_versions + list(f.lifted_parameter_versions))
+    if any(tensor._version != version for tensor, version in versions):
+      return result, _EagerFunction(owners)
+    jit_module = self._backend.load(self._backend.compile(mb.module))
+    entry = _CapturedFunction(owners, jit_module[name], lifted_parameters,
+                              returns_sequence)
+    return result, entry
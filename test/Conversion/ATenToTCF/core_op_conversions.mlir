@@ -24,3 +24,119 @@ func @add_alpha_non_constant1(%arg0: tensor<4x6x3xf32>, %arg1: tensor<1x1x3xf32>
   %0 = "aten.add"(%arg0, %arg1, %c1_i64) : (tensor<4x6x3xf32>, tensor<1x1x3xf32>, i64) -> tensor<4x6x3xf32>
   return %0 : tensor<4x6x3xf32>
 }
+
+// CHECK-LABEL: @activations
+func @activations(%arg0: tensor<4x6xf32>) -> (tensor<4x6xf32>, tensor<4x6xf32>, tensor<4x6xf32>) {
+  // CHECK: tcf.clamp %arg0 {min = 0.000000e+00 : f32} : tensor<4x6xf32>
+  %0 = "aten.relu"(%arg0) : (tensor<4x6xf32>) -> tensor<4x6xf32>
+  %c0 = constant 0 : i64
+  %c6 = constant 6.0 : f64
+  // CHECK: tcf.clamp %arg0 {max = 6.000000e+00 : f32, min = 0.000000e+00 : f32} : tensor<4x6xf32>
+  %1 = "aten.hardtanh"(%arg0, %c0, %c6) : (tensor<4x6xf32>, i64, f64) -> tensor<4x6xf32>
+  // CHECK: tcf.sigmoid %arg0 : tensor<4x6xf32>
+  %2 = "aten.sigmoid"(%arg0) : (tensor<4x6xf32>) -> tensor<4x6xf32>
+  return %0, %1, %2 : tensor<4x6xf32>, tensor<4x6xf32>, tensor<4x6xf32>
+}
+
+// CHECK-LABEL: @addmm
+func @addmm(%arg0: tensor<16xf32>, %arg1: tensor<2x1024xf32>, %arg2: tensor<1024x16xf32>) -> tensor<2x16xf32> {
+  %0 = "aten.constant"() {type = "i64", value = 1 : i64} : () -> i64
+  // CHECK: %[[MM:.*]] = tcf.matmul %arg1, %arg2 : (tensor<2x1024xf32>, tensor<1024x16xf32>) -> tensor<2x16xf32>
+  // CHECK: tcf.add %[[MM]], %arg0 : (tensor<2x16xf32>, tensor<16xf32>) -> tensor<2x16xf32>
+  %1 = "aten.addmm"(%arg0, %arg1, %arg2, %0, %0) : (tensor<16xf32>, tensor<2x1024xf32>, tensor<1024x16xf32>, i64, i64) -> tensor<2x16xf32>
+  return %1 : tensor<2x16xf32>
+}
+
+// CHECK-LABEL: @addmm_scaled
+func @addmm_scaled(%arg0: tensor<16xf32>, %arg1: tensor<2x1024xf32>, %arg2: tensor<1024x16xf32>) -> tensor<2x16xf32> {
+  %0 = "aten.constant"() {type = "i64", value = 1 : i64} : () -> i64
+  %1 = "aten.constant"() {type = "i64", value = 2 : i64} : () -> i64
+  // CHECK: "aten.addmm"
+  %2 = "aten.addmm"(%arg0, %arg1, %arg2, %0, %1) : (tensor<16xf32>, tensor<2x1024xf32>, tensor<1024x16xf32>, i64, i64) -> tensor<2x16xf32>
+  return %2 : tensor<2x16xf32>
+}
+
+// CHECK-LABEL: @convolution
+func @convolution(%arg0: tensor<1x3x32x32xf32>, %arg1: tensor<16x3x3x3xf32>, %arg2: tensor<16xf32>, %arg3: !basicpy.NoneType) -> (tensor<1x16x16x16xf32>, tensor<1x16x30x30xf32>) {
+  %c0 = constant 0 : i64
+  %c1 = constant 1 : i64
+  %c2 = constant 2 : i64
+  %false = basicpy.bool_constant false
+  %stride = basicpy.build_list %c2, %c2 : (i64, i64) -> !basicpy.ListType
+  %padding = basicpy.build_list %c1, %c1 : (i64, i64) -> !basicpy.ListType
+  %ones = basicpy.build_list %c1, %c1 : (i64, i64) -> !basicpy.ListType
+  %zeros = basicpy.build_list %c0, %c0 : (i64, i64) -> !basicpy.ListType
+  // CHECK: tcf.conv_2d_nchw %arg0, %arg1, %arg2 {padding = [1, 1], strides = [2, 2]} : (tensor<1x3x32x32xf32>, tensor<16x3x3x3xf32>, tensor<16xf32>) -> tensor<1x16x16x16xf32>
+  %0 = "aten.convolution"(%arg0, %arg1, %arg2, %stride, %padding, %ones, %false, %zeros, %c1) : (tensor<1x3x32x32xf32>, tensor<16x3x3x3xf32>, tensor<16xf32>, !basicpy.ListType, !basicpy.ListType, !basicpy.ListType, !basicpy.BoolType, !basicpy.ListType, i64) -> tensor<1x16x16x16xf32>
+  // CHECK: tcf.conv_2d_nchw %arg0, %arg1 : (tensor<1x3x32x32xf32>, tensor<16x3x3x3xf32>) -> tensor<1x16x30x30xf32>
+  %1 = "aten.convolution"(%arg0, %arg1, %arg3, %ones, %zeros, %ones, %false, %zeros, %c1) : (tensor<1x3x32x32xf32>, tensor<16x3x3x3xf32>, !basicpy.NoneType, !basicpy.ListType, !basicpy.ListType, !basicpy.ListType, !basicpy.BoolType, !basicpy.ListType, i64) -> tensor<1x16x30x30xf32>
+  return %0, %1 : tensor<1x16x16x16xf32>, tensor<1x16x30x30xf32>
+}
+
+// CHECK-LABEL: @convolution_grouped
+func @convolution_grouped(%arg0: tensor<1x4x8x8xf32>, %arg1: tensor<4x1x3x3xf32>, %arg2: !basicpy.NoneType) -> tensor<1x4x6x6xf32> {
+  %c0 = constant 0 : i64
+  %c1 = constant 1 : i64
+  %c4 = constant 4 : i64
+  %false = basicpy.bool_constant false
+  %ones = basicpy.build_list %c1, %c1 : (i64, i64) -> !basicpy.ListType
+  %zeros = basicpy.build_list %c0, %c0 : (i64, i64) -> !basicpy.ListType
+  // CHECK: "aten.convolution"
+  %0 = "aten.convolution"(%arg0, %arg1, %arg2, %ones, %zeros, %ones, %false, %zeros, %c4) : (tensor<1x4x8x8xf32>, tensor<4x1x3x3xf32>, !basicpy.NoneType, !basicpy.ListType, !basicpy.ListType, !basicpy.ListType, !basicpy.BoolType, !basicpy.ListType, i64) -> tensor<1x4x6x6xf32>
+  return %0 : tensor<1x4x6x6xf32>
+}
+
+// CHECK-LABEL: @batch_norm_inference
+func @batch_norm_inference(%arg0: tensor<2x8x4x4xf32>, %arg1: tensor<8xf32>, %arg2: tensor<8xf32>, %arg3: tensor<8xf32>, %arg4: tensor<8xf32>) -> tensor<2x8x4x4xf32> {
+  %0 = "aten.constant"() {type = "bool", value = 0 : i1} : () -> i1
+  %1 = "aten.constant"() {type = "f32", value = 1.000000e-01 : f32} : () -> f32
+  %2 = "aten.constant"() {type = "f32", value = 9.99999974E-6 : f32} : () -> f32
+  %3 = "aten.constant"() {type = "bool", value = 1 : i1} : () -> i1
+  // CHECK: tcf.batch_norm_inference %arg0, %arg1, %arg2, %arg3, %arg4 {epsilon = 9.99999974E-6 : f32} : (tensor<2x8x4x4xf32>, tensor<8xf32>, tensor<8xf32>, tensor<8xf32>, tensor<8xf32>) -> tensor<2x8x4x4xf32>
+  %4:3 = "aten.batch_norm"(%arg0, %arg1, %arg2, %arg3, %arg4, %0, %1, %2, %3) : (tensor<2x8x4x4xf32>, tensor<8xf32>, tensor<8xf32>, tensor<8xf32>, tensor<8xf32>, i1, f32, f32, i1) -> (tensor<2x8x4x4xf32>, tensor<8xf32>, tensor<8xf32>)
+  return %4#0 : tensor<2x8x4x4xf32>
+}
+
+// CHECK-LABEL: @batch_norm_training
+func @batch_norm_training(%arg0: tensor<2x8x4x4xf32>, %arg1: tensor<8xf32>, %arg2: tensor<8xf32>, %arg3: tensor<8xf32>, %arg4: tensor<8xf32>) -> tensor<2x8x4x4xf32> {
+  %0 = "aten.constant"() {type = "bool", value = 1 : i1} : () -> i1
+  %1 = "aten.constant"() {type = "f32", value = 1.000000e-01 : f32} : () -> f32
+  %2 = "aten.constant"() {type = "f32", value = 9.99999974E-6 : f32} : () -> f32
+  // CHECK: "aten.batch_norm"
+  %3:3 = "aten.batch_norm"(%arg0, %arg1, %arg2, %arg3, %arg4, %0, %1, %2, %0) : (tensor<2x8x4x4xf32>, tensor<8xf32>, tensor<8xf32>, tensor<8xf32>, tensor<8xf32>, i1, f32, f32, i1) -> (tensor<2x8x4x4xf32>, tensor<8xf32>, tensor<8xf32>)
+  return %3#0 : tensor<2x8x4x4xf32>
+}
+
+// CHECK-LABEL: @max_pool2d
+func @max_pool2d(%arg0: tensor<1x32x16x16xf32>) -> tensor<1x32x8x8xf32> {
+  %0 = "aten.constant"() {type = "List[i32]", value = dense<3> : vector<2xi64>} : () -> !aten.list<i32>
+  %1 = "aten.constant"() {type = "List[i32]", value = dense<2> : vector<2xi64>} : () -> !aten.list<i32>
+  %2 = "aten.constant"() {type = "List[i32]", value = dense<1> : vector<2xi64>} : () -> !aten.list<i32>
+  %3 = "aten.constant"() {type = "bool", value = 0 : i1} : () -> i1
+  // CHECK: tcf.max_pool_2d_nchw %arg0 {dilations = [1, 1], kernel_size = [3, 3], padding = [1, 1], strides = [2, 2]} : (tensor<1x32x16x16xf32>) -> tensor<1x32x8x8xf32>
+  %4 = "aten.max_pool2d"(%arg0, %0, %1, %2, %2, %3) : (tensor<1x32x16x16xf32>, !aten.list<i32>, !aten.list<i32>, !aten.list<i32>, !aten.list<i32>, i1) -> tensor<1x32x8x8xf32>
+  return %4 : tensor<1x32x8x8xf32>
+}
+
+// CHECK-LABEL: @reductions
+func @reductions(%arg0: tensor<2x8x4x4xf32>) -> (tensor<2x8x1x1xf32>, tensor<2x4xf32>, tensor<f32>) {
+  %0 = "aten.constant"() {type = "List[i32]", value = dense<1> : vector<2xi64>} : () -> !aten.list<i32>
+  // CHECK: tcf.mean %arg0 {axes = [2, 3], keep_dims = true} : (tensor<2x8x4x4xf32>) -> tensor<2x8x1x1xf32>
+  %1 = "aten._adaptive_avg_pool2d"(%arg0, %0) : (tensor<2x8x4x4xf32>, !aten.list<i32>) -> tensor<2x8x1x1xf32>
+  %2 = "aten.constant"() {type = "List[i32]", value = dense<[1, -1]> : vector<2xi64>} : () -> !aten.list<i32>
+  %3 = "aten.constant"() {type = "bool", value = 0 : i1} : () -> i1
+  // CHECK: tcf.sum %arg0 {axes = [1, 3], keep_dims = false} : (tensor<2x8x4x4xf32>) -> tensor<2x4xf32>
+  %4 = "aten.sum"(%arg0, %2, %3) : (tensor<2x8x4x4xf32>, !aten.list<i32>, i1) -> tensor<2x4xf32>
+  // CHECK: tcf.mean %arg0 {axes = [0, 1, 2, 3], keep_dims = false} : (tensor<2x8x4x4xf32>) -> tensor<f32>
+  %5 = "aten.mean"(%arg0) : (tensor<2x8x4x4xf32>) -> tensor<f32>
+  return %1, %4, %5 : tensor<2x8x1x1xf32>, tensor<2x4xf32>, tensor<f32>
+}
+
+// CHECK-LABEL: @log_softmax
+func @log_softmax(%arg0: tensor<3x10xf32>) -> tensor<3x10xf32> {
+  %c-1 = constant -1 : i64
+  %false = basicpy.bool_constant false
+  // CHECK: tcf.log_softmax %arg0 {axis = 1 : i64} : tensor<3x10xf32>
+  %0 = "aten.log_softmax"(%arg0, %c-1, %false) : (tensor<3x10xf32>, i64, !basicpy.BoolType) -> tensor<3x10xf32>
+  return %0 : tensor<3x10xf32>
+}
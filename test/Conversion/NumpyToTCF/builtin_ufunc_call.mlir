@@ -23,3 +23,41 @@ func @numpyAdd(%arg0: tensor<?xf32>, %arg1: tensor<?x?xf32>) -> tensor<*xf32> {
   %0 = numpy.builtin_ufunc_call<"numpy.add"> (%arg0, %arg1) : (tensor<?xf32>, tensor<?x?xf32>) -> tensor<*xf32>
   return %0 : tensor<*xf32>
 }
+
+// CHECK-LABEL: func @numpyBinary
+func @numpyBinary(%arg0: tensor<?xf32>, %arg1: tensor<?xf32>) -> (tensor<*xf32>, tensor<*xf32>, tensor<*xf32>, tensor<*xf32>, tensor<*xf32>, tensor<*xf32>) {
+  // CHECK: tcf.sub %arg0, %arg1 : (tensor<?xf32>, tensor<?xf32>) -> tensor<*xf32>
+  // CHECK: tcf.mul %arg0, %arg1 : (tensor<?xf32>, tensor<?xf32>) -> tensor<*xf32>
+  // CHECK: tcf.div %arg0, %arg1 : (tensor<?xf32>, tensor<?xf32>) -> tensor<*xf32>
+  // CHECK: tcf.div %arg0, %arg1 : (tensor<?xf32>, tensor<?xf32>) -> tensor<*xf32>
+  // CHECK: tcf.max %arg0, %arg1 : (tensor<?xf32>, tensor<?xf32>) -> tensor<*xf32>
+  // CHECK: tcf.min %arg0, %arg1 : (tensor<?xf32>, tensor<?xf32>) -> tensor<*xf32>
+  %0 = numpy.builtin_ufunc_call<"numpy.subtract"> (%arg0, %arg1) : (tensor<?xf32>, tensor<?xf32>) -> tensor<*xf32>
+  %1 = numpy.builtin_ufunc_call<"numpy.multiply"> (%arg0, %arg1) : (tensor<?xf32>, tensor<?xf32>) -> tensor<*xf32>
+  %2 = numpy.builtin_ufunc_call<"numpy.true_divide"> (%arg0, %arg1) : (tensor<?xf32>, tensor<?xf32>) -> tensor<*xf32>
+  %3 = numpy.builtin_ufunc_call<"numpy.divide"> (%arg0, %arg1) : (tensor<?xf32>, tensor<?xf32>) -> tensor<*xf32>
+  %4 = numpy.builtin_ufunc_call<"numpy.maximum"> (%arg0, %arg1) : (tensor<?xf32>, tensor<?xf32>) -> tensor<*xf32>
+  %5 = numpy.builtin_ufunc_call<"numpy.minimum"> (%arg0, %arg1) : (tensor<?xf32>, tensor<?xf32>) -> tensor<*xf32>
+  return %0, %1, %2, %3, %4, %5 : tensor<*xf32>, tensor<*xf32>, tensor<*xf32>, tensor<*xf32>, tensor<*xf32>, tensor<*xf32>
+}
+
+// CHECK-LABEL: func @numpyUnary
+func @numpyUnary(%arg0: tensor<?xf32>) -> (tensor<?xf32>, tensor<?xf32>, tensor<*xf32>) {
+  // CHECK: tcf.exp %arg0 : tensor<?xf32>
+  // CHECK: tcf.log %arg0 : tensor<?xf32>
+  // CHECK: %[[SQRT:.*]] = tcf.sqrt %arg0 : tensor<?xf32>
+  // CHECK: tensor_cast %[[SQRT]] : tensor<?xf32> to tensor<*xf32>
+  %0 = numpy.builtin_ufunc_call<"numpy.exp"> (%arg0) : (tensor<?xf32>) -> tensor<?xf32>
+  %1 = numpy.builtin_ufunc_call<"numpy.log"> (%arg0) : (tensor<?xf32>) -> tensor<?xf32>
+  %2 = numpy.builtin_ufunc_call<"numpy.sqrt"> (%arg0) : (tensor<?xf32>) -> tensor<*xf32>
+  return %0, %1, %2 : tensor<?xf32>, tensor<?xf32>, tensor<*xf32>
+}
+
+// CHECK-LABEL: func @numpyCompare
+func @numpyCompare(%arg0: tensor<?xf32>, %arg1: tensor<?xf32>) -> (tensor<*xi1>, tensor<*xi1>) {
+  // CHECK: tcf.compare "gt", %arg0, %arg1 : (tensor<?xf32>, tensor<?xf32>) -> tensor<*xi1>
+  // CHECK: tcf.compare "le", %arg0, %arg1 : (tensor<?xf32>, tensor<?xf32>) -> tensor<*xi1>
+  %0 = numpy.builtin_ufunc_call<"numpy.greater"> (%arg0, %arg1) : (tensor<?xf32>, tensor<?xf32>) -> tensor<*xi1>
+  %1 = numpy.builtin_ufunc_call<"numpy.less_equal"> (%arg0, %arg1) : (tensor<?xf32>, tensor<?xf32>) -> tensor<*xi1>
+  return %0, %1 : tensor<*xi1>, tensor<*xi1>
+}
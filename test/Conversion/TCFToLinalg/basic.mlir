@@ -1,5 +1,11 @@
 // RUN: npcomp-opt <%s -convert-tcf-to-linalg | FileCheck %s --dump-input=fail
 
+// Indexing maps used by the windowed and reduction ops below.
+// CHECK-DAG: #[[CONV_IN_MAP:.*]] = affine_map<(d0, d1, d2, d3, d4, d5, d6) -> (d0, d4, d2 * 2 + d5, d3 * 2 + d6)>
+// CHECK-DAG: #[[CONV_FILTER_MAP:.*]] = affine_map<(d0, d1, d2, d3, d4, d5, d6) -> (d1, d4, d5, d6)>
+// CHECK-DAG: #[[CONV_OUT_MAP:.*]] = affine_map<(d0, d1, d2, d3, d4, d5, d6) -> (d0, d1, d2, d3)>
+// CHECK-DAG: #[[REDUCED_MAP:.*]] = affine_map<(d0, d1, d2, d3) -> (d0, d1)>
+
 // CHECK-LABEL:   func @tcf_matmul(
 // CHECK-SAME:                     %[[LHS:.*]]: tensor<?x?xf32>,
 // CHECK-SAME:                     %[[RHS:.*]]: tensor<?x?xf32>) -> tensor<?x?xf32> {
@@ -70,3 +76,112 @@ func @tcf_conv_2d_nchw(%arg0: tensor<?x?x?x?xf32>, %arg1: tensor<?x?x?x?xf32>) -
   %0 = tcf.conv_2d_nchw %arg0, %arg1 : (tensor<?x?x?x?xf32>, tensor<?x?x?x?xf32>) -> tensor<?x?x?x?xf32>
   return %0 : tensor<?x?x?x?xf32>
 }
+
+// Strided/dilated convolutions are spelled out as a linalg.generic, reading
+// the input through a strided indexing map. The bias initializes the
+// accumulator and padding goes through tcp.pad.
+// CHECK-LABEL:   func @tcf_conv_2d_nchw_strided(
+// CHECK-SAME:                     %[[IN:[a-zA-Z0-9]+]]: tensor<?x?x?x?xf32>
+// CHECK-SAME:                     %[[FILTER:[a-zA-Z0-9]+]]: tensor<?x?x?x?xf32>
+// CHECK-SAME:                     %[[BIAS:[a-zA-Z0-9]+]]: tensor<?xf32>) -> tensor<?x?x?x?xf32> {
+// CHECK:           shape.cstr_require %{{.*}}, "bias size must equal the filter out-channels"
+// CHECK:           shape.assuming
+// CHECK:             %[[SPLATTED:.*]] = tcp.splatted
+// CHECK:             %[[INIT:.*]] = linalg.generic {{.*}} ins(%[[BIAS]] : tensor<?xf32>) outs(%[[SPLATTED]] : tensor<?x?x?x?xf32>)
+// CHECK:             %[[PADDED:.*]] = tcp.pad %[[IN]]
+// CHECK:             %[[CONV:.*]] = linalg.generic {indexing_maps = [#[[CONV_IN_MAP]], #[[CONV_FILTER_MAP]], #[[CONV_OUT_MAP]]], iterator_types = ["parallel", "parallel", "parallel", "parallel", "reduction", "reduction", "reduction"]} ins(%[[PADDED]], %[[FILTER]] : tensor<?x?x?x?xf32>, tensor<?x?x?x?xf32>) outs(%[[INIT]] : tensor<?x?x?x?xf32>)
+// CHECK:               mulf
+// CHECK:               addf
+// CHECK:             shape.assuming_yield %[[CONV]] : tensor<?x?x?x?xf32>
+func @tcf_conv_2d_nchw_strided(%arg0: tensor<?x?x?x?xf32>, %arg1: tensor<?x?x?x?xf32>, %arg2: tensor<?xf32>) -> tensor<?x?x?x?xf32> {
+  %0 = tcf.conv_2d_nchw %arg0, %arg1, %arg2 {padding = [1, 1], strides = [2, 2]} : (tensor<?x?x?x?xf32>, tensor<?x?x?x?xf32>, tensor<?xf32>) -> tensor<?x?x?x?xf32>
+  return %0 : tensor<?x?x?x?xf32>
+}
+
+// CHECK-LABEL:   func @tcf_max_pool_2d_nchw(
+// CHECK-DAG:       %[[NEGINF:.*]] = constant 0xFF800000 : f32
+// CHECK-DAG:       %[[WINDOW:.*]] = constant dense<0.000000e+00> : tensor<3x3xf32>
+// CHECK:           shape.cstr_require %{{.*}}, "input height must be greater than or equal to the pooling window height"
+// CHECK:           shape.assuming
+// CHECK:             %[[INIT:.*]] = tcp.splatted %[[NEGINF]]
+// CHECK:             %[[PADDED:.*]] = tcp.pad %{{.*}}, %{{.*}}, %{{.*}}, %[[NEGINF]]
+// CHECK:             linalg.generic {{.*}} iterator_types = ["parallel", "parallel", "parallel", "parallel", "reduction", "reduction"]} ins(%[[PADDED]], %[[WINDOW]] : tensor<?x?x?x?xf32>, tensor<3x3xf32>) outs(%[[INIT]] : tensor<?x?x?x?xf32>)
+// CHECK:             ^bb0(%[[ELEMENT:[a-zA-Z0-9_]+]]: f32, %{{[a-zA-Z0-9_]+}}: f32, %[[ACC:[a-zA-Z0-9_]+]]: f32):
+// CHECK:               %[[GREATER:.*]] = cmpf ogt, %[[ELEMENT]], %[[ACC]] : f32
+// CHECK:               %[[NAN:.*]] = cmpf uno, %[[ELEMENT]], %[[ELEMENT]] : f32
+// CHECK:               %[[TAKE:.*]] = or %[[GREATER]], %[[NAN]] : i1
+// CHECK:               %[[MAX:.*]] = select %[[TAKE]], %[[ELEMENT]], %[[ACC]] : f32
+// CHECK:               linalg.yield %[[MAX]] : f32
+func @tcf_max_pool_2d_nchw(%arg0: tensor<?x?x?x?xf32>) -> tensor<?x?x?x?xf32> {
+  %0 = tcf.max_pool_2d_nchw %arg0 {dilations = [1, 1], kernel_size = [3, 3], padding = [1, 1], strides = [2, 2]} : (tensor<?x?x?x?xf32>) -> tensor<?x?x?x?xf32>
+  return %0 : tensor<?x?x?x?xf32>
+}
+
+// CHECK-LABEL:   func @tcf_clamp(
+// CHECK-DAG:       %[[MIN:.*]] = constant 0.000000e+00 : f32
+// CHECK-DAG:       %[[MAX:.*]] = constant 6.000000e+00 : f32
+// CHECK:           linalg.generic
+// CHECK:             cmpf olt, %{{.*}}, %[[MIN]] : f32
+// CHECK:             cmpf ogt, %{{.*}}, %[[MAX]] : f32
+func @tcf_clamp(%arg0: tensor<?x?xf32>) -> tensor<?x?xf32> {
+  %0 = tcf.clamp %arg0 {min = 0.0 : f32, max = 6.0 : f32} : tensor<?x?xf32>
+  return %0 : tensor<?x?xf32>
+}
+
+// CHECK-LABEL:   func @tcf_sigmoid(
+// CHECK:           linalg.generic
+// CHECK:             negf
+// CHECK:             math.exp
+// CHECK:             addf
+// CHECK:             divf
+func @tcf_sigmoid(%arg0: tensor<?x?xf32>) -> tensor<?x?xf32> {
+  %0 = tcf.sigmoid %arg0 : tensor<?x?xf32>
+  return %0 : tensor<?x?xf32>
+}
+
+// A mean reduces into a tensor without the reduced dimensions, then divides
+// by the element count while reinserting them for keep_dims.
+// CHECK-LABEL:   func @tcf_mean_keep_dims(
+// CHECK:           %[[SUM:.*]] = linalg.generic {{.*}} iterator_types = ["parallel", "parallel", "reduction", "reduction"]} ins(%{{.*}} : tensor<?x?x?x?xf32>) outs(%{{.*}} : tensor<?x?xf32>)
+// CHECK:           %[[COUNT:.*]] = sitofp %{{.*}} : i64 to f32
+// CHECK:           linalg.generic {indexing_maps = [#[[REDUCED_MAP]], {{.*}}], iterator_types = ["parallel", "parallel", "parallel", "parallel"]} ins(%[[SUM]] : tensor<?x?xf32>) outs(%{{.*}} : tensor<?x?x1x1xf32>)
+// CHECK:             divf %{{.*}}, %[[COUNT]] : f32
+func @tcf_mean_keep_dims(%arg0: tensor<?x?x?x?xf32>) -> tensor<?x?x1x1xf32> {
+  %0 = tcf.mean %arg0 {axes = [2, 3], keep_dims = true} : (tensor<?x?x?x?xf32>) -> tensor<?x?x1x1xf32>
+  return %0 : tensor<?x?x1x1xf32>
+}
+
+// CHECK-LABEL:   func @tcf_sum(
+// CHECK:           %[[SUM:.*]] = linalg.generic {{.*}} iterator_types = ["reduction", "parallel"]} ins(%{{.*}} : tensor<?x?xf32>) outs(%{{.*}} : tensor<?xf32>)
+// CHECK:           return %[[SUM]] : tensor<?xf32>
+func @tcf_sum(%arg0: tensor<?x?xf32>) -> tensor<?xf32> {
+  %0 = tcf.sum %arg0 {axes = [0]} : (tensor<?x?xf32>) -> tensor<?xf32>
+  return %0 : tensor<?xf32>
+}
+
+// CHECK-LABEL:   func @tcf_log_softmax(
+// CHECK:           %[[MAX:.*]] = linalg.generic {{.*}} iterator_types = ["parallel", "reduction"]}
+// CHECK:             cmpf ogt
+// CHECK:           %[[SUMEXP:.*]] = linalg.generic {{.*}} iterator_types = ["parallel", "reduction"]} ins(%{{.*}}, %[[MAX]] : tensor<?x?xf32>, tensor<?xf32>)
+// CHECK:             math.exp
+// CHECK:           linalg.generic {{.*}} iterator_types = ["parallel", "parallel"]} ins(%{{.*}}, %[[MAX]], %[[SUMEXP]] : tensor<?x?xf32>, tensor<?xf32>, tensor<?xf32>)
+// CHECK:             math.log
+func @tcf_log_softmax(%arg0: tensor<?x?xf32>) -> tensor<?x?xf32> {
+  %0 = tcf.log_softmax %arg0 {axis = 1 : i64} : tensor<?x?xf32>
+  return %0 : tensor<?x?xf32>
+}
+
+// The statistics are folded into a per-channel multiplier and shift before
+// touching the (much larger) input.
+// CHECK-LABEL:   func @tcf_batch_norm_inference(
+// CHECK:           shape.cstr_require %{{.*}}, "batch norm parameters must have one element per channel"
+// CHECK:           shape.assuming
+// CHECK:             %[[PARAMS:.*]]:2 = linalg.generic {{.*}} outs(%{{.*}}, %{{.*}} : tensor<?xf32>, tensor<?xf32>)
+// CHECK:               math.rsqrt
+// CHECK:             linalg.generic {{.*}} ins(%{{.*}}, %[[PARAMS]]#0, %[[PARAMS]]#1 : tensor<?x?x?x?xf32>, tensor<?xf32>, tensor<?xf32>)
+// CHECK:               mulf
+// CHECK:               addf
+func @tcf_batch_norm_inference(%arg0: tensor<?x?x?x?xf32>, %arg1: tensor<?xf32>, %arg2: tensor<?xf32>, %arg3: tensor<?xf32>, %arg4: tensor<?xf32>) -> tensor<?x?x?x?xf32> {
+  %0 = tcf.batch_norm_inference %arg0, %arg1, %arg2, %arg3, %arg4 {epsilon = 1.0e-5 : f32} : (tensor<?x?x?x?xf32>, tensor<?xf32>, tensor<?xf32>, tensor<?xf32>, tensor<?xf32>) -> tensor<?x?x?x?xf32>
+  return %0 : tensor<?x?x?x?xf32>
+}
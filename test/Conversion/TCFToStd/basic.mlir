@@ -29,3 +29,76 @@ func @tcf_add(%arg0: tensor<?xf32>, %arg1: tensor<?xf32>) -> tensor<?xf32> {
   %0 = tcf.add %arg0, %arg1 : (tensor<?xf32>, tensor<?xf32>) -> tensor<?xf32>
   return %0 : tensor<?xf32>
 }
+
+// Operands of the same static shape need no broadcasting.
+// CHECK-LABEL:   func @static_same_shape(
+// CHECK-SAME:            %[[LHS:.*]]: tensor<4xf32>,
+// CHECK-SAME:            %[[RHS:.*]]: tensor<4xf32>) -> tensor<4xi1> {
+// CHECK-NOT:       shape.assuming
+// CHECK:           %[[SUB:.*]] = subf %[[LHS]], %[[RHS]] : tensor<4xf32>
+// CHECK:           %[[LOG:.*]] = math.log %[[SUB]] : tensor<4xf32>
+// CHECK:           %[[LESS:.*]] = cmpf olt, %[[LOG]], %[[RHS]] : tensor<4xf32>
+// CHECK:           %[[LOG_IS_NAN:.*]] = cmpf uno, %[[LOG]], %[[LOG]] : tensor<4xf32>
+// CHECK:           %[[MIN_PRED:.*]] = or %[[LESS]], %[[LOG_IS_NAN]] : tensor<4xi1>
+// CHECK:           %[[MIN:.*]] = select %[[MIN_PRED]], %[[LOG]], %[[RHS]] : tensor<4xi1>, tensor<4xf32>
+// CHECK:           %[[RET:.*]] = cmpf oge, %[[MIN]], %[[LHS]] : tensor<4xf32>
+// CHECK:           return %[[RET]] : tensor<4xi1>
+// CHECK:         }
+func @static_same_shape(%arg0: tensor<4xf32>, %arg1: tensor<4xf32>) -> tensor<4xi1> {
+  %0 = tcf.sub %arg0, %arg1 : (tensor<4xf32>, tensor<4xf32>) -> tensor<4xf32>
+  %1 = tcf.log %0 : tensor<4xf32>
+  %2 = tcf.min %1, %arg1 : (tensor<4xf32>, tensor<4xf32>) -> tensor<4xf32>
+  %3 = tcf.compare "ge", %2, %arg0 : (tensor<4xf32>, tensor<4xf32>) -> tensor<4xi1>
+  return %3 : tensor<4xi1>
+}
+
+// A chain of dynamically shaped ops checks and broadcasts its operands once,
+// and is computed in a single shape.assuming region.
+// CHECK-LABEL:   func @dynamic_chain(
+// CHECK-SAME:            %[[ARG0:.*]]: tensor<?xf32>, %[[ARG1:.*]]: tensor<?xf32>,
+// CHECK-SAME:            %[[ARG2:.*]]: tensor<?xf32>) -> tensor<?xf32> {
+// CHECK:           %[[SHAPE0:.*]] = shape.shape_of %[[ARG0]]
+// CHECK:           %[[SHAPE1:.*]] = shape.shape_of %[[ARG1]]
+// CHECK:           %[[SHAPE2:.*]] = shape.shape_of %[[ARG2]]
+// CHECK:           %[[WITNESS01:.*]] = shape.cstr_broadcastable %[[SHAPE0]], %[[SHAPE1]]
+// CHECK:           %[[WITNESS02:.*]] = shape.cstr_broadcastable %[[SHAPE0]], %[[SHAPE2]]
+// CHECK:           %[[WITNESS12:.*]] = shape.cstr_broadcastable %[[SHAPE1]], %[[SHAPE2]]
+// CHECK:           %[[WITNESS:.*]] = shape.assuming_all %[[WITNESS01]], %[[WITNESS02]], %[[WITNESS12]]
+// CHECK:           %[[RET:.*]] = shape.assuming %[[WITNESS]] -> (tensor<?xf32>) {
+// CHECK:             %[[SHAPE01:.*]] = shape.broadcast %[[SHAPE0]], %[[SHAPE1]]
+// CHECK:             %[[RESULTSHAPE:.*]] = shape.broadcast %[[SHAPE01]], %[[SHAPE2]]
+// CHECK:             %[[BCAST0:.*]] = tcp.broadcast_to %[[ARG0]], %[[RESULTSHAPE]]
+// CHECK:             %[[BCAST1:.*]] = tcp.broadcast_to %[[ARG1]], %[[RESULTSHAPE]]
+// CHECK:             %[[BCAST2:.*]] = tcp.broadcast_to %[[ARG2]], %[[RESULTSHAPE]]
+// CHECK:             %[[SUB:.*]] = subf %[[BCAST0]], %[[BCAST1]]
+// CHECK:             %[[MUL:.*]] = mulf %[[SUB]], %[[BCAST2]]
+// CHECK:             %[[EXP:.*]] = math.exp %[[MUL]]
+// CHECK:             shape.assuming_yield %[[EXP]] : tensor<?xf32>
+// CHECK:           }
+// CHECK-NOT:       shape.assuming
+// CHECK:           return %[[RET]] : tensor<?xf32>
+// CHECK:         }
+func @dynamic_chain(%arg0: tensor<?xf32>, %arg1: tensor<?xf32>, %arg2: tensor<?xf32>) -> tensor<?xf32> {
+  %0 = tcf.sub %arg0, %arg1 : (tensor<?xf32>, tensor<?xf32>) -> tensor<?xf32>
+  %1 = tcf.mul %0, %arg2 : (tensor<?xf32>, tensor<?xf32>) -> tensor<?xf32>
+  %2 = tcf.exp %1 : tensor<?xf32>
+  return %2 : tensor<?xf32>
+}
+
+// An op whose result has several uses ends a chain, and an op applied to the
+// same value twice needs no broadcasting.
+// CHECK-LABEL:   func @dynamic_shared_result(
+// CHECK-SAME:            %[[LHS:.*]]: tensor<?xf32>,
+// CHECK-SAME:            %[[RHS:.*]]: tensor<?xf32>) -> tensor<?xf32> {
+// CHECK:           %[[ADD:.*]] = shape.assuming
+// CHECK:             addf
+// CHECK:           }
+// CHECK-NOT:       shape.assuming
+// CHECK:           %[[RET:.*]] = mulf %[[ADD]], %[[ADD]] : tensor<?xf32>
+// CHECK:           return %[[RET]] : tensor<?xf32>
+// CHECK:         }
+func @dynamic_shared_result(%arg0: tensor<?xf32>, %arg1: tensor<?xf32>) -> tensor<?xf32> {
+  %0 = tcf.add %arg0, %arg1 : (tensor<?xf32>, tensor<?xf32>) -> tensor<?xf32>
+  %1 = tcf.mul %0, %0 : (tensor<?xf32>, tensor<?xf32>) -> tensor<?xf32>
+  return %1 : tensor<?xf32>
+}
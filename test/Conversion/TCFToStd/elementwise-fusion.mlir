@@ -0,0 +1,40 @@
+// RUN: npcomp-opt <%s -convert-tcf-to-std -convert-elementwise-to-linalg -linalg-fusion-for-tensor-ops | FileCheck %s --dump-input=fail
+
+// A chain of statically shaped elementwise ops lowers without shape.assuming
+// regions, so that it fuses into a single loop with no intermediate tensors.
+// CHECK-LABEL: func @elementwise_chain
+// CHECK-NOT:     shape.assuming
+// CHECK:         linalg.generic
+// CHECK:           subf
+// CHECK:           mulf
+// CHECK:           math.exp
+// CHECK:           linalg.yield
+// CHECK-NOT:     linalg.generic
+// CHECK:         return
+func @elementwise_chain(%arg0: tensor<4x8xf32>, %arg1: tensor<4x8xf32>, %arg2: tensor<4x8xf32>) -> tensor<4x8xf32> {
+  %0 = tcf.sub %arg0, %arg1 : (tensor<4x8xf32>, tensor<4x8xf32>) -> tensor<4x8xf32>
+  %1 = tcf.mul %0, %arg2 : (tensor<4x8xf32>, tensor<4x8xf32>) -> tensor<4x8xf32>
+  %2 = tcf.exp %1 : tensor<4x8xf32>
+  return %2 : tensor<4x8xf32>
+}
+
+// A chain of dynamically shaped ops is checked once and computed in a single
+// shape.assuming region, inside which it fuses the same way.
+// CHECK-LABEL: func @dynamic_elementwise_chain
+// CHECK:         shape.assuming %
+// CHECK-COUNT-3:   tcp.broadcast_to
+// CHECK:           linalg.generic
+// CHECK:             subf
+// CHECK:             mulf
+// CHECK:             math.exp
+// CHECK:             linalg.yield
+// CHECK-NOT:       linalg.generic
+// CHECK:           shape.assuming_yield
+// CHECK-NOT:     shape.assuming
+// CHECK:         return
+func @dynamic_elementwise_chain(%arg0: tensor<?x?xf32>, %arg1: tensor<?x?xf32>, %arg2: tensor<?x?xf32>) -> tensor<?x?xf32> {
+  %0 = tcf.sub %arg0, %arg1 : (tensor<?x?xf32>, tensor<?x?xf32>) -> tensor<?x?xf32>
+  %1 = tcf.mul %0, %arg2 : (tensor<?x?xf32>, tensor<?x?xf32>) -> tensor<?x?xf32>
+  %2 = tcf.exp %1 : tensor<?x?xf32>
+  return %2 : tensor<?x?xf32>
+}
@@ -0,0 +1,7 @@
+// RUN: not npcomp-opt %s -aten-op-report='roofline=true peak-gflops=100 peak-bandwidth=10' 2>&1 | FileCheck %s
+
+// The report is of the function named "graph".
+// CHECK: OpReportPass failed: can't find a graph function
+func @not_graph(%arg0: tensor<4xf32>) -> tensor<4xf32> {
+  return %arg0 : tensor<4xf32>
+}
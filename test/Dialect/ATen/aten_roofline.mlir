@@ -0,0 +1,32 @@
+// RUN: npcomp-opt %s -aten-layer-name -aten-op-report='roofline=true peak-gflops=100 peak-bandwidth=10' |& FileCheck %s
+//   CHECK:             "layers": [
+//   CHECK-NEXT:          {
+//   CHECK-NEXT:            "arithmetic_intensity": 0.4699
+//   CHECK-NEXT:            "attainable_gflops": 4.699
+//   CHECK-NEXT:            "bound": "memory",
+//   CHECK-NEXT:            "bytes": 69760,
+//   CHECK-NEXT:            "estimated_time_us": 6.97{{[56]}}
+//   CHECK-NEXT:            "flops": 32784,
+//   CHECK-NEXT:            "layer": "L1-addmm-0",
+//   CHECK-NEXT:            "op": "aten.addmm",
+//   CHECK-NEXT:            "parameter_bytes": 65600,
+//   CHECK-NEXT:            "time_percent": 100
+//   CHECK-NEXT:          }
+//   CHECK-NEXT:        ],
+//   CHECK-NEXT:        "machine": {
+//   CHECK-NEXT:          "peak_bandwidth_gbps": 10,
+//   CHECK-NEXT:          "peak_gflops": 100,
+//   CHECK-NEXT:          "ridge_point": 10
+//   CHECK-NEXT:        },
+//   CHECK-NEXT:        "total_estimated_time_us": 6.97{{[56]}}
+//   CHECK-NEXT:        "unmodeled_layers": []
+
+module {
+  func @graph(%arg0: tensor<1x1024xf32>, %arg1: tensor<16x1024xf32>, %arg2: tensor<16xf32>) -> tensor<1x16xf32> {
+    %0 = "aten.t"(%arg1) : (tensor<16x1024xf32>) -> tensor<1024x16xf32>
+    %1 = "aten.constant"() {type = "i32", value = 1 : i32} : () -> i32
+    %2 = "aten.constant"() {type = "i32", value = 1 : i32} : () -> i32
+    %3 = "aten.addmm"(%arg2, %arg0, %0, %1, %2) : (tensor<16xf32>, tensor<1x1024xf32>, tensor<1024x16xf32>, i32, i32) -> tensor<1x16xf32>
+    "std.return"(%3) : (tensor<1x16xf32>) -> ()
+  }
+}
@@ -0,0 +1,89 @@
+// RUN: npcomp-opt %s -aten-fold-batch-norm -split-input-file | FileCheck %s
+
+// scale = bn_weight / sqrt(var + eps) = [0.5, 2]
+// shift = bn_bias - mean * scale = [-0.5, 1]
+// CHECK-LABEL: func @conv_batch_norm
+func @conv_batch_norm(%arg0: tensor<1x1x4x4xf32>) -> tensor<1x2x4x4xf32> {
+  // CHECK-DAG: %[[WEIGHT:.*]] = constant dense<{{\[\[\[\[}}1.000000e+00]]], {{\[\[\[}}6.000000e+00]]]]> : tensor<2x1x1x1xf32>
+  // CHECK-DAG: %[[BIAS:.*]] = constant dense<[0.000000e+00, 3.000000e+00]> : tensor<2xf32>
+  // CHECK: %[[CONV:.*]] = "aten.convolution"(%arg0, %[[WEIGHT]], %[[BIAS]],
+  // CHECK-NOT: aten.batch_norm
+  // CHECK: return %[[CONV]]
+  %w = constant dense<[[[[2.0]]], [[[3.0]]]]> : tensor<2x1x1x1xf32>
+  %wa = numpy.create_array_from_tensor %w : (tensor<2x1x1x1xf32>) -> !numpy.ndarray<[2,1,1,1]:f32>
+  %wt = numpy.copy_to_tensor %wa : (!numpy.ndarray<[2,1,1,1]:f32>) -> tensor<2x1x1x1xf32>
+  %b = constant dense<1.0> : tensor<2xf32>
+  %c0 = constant 0 : i64
+  %c1 = constant 1 : i64
+  %ones = basicpy.build_list %c1, %c1 : (i64, i64) -> !basicpy.ListType
+  %zeros = basicpy.build_list %c0, %c0 : (i64, i64) -> !basicpy.ListType
+  %false = constant false
+  %0 = "aten.convolution"(%arg0, %wt, %b, %ones, %zeros, %ones, %false, %zeros, %c1) : (tensor<1x1x4x4xf32>, tensor<2x1x1x1xf32>, tensor<2xf32>, !basicpy.ListType, !basicpy.ListType, !basicpy.ListType, i1, !basicpy.ListType, i64) -> tensor<1x2x4x4xf32>
+  %bn_w = constant dense<[1.0, 2.0]> : tensor<2xf32>
+  %bn_b = constant dense<[0.0, 1.0]> : tensor<2xf32>
+  %mean = constant dense<[1.0, 0.0]> : tensor<2xf32>
+  %var = constant dense<[3.0, 0.0]> : tensor<2xf32>
+  %momentum = constant 1.000000e-01 : f64
+  %eps = constant 1.000000e+00 : f64
+  %1:3 = "aten.batch_norm"(%0, %bn_w, %bn_b, %mean, %var, %false, %momentum, %eps, %false) : (tensor<1x2x4x4xf32>, tensor<2xf32>, tensor<2xf32>, tensor<2xf32>, tensor<2xf32>, i1, f64, f64, i1) -> (tensor<1x2x4x4xf32>, tensor<2xf32>, tensor<2xf32>)
+  return %1#0 : tensor<1x2x4x4xf32>
+}
+
+// -----
+// The nn.Linear weight is scaled along its rows (the output features).
+// scale = [1, 0.5], shift = [0, 0]
+// CHECK-LABEL: func @linear_batch_norm
+func @linear_batch_norm(%arg0: tensor<4x3xf32>) -> tensor<4x2xf32> {
+  // CHECK-DAG: %[[WEIGHT:.*]] = constant dense<{{\[\[}}1.000000e+00, 2.000000e+00, 3.000000e+00], [2.000000e+00, 2.500000e+00, 3.000000e+00]]> : tensor<2x3xf32>
+  // CHECK-DAG: %[[BIAS:.*]] = constant dense<1.000000e+00> : tensor<2xf32>
+  // CHECK: %[[T:.*]] = "aten.t"(%[[WEIGHT]])
+  // CHECK: %[[ADDMM:.*]] = "aten.addmm"(%[[BIAS]], %arg0, %[[T]],
+  // CHECK-NOT: aten.native_batch_norm
+  // CHECK: return %[[ADDMM]]
+  %w = constant dense<[[1.0, 2.0, 3.0], [4.0, 5.0, 6.0]]> : tensor<2x3xf32>
+  %b = constant dense<[1.0, 2.0]> : tensor<2xf32>
+  %c1 = constant 1 : i64
+  %0 = "aten.t"(%w) : (tensor<2x3xf32>) -> tensor<3x2xf32>
+  %1 = "aten.addmm"(%b, %arg0, %0, %c1, %c1) : (tensor<2xf32>, tensor<4x3xf32>, tensor<3x2xf32>, i64, i64) -> tensor<4x2xf32>
+  %none = basicpy.singleton : !basicpy.NoneType
+  %bn_w = constant dense<[2.0, 1.0]> : tensor<2xf32>
+  %mean = constant dense<0.0> : tensor<2xf32>
+  %var = constant dense<3.0> : tensor<2xf32>
+  %false = constant false
+  %momentum = constant 1.000000e-01 : f64
+  %eps = constant 1.000000e+00 : f64
+  %2:3 = "aten.native_batch_norm"(%1, %bn_w, %none, %mean, %var, %false, %momentum, %eps) : (tensor<4x2xf32>, tensor<2xf32>, !basicpy.NoneType, tensor<2xf32>, tensor<2xf32>, i1, f64, f64) -> (tensor<4x2xf32>, tensor<2xf32>, tensor<2xf32>)
+  return %2#0 : tensor<4x2xf32>
+}
+
+// -----
+// Training mode normalizes with batch statistics, which cannot be folded.
+// CHECK-LABEL: func @training_batch_norm
+func @training_batch_norm(%arg0: tensor<4x3xf32>, %arg1: tensor<3x2xf32>) -> tensor<4x2xf32> {
+  // CHECK: aten.native_batch_norm
+  %c = constant dense<1.0> : tensor<2xf32>
+  %c1 = constant 1 : i64
+  %true = constant true
+  %momentum = constant 1.000000e-01 : f64
+  %eps = constant 1.000000e-05 : f64
+  %w = constant dense<1.0> : tensor<3x2xf32>
+  %0 = "aten.addmm"(%c, %arg0, %w, %c1, %c1) : (tensor<2xf32>, tensor<4x3xf32>, tensor<3x2xf32>, i64, i64) -> tensor<4x2xf32>
+  %1:3 = "aten.native_batch_norm"(%0, %c, %c, %c, %c, %true, %momentum, %eps) : (tensor<4x2xf32>, tensor<2xf32>, tensor<2xf32>, tensor<2xf32>, tensor<2xf32>, i1, f64, f64) -> (tensor<4x2xf32>, tensor<2xf32>, tensor<2xf32>)
+  return %1#0 : tensor<4x2xf32>
+}
+
+// -----
+// The saved statistics have no replacement, so they must be unused.
+// CHECK-LABEL: func @saved_mean_used
+func @saved_mean_used(%arg0: tensor<4x3xf32>) -> (tensor<4x2xf32>, tensor<2xf32>) {
+  // CHECK: aten.native_batch_norm
+  %c = constant dense<1.0> : tensor<2xf32>
+  %c1 = constant 1 : i64
+  %false = constant false
+  %momentum = constant 1.000000e-01 : f64
+  %eps = constant 1.000000e-05 : f64
+  %w = constant dense<1.0> : tensor<3x2xf32>
+  %0 = "aten.addmm"(%c, %arg0, %w, %c1, %c1) : (tensor<2xf32>, tensor<4x3xf32>, tensor<3x2xf32>, i64, i64) -> tensor<4x2xf32>
+  %1:3 = "aten.native_batch_norm"(%0, %c, %c, %c, %c, %false, %momentum, %eps) : (tensor<4x2xf32>, tensor<2xf32>, tensor<2xf32>, tensor<2xf32>, tensor<2xf32>, i1, f64, f64) -> (tensor<4x2xf32>, tensor<2xf32>, tensor<2xf32>)
+  return %1#0, %1#1 : tensor<4x2xf32>, tensor<2xf32>
+}
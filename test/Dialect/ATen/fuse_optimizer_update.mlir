@@ -0,0 +1,60 @@
+// RUN: npcomp-opt %s -aten-fuse-optimizer-update -split-input-file | FileCheck %s
+
+// The scaling of the gradient folds into the learning rate:
+// alpha = -0.1 * 0.5.
+// CHECK-LABEL: func @sgd_mm
+func @sgd_mm(%arg0: tensor<8x4xf32>, %arg1: tensor<4x16xf32>, %arg2: tensor<8x16xf32>) -> tensor<8x16xf32> {
+  // CHECK: %[[ALPHA:.*]] = constant -5.000000e-02 : f32
+  // CHECK: %[[UPDATE:.*]] = "aten.mm_update"(%arg2, %arg0, %arg1, %[[ALPHA]])
+  // CHECK-NOT: aten.mm"
+  // CHECK-NOT: aten.mul_
+  // CHECK-NOT: aten.add_
+  // CHECK: return %[[UPDATE]]
+  %0 = "aten.mm"(%arg0, %arg1) : (tensor<8x4xf32>, tensor<4x16xf32>) -> tensor<8x16xf32>
+  %scale = constant dense<5.000000e-01> : tensor<f32>
+  %1 = "aten.mul_"(%0, %scale) : (tensor<8x16xf32>, tensor<f32>) -> tensor<8x16xf32>
+  %lr = constant -1.000000e-01 : f64
+  %2 = "aten.add_"(%arg2, %1, %lr) : (tensor<8x16xf32>, tensor<8x16xf32>, f64) -> tensor<8x16xf32>
+  return %2 : tensor<8x16xf32>
+}
+
+// -----
+// The other results of convolution_backward are taken from the fused op.
+// CHECK-LABEL: func @sgd_convolution_backward
+func @sgd_convolution_backward(%arg0: tensor<3x4x8x8xf32>, %arg1: tensor<3x16x10x10xf32>, %arg2: tensor<4x16x3x3xf32>, %arg3: !basicpy.ListType, %arg4: !basicpy.ListType, %arg5: i1, %arg6: i64, %arg7: !basicpy.ListType) -> (tensor<3x16x10x10xf32>, tensor<4x16x3x3xf32>, tensor<4xf32>) {
+  // CHECK: %[[ALPHA:.*]] = constant -1.000000e-02 : f32
+  // CHECK: %[[FUSED:.*]]:3 = "aten.convolution_backward_update"(%arg0, %arg1, %arg2, %arg3, %arg4, %arg3, %arg5, %arg4, %arg6, %arg7, %arg2, %[[ALPHA]])
+  // CHECK-NOT: aten.add_
+  // CHECK: return %[[FUSED]]#0, %[[FUSED]]#1, %[[FUSED]]#2
+  %0:3 = "aten.convolution_backward"(%arg0, %arg1, %arg2, %arg3, %arg4, %arg3, %arg5, %arg4, %arg6, %arg7) : (tensor<3x4x8x8xf32>, tensor<3x16x10x10xf32>, tensor<4x16x3x3xf32>, !basicpy.ListType, !basicpy.ListType, !basicpy.ListType, i1, !basicpy.ListType, i64, !basicpy.ListType) -> (tensor<3x16x10x10xf32>, tensor<4x16x3x3xf32>, tensor<4xf32>)
+  %lr = constant -1.000000e-02 : f64
+  %1 = "aten.add_"(%arg2, %0#1, %lr) : (tensor<4x16x3x3xf32>, tensor<4x16x3x3xf32>, f64) -> tensor<4x16x3x3xf32>
+  return %0#0, %1, %0#2 : tensor<3x16x10x10xf32>, tensor<4x16x3x3xf32>, tensor<4xf32>
+}
+
+// -----
+// A gradient that is also returned must be materialized anyway.
+// CHECK-LABEL: func @gradient_used_twice
+func @gradient_used_twice(%arg0: tensor<8x4xf32>, %arg1: tensor<4x16xf32>, %arg2: tensor<8x16xf32>) -> (tensor<8x16xf32>, tensor<8x16xf32>) {
+  // CHECK: "aten.mm"
+  // CHECK: "aten.add_"
+  // CHECK-NOT: aten.mm_update
+  %0 = "aten.mm"(%arg0, %arg1) : (tensor<8x4xf32>, tensor<4x16xf32>) -> tensor<8x16xf32>
+  %lr = constant -1.000000e-01 : f64
+  %1 = "aten.add_"(%arg2, %0, %lr) : (tensor<8x16xf32>, tensor<8x16xf32>, f64) -> tensor<8x16xf32>
+  return %0, %1 : tensor<8x16xf32>, tensor<8x16xf32>
+}
+
+// -----
+// Likewise for the weight gradient of convolution_backward, which the fused
+// op does not produce.
+// CHECK-LABEL: func @weight_gradient_used_twice
+func @weight_gradient_used_twice(%arg0: tensor<3x4x8x8xf32>, %arg1: tensor<3x16x10x10xf32>, %arg2: tensor<4x16x3x3xf32>, %arg3: !basicpy.ListType, %arg4: !basicpy.ListType, %arg5: i1, %arg6: i64, %arg7: !basicpy.ListType) -> (tensor<4x16x3x3xf32>, tensor<4x16x3x3xf32>) {
+  // CHECK: "aten.convolution_backward"
+  // CHECK: "aten.add_"
+  // CHECK-NOT: aten.convolution_backward_update
+  %0:3 = "aten.convolution_backward"(%arg0, %arg1, %arg2, %arg3, %arg4, %arg3, %arg5, %arg4, %arg6, %arg7) : (tensor<3x4x8x8xf32>, tensor<3x16x10x10xf32>, tensor<4x16x3x3xf32>, !basicpy.ListType, !basicpy.ListType, !basicpy.ListType, i1, !basicpy.ListType, i64, !basicpy.ListType) -> (tensor<3x16x10x10xf32>, tensor<4x16x3x3xf32>, tensor<4xf32>)
+  %lr = constant -1.000000e-02 : f64
+  %1 = "aten.add_"(%arg2, %0#1, %lr) : (tensor<4x16x3x3xf32>, tensor<4x16x3x3xf32>, f64) -> tensor<4x16x3x3xf32>
+  return %0#1, %1 : tensor<4x16x3x3xf32>, tensor<4x16x3x3xf32>
+}
@@ -0,0 +1,66 @@
+// RUN: npcomp-opt %s -aten-to-std |& FileCheck %s
+// Checks the calling convention used for the functions implemented by
+// lib/RefBackend/ATenKernels.
+
+// Memref operands are passed with erased shapes and fully dynamic strided
+// layouts, so that views (here the transpose) are passed without copying.
+// CHECK-LABEL: func @addmm
+func @addmm(%arg0: tensor<1x1024xf32>, %arg1: tensor<16x1024xf32>, %arg2: tensor<16xf32>) -> tensor<1x16xf32> {
+  // CHECK: %[[T:.*]] = memref_reinterpret_cast %arg1 to offset: [0], sizes: [1024, 16], strides: [1, 1024]
+  // CHECK-NOT: call @t_
+  %0 = "aten.t"(%arg1) : (tensor<16x1024xf32>) -> tensor<1024x16xf32>
+  %1 = "aten.constant"() {type = "i64", value = 1 : i64} : () -> i64
+  %2 = "aten.constant"() {type = "i64", value = 1 : i64} : () -> i64
+  // CHECK: memref_cast %[[T]] : memref<1024x16xf32, #map{{[0-9]*}}> to memref<?x?xf32, #map{{[0-9]*}}>
+  // CHECK: %[[BETA:.*]] = sitofp %{{.*}} : i64 to f32
+  // CHECK: %[[ALPHA:.*]] = sitofp %{{.*}} : i64 to f32
+  // CHECK: call @addmm_2F32_1F32_2F32_2F32_out(%{{.*}}, %{{.*}}, %{{.*}}, %[[BETA]], %[[ALPHA]], %{{.*}}) : (memref<?xf32, #map{{[0-9]*}}>, memref<?x?xf32, #map{{[0-9]*}}>, memref<?x?xf32, #map{{[0-9]*}}>, f32, f32, memref<?x?xf32, #map{{[0-9]*}}>) -> ()
+  %3 = "aten.addmm"(%arg2, %arg0, %0, %1, %2) : (tensor<16xf32>, tensor<1x1024xf32>, tensor<1024x16xf32>, i64, i64) -> tensor<1x16xf32>
+  return %3 : tensor<1x16xf32>
+}
+
+// An absent optional operand is left out of both the call and the name.
+// CHECK-LABEL: func @nll_loss_unweighted
+func @nll_loss_unweighted(%arg0: tensor<2x3xf32>, %arg1: tensor<2xi64>, %arg2: !basicpy.NoneType) -> tensor<f32> {
+  %0 = "aten.constant"() {type = "i64", value = 1 : i64} : () -> i64
+  %1 = "aten.constant"() {type = "i64", value = -100 : i64} : () -> i64
+  // CHECK: call @nll_loss_forward_0F32_0F32_2F32_1I64_out(%{{.*}}, %{{.*}}, %{{.*}}, %{{.*}}, %{{.*}}, %{{.*}}) : (memref<?x?xf32, #map{{[0-9]*}}>, memref<?xi64, #map{{[0-9]*}}>, i32, i32, memref<f32, #map{{[0-9]*}}>, memref<f32, #map{{[0-9]*}}>) -> ()
+  %2:2 = "aten.nll_loss_forward"(%arg0, %arg1, %arg2, %0, %1) : (tensor<2x3xf32>, tensor<2xi64>, !basicpy.NoneType, i64, i64) -> (tensor<f32>, tensor<f32>)
+  return %2#0 : tensor<f32>
+}
+
+// The learning rate of a fused update is passed as f32.
+// CHECK-LABEL: func @mm_update
+func @mm_update(%arg0: tensor<8x16xf32>, %arg1: tensor<8x4xf32>, %arg2: tensor<4x16xf32>) -> tensor<8x16xf32> {
+  %alpha = constant -1.000000e-01 : f32
+  // CHECK: call @mm_update_2F32_2F32_2F32_2F32_out(%{{.*}}, %{{.*}}, %{{.*}}, %{{.*}}, %{{.*}}) : (memref<?x?xf32, #map{{[0-9]*}}>, memref<?x?xf32, #map{{[0-9]*}}>, memref<?x?xf32, #map{{[0-9]*}}>, f32, memref<?x?xf32, #map{{[0-9]*}}>) -> ()
+  %0 = "aten.mm_update"(%arg0, %arg1, %arg2, %alpha) : (tensor<8x16xf32>, tensor<8x4xf32>, tensor<4x16xf32>, f32) -> tensor<8x16xf32>
+  return %0 : tensor<8x16xf32>
+}
+
+// Weights packed by -aten-prepack-weights are flat buffers.
+// CHECK-LABEL: func @mm_prepacked
+func @mm_prepacked(%arg0: tensor<8x4xf32>, %arg1: tensor<64xf32>) -> tensor<8x16xf32> {
+  // CHECK: call @mm_prepacked_2F32_2F32_1F32_out(%{{.*}}, %{{.*}}, %{{.*}}) : (memref<?x?xf32, #map{{[0-9]*}}>, memref<?xf32, #map{{[0-9]*}}>, memref<?x?xf32, #map{{[0-9]*}}>) -> ()
+  %0 = "aten.mm_prepacked"(%arg0, %arg1) : (tensor<8x4xf32>, tensor<64xf32>) -> tensor<8x16xf32>
+  return %0 : tensor<8x16xf32>
+}
+
+// ATen Scalars are passed as f32 whatever type they were imported with, so
+// that all callers agree with the single C signature of a mangled name.
+// CHECK-LABEL: func @threshold_backward
+func @threshold_backward(%arg0: tensor<2x3xf32>, %arg1: tensor<2x3xf32>) -> (tensor<2x3xf32>, tensor<2x3xf32>) {
+  // CHECK: %[[FLOAT:.*]] = fptrunc %{{.*}} : f64 to f32
+  // CHECK: call @threshold_backward_2F32_2F32_2F32_out(%{{.*}}, %{{.*}}, %[[FLOAT]], %{{.*}})
+  // CHECK: %[[INT:.*]] = sitofp %{{.*}} : i64 to f32
+  // CHECK: call @threshold_backward_2F32_2F32_2F32_out(%{{.*}}, %{{.*}}, %[[INT]], %{{.*}})
+  %0 = constant 5.000000e-01 : f64
+  %1 = constant 0 : i64
+  %2 = "aten.threshold_backward"(%arg0, %arg1, %0) : (tensor<2x3xf32>, tensor<2x3xf32>, f64) -> tensor<2x3xf32>
+  %3 = "aten.threshold_backward"(%arg0, %arg1, %1) : (tensor<2x3xf32>, tensor<2x3xf32>, i64) -> tensor<2x3xf32>
+  return %2, %3 : tensor<2x3xf32>, tensor<2x3xf32>
+}
+
+// CHECK: func private @addmm_2F32_1F32_2F32_2F32_out(memref<?xf32, #map{{[0-9]*}}>, memref<?x?xf32, #map{{[0-9]*}}>, memref<?x?xf32, #map{{[0-9]*}}>, f32, f32, memref<?x?xf32, #map{{[0-9]*}}>) attributes {llvm.emit_c_interface}
+// CHECK: func private @nll_loss_forward_0F32_0F32_2F32_1I64_out(memref<?x?xf32, #map{{[0-9]*}}>, memref<?xi64, #map{{[0-9]*}}>, i32, i32, memref<f32, #map{{[0-9]*}}>, memref<f32, #map{{[0-9]*}}>) attributes {llvm.emit_c_interface}
+// CHECK: func private @threshold_backward_2F32_2F32_2F32_out(memref<?x?xf32, #map{{[0-9]*}}>, memref<?x?xf32, #map{{[0-9]*}}>, f32, memref<?x?xf32, #map{{[0-9]*}}>) attributes {llvm.emit_c_interface}
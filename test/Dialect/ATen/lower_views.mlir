@@ -0,0 +1,96 @@
+// RUN: npcomp-opt %s -aten-to-std |& FileCheck %s
+// View ops are lowered to views of their operand's buffer rather than to
+// library calls that copy.
+
+// CHECK-LABEL: func @view
+func @view(%arg0: tensor<2x3x4xf32>, %arg1: tensor<4x5xf32>) -> tensor<6x5xf32> {
+  // CHECK-NOT: call @view
+  // CHECK: %[[VIEW:.*]] = memref_reinterpret_cast %arg0 to offset: [0], sizes: [6, 4], strides: [4, 1] : memref<2x3x4xf32> to memref<6x4xf32>
+  // CHECK: memref_cast %[[VIEW]]
+  // CHECK: call @mm_2F32_2F32_2F32_out
+  %0 = "aten.constant"() {type = "List[i32]", value = dense<[6, 4]> : vector<2xi32>} : () -> !aten.list<i32>
+  %1 = "aten.view"(%arg0, %0) : (tensor<2x3x4xf32>, !aten.list<i32>) -> tensor<6x4xf32>
+  %2 = "aten.mm"(%1, %arg1) : (tensor<6x4xf32>, tensor<4x5xf32>) -> tensor<6x5xf32>
+  return %2 : tensor<6x5xf32>
+}
+
+// CHECK-LABEL: func @flatten
+func @flatten(%arg0: tensor<2x3x4x5xf32>, %arg1: tensor<60x7xf32>) -> tensor<2x7xf32> {
+  // CHECK: memref_reinterpret_cast %arg0 to offset: [0], sizes: [2, 60], strides: [60, 1] : memref<2x3x4x5xf32> to memref<2x60xf32>
+  %0 = "aten.constant"() {type = "i64", value = 1 : i64} : () -> i64
+  %1 = "aten.constant"() {type = "i64", value = -1 : i64} : () -> i64
+  %2 = "aten.flatten"(%arg0, %0, %1) : (tensor<2x3x4x5xf32>, i64, i64) -> tensor<2x60xf32>
+  %3 = "aten.mm"(%2, %arg1) : (tensor<2x60xf32>, tensor<60x7xf32>) -> tensor<2x7xf32>
+  return %3 : tensor<2x7xf32>
+}
+
+// Broadcast dimensions get a stride of zero.
+// CHECK-LABEL: func @expand
+func @expand(%arg0: tensor<3x1xf32>, %arg1: tensor<2x3x4xf32>) -> tensor<2x3x4xf32> {
+  // CHECK: memref_reinterpret_cast %arg0 to offset: [0], sizes: [2, 3, 4], strides: [0, 1, 0] : memref<3x1xf32> to memref<2x3x4xf32, #map{{[0-9]*}}>
+  // CHECK: call @add_3F32_3F32_3F32_out
+  %0 = "aten.constant"() {type = "List[i32]", value = dense<[2, 3, 4]> : vector<3xi32>} : () -> !aten.list<i32>
+  %1 = "aten.constant"() {type = "bool", value = false} : () -> i1
+  %2 = "aten.expand"(%arg0, %0, %1) : (tensor<3x1xf32>, !aten.list<i32>, i1) -> tensor<2x3x4xf32>
+  %3 = "aten.constant"() {type = "i64", value = 1 : i64} : () -> i64
+  %4 = "aten.add"(%arg1, %2, %3) : (tensor<2x3x4xf32>, tensor<2x3x4xf32>, i64) -> tensor<2x3x4xf32>
+  return %4 : tensor<2x3x4xf32>
+}
+
+// Views compose, and unit dimensions can be inserted into or removed from
+// any strided view.
+// CHECK-LABEL: func @transpose_unsqueeze_squeeze
+func @transpose_unsqueeze_squeeze(%arg0: tensor<2x3xf32>) -> tensor<3x2xf32> {
+  // CHECK: %[[T:.*]] = memref_reinterpret_cast %arg0 to offset: [0], sizes: [3, 2], strides: [1, 3]
+  // CHECK: %[[U:.*]] = memref_reinterpret_cast %[[T]] to offset: [0], sizes: [3, 1, 2], strides: [1, 6, 3]
+  // CHECK: %[[S:.*]] = memref_reinterpret_cast %[[U]] to offset: [0], sizes: [3, 2], strides: [1, 3]
+  // CHECK: memref_cast %[[S]]
+  // CHECK: call @relu_2F32_2F32_out
+  %0 = "aten.t"(%arg0) : (tensor<2x3xf32>) -> tensor<3x2xf32>
+  %1 = "aten.constant"() {type = "i64", value = 1 : i64} : () -> i64
+  %2 = "aten.unsqueeze"(%0, %1) : (tensor<3x2xf32>, i64) -> tensor<3x1x2xf32>
+  %3 = "aten.squeeze"(%2, %1) : (tensor<3x1x2xf32>, i64) -> tensor<3x2xf32>
+  %4 = "aten.relu"(%3) : (tensor<3x2xf32>) -> tensor<3x2xf32>
+  return %4 : tensor<3x2xf32>
+}
+
+// Reshaping a transpose needs a contiguous copy first.
+// CHECK-LABEL: func @view_of_transpose
+func @view_of_transpose(%arg0: tensor<2x3xf32>, %arg1: tensor<6xf32>) -> tensor<6xf32> {
+  // CHECK: %[[T:.*]] = memref_reinterpret_cast %arg0 to offset: [0], sizes: [3, 2], strides: [1, 3]
+  // CHECK: %[[COPY:.*]] = alloc() : memref<3x2xf32>
+  // CHECK: scf.for
+  // CHECK: scf.for
+  // CHECK: %[[ELT:.*]] = load %[[T]]
+  // CHECK: store %[[ELT]], %[[COPY]]
+  // CHECK: memref_reinterpret_cast %[[COPY]] to offset: [0], sizes: [6], strides: [1] : memref<3x2xf32> to memref<6xf32>
+  %0 = "aten.t"(%arg0) : (tensor<2x3xf32>) -> tensor<3x2xf32>
+  %1 = "aten.constant"() {type = "List[i32]", value = dense<6> : vector<1xi32>} : () -> !aten.list<i32>
+  %2 = "aten.view"(%0, %1) : (tensor<3x2xf32>, !aten.list<i32>) -> tensor<6xf32>
+  %3 = "aten.constant"() {type = "i64", value = 1 : i64} : () -> i64
+  %4 = "aten.add"(%arg1, %2, %3) : (tensor<6xf32>, tensor<6xf32>, i64) -> tensor<6xf32>
+  return %4 : tensor<6xf32>
+}
+
+// A view that is returned is materialized into a fresh buffer.
+// CHECK-LABEL: func @escaping_view
+func @escaping_view(%arg0: tensor<2x3xf32>) -> tensor<3x2xf32> {
+  // CHECK: %[[T:.*]] = memref_reinterpret_cast %arg0
+  // CHECK: %[[COPY:.*]] = alloc() : memref<3x2xf32>
+  // CHECK: scf.for
+  // CHECK: return %[[COPY]] : memref<3x2xf32>
+  %0 = "aten.t"(%arg0) : (tensor<2x3xf32>) -> tensor<3x2xf32>
+  return %0 : tensor<3x2xf32>
+}
+
+// as_strided strides and offsets are relative to the underlying buffer.
+// CHECK-LABEL: func @as_strided
+func @as_strided(%arg0: tensor<4x4xf32>, %arg1: tensor<2x2xf32>) -> tensor<2x2xf32> {
+  // CHECK: memref_reinterpret_cast %arg0 to offset: [5], sizes: [2, 2], strides: [4, 1] : memref<4x4xf32> to memref<2x2xf32, #map{{[0-9]*}}>
+  %0 = "aten.constant"() {type = "List[i32]", value = dense<2> : vector<2xi32>} : () -> !aten.list<i32>
+  %1 = "aten.constant"() {type = "List[i32]", value = dense<[4, 1]> : vector<2xi32>} : () -> !aten.list<i32>
+  %2 = "aten.constant"() {type = "i64", value = 5 : i64} : () -> i64
+  %3 = "aten.as_strided"(%arg0, %0, %1, %2) : (tensor<4x4xf32>, !aten.list<i32>, !aten.list<i32>, i64) -> tensor<2x2xf32>
+  %4 = "aten.relu"(%3) : (tensor<2x2xf32>) -> tensor<2x2xf32>
+  return %4 : tensor<2x2xf32>
+}
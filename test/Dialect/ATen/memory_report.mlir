@@ -0,0 +1,58 @@
+// RUN: npcomp-opt %s -aten-layer-name -aten-memory-report |& FileCheck %s
+
+// Intermediates whose live ranges don't overlap share buffers. The view made
+// by aten.t keeps L3-relu-1 alive until L5-mm-2, and L5-mm-2 then grows the
+// buffer it reuses. The returned L6-mm-3 is not planned.
+// CHECK:      "arena_bytes": 384,
+// CHECK-NEXT: "buffers": [
+// CHECK-NEXT:   {
+// CHECK-NEXT:     "bytes": 256,
+// CHECK-NEXT:     "offset": 0,
+// CHECK-NEXT:     "values": [
+// CHECK-NEXT:       "L0-mm-0",
+// CHECK-NEXT:       "L2-mm-1",
+// CHECK-NEXT:       "L5-mm-2"
+// CHECK-NEXT:     ]
+// CHECK-NEXT:   },
+// CHECK-NEXT:   {
+// CHECK-NEXT:     "bytes": 128,
+// CHECK-NEXT:     "offset": 256,
+// CHECK-NEXT:     "values": [
+// CHECK-NEXT:       "L1-relu-0",
+// CHECK-NEXT:       "L3-relu-1"
+// CHECK-NEXT:     ]
+// CHECK-NEXT:   }
+// CHECK-NEXT: ],
+// CHECK-NEXT: "dynamic_values": 0,
+// CHECK-NEXT: "live_bytes": [
+// CHECK-NEXT:   {
+// CHECK-NEXT:     "layer": "L0-mm-0",
+// CHECK-NEXT:     "live_bytes": 512
+// CHECK:          "layer": "L1-relu-0",
+// CHECK-NEXT:     "live_bytes": 640
+// CHECK:          "layer": "L2-mm-1",
+// CHECK-NEXT:     "live_bytes": 640
+// CHECK:          "layer": "L3-relu-1",
+// CHECK-NEXT:     "live_bytes": 384
+// CHECK:          "layer": "L4-t-0",
+// CHECK-NEXT:     "live_bytes": 256
+// CHECK:          "layer": "L5-mm-2",
+// CHECK-NEXT:     "live_bytes": 512
+// CHECK:          "layer": "L6-mm-3",
+// CHECK-NEXT:     "live_bytes": 512
+// CHECK:      "peak_bytes": 640,
+// CHECK-NEXT: "peak_layer": "L1-relu-0",
+// CHECK-NEXT: "reused_bytes": 384
+
+module {
+  func @graph(%arg0: tensor<4x8xf32>, %arg1: tensor<8x8xf32>) -> tensor<4x8xf32> {
+    %0 = "aten.mm"(%arg0, %arg1) : (tensor<4x8xf32>, tensor<8x8xf32>) -> tensor<4x8xf32>
+    %1 = "aten.relu"(%0) : (tensor<4x8xf32>) -> tensor<4x8xf32>
+    %2 = "aten.mm"(%1, %arg1) : (tensor<4x8xf32>, tensor<8x8xf32>) -> tensor<4x8xf32>
+    %3 = "aten.relu"(%2) : (tensor<4x8xf32>) -> tensor<4x8xf32>
+    %4 = "aten.t"(%3) : (tensor<4x8xf32>) -> tensor<8x4xf32>
+    %5 = "aten.mm"(%4, %arg0) : (tensor<8x4xf32>, tensor<4x8xf32>) -> tensor<8x8xf32>
+    %6 = "aten.mm"(%arg0, %5) : (tensor<4x8xf32>, tensor<8x8xf32>) -> tensor<4x8xf32>
+    "std.return"(%6) : (tensor<4x8xf32>) -> ()
+  }
+}
@@ -0,0 +1,37 @@
+// RUN: npcomp-opt -split-input-file %s -verify-diagnostics -allow-unregistered-dialect -aten-memory-schedule='report=true' | FileCheck --dump-input=fail %s
+
+// Each 64x64 tensor is reduced as soon as it is computed, rather than both
+// being live at once.
+// CHECK-LABEL: func @branches
+// CHECK: %[[ADD:.+]] = tcf.add %arg0, %arg1
+// CHECK: %[[SUM0:.+]] = tcf.sum %[[ADD]]
+// CHECK: %[[MUL:.+]] = tcf.mul %arg0, %arg1
+// CHECK: %[[SUM1:.+]] = tcf.sum %[[MUL]]
+// CHECK: %[[RESULT:.+]] = tcf.add %[[SUM0]], %[[SUM1]]
+// CHECK: return %[[RESULT]]
+// expected-remark @+1 {{peak live tensor bytes: 33280 -> 17152}}
+func @branches(%arg0: tensor<64x1xf32>, %arg1: tensor<1x64xf32>) -> tensor<64xf32> {
+  %0 = tcf.add %arg0, %arg1 : (tensor<64x1xf32>, tensor<1x64xf32>) -> tensor<64x64xf32>
+  %1 = tcf.mul %arg0, %arg1 : (tensor<64x1xf32>, tensor<1x64xf32>) -> tensor<64x64xf32>
+  %2 = tcf.sum %0 {axes = [1]} : (tensor<64x64xf32>) -> tensor<64xf32>
+  %3 = tcf.sum %1 {axes = [1]} : (tensor<64x64xf32>) -> tensor<64xf32>
+  %4 = tcf.add %2, %3 : (tensor<64xf32>, tensor<64xf32>) -> tensor<64xf32>
+  return %4 : tensor<64xf32>
+}
+
+// -----
+
+// Ops with side effects keep their order, so both tensors must be live.
+// CHECK-LABEL: func @side_effects
+// CHECK: %[[ADD:.+]] = tcf.add %arg0, %arg1
+// CHECK: %[[MUL:.+]] = tcf.mul %arg0, %arg1
+// CHECK: "test.use"(%[[MUL]])
+// CHECK: "test.use"(%[[ADD]])
+// expected-remark @+1 {{peak live tensor bytes: 33280 -> 33280}}
+func @side_effects(%arg0: tensor<64x1xf32>, %arg1: tensor<1x64xf32>) {
+  %0 = tcf.add %arg0, %arg1 : (tensor<64x1xf32>, tensor<1x64xf32>) -> tensor<64x64xf32>
+  %1 = tcf.mul %arg0, %arg1 : (tensor<64x1xf32>, tensor<1x64xf32>) -> tensor<64x64xf32>
+  "test.use"(%1) : (tensor<64x64xf32>) -> ()
+  "test.use"(%0) : (tensor<64x64xf32>) -> ()
+  return
+}
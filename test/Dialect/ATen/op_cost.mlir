@@ -0,0 +1,70 @@
+// RUN: npcomp-opt %s -aten-op-report='roofline=true peak-gflops=100 peak-bandwidth=10' |& FileCheck %s
+// Checks the cost model on TCF and linalg ops through the roofline report,
+// which lists layers by decreasing estimated time.
+
+// The output tensor of the linalg matmul is read as its accumulator.
+// CHECK:           "bytes": 1152,
+// CHECK:           "flops": 1024,
+// CHECK:           "op": "linalg.matmul",
+// CHECK-NEXT:      "parameter_bytes": 0,
+
+// CHECK:           "bytes": 896,
+// CHECK:           "flops": 1024,
+// CHECK:           "op": "tcf.matmul",
+// CHECK-NEXT:      "parameter_bytes": 512,
+
+// A product of activations reads no parameters.
+// CHECK:           "bytes": 896,
+// CHECK:           "flops": 1024,
+// CHECK:           "op": "tcf.matmul",
+// CHECK-NEXT:      "parameter_bytes": 0,
+
+// CHECK:           "bytes": 768,
+// CHECK:           "flops": 64,
+// CHECK:           "op": "tcf.add",
+
+// Layers of equal time keep their order.
+// CHECK:           "bytes": 768,
+// CHECK:           "flops": 64,
+// CHECK:           "op": "tcf.sub",
+// CHECK:           "bytes": 768,
+// CHECK:           "flops": 64,
+// CHECK:           "op": "tcf.div",
+// CHECK:           "bytes": 768,
+// CHECK:           "flops": 64,
+// CHECK:           "op": "tcf.min",
+
+// The i1 result is one byte per element.
+// CHECK:           "bytes": 576,
+// CHECK:           "flops": 64,
+// CHECK:           "op": "tcf.compare",
+
+// CHECK:           "bytes": 512,
+// CHECK:           "flops": 64,
+// CHECK:           "op": "tcf.log",
+// CHECK:           "bytes": 512,
+// CHECK:           "flops": 64,
+// CHECK:           "op": "tcf.sqrt",
+
+// Dynamic shapes can't be costed.
+// CHECK:         "unmodeled_layers": [
+// CHECK-NEXT:      "unknown-layer-{{[0-9]+}}"
+// CHECK-NEXT:    ]
+
+module {
+  func @graph(%arg0: tensor<4x8xf32>, %arg1: tensor<8x16xf32>, %arg2: tensor<4x16xf32>, %arg3: tensor<?xf32>) -> (tensor<4x16xf32>, tensor<?xf32>) {
+    %cst = constant dense<1.0> : tensor<8x16xf32>
+    %0 = tcf.matmul %arg0, %cst : (tensor<4x8xf32>, tensor<8x16xf32>) -> tensor<4x16xf32>
+    %1 = linalg.matmul ins(%arg0, %arg1 : tensor<4x8xf32>, tensor<8x16xf32>) outs(%arg2 : tensor<4x16xf32>) -> tensor<4x16xf32>
+    %2 = tcf.add %0, %1 : (tensor<4x16xf32>, tensor<4x16xf32>) -> tensor<4x16xf32>
+    %3 = tcf.exp %arg3 : tensor<?xf32>
+    %4 = tcf.sub %0, %1 : (tensor<4x16xf32>, tensor<4x16xf32>) -> tensor<4x16xf32>
+    %5 = tcf.div %0, %1 : (tensor<4x16xf32>, tensor<4x16xf32>) -> tensor<4x16xf32>
+    %6 = tcf.min %0, %1 : (tensor<4x16xf32>, tensor<4x16xf32>) -> tensor<4x16xf32>
+    %7 = tcf.compare "lt", %0, %1 : (tensor<4x16xf32>, tensor<4x16xf32>) -> tensor<4x16xi1>
+    %8 = tcf.log %0 : tensor<4x16xf32>
+    %9 = tcf.sqrt %0 : tensor<4x16xf32>
+    %10 = tcf.matmul %arg0, %arg1 : (tensor<4x8xf32>, tensor<8x16xf32>) -> tensor<4x16xf32>
+    return %2, %3 : tensor<4x16xf32>, tensor<?xf32>
+  }
+}
@@ -0,0 +1,56 @@
+// RUN: npcomp-opt %s -aten-prepack-weights -split-input-file | FileCheck %s
+// RUN: npcomp-opt %s -aten-prepack-weights=gemm-panels -split-input-file | FileCheck %s --check-prefix=PANELS
+
+// The nn.Linear weight is stored transposed.
+// CHECK-LABEL: func @linear
+func @linear(%arg0: tensor<4x3xf32>) -> tensor<4x2xf32> {
+  // CHECK: %[[WEIGHT:.*]] = constant dense<{{\[\[}}1.000000e+00, 4.000000e+00], [2.000000e+00, 5.000000e+00], [3.000000e+00, 6.000000e+00]]> : tensor<3x2xf32>
+  // CHECK-NOT: aten.t
+  // CHECK: "aten.mm"(%arg0, %[[WEIGHT]])
+  // The [3, 2] weight is a single NR-wide panel, k-major, zero padded.
+  // PANELS: %[[PACKED:.*]] = constant dense<[1.000000e+00, 4.000000e+00, 0.000000e+00, {{.*}}, 2.000000e+00, 5.000000e+00, 0.000000e+00, {{.*}}, 3.000000e+00, 6.000000e+00, 0.000000e+00, {{.*}}]> : tensor<48xf32>
+  // PANELS: "aten.mm_prepacked"(%arg0, %[[PACKED]]) : (tensor<4x3xf32>, tensor<48xf32>) -> tensor<4x2xf32>
+  %w = constant dense<[[1.0, 2.0, 3.0], [4.0, 5.0, 6.0]]> : tensor<2x3xf32>
+  %wa = numpy.create_array_from_tensor %w : (tensor<2x3xf32>) -> !numpy.ndarray<[2,3]:f32>
+  %wt = numpy.copy_to_tensor %wa : (!numpy.ndarray<[2,3]:f32>) -> tensor<2x3xf32>
+  %0 = "aten.t"(%wt) : (tensor<2x3xf32>) -> tensor<3x2xf32>
+  %1 = "aten.mm"(%arg0, %0) : (tensor<4x3xf32>, tensor<3x2xf32>) -> tensor<4x2xf32>
+  return %1 : tensor<4x2xf32>
+}
+
+// -----
+
+// Transposes of activations are left alone.
+// CHECK-LABEL: func @activation
+func @activation(%arg0: tensor<2x3xf32>) -> tensor<3x2xf32> {
+  // CHECK: "aten.t"(%arg0)
+  %0 = "aten.t"(%arg0) : (tensor<2x3xf32>) -> tensor<3x2xf32>
+  return %0 : tensor<3x2xf32>
+}
+
+// -----
+
+// Packing a weight that has other uses would keep both copies.
+// CHECK-LABEL: func @shared
+// PANELS-LABEL: func @shared
+func @shared(%arg0: tensor<4x3xf32>) -> (tensor<4x2xf32>, tensor<2x3xf32>) {
+  // CHECK: "aten.t"
+  // PANELS: "aten.t"
+  // PANELS: "aten.mm"
+  %w = constant dense<[[1.0, 2.0, 3.0], [4.0, 5.0, 6.0]]> : tensor<2x3xf32>
+  %0 = "aten.t"(%w) : (tensor<2x3xf32>) -> tensor<3x2xf32>
+  %1 = "aten.mm"(%arg0, %0) : (tensor<4x3xf32>, tensor<3x2xf32>) -> tensor<4x2xf32>
+  return %1, %w : tensor<4x2xf32>, tensor<2x3xf32>
+}
+
+// -----
+
+// PANELS-LABEL: func @addmm
+func @addmm(%arg0: tensor<4x3xf32>, %arg1: tensor<2xf32>) -> tensor<4x2xf32> {
+  // PANELS: %[[PACKED:.*]] = constant dense<{{.*}}> : tensor<48xf32>
+  // PANELS: "aten.addmm_prepacked"(%arg1, %arg0, %[[PACKED]], %{{.*}}, %{{.*}})
+  %w = constant dense<[[1.0, 2.0], [3.0, 4.0], [5.0, 6.0]]> : tensor<3x2xf32>
+  %one = constant 1 : i64
+  %0 = "aten.addmm"(%arg1, %arg0, %w, %one, %one) : (tensor<2xf32>, tensor<4x3xf32>, tensor<3x2xf32>, i64, i64) -> tensor<4x2xf32>
+  return %0 : tensor<4x2xf32>
+}
@@ -0,0 +1,39 @@
+// RUN: npcomp-opt -split-input-file %s -verify-diagnostics -aten-rematerialize='report=true' | FileCheck --dump-input=fail %s
+
+// The relu of the forward pass is recomputed for the backward pass from
+// %arg0, which is live anyway, instead of being kept across the peak.
+// CHECK-LABEL: func @recompute
+// CHECK: %[[RELU:.+]] = "aten.relu"(%arg0)
+// CHECK: %[[FWD0:.+]] = "aten.mm"(%[[RELU]], %arg1)
+// CHECK: %[[FWD1:.+]] = "aten.mm"(%[[FWD0]], %arg1)
+// CHECK: %[[GRAD:.+]] = "aten.mm"(%[[FWD1]], %arg1)
+// CHECK: %[[RELU2:.+]] = "aten.relu"(%arg0)
+// CHECK: "aten.mul"(%[[GRAD]], %[[RELU2]])
+// expected-remark @+1 {{peak live tensor bytes: 2048 -> 1792, recomputed 1 ops}}
+func @recompute(%arg0: tensor<4x16xf32>, %arg1: tensor<16x16xf32>) -> tensor<4x16xf32> {
+  %0 = "aten.relu"(%arg0) : (tensor<4x16xf32>) -> tensor<4x16xf32>
+  %1 = "aten.mm"(%0, %arg1) : (tensor<4x16xf32>, tensor<16x16xf32>) -> tensor<4x16xf32>
+  %2 = "aten.mm"(%1, %arg1) : (tensor<4x16xf32>, tensor<16x16xf32>) -> tensor<4x16xf32>
+  %3 = "aten.mm"(%2, %arg1) : (tensor<4x16xf32>, tensor<16x16xf32>) -> tensor<4x16xf32>
+  %4 = "aten.mul"(%3, %0) : (tensor<4x16xf32>, tensor<4x16xf32>) -> tensor<4x16xf32>
+  %5 = "aten.mul"(%4, %arg0) : (tensor<4x16xf32>, tensor<4x16xf32>) -> tensor<4x16xf32>
+  return %5 : tensor<4x16xf32>
+}
+
+// -----
+
+// Recomputing the relu would keep %arg0 alive across the peak instead, which
+// saves nothing.
+// CHECK-LABEL: func @unprofitable
+// CHECK-COUNT-1: "aten.relu"
+// CHECK-NOT: "aten.relu"
+// expected-remark @+1 {{peak live tensor bytes: 1792 -> 1792, recomputed 0 ops}}
+func @unprofitable(%arg0: tensor<4x16xf32>, %arg1: tensor<16x16xf32>) -> tensor<4x16xf32> {
+  %0 = "aten.relu"(%arg0) : (tensor<4x16xf32>) -> tensor<4x16xf32>
+  %1 = "aten.mm"(%0, %arg1) : (tensor<4x16xf32>, tensor<16x16xf32>) -> tensor<4x16xf32>
+  %2 = "aten.mm"(%1, %arg1) : (tensor<4x16xf32>, tensor<16x16xf32>) -> tensor<4x16xf32>
+  %3 = "aten.mm"(%2, %arg1) : (tensor<4x16xf32>, tensor<16x16xf32>) -> tensor<4x16xf32>
+  %4 = "aten.mul"(%3, %0) : (tensor<4x16xf32>, tensor<4x16xf32>) -> tensor<4x16xf32>
+  %5 = "aten.mul"(%4, %4) : (tensor<4x16xf32>, tensor<4x16xf32>) -> tensor<4x16xf32>
+  return %5 : tensor<4x16xf32>
+}
@@ -0,0 +1,29 @@
+// RUN: npcomp-opt -split-input-file -verify-diagnostics -basicpy-type-inference %s
+
+// Conflicting constant types are reported at the expressions that they come
+// from.
+// expected-error@+1 {{type inference failed}}
+func @conflicting_bindings(%arg0: i1) -> !basicpy.UnknownType {
+  // expected-remark@+1 {{conflicting expression here}}
+  %0 = constant 1 : i64
+  // expected-error@+1 {{cannot unify type}}
+  %1 = constant 1.0 : f64
+  %2 = basicpy.unknown_cast %0 : i64 -> !basicpy.UnknownType
+  %3 = basicpy.unknown_cast %1 : f64 -> !basicpy.UnknownType
+  %4 = select %arg0, %2, %3 : !basicpy.UnknownType
+  return %4 : !basicpy.UnknownType
+}
+
+// -----
+
+// A type variable already bound to one type is not bound to another.
+// expected-error@+1 {{type inference failed}}
+func @conflicting_variable(%arg0: !basicpy.UnknownType) -> !basicpy.UnknownType {
+  // expected-remark@+1 {{conflicting expression here}}
+  %0 = constant 1 : i64
+  // expected-error@+1 {{cannot unify type}}
+  %1 = constant 1.0 : f64
+  %2 = basicpy.binary_expr %arg0 "Add" %0 : (!basicpy.UnknownType, i64) -> !basicpy.UnknownType
+  %3 = basicpy.binary_expr %arg0 "Add" %1 : (!basicpy.UnknownType, f64) -> !basicpy.UnknownType
+  return %2 : !basicpy.UnknownType
+}
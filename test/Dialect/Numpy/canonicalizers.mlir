@@ -13,8 +13,8 @@ func @elideCreateRedundantArrayFromTensor() -> tensor<2xf64> {
 }
 
 // This test verifies that the very trivial elision is not overly aggressive.
-// Note that in this example, it is still safe to remove the copy, but the
-// analysis has not yet been written to do that safely.
+// Note that in this example, it is still safe to remove the copy, which is
+// left to the -numpy-elide-array-copies analysis.
 // CHECK-LABEL: func @elideCreateRedundantArrayFromTensorNonTrivial
 func @elideCreateRedundantArrayFromTensorNonTrivial() -> (tensor<2xf64>, tensor<2xf64>) {
   // CHECK: numpy.create_array_from_tensor
@@ -0,0 +1,61 @@
+// RUN: npcomp-opt -split-input-file %s -verify-diagnostics -numpy-elide-array-copies='report=true' | FileCheck --dump-input=fail %s
+
+// An array that is only ever copied is immutable, so all copies are elided.
+// CHECK-LABEL: func @multipleCopies
+// expected-remark @+1 {{elided 2 array copies of 32 bytes (0 of dynamic size)}}
+func @multipleCopies(%arg0: tensor<2xf64>) -> (tensor<2xf64>, tensor<2xf64>) {
+  // CHECK-NOT: numpy.create_array_from_tensor
+  // CHECK-NOT: numpy.copy_to_tensor
+  // CHECK: return %arg0, %arg0
+  %0 = numpy.create_array_from_tensor %arg0 : (tensor<2xf64>) -> !numpy.ndarray<[2]:f64>
+  %1 = numpy.copy_to_tensor %0 : (!numpy.ndarray<[2]:f64>) -> tensor<2xf64>
+  %2 = numpy.copy_to_tensor %0 : (!numpy.ndarray<[2]:f64>) -> tensor<2xf64>
+  return %1, %2 : tensor<2xf64>, tensor<2xf64>
+}
+
+// -----
+
+// Only the copy made before the array escapes is elided.
+func private @mutate(!numpy.ndarray<[?]:f32>)
+// CHECK-LABEL: func @copyBeforeEscape
+// expected-remark @+1 {{elided 1 array copies of 0 bytes (1 of dynamic size)}}
+func @copyBeforeEscape(%arg0: tensor<?xf32>) -> (tensor<?xf32>, tensor<?xf32>) {
+  // CHECK: %[[ARRAY:.*]] = numpy.create_array_from_tensor %arg0
+  // CHECK-NEXT: call @mutate(%[[ARRAY]])
+  // CHECK-NEXT: %[[COPY:.*]] = numpy.copy_to_tensor %[[ARRAY]]
+  // CHECK-NEXT: return %arg0, %[[COPY]]
+  %0 = numpy.create_array_from_tensor %arg0 : (tensor<?xf32>) -> !numpy.ndarray<[?]:f32>
+  %1 = numpy.copy_to_tensor %0 : (!numpy.ndarray<[?]:f32>) -> tensor<?xf32>
+  call @mutate(%0) : (!numpy.ndarray<[?]:f32>) -> ()
+  %2 = numpy.copy_to_tensor %0 : (!numpy.ndarray<[?]:f32>) -> tensor<?xf32>
+  return %1, %2 : tensor<?xf32>, tensor<?xf32>
+}
+
+// -----
+
+// A copy in another block may execute after the array escapes.
+func private @mutate(!numpy.ndarray<[2]:f32>)
+// CHECK-LABEL: func @copyInSuccessor
+// expected-remark @+1 {{elided 0 array copies of 0 bytes (0 of dynamic size)}}
+func @copyInSuccessor(%arg0: tensor<2xf32>) -> tensor<2xf32> {
+  // CHECK: numpy.create_array_from_tensor
+  // CHECK: numpy.copy_to_tensor
+  %0 = numpy.create_array_from_tensor %arg0 : (tensor<2xf32>) -> !numpy.ndarray<[2]:f32>
+  call @mutate(%0) : (!numpy.ndarray<[2]:f32>) -> ()
+  br ^bb1
+^bb1:
+  %1 = numpy.copy_to_tensor %0 : (!numpy.ndarray<[2]:f32>) -> tensor<2xf32>
+  return %1 : tensor<2xf32>
+}
+
+// -----
+
+// Copies that change the tensor type are kept.
+// CHECK-LABEL: func @typeChangingCopy
+// expected-remark @+1 {{elided 0 array copies of 0 bytes (0 of dynamic size)}}
+func @typeChangingCopy(%arg0: tensor<2xf32>) -> tensor<*xf32> {
+  // CHECK: numpy.copy_to_tensor
+  %0 = numpy.create_array_from_tensor %arg0 : (tensor<2xf32>) -> !numpy.ndarray<*:f32>
+  %1 = numpy.copy_to_tensor %0 : (!numpy.ndarray<*:f32>) -> tensor<*xf32>
+  return %1 : tensor<*xf32>
+}
@@ -0,0 +1,84 @@
+// RUN: npcomp-opt -canonicalize -split-input-file <%s | FileCheck %s --dump-input=fail
+
+// CHECK-LABEL: func @fold_broadcasting_add
+func @fold_broadcasting_add() -> tensor<2x2xf32> {
+  // CHECK: %[[RESULT:.*]] = constant dense<{{\[\[}}1.100000e+01, 2.200000e+01], [1.300000e+01, 2.400000e+01]]> : tensor<2x2xf32>
+  // CHECK-NOT: tcf.add
+  // CHECK: return %[[RESULT]]
+  %0 = constant dense<[[1.0, 2.0], [3.0, 4.0]]> : tensor<2x2xf32>
+  %1 = constant dense<[10.0, 20.0]> : tensor<2xf32>
+  %2 = tcf.add %0, %1 : (tensor<2x2xf32>, tensor<2xf32>) -> tensor<2x2xf32>
+  return %2 : tensor<2x2xf32>
+}
+
+// -----
+
+// CHECK-LABEL: func @fold_chain
+func @fold_chain() -> tensor<3xf32> {
+  // CHECK: %[[RESULT:.*]] = constant dense<[0.000000e+00, 0.000000e+00, 6.000000e+00]> : tensor<3xf32>
+  // CHECK-NOT: tcf.
+  // CHECK: return %[[RESULT]]
+  %0 = constant dense<[-1.0, 0.0, 3.0]> : tensor<3xf32>
+  %1 = constant dense<2.0> : tensor<3xf32>
+  %2 = tcf.mul %0, %1 : (tensor<3xf32>, tensor<3xf32>) -> tensor<3xf32>
+  %3 = tcf.clamp %2 {min = 0.0 : f32} : tensor<3xf32>
+  return %3 : tensor<3xf32>
+}
+
+// -----
+
+// CHECK-LABEL: func @fold_numpy_ufunc_chain
+func @fold_numpy_ufunc_chain() -> tensor<3xf32> {
+  // CHECK: %[[RESULT:.*]] = constant dense<[-1.500000e+00, -1.000000e+00, -5.000000e-01]> : tensor<3xf32>
+  // CHECK-NOT: tcf.
+  // CHECK: return %[[RESULT]]
+  %0 = constant dense<[1.0, 4.0, 9.0]> : tensor<3xf32>
+  %1 = constant dense<2.0> : tensor<3xf32>
+  %2 = tcf.sqrt %0 : tensor<3xf32>
+  %3 = tcf.div %2, %1 : (tensor<3xf32>, tensor<3xf32>) -> tensor<3xf32>
+  %4 = tcf.min %3, %1 : (tensor<3xf32>, tensor<3xf32>) -> tensor<3xf32>
+  %5 = tcf.sub %4, %1 : (tensor<3xf32>, tensor<3xf32>) -> tensor<3xf32>
+  return %5 : tensor<3xf32>
+}
+
+// -----
+
+// A NaN in either operand of min/max is propagated, as in numpy.
+// CHECK-LABEL: func @fold_min_max_nan
+func @fold_min_max_nan() -> (tensor<2xf32>, tensor<2xf32>) {
+  // CHECK: %[[NAN:.*]] = constant dense<0x7FC00000> : tensor<2xf32>
+  // CHECK-NOT: tcf.
+  // CHECK: return %[[NAN]], %[[NAN]]
+  %0 = constant dense<[1.0, 0x7FC00000]> : tensor<2xf32>
+  %1 = constant dense<[0x7FC00000, 1.0]> : tensor<2xf32>
+  %2 = tcf.max %0, %1 : (tensor<2xf32>, tensor<2xf32>) -> tensor<2xf32>
+  %3 = tcf.min %0, %1 : (tensor<2xf32>, tensor<2xf32>) -> tensor<2xf32>
+  return %2, %3 : tensor<2xf32>, tensor<2xf32>
+}
+
+// -----
+
+// CHECK-LABEL: func @fold_matmul
+func @fold_matmul() -> tensor<1x2xf32> {
+  // CHECK: %[[RESULT:.*]] = constant dense<{{\[\[}}4.000000e+00, 6.000000e+00]]> : tensor<1x2xf32>
+  // CHECK-NOT: tcf.matmul
+  // CHECK: return %[[RESULT]]
+  %0 = constant dense<[[1.0, 1.0]]> : tensor<1x2xf32>
+  %1 = constant dense<[[1.0, 2.0], [3.0, 4.0]]> : tensor<2x2xf32>
+  %2 = tcf.matmul %0, %1 : (tensor<1x2xf32>, tensor<2x2xf32>) -> tensor<1x2xf32>
+  return %2 : tensor<1x2xf32>
+}
+
+// -----
+
+// Non-constant and non-broadcastable operands are left for the runtime.
+// CHECK-LABEL: func @no_fold
+func @no_fold(%arg0: tensor<2xf32>) -> (tensor<2xf32>, tensor<?xf32>) {
+  // CHECK: tcf.add %arg0
+  // CHECK: tcf.add %[[LHS:.*]], %[[RHS:.*]] : (tensor<2xf32>, tensor<3xf32>) -> tensor<?xf32>
+  %0 = constant dense<1.0> : tensor<2xf32>
+  %1 = constant dense<1.0> : tensor<3xf32>
+  %2 = tcf.add %arg0, %0 : (tensor<2xf32>, tensor<2xf32>) -> tensor<2xf32>
+  %3 = tcf.add %0, %1 : (tensor<2xf32>, tensor<3xf32>) -> tensor<?xf32>
+  return %2, %3 : tensor<2xf32>, tensor<?xf32>
+}
@@ -11,6 +11,23 @@ func @binary_elementwise(%arg0: tensor<?xf32>, %arg1: tensor<?xf32>) {
   return
 }
 
+// CHECK-LABEL: func @numpy_ufuncs
+func @numpy_ufuncs(%arg0: tensor<?xf32>, %arg1: tensor<?xf32>) {
+  // CHECK: tcf.sub %arg0, %arg1 : (tensor<?xf32>, tensor<?xf32>) -> tensor<?xf32>
+  // CHECK: tcf.div %arg0, %arg1 : (tensor<?xf32>, tensor<?xf32>) -> tensor<?xf32>
+  // CHECK: tcf.min %arg0, %arg1 : (tensor<?xf32>, tensor<?xf32>) -> tensor<?xf32>
+  // CHECK: tcf.log %arg0 : tensor<?xf32>
+  // CHECK: tcf.sqrt %arg0 : tensor<?xf32>
+  // CHECK: tcf.compare "lt", %arg0, %arg1 : (tensor<?xf32>, tensor<?xf32>) -> tensor<?xi1>
+  %0 = tcf.sub %arg0, %arg1 : (tensor<?xf32>, tensor<?xf32>) -> tensor<?xf32>
+  %1 = tcf.div %arg0, %arg1 : (tensor<?xf32>, tensor<?xf32>) -> tensor<?xf32>
+  %2 = tcf.min %arg0, %arg1 : (tensor<?xf32>, tensor<?xf32>) -> tensor<?xf32>
+  %3 = tcf.log %arg0 : tensor<?xf32>
+  %4 = tcf.sqrt %arg0 : tensor<?xf32>
+  %5 = tcf.compare "lt", %arg0, %arg1 : (tensor<?xf32>, tensor<?xf32>) -> tensor<?xi1>
+  return
+}
+
 // CHECK-LABEL: func @matmul
 func @matmul(%arg0: tensor<?x?xf32>, %arg1: tensor<?x?xf32>) -> tensor<?x?xf32> {
   // CHECK: tcf.matmul %arg0, %arg1 : (tensor<?x?xf32>, tensor<?x?xf32>) -> tensor<?x?xf32>
@@ -24,3 +41,29 @@ func @conv_2d_nchw(%arg0: tensor<?x?x?x?xf32>, %arg1: tensor<?x?x?x?xf32>) -> te
   %0 = tcf.conv_2d_nchw %arg0, %arg1 : (tensor<?x?x?x?xf32>, tensor<?x?x?x?xf32>) -> tensor<?x?x?x?xf32>
   return %0 : tensor<?x?x?x?xf32>
 }
+
+// CHECK-LABEL: func @conv_2d_nchw_strided
+func @conv_2d_nchw_strided(%arg0: tensor<?x?x?x?xf32>, %arg1: tensor<?x?x?x?xf32>, %arg2: tensor<?xf32>) -> tensor<?x?x?x?xf32> {
+  // CHECK: tcf.conv_2d_nchw %arg0, %arg1, %arg2 {padding = [1, 1], strides = [2, 2]} : (tensor<?x?x?x?xf32>, tensor<?x?x?x?xf32>, tensor<?xf32>) -> tensor<?x?x?x?xf32>
+  %0 = tcf.conv_2d_nchw %arg0, %arg1, %arg2 {padding = [1, 1], strides = [2, 2]} : (tensor<?x?x?x?xf32>, tensor<?x?x?x?xf32>, tensor<?xf32>) -> tensor<?x?x?x?xf32>
+  return %0 : tensor<?x?x?x?xf32>
+}
+
+// CHECK-LABEL: func @nn_ops
+func @nn_ops(%arg0: tensor<?x?x?x?xf32>, %arg1: tensor<?xf32>) {
+  // CHECK: tcf.clamp %arg0 {min = 0.000000e+00 : f32} : tensor<?x?x?x?xf32>
+  // CHECK: tcf.sigmoid %arg0 : tensor<?x?x?x?xf32>
+  // CHECK: tcf.max_pool_2d_nchw %arg0 {dilations = [1, 1], kernel_size = [3, 3], padding = [1, 1], strides = [2, 2]} : (tensor<?x?x?x?xf32>) -> tensor<?x?x?x?xf32>
+  // CHECK: tcf.batch_norm_inference %arg0, %arg1, %arg1, %arg1, %arg1 {epsilon = 9.99999974E-6 : f32} : (tensor<?x?x?x?xf32>, tensor<?xf32>, tensor<?xf32>, tensor<?xf32>, tensor<?xf32>) -> tensor<?x?x?x?xf32>
+  // CHECK: tcf.mean %arg0 {axes = [2, 3], keep_dims = true} : (tensor<?x?x?x?xf32>) -> tensor<?x?x1x1xf32>
+  // CHECK: tcf.sum %arg0 {axes = [1]} : (tensor<?x?x?x?xf32>) -> tensor<?x?x?xf32>
+  // CHECK: tcf.log_softmax %arg0 {axis = 1 : i64} : tensor<?x?x?x?xf32>
+  %0 = tcf.clamp %arg0 {min = 0.0 : f32} : tensor<?x?x?x?xf32>
+  %1 = tcf.sigmoid %arg0 : tensor<?x?x?x?xf32>
+  %2 = tcf.max_pool_2d_nchw %arg0 {dilations = [1, 1], kernel_size = [3, 3], padding = [1, 1], strides = [2, 2]} : (tensor<?x?x?x?xf32>) -> tensor<?x?x?x?xf32>
+  %3 = tcf.batch_norm_inference %arg0, %arg1, %arg1, %arg1, %arg1 {epsilon = 1.0e-5 : f32} : (tensor<?x?x?x?xf32>, tensor<?xf32>, tensor<?xf32>, tensor<?xf32>, tensor<?xf32>) -> tensor<?x?x?x?xf32>
+  %4 = tcf.mean %arg0 {axes = [2, 3], keep_dims = true} : (tensor<?x?x?x?xf32>) -> tensor<?x?x1x1xf32>
+  %5 = tcf.sum %arg0 {axes = [1]} : (tensor<?x?x?x?xf32>) -> tensor<?x?x?xf32>
+  %6 = tcf.log_softmax %arg0 {axis = 1 : i64} : tensor<?x?x?x?xf32>
+  return
+}
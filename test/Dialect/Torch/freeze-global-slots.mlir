@@ -0,0 +1,71 @@
+// RUN: npcomp-opt -torch-freeze-global-slots -split-input-file %s | FileCheck %s
+
+// Private weights that are only read become constants at each use.
+
+// CHECK-NOT:     torch.global_slot
+// CHECK-LABEL:   func @forward() -> tensor<2xf32> {
+// CHECK:           %[[W:.*]] = constant dense<[1.000000e+00, 2.000000e+00]> : tensor<2xf32>
+// CHECK:           %[[ARRAY:.*]] = numpy.create_array_from_tensor %[[W]]
+// CHECK:           %[[TENSOR:.*]] = numpy.copy_to_tensor %[[ARRAY]]
+// CHECK:           return %[[TENSOR]]
+
+torch.global_slot "private" @w : !numpy.ndarray<*:!numpy.any_dtype> {
+  %0 = constant dense<[1.0, 2.0]> : tensor<2xf32>
+  %1 = numpy.create_array_from_tensor %0 : (tensor<2xf32>) -> !numpy.ndarray<*:!numpy.any_dtype>
+  torch.global_slot.init %1 : !numpy.ndarray<*:!numpy.any_dtype>
+}
+
+func @forward() -> tensor<2xf32> {
+  %0 = torch.global_slot.get @w : !numpy.ndarray<*:!numpy.any_dtype>
+  %1 = numpy.copy_to_tensor %0 : (!numpy.ndarray<*:!numpy.any_dtype>) -> tensor<2xf32>
+  return %1 : tensor<2xf32>
+}
+
+// -----
+
+// CHECK-LABEL:   func @scalar() -> f64 {
+// CHECK:           %[[C:.*]] = constant 4.200000e+01 : f64
+// CHECK:           return %[[C]]
+
+torch.global_slot "private" @float : f64 {
+  %0 = constant 42.0 : f64
+  torch.global_slot.init %0 : f64
+}
+
+func @scalar() -> f64 {
+  %0 = torch.global_slot.get @float : f64
+  return %0 : f64
+}
+
+// -----
+
+// Public slots, slots that are set, and ndarrays used other than by copying
+// them are kept.
+
+// CHECK:         torch.global_slot @public : f64
+// CHECK:         torch.global_slot "private" @set : f64
+// CHECK:         torch.global_slot "private" @escapes : !numpy.ndarray<*:!numpy.any_dtype>
+
+torch.global_slot @public : f64 {
+  %0 = constant 1.0 : f64
+  torch.global_slot.init %0 : f64
+}
+
+torch.global_slot "private" @set : f64 {
+  %0 = constant 1.0 : f64
+  torch.global_slot.init %0 : f64
+}
+
+torch.global_slot "private" @escapes : !numpy.ndarray<*:!numpy.any_dtype> {
+  %0 = constant dense<1.0> : tensor<2xf32>
+  %1 = numpy.create_array_from_tensor %0 : (tensor<2xf32>) -> !numpy.ndarray<*:!numpy.any_dtype>
+  torch.global_slot.init %1 : !numpy.ndarray<*:!numpy.any_dtype>
+}
+
+func @uses() -> (f64, !numpy.ndarray<*:!numpy.any_dtype>) {
+  %0 = torch.global_slot.get @public : f64
+  %c = constant 2.0 : f64
+  torch.global_slot.set @set = %c : f64
+  %1 = torch.global_slot.get @escapes : !numpy.ndarray<*:!numpy.any_dtype>
+  return %0, %1 : f64, !numpy.ndarray<*:!numpy.any_dtype>
+}
@@ -0,0 +1,69 @@
+// RUN: npcomp-opt -torch-globalized-module-pipeline -split-input-file %s | FileCheck %s
+
+// Private attributes that are never set are frozen after globalization.
+
+// CHECK-NOT:     torch.global_slot
+// CHECK-LABEL:   func @forward() -> f64 {
+// CHECK:           %[[C:.*]] = constant 4.200000e+01 : f64
+// CHECK:           return %[[C]]
+
+torch.class_type @c {
+  torch.attr private "float" : f64
+  torch.method "forward", @method
+}
+
+func private @method(%arg0: !torch.nn.Module<"c">) -> f64 {
+  %0 = torch.prim.GetAttr %arg0["float"] : !torch.nn.Module<"c"> -> f64
+  return %0 : f64
+}
+
+%c42 = std.constant 42.0 : f64
+torch.nn_module {
+  torch.slot "float", %c42 : f64
+} : !torch.nn.Module<"c">
+
+// -----
+
+// Frozen weights become constants and the tensor attributes that remain
+// become globals of the module.
+
+// CHECK-NOT:     torch.global_slot
+// CHECK:         global_memref @state : memref<2xf32> = dense<[3.000000e+00, 4.000000e+00]>
+// CHECK-LABEL:   func @forward() -> tensor<2xf32> {
+// CHECK:           %[[W:.*]] = constant dense<[1.000000e+00, 2.000000e+00]> : tensor<2xf32>
+// CHECK:           %[[GLOBAL:.*]] = get_global_memref @state : memref<2xf32>
+// CHECK:           linalg.copy(%[[GLOBAL]],
+// CHECK:           tcf.add
+// CHECK-LABEL:   func @update(
+// CHECK:           %[[GLOBAL:.*]] = get_global_memref @state : memref<2xf32>
+// CHECK:           linalg.copy(%{{.*}}, %[[GLOBAL]])
+
+torch.class_type @c {
+  torch.attr private "w" : !numpy.ndarray<*:!numpy.any_dtype>
+  torch.attr "state" : !numpy.ndarray<*:!numpy.any_dtype>
+  torch.method "forward", @f
+  torch.method "update", @u
+}
+
+func private @f(%arg0: !torch.nn.Module<"c">) -> tensor<2xf32> {
+  %0 = torch.prim.GetAttr %arg0["w"] : !torch.nn.Module<"c"> -> !numpy.ndarray<*:!numpy.any_dtype>
+  %1 = torch.prim.GetAttr %arg0["state"] : !torch.nn.Module<"c"> -> !numpy.ndarray<*:!numpy.any_dtype>
+  %2 = numpy.copy_to_tensor %0 : (!numpy.ndarray<*:!numpy.any_dtype>) -> tensor<2xf32>
+  %3 = numpy.copy_to_tensor %1 : (!numpy.ndarray<*:!numpy.any_dtype>) -> tensor<2xf32>
+  %4 = tcf.add %2, %3 : (tensor<2xf32>, tensor<2xf32>) -> tensor<2xf32>
+  return %4 : tensor<2xf32>
+}
+
+func private @u(%arg0: !torch.nn.Module<"c">, %arg1: !numpy.ndarray<*:!numpy.any_dtype>) {
+  torch.prim.SetAttr %arg0["state"] = %arg1 : !torch.nn.Module<"c">, !numpy.ndarray<*:!numpy.any_dtype>
+  return
+}
+
+%w = constant dense<[1.0, 2.0]> : tensor<2xf32>
+%wa = numpy.create_array_from_tensor %w : (tensor<2xf32>) -> !numpy.ndarray<*:!numpy.any_dtype>
+%s = constant dense<[3.0, 4.0]> : tensor<2xf32>
+%sa = numpy.create_array_from_tensor %s : (tensor<2xf32>) -> !numpy.ndarray<*:!numpy.any_dtype>
+torch.nn_module {
+  torch.slot "w", %wa : !numpy.ndarray<*:!numpy.any_dtype>
+  torch.slot "state", %sa : !numpy.ndarray<*:!numpy.any_dtype>
+} : !torch.nn.Module<"c">
@@ -0,0 +1,84 @@
+// RUN: npcomp-opt -torch-lower-global-slots -split-input-file %s | FileCheck %s
+
+// Constant slots that are never set become constant globals, read in place.
+
+// CHECK:         global_memref "private" constant @w : memref<2xf32> = dense<[1.000000e+00, 2.000000e+00]>
+// CHECK-NOT:     torch.global_slot
+// CHECK-LABEL:   func @forward() -> !numpy.ndarray<*:!numpy.any_dtype> {
+// CHECK:           %[[GLOBAL:.*]] = get_global_memref @w : memref<2xf32>
+// CHECK:           %[[TENSOR:.*]] = tensor_load %[[GLOBAL]] : memref<2xf32>
+// CHECK:           %[[ARRAY:.*]] = numpy.create_array_from_tensor %[[TENSOR]] : (tensor<2xf32>) -> !numpy.ndarray<*:!numpy.any_dtype>
+// CHECK:           return %[[ARRAY]]
+// CHECK-NOT:     func @__npcomp_module_init
+
+torch.global_slot "private" @w : !numpy.ndarray<*:!numpy.any_dtype> {
+  %0 = constant dense<[1.0, 2.0]> : tensor<2xf32>
+  %1 = numpy.create_array_from_tensor %0 : (tensor<2xf32>) -> !numpy.ndarray<*:!numpy.any_dtype>
+  torch.global_slot.init %1 : !numpy.ndarray<*:!numpy.any_dtype>
+}
+
+func @forward() -> !numpy.ndarray<*:!numpy.any_dtype> {
+  %0 = torch.global_slot.get @w : !numpy.ndarray<*:!numpy.any_dtype>
+  return %0 : !numpy.ndarray<*:!numpy.any_dtype>
+}
+
+// -----
+
+// Slots that are set are mutable, and computed initializers run in the
+// module initializer. Reads copy the global so that later sets do not change
+// the value read.
+
+// CHECK:         global_memref @state : memref<2xf32> = uninitialized
+// CHECK-LABEL:   func @read() -> !numpy.ndarray<*:!numpy.any_dtype> {
+// CHECK:           %[[GLOBAL:.*]] = get_global_memref @state : memref<2xf32>
+// CHECK:           %[[COPY:.*]] = alloc() : memref<2xf32>
+// CHECK:           linalg.copy(%[[GLOBAL]], %[[COPY]])
+// CHECK:           %[[TENSOR:.*]] = tensor_load %[[COPY]] : memref<2xf32>
+// CHECK:           %[[ARRAY:.*]] = numpy.create_array_from_tensor %[[TENSOR]]
+// CHECK:           return %[[ARRAY]]
+// CHECK-LABEL:   func @update(
+// CHECK-SAME:                 %[[ARG:.*]]: !numpy.ndarray<*:!numpy.any_dtype>) {
+// CHECK:           %[[TENSOR:.*]] = numpy.copy_to_tensor %[[ARG]] : (!numpy.ndarray<*:!numpy.any_dtype>) -> tensor<2xf32>
+// CHECK:           %[[MEMREF:.*]] = tensor_to_memref %[[TENSOR]] : memref<2xf32>
+// CHECK:           %[[GLOBAL:.*]] = get_global_memref @state : memref<2xf32>
+// CHECK:           linalg.copy(%[[MEMREF]], %[[GLOBAL]])
+// CHECK-LABEL:   func @__npcomp_module_init() {
+// CHECK:           %[[INIT:.*]] = tcf.add
+// CHECK:           %[[MEMREF:.*]] = tensor_to_memref %[[INIT]] : memref<2xf32>
+// CHECK:           %[[GLOBAL:.*]] = get_global_memref @state : memref<2xf32>
+// CHECK:           linalg.copy(%[[MEMREF]], %[[GLOBAL]])
+// CHECK:           return
+
+torch.global_slot @state : !numpy.ndarray<*:!numpy.any_dtype> {
+  %0 = constant dense<[1.0, 2.0]> : tensor<2xf32>
+  %1 = tcf.add %0, %0 : (tensor<2xf32>, tensor<2xf32>) -> tensor<2xf32>
+  %2 = numpy.create_array_from_tensor %1 : (tensor<2xf32>) -> !numpy.ndarray<*:!numpy.any_dtype>
+  torch.global_slot.init %2 : !numpy.ndarray<*:!numpy.any_dtype>
+}
+
+func @read() -> !numpy.ndarray<*:!numpy.any_dtype> {
+  %0 = torch.global_slot.get @state : !numpy.ndarray<*:!numpy.any_dtype>
+  return %0 : !numpy.ndarray<*:!numpy.any_dtype>
+}
+
+func @update(%arg0: !numpy.ndarray<*:!numpy.any_dtype>) {
+  torch.global_slot.set @state = %arg0 : !numpy.ndarray<*:!numpy.any_dtype>
+  return
+}
+
+// -----
+
+// Slots that do not hold a tensor of static shape are left alone.
+
+// CHECK:         torch.global_slot @l : !basicpy.ListType
+// CHECK:         torch.global_slot.get @l
+
+torch.global_slot @l : !basicpy.ListType {
+  %0 = basicpy.build_list : () -> !basicpy.ListType
+  torch.global_slot.init %0 : !basicpy.ListType
+}
+
+func @get_l() -> !basicpy.ListType {
+  %0 = torch.global_slot.get @l : !basicpy.ListType
+  return %0 : !basicpy.ListType
+}
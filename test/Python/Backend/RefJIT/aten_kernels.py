@@ -0,0 +1,197 @@
+# RUN: %PYTHON %s | FileCheck %s --dump-input=fail
+
+# Checks results of the ATen kernel library (lib/RefBackend/ATenKernels)
+# against numpy, calling the exported functions directly with the memref
+# descriptors that -aten-to-std lowered code passes them.
+
+import ctypes
+
+import numpy as np
+
+from npcomp.compiler.generic.backend import refjit as refjit_backend
+
+kernels = ctypes.CDLL(refjit_backend.get_runtime_libs()[1])
+rng = np.random.RandomState(0)
+
+
+def memref(array, view=None):
+  """Returns a pointer to a descriptor of `view` (an array sharing the memory
+  of `array`, default `array` itself), keeping both alive."""
+  view = array if view is None else view
+  rank = view.ndim
+
+  class Descriptor(ctypes.Structure):
+    _fields_ = [
+        ("base", ctypes.c_void_p),
+        ("data", ctypes.c_void_p),
+        ("offset", ctypes.c_int64),
+        ("sizes", ctypes.c_int64 * rank),
+        ("strides", ctypes.c_int64 * rank),
+    ]
+
+  itemsize = view.itemsize
+  descriptor = Descriptor(array.ctypes.data, view.ctypes.data, 0,
+                          (ctypes.c_int64 * rank)(*view.shape),
+                          (ctypes.c_int64 * rank)(*[
+                              s // itemsize for s in view.strides
+                          ]))
+  descriptor._keepalive = (array, view)
+  return ctypes.pointer(descriptor)
+
+
+def check(name, actual, expected):
+  ok = np.allclose(actual, expected, rtol=1e-4, atol=1e-4)
+  print(name, "OK" if ok else "MISMATCH\n{}\n{}".format(actual, expected))
+
+
+def random(*shape):
+  return rng.uniform(-1.0, 1.0, shape).astype(np.float32)
+
+
+def mm(lhs, rhs, lhs_view=None, rhs_view=None):
+  lhs_view = lhs if lhs_view is None else lhs_view
+  rhs_view = rhs if rhs_view is None else rhs_view
+  out = np.zeros((lhs_view.shape[0], rhs_view.shape[1]), np.float32)
+  kernels._mlir_ciface_mm_2F32_2F32_2F32_out(memref(lhs, lhs_view),
+                                             memref(rhs, rhs_view),
+                                             memref(out))
+  return out
+
+
+# Shapes that are not multiples of the register (MR = 6, NR = 16) and cache
+# (KC = 256, MC = 96, NC = 2048) blocks of the GEMM, so that every remainder
+# path is exercised.
+# CHECK: mm 1x1x1 OK
+# CHECK: mm 7x17x3 OK
+# CHECK: mm 13x33x257 OK
+# CHECK: mm 97x20x5 OK
+# CHECK: mm 3x2049x7 OK
+# CHECK: mm 101x35x600 OK
+for m, n, k in [(1, 1, 1), (7, 17, 3), (13, 33, 257), (97, 20, 5),
+                (3, 2049, 7), (101, 35, 600)]:
+  lhs, rhs = random(m, k), random(k, n)
+  check("mm {}x{}x{}".format(m, n, k), mm(lhs, rhs), lhs @ rhs)
+
+# Transposed views of the operands are multiplied without copying them.
+# CHECK: mm transA OK
+# CHECK: mm transB OK
+# CHECK: mm transA transB OK
+lhs_t, rhs_t = random(263, 19), random(37, 263)
+lhs, rhs = random(19, 263), random(263, 37)
+check("mm transA", mm(lhs_t, rhs, lhs_view=lhs_t.T), lhs_t.T @ rhs)
+check("mm transB", mm(lhs, rhs_t, rhs_view=rhs_t.T), lhs @ rhs_t.T)
+check("mm transA transB", mm(lhs_t, rhs_t, lhs_t.T, rhs_t.T),
+      lhs_t.T @ rhs_t.T)
+
+# A strided (non-unit inner stride) operand is made contiguous first.
+# CHECK: mm strided OK
+wide = random(23, 2 * 29)
+rhs = random(29, 11)
+check("mm strided", mm(wide, rhs, lhs_view=wide[:, ::2]), wide[:, ::2] @ rhs)
+
+# Scalar operands are floats.
+# CHECK: addmm OK
+kernels._mlir_ciface_addmm_2F32_1F32_2F32_2F32_out.argtypes = [
+    ctypes.c_void_p, ctypes.c_void_p, ctypes.c_void_p, ctypes.c_float,
+    ctypes.c_float, ctypes.c_void_p
+]
+bias, lhs, rhs = random(9), random(10, 300), random(300, 9)
+out = np.zeros((10, 9), np.float32)
+kernels._mlir_ciface_addmm_2F32_1F32_2F32_2F32_out(memref(bias), memref(lhs),
+                                                   memref(rhs), 0.5, 2.0,
+                                                   memref(out))
+check("addmm", out, 0.5 * bias + 2.0 * (lhs @ rhs))
+
+
+
+def pack_gemm_b(rhs, nr=16, kc=256, nc=2048):
+  """Packs `rhs` [K, N] as -aten-prepack-weights does (see GemmLayout.h):
+  (NC column block, KC row slice) blocks, each holding NR-wide, k-major,
+  zero padded panels."""
+  k_size, n_size = rhs.shape
+  blocks = []
+  for jc in range(0, n_size, nc):
+    for pc in range(0, k_size, kc):
+      block = rhs[pc:pc + kc, jc:jc + nc]
+      padded = -block.shape[1] % nr
+      block = np.pad(block, ((0, 0), (0, padded)))
+      panels = block.reshape(block.shape[0], -1, nr).transpose(1, 0, 2)
+      blocks.append(panels.ravel())
+  return np.ascontiguousarray(np.concatenate(blocks), np.float32)
+
+
+# The packed rhs covers every (NC, KC) block boundary.
+# CHECK: mm_prepacked 1x1x1 OK
+# CHECK: mm_prepacked 7x17x3 OK
+# CHECK: mm_prepacked 5x2049x300 OK
+for m, n, k in [(1, 1, 1), (7, 17, 3), (5, 2049, 300)]:
+  lhs, rhs = random(m, k), random(k, n)
+  out = np.zeros((m, n), np.float32)
+  kernels._mlir_ciface_mm_prepacked_2F32_2F32_1F32_out(
+      memref(lhs), memref(pack_gemm_b(rhs)), memref(out))
+  check("mm_prepacked {}x{}x{}".format(m, n, k), out, lhs @ rhs)
+
+# CHECK: addmm_prepacked OK
+kernels._mlir_ciface_addmm_prepacked_2F32_1F32_2F32_1F32_out.argtypes = [
+    ctypes.c_void_p, ctypes.c_void_p, ctypes.c_void_p, ctypes.c_float,
+    ctypes.c_float, ctypes.c_void_p
+]
+bias, lhs, rhs = random(9), random(10, 300), random(300, 9)
+out = np.zeros((10, 9), np.float32)
+kernels._mlir_ciface_addmm_prepacked_2F32_1F32_2F32_1F32_out(
+    memref(bias), memref(lhs), memref(pack_gemm_b(rhs)), 0.5, 2.0,
+    memref(out))
+check("addmm_prepacked", out, 0.5 * bias + 2.0 * (lhs @ rhs))
+
+# CHECK: threshold_backward OK
+kernels._mlir_ciface_threshold_backward_2F32_2F32_2F32_out.argtypes = [
+    ctypes.c_void_p, ctypes.c_void_p, ctypes.c_float, ctypes.c_void_p
+]
+grad, self = random(4, 5), random(4, 5)
+out = np.zeros((4, 5), np.float32)
+kernels._mlir_ciface_threshold_backward_2F32_2F32_2F32_out(
+    memref(grad), memref(self), 0.25, memref(out))
+check("threshold_backward", out, np.where(self <= 0.25, 0.0, grad))
+
+
+def conv2d_reference(input, weight, bias, stride, padding, groups):
+  n, c, h, w = input.shape
+  k, c_per_group, kh, kw = weight.shape
+  padded = np.pad(input, ((0, 0), (0, 0), (padding, padding),
+                          (padding, padding)))
+  oh = (h + 2 * padding - kh) // stride + 1
+  ow = (w + 2 * padding - kw) // stride + 1
+  out = np.zeros((n, k, oh, ow), np.float32)
+  k_per_group = k // groups
+  for o in range(k):
+    g = o // k_per_group
+    channels = padded[:, g * c_per_group:(g + 1) * c_per_group]
+    for y in range(oh):
+      for x in range(ow):
+        window = channels[:, :, y * stride:y * stride + kh,
+                          x * stride:x * stride + kw]
+        out[:, o, y, x] = np.sum(window * weight[o], axis=(1, 2, 3)) + bias[o]
+  return out
+
+
+# CHECK: conv2d OK
+# CHECK: conv2d grouped OK
+for name, groups in [("conv2d", 1), ("conv2d grouped", 2)]:
+  input, weight, bias = random(2, 4, 9, 7), random(6, 4 // groups, 3, 3), \
+      random(6)
+  expected = conv2d_reference(input, weight, bias, stride=2, padding=1,
+                              groups=groups)
+  out = np.zeros(expected.shape, np.float32)
+  kernels._mlir_ciface_conv2d_4F32_4F32_4F32_1F32_out(
+      memref(input), memref(weight), memref(bias), 2, 1, 1, 0, 0, groups,
+      memref(out))
+  check(name, out, expected)
+
+# CHECK: log_softmax OK
+input = random(3, 5) * 10.0
+out = np.zeros((3, 5), np.float32)
+kernels._mlir_ciface_log_softmax_2F32_2F32_out(memref(input), 1, 0,
+                                               memref(out))
+shifted = input - input.max(axis=1, keepdims=True)
+check("log_softmax", out,
+      shifted - np.log(np.exp(shifted).sum(axis=1, keepdims=True)))
@@ -0,0 +1,82 @@
+# RUN: %PYTHON %s | FileCheck %s --dump-input=fail
+
+# Checks that JITModules in one process share the blobs of their external
+# weights: while a module using a blob is alive, another module binds the
+# same blob file without reading it again.
+
+import os
+import struct
+import tempfile
+
+import numpy as np
+
+from mlir.ir import *
+from mlir.passmanager import *
+from npcomp import _cext
+from npcomp.compiler.generic.backend import refjit as refjit_backend
+
+ASM = r"""
+func @add_weight(%arg0: tensor<2xf32>) -> tensor<2xf32> {
+  %0 = constant opaque<"torch", "0x00000000DEADBEEF"> : tensor<2xf32>
+  %1 = tcf.add %arg0, %0 : (tensor<2xf32>, tensor<2xf32>) -> tensor<2xf32>
+  return %1 : tensor<2xf32>
+}
+"""
+
+refjit = refjit_backend.get_refjit()
+
+
+def write_weights(values):
+  weights_dir = tempfile.mkdtemp()
+  blob_path = os.path.join(weights_dir, "00000000DEADBEEF.bin")
+  with open(blob_path, "wb") as f:
+    f.write(struct.pack("<2f", *values))
+  return weights_dir, blob_path
+
+
+weights_dir, blob_path = write_weights([1.0, 2.0])
+
+
+def load(weights_dir=weights_dir):
+  with Context() as context:
+    _cext.register_all_dialects(context)
+    module = Module.parse(ASM)
+    pm = PassManager()
+    refjit.build_backend_compilation_pipeline(pm)
+    pm.run(module)
+    return refjit.JITModule.from_compiled_module(
+        module, refjit_backend.get_runtime_libs(), weights_dir)
+
+
+x = np.asarray([3.0, 5.0], dtype=np.float32)
+
+# CHECK: first: [4. 7.]
+first = load()
+print("first:", first.invoke("add_weight", [x])[0])
+
+# CHECK: second: [4. 7.]
+os.remove(blob_path)
+second = load()
+print("second:", second.invoke("add_weight", [x])[0])
+
+# The same directory under another name is the same file.
+# CHECK: alias: [4. 7.]
+alias_dir = os.path.join(weights_dir, os.pardir,
+                         os.path.basename(weights_dir))
+alias = load(alias_dir)
+print("alias:", alias.invoke("add_weight", [x])[0])
+
+# Another directory may hold different contents under the same key.
+# CHECK: other: [13. 25.]
+other_dir, _ = write_weights([10.0, 20.0])
+other = load(other_dir)
+print("other:", other.invoke("add_weight", [x])[0])
+
+# The store only holds weak references, so the blob is gone once no module
+# uses it.
+# CHECK: reload: {{.*}}could not open weight
+del first, second, alias
+try:
+  load()
+except Exception as e:
+  print("reload:", e)
@@ -39,3 +39,18 @@ assert global_add.__isnpcomp__
 # CHECK: GLOBAL_ADD: [5. 8.]
 result = global_add()
 print("GLOBAL_ADD:", result)
+
+c = np.asarray([2.0, 6.0], dtype=np.float32)
+
+# Module globals are constants, so this chain folds at compile time. Chains on
+# runtime values are covered by test/npcomp-run-mlir/elementwise-chain.mlir.
+
+@compile_function
+def global_ufunc_chain():
+  return np.minimum(np.sqrt(np.multiply(np.subtract(np.multiply(a, b), a), c)),
+                    b)
+
+
+# CHECK: GLOBAL_UFUNC_CHAIN: [2. 4.]
+result = global_ufunc_chain()
+print("GLOBAL_UFUNC_CHAIN:", result)
@@ -0,0 +1,64 @@
+// RUN: npcomp-opt -refback-lower-to-llvm=raw-data-threshold=16 -split-input-file <%s | FileCheck %s --dump-input=fail
+
+// Test that large initializers are emitted as raw data, aligned for vector
+// loads of their elements.
+
+// CHECK:         llvm.mlir.global private constant @large("{{.*}}") {alignment = 64 : i64} : !llvm.array<16 x i8>
+// CHECK-LABEL:   llvm.func @uses_large()
+// CHECK:           %[[ADDRESS:.*]] = llvm.mlir.addressof @large : !llvm.ptr<array<16 x i8>>
+// CHECK:           %[[DATA:.*]] = llvm.bitcast %[[ADDRESS]] : !llvm.ptr<array<16 x i8>> to !llvm.ptr<f32>
+// CHECK:           llvm.insertvalue %[[DATA]], %{{.*}}[1 : i64] : !llvm.struct<(ptr<f32>, ptr<f32>, i64, array<2 x i64>, array<2 x i64>)>
+
+refbackrt.module_metadata {
+  refbackrt.func_metadata {funcName = @uses_large, numInputs = 0 : i32, numOutputs = 0 : i32}
+}
+
+global_memref "private" constant @large : memref<2x2xf32> = dense<[[1.0, 2.0], [3.0, 4.0]]>
+
+func @uses_large() {
+  %0 = get_global_memref @large : memref<2x2xf32>
+  return
+}
+
+// -----
+
+// Test that small and splat initializers keep the upstream lowering.
+
+// CHECK:         llvm.mlir.global private constant @small(dense<[1.000000e+00, 2.000000e+00]> : tensor<2xf32>) : !llvm.array<2 x f32>
+// CHECK:         llvm.mlir.global private constant @splat(dense<1.000000e+00> : tensor<8xf32>) : !llvm.array<8 x f32>
+
+refbackrt.module_metadata {
+  refbackrt.func_metadata {funcName = @uses_small, numInputs = 0 : i32, numOutputs = 0 : i32}
+}
+
+global_memref "private" constant @small : memref<2xf32> = dense<[1.0, 2.0]>
+global_memref "private" constant @splat : memref<8xf32> = dense<1.0>
+
+func @uses_small() {
+  %0 = get_global_memref @small : memref<2xf32>
+  %1 = get_global_memref @splat : memref<8xf32>
+  return
+}
+
+// -----
+
+// Test that private constants with the same raw data share a global.
+
+// CHECK:         llvm.mlir.global private constant @shared("{{.*}}") {alignment = 64 : i64} : !llvm.array<16 x i8>
+// CHECK-NOT:     llvm.mlir.global private constant @reshaped
+// CHECK-LABEL:   llvm.func @uses_shared()
+// CHECK:           llvm.mlir.addressof @shared : !llvm.ptr<array<16 x i8>>
+// CHECK:           llvm.mlir.addressof @shared : !llvm.ptr<array<16 x i8>>
+
+refbackrt.module_metadata {
+  refbackrt.func_metadata {funcName = @uses_shared, numInputs = 0 : i32, numOutputs = 0 : i32}
+}
+
+global_memref "private" constant @shared : memref<2x2xf32> = dense<[[1.0, 2.0], [3.0, 4.0]]>
+global_memref "private" constant @reshaped : memref<4xf32> = dense<[1.0, 2.0, 3.0, 4.0]>
+
+func @uses_shared() {
+  %0 = get_global_memref @shared : memref<2x2xf32>
+  %1 = get_global_memref @reshaped : memref<4xf32>
+  return
+}
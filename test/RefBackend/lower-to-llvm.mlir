@@ -116,14 +116,18 @@
 // CHECK:           llvm.return %[[VAL_37]] : !llvm.array<3 x struct<(i32, ptr<i8>, ptr<i8>, i32, i32)>>
 // CHECK:         }
 
-// CHECK-LABEL:   llvm.mlir.global external constant @_mlir___npcomp_module_descriptor() : !llvm.struct<(i32, ptr<struct<(i32, ptr<i8>, ptr<i8>, i32, i32)>>)> {
-// CHECK:           %[[VAL_0:.*]] = llvm.mlir.undef : !llvm.struct<(i32, ptr<struct<(i32, ptr<i8>, ptr<i8>, i32, i32)>>)>
+// CHECK-LABEL:   llvm.mlir.global external constant @_mlir___npcomp_module_descriptor() : !llvm.struct<(i32, ptr<struct<(i32, ptr<i8>, ptr<i8>, i32, i32)>>, i32, ptr<struct<(i32, ptr<i8>, ptr<ptr<i8>>, i64)>>)> {
+// CHECK:           %[[VAL_0:.*]] = llvm.mlir.undef : !llvm.struct<(i32, ptr<struct<(i32, ptr<i8>, ptr<i8>, i32, i32)>>, i32, ptr<struct<(i32, ptr<i8>, ptr<ptr<i8>>, i64)>>)>
 // CHECK:           %[[VAL_1:.*]] = llvm.mlir.constant(3 : i32) : i32
-// CHECK:           %[[VAL_2:.*]] = llvm.insertvalue %[[VAL_1]], %[[VAL_0]][0 : i32] : !llvm.struct<(i32, ptr<struct<(i32, ptr<i8>, ptr<i8>, i32, i32)>>)>
+// CHECK:           %[[VAL_2:.*]] = llvm.insertvalue %[[VAL_1]], %[[VAL_0]][0 : i32] : !llvm.struct<(i32, ptr<struct<(i32, ptr<i8>, ptr<i8>, i32, i32)>>, i32, ptr<struct<(i32, ptr<i8>, ptr<ptr<i8>>, i64)>>)>
 // CHECK:           %[[VAL_3:.*]] = llvm.mlir.addressof @__npcomp_func_descriptors : !llvm.ptr<array<3 x struct<(i32, ptr<i8>, ptr<i8>, i32, i32)>>>
 // CHECK:           %[[VAL_4:.*]] = llvm.bitcast %[[VAL_3]] : !llvm.ptr<array<3 x struct<(i32, ptr<i8>, ptr<i8>, i32, i32)>>> to !llvm.ptr<struct<(i32, ptr<i8>, ptr<i8>, i32, i32)>>
-// CHECK:           %[[VAL_5:.*]] = llvm.insertvalue %[[VAL_4]], %[[VAL_2]][1 : i32] : !llvm.struct<(i32, ptr<struct<(i32, ptr<i8>, ptr<i8>, i32, i32)>>)>
-// CHECK:           llvm.return %[[VAL_5]] : !llvm.struct<(i32, ptr<struct<(i32, ptr<i8>, ptr<i8>, i32, i32)>>)>
+// CHECK:           %[[VAL_5:.*]] = llvm.insertvalue %[[VAL_4]], %[[VAL_2]][1 : i32] : !llvm.struct<(i32, ptr<struct<(i32, ptr<i8>, ptr<i8>, i32, i32)>>, i32, ptr<struct<(i32, ptr<i8>, ptr<ptr<i8>>, i64)>>)>
+// CHECK:           %[[VAL_6:.*]] = llvm.mlir.null : !llvm.ptr<struct<(i32, ptr<i8>, ptr<ptr<i8>>, i64)>>
+// CHECK:           %[[VAL_7:.*]] = llvm.mlir.constant(0 : i32) : i32
+// CHECK:           %[[VAL_8:.*]] = llvm.insertvalue %[[VAL_7]], %[[VAL_5]][2 : i32] : !llvm.struct<(i32, ptr<struct<(i32, ptr<i8>, ptr<i8>, i32, i32)>>, i32, ptr<struct<(i32, ptr<i8>, ptr<ptr<i8>>, i64)>>)>
+// CHECK:           %[[VAL_9:.*]] = llvm.insertvalue %[[VAL_6]], %[[VAL_8]][3 : i32] : !llvm.struct<(i32, ptr<struct<(i32, ptr<i8>, ptr<i8>, i32, i32)>>, i32, ptr<struct<(i32, ptr<i8>, ptr<ptr<i8>>, i64)>>)>
+// CHECK:           llvm.return %[[VAL_9]] : !llvm.struct<(i32, ptr<struct<(i32, ptr<i8>, ptr<i8>, i32, i32)>>, i32, ptr<struct<(i32, ptr<i8>, ptr<ptr<i8>>, i64)>>)>
 // CHECK:         }
 
 refbackrt.module_metadata {
@@ -163,3 +167,40 @@ func @calls_abort_if(%arg0: i1) {
   refbackrt.abort_if %arg0, "msg"
   return
 }
+
+// -----
+
+// Test binding of weights imported by reference.
+
+// CHECK:         llvm.mlir.global internal @__npcomp_weight_weight() : !llvm.ptr<f32> {
+// CHECK:           %[[NULL:.*]] = llvm.mlir.null : !llvm.ptr<f32>
+// CHECK:           llvm.return %[[NULL]] : !llvm.ptr<f32>
+// CHECK:         }
+
+// CHECK:         llvm.mlir.global internal constant @__npcomp_weight_weight_key("00000000DEADBEEF")
+// CHECK-LABEL:   llvm.mlir.global internal constant @__npcomp_weight_descriptors() : !llvm.array<1 x struct<(i32, ptr<i8>, ptr<ptr<i8>>, i64)>> {
+// CHECK:           llvm.mlir.constant(16 : i32) : i32
+// CHECK:           llvm.mlir.addressof @__npcomp_weight_weight_key : !llvm.ptr<array<16 x i8>>
+// CHECK:           %[[SLOT:.*]] = llvm.mlir.addressof @__npcomp_weight_weight : !llvm.ptr<ptr<f32>>
+// CHECK:           llvm.bitcast %[[SLOT]] : !llvm.ptr<ptr<f32>> to !llvm.ptr<ptr<i8>>
+// CHECK:           llvm.mlir.constant(8 : i64) : i64
+
+// CHECK-LABEL:   llvm.mlir.global external constant @_mlir___npcomp_module_descriptor()
+// CHECK:           llvm.mlir.addressof @__npcomp_weight_descriptors
+// CHECK:           llvm.mlir.constant(1 : i32) : i32
+
+// CHECK-LABEL:   llvm.func @uses_weight()
+// CHECK:           %[[SLOT:.*]] = llvm.mlir.addressof @__npcomp_weight_weight : !llvm.ptr<ptr<f32>>
+// CHECK:           %[[DATA:.*]] = llvm.load %[[SLOT]] : !llvm.ptr<ptr<f32>>
+// CHECK:           llvm.insertvalue %[[DATA]], %{{.*}}[1 : i64] : !llvm.struct<(ptr<f32>, ptr<f32>, i64, array<1 x i64>, array<1 x i64>)>
+
+refbackrt.module_metadata {
+  refbackrt.func_metadata {funcName = @uses_weight, numInputs = 0 : i32, numOutputs = 0 : i32}
+}
+
+global_memref "private" constant @weight : memref<2xf32> = opaque<"torch", "0x00000000DEADBEEF">
+
+func @uses_weight() {
+  %0 = get_global_memref @weight : memref<2xf32>
+  return
+}
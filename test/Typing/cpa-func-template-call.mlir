@@ -0,0 +1,61 @@
+// RUN: npcomp-opt -npcomp-cpa-type-inference %s | FileCheck --dump-input=fail %s
+
+// The template itself is left as is.
+// CHECK: basicpy.func_template @__global$double
+// CHECK: func @generic(%arg0: !basicpy.UnknownType) -> !basicpy.UnknownType
+basicpy.func_template @__global$double {
+  func @forF64(%arg0: f64) -> f64 {
+    return %arg0 : f64
+  }
+  func @generic(%arg0: !basicpy.UnknownType) -> !basicpy.UnknownType {
+    %0 = basicpy.binary_expr %arg0 "Add" %arg0 : (!basicpy.UnknownType, !basicpy.UnknownType) -> !basicpy.UnknownType
+    return %0 : !basicpy.UnknownType
+  }
+}
+
+// The generic overload is analyzed for the i64 argument type.
+// CHECK-LABEL: func @direct(
+// CHECK-SAME:      %arg0: i64) -> i64
+// CHECK:         basicpy.func_template_call @__global$double(%arg0) kw [] : (i64) -> i64
+func @direct(%arg0: i64) -> !basicpy.UnknownType {
+  %0 = basicpy.func_template_call @__global$double(%arg0) kw [] : (i64) -> !basicpy.UnknownType
+  return %0 : !basicpy.UnknownType
+}
+
+// The argument type is only known after propagation, and the result feeds
+// another call.
+// CHECK-LABEL: func @chained(
+// CHECK-SAME:      %arg0: i64) -> i64
+// CHECK:         %[[A:.*]] = basicpy.unknown_cast %arg0 : i64 -> i64
+// CHECK:         %[[B:.*]] = basicpy.func_template_call @__global$double(%[[A]]) kw [] : (i64) -> i64
+// CHECK:         basicpy.func_template_call @__global$double(%[[B]]) kw [] : (i64) -> i64
+func @chained(%arg0: i64) -> !basicpy.UnknownType {
+  %0 = basicpy.unknown_cast %arg0 : i64 -> !basicpy.UnknownType
+  %1 = basicpy.func_template_call @__global$double(%0) kw [] : (!basicpy.UnknownType) -> !basicpy.UnknownType
+  %2 = basicpy.func_template_call @__global$double(%1) kw [] : (!basicpy.UnknownType) -> !basicpy.UnknownType
+  return %2 : !basicpy.UnknownType
+}
+
+// The first matching overload wins.
+// CHECK-LABEL: func @concrete(
+// CHECK-SAME:      %arg0: f64) -> f64
+func @concrete(%arg0: f64) -> !basicpy.UnknownType {
+  %0 = basicpy.func_template_call @__global$double(%arg0) kw [] : (f64) -> !basicpy.UnknownType
+  return %0 : !basicpy.UnknownType
+}
+
+// Recursion through a template is cut. Results computed under the cut are
+// not memoized, so every caller sees the instance analyzed from its entry.
+// CHECK-LABEL: func @recursive(
+// CHECK-SAME:      %arg0: i64) -> i64
+// CHECK:         basicpy.func_template_call @__global$identity(%arg0) kw [] : (i64) -> i64
+basicpy.func_template @__global$identity {
+  func @generic(%arg0: !basicpy.UnknownType) -> !basicpy.UnknownType {
+    %0 = basicpy.func_template_call @__global$identity(%arg0) kw [] : (!basicpy.UnknownType) -> !basicpy.UnknownType
+    return %arg0 : !basicpy.UnknownType
+  }
+}
+func @recursive(%arg0: i64) -> !basicpy.UnknownType {
+  %0 = basicpy.func_template_call @__global$identity(%arg0) kw [] : (i64) -> !basicpy.UnknownType
+  return %0 : !basicpy.UnknownType
+}
@@ -0,0 +1,39 @@
+// RUN: npcomp-run-mlir %s \
+// RUN:   -invoke ufunc_chain \
+// RUN:   -arg-value="dense<[1.0, 2.0]> : tensor<2xf32>" \
+// RUN:   -arg-value="dense<[3.0, 4.0]> : tensor<2xf32>" \
+// RUN:   -arg-value="dense<[2.0, 6.0]> : tensor<2xf32>" \
+// RUN:   -shared-libs=%npcomp_runtime_shlib 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=SAME
+
+// RUN: npcomp-run-mlir %s \
+// RUN:   -invoke ufunc_chain \
+// RUN:   -arg-value="dense<[1.0, 2.0]> : tensor<2xf32>" \
+// RUN:   -arg-value="dense<[3.0, 4.0]> : tensor<2xf32>" \
+// RUN:   -arg-value="dense<[2.0]> : tensor<1xf32>" \
+// RUN:   -shared-libs=%npcomp_runtime_shlib 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=BROADCAST
+
+// RUN: not npcomp-run-mlir %s \
+// RUN:   -invoke ufunc_chain \
+// RUN:   -arg-value="dense<[1.0, 2.0]> : tensor<2xf32>" \
+// RUN:   -arg-value="dense<[3.0, 4.0]> : tensor<2xf32>" \
+// RUN:   -arg-value="dense<[2.0, 6.0, 1.0]> : tensor<3xf32>" \
+// RUN:   -shared-libs=%npcomp_runtime_shlib 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=INVALID
+
+// The chain is converted as a whole, with a single broadcast check of its
+// operands, so each run checks that this matches converting it op by op.
+
+// minimum(sqrt((a * b - a) * c), b)
+// SAME: output #0: dense<[2.000000e+00, 4.000000e+00]> : tensor<2xf32>
+// BROADCAST: output #0: dense<[2.000000e+00, 3.46410155]> : tensor<2xf32>
+// INVALID: NPCOMP: aborting: required broadcastable shapes
+func @ufunc_chain(%arg0: tensor<?xf32>, %arg1: tensor<?xf32>, %arg2: tensor<?xf32>) -> tensor<?xf32> {
+  %0 = tcf.mul %arg0, %arg1 : (tensor<?xf32>, tensor<?xf32>) -> tensor<?xf32>
+  %1 = tcf.sub %0, %arg0 : (tensor<?xf32>, tensor<?xf32>) -> tensor<?xf32>
+  %2 = tcf.mul %1, %arg2 : (tensor<?xf32>, tensor<?xf32>) -> tensor<?xf32>
+  %3 = tcf.sqrt %2 : tensor<?xf32>
+  %4 = tcf.min %3, %arg1 : (tensor<?xf32>, tensor<?xf32>) -> tensor<?xf32>
+  return %4 : tensor<?xf32>
+}
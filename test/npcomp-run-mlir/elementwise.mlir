@@ -24,6 +24,39 @@
 // RUN:   -shared-libs=%npcomp_runtime_shlib 2>&1 \
 // RUN:   | FileCheck %s --check-prefix=TANH
 
+// RUN: npcomp-run-mlir %s \
+// RUN:   -invoke sub \
+// RUN:   -arg-value="dense<[1.0, 2.0]> : tensor<2xf32>" \
+// RUN:   -arg-value="dense<[3.0, 4.0]> : tensor<2xf32>" \
+// RUN:   -shared-libs=%npcomp_runtime_shlib 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=SUB
+
+// RUN: npcomp-run-mlir %s \
+// RUN:   -invoke div \
+// RUN:   -arg-value="dense<[3.0, 8.0]> : tensor<2xf32>" \
+// RUN:   -arg-value="dense<[2.0, 4.0]> : tensor<2xf32>" \
+// RUN:   -shared-libs=%npcomp_runtime_shlib 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=DIV
+
+// RUN: npcomp-run-mlir %s \
+// RUN:   -invoke min \
+// RUN:   -arg-value="dense<[1.0]> : tensor<1xf32>" \
+// RUN:   -arg-value="dense<[3.0]> : tensor<1xf32>" \
+// RUN:   -shared-libs=%npcomp_runtime_shlib 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=MIN
+
+// RUN: npcomp-run-mlir %s \
+// RUN:   -invoke log \
+// RUN:   -arg-value="dense<[1.0]> : tensor<1xf32>" \
+// RUN:   -shared-libs=%npcomp_runtime_shlib 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=LOG
+
+// RUN: npcomp-run-mlir %s \
+// RUN:   -invoke sqrt \
+// RUN:   -arg-value="dense<[4.0, 9.0]> : tensor<2xf32>" \
+// RUN:   -shared-libs=%npcomp_runtime_shlib 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=SQRT
+
 // These ops share a lot of code paths. So we don't test the exact
 // broadcasting behavior and error checking for all of them.
 
@@ -50,3 +83,33 @@ func @tanh(%arg0: tensor<?xf32>) -> tensor<?xf32> {
   %0 = tcf.tanh %arg0 : tensor<?xf32>
   return %0 : tensor<?xf32>
 }
+
+// SUB: output #0: dense<-2.000000e+00> : tensor<2xf32>
+func @sub(%arg0: tensor<?xf32>, %arg1: tensor<?xf32>) -> tensor<?xf32> {
+  %0 = tcf.sub %arg0, %arg1 : (tensor<?xf32>, tensor<?xf32>) -> tensor<?xf32>
+  return %0 : tensor<?xf32>
+}
+
+// DIV: output #0: dense<[1.500000e+00, 2.000000e+00]> : tensor<2xf32>
+func @div(%arg0: tensor<?xf32>, %arg1: tensor<?xf32>) -> tensor<?xf32> {
+  %0 = tcf.div %arg0, %arg1 : (tensor<?xf32>, tensor<?xf32>) -> tensor<?xf32>
+  return %0 : tensor<?xf32>
+}
+
+// MIN: output #0: dense<1.000000e+00> : tensor<1xf32>
+func @min(%arg0: tensor<?xf32>, %arg1: tensor<?xf32>) -> tensor<?xf32> {
+  %0 = tcf.min %arg0, %arg1 : (tensor<?xf32>, tensor<?xf32>) -> tensor<?xf32>
+  return %0 : tensor<?xf32>
+}
+
+// LOG: output #0: dense<0.000000e+00> : tensor<1xf32>
+func @log(%arg0: tensor<?xf32>) -> tensor<?xf32> {
+  %0 = tcf.log %arg0 : tensor<?xf32>
+  return %0 : tensor<?xf32>
+}
+
+// SQRT: output #0: dense<[2.000000e+00, 3.000000e+00]> : tensor<2xf32>
+func @sqrt(%arg0: tensor<?xf32>) -> tensor<?xf32> {
+  %0 = tcf.sqrt %arg0 : tensor<?xf32>
+  return %0 : tensor<?xf32>
+}
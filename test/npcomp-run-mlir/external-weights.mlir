@@ -0,0 +1,16 @@
+// RUN: rm -rf %t && mkdir -p %t
+// RUN: %PYTHON -c "import struct; open('%t/00000000DEADBEEF.bin', 'wb').write(struct.pack('<2f', 1.0, 2.0))"
+// RUN: npcomp-run-mlir %s \
+// RUN:   -invoke external_weights \
+// RUN:   -arg-value="dense<[3.0, 5.0]> : tensor<2xf32>" \
+// RUN:   -weights-dir=%t \
+// RUN:   -shared-libs=%npcomp_runtime_shlib 2>&1 \
+// RUN:   | FileCheck %s
+
+// The weight is bound to the blob named by its key when the module is loaded.
+// CHECK: output #0: dense<[4.000000e+00, 7.000000e+00]> : tensor<2xf32>
+func @external_weights(%arg0: tensor<2xf32>) -> tensor<2xf32> {
+  %0 = constant opaque<"torch", "0x00000000DEADBEEF"> : tensor<2xf32>
+  %1 = tcf.add %arg0, %0 : (tensor<2xf32>, tensor<2xf32>) -> tensor<2xf32>
+  return %1 : tensor<2xf32>
+}
@@ -0,0 +1,33 @@
+// RUN: npcomp-opt %s -torch-globalized-module-pipeline -canonicalize \
+// RUN:   | npcomp-run-mlir - \
+// RUN:   -invoke forward \
+// RUN:   -shared-libs=%npcomp_runtime_shlib 2>&1 \
+// RUN:   | FileCheck %s
+
+// The private weight is frozen into a constant, and the public attribute is
+// read from a global of the compiled module.
+// CHECK: output #0: dense<[4.000000e+00, 6.000000e+00]> : tensor<2xf32>
+
+torch.class_type @c {
+  torch.attr private "w" : !numpy.ndarray<*:!numpy.any_dtype>
+  torch.attr "state" : !numpy.ndarray<*:!numpy.any_dtype>
+  torch.method "forward", @f
+}
+
+func private @f(%arg0: !torch.nn.Module<"c">) -> tensor<2xf32> {
+  %0 = torch.prim.GetAttr %arg0["w"] : !torch.nn.Module<"c"> -> !numpy.ndarray<*:!numpy.any_dtype>
+  %1 = torch.prim.GetAttr %arg0["state"] : !torch.nn.Module<"c"> -> !numpy.ndarray<*:!numpy.any_dtype>
+  %2 = numpy.copy_to_tensor %0 : (!numpy.ndarray<*:!numpy.any_dtype>) -> tensor<2xf32>
+  %3 = numpy.copy_to_tensor %1 : (!numpy.ndarray<*:!numpy.any_dtype>) -> tensor<2xf32>
+  %4 = tcf.add %2, %3 : (tensor<2xf32>, tensor<2xf32>) -> tensor<2xf32>
+  return %4 : tensor<2xf32>
+}
+
+%w = constant dense<[1.0, 2.0]> : tensor<2xf32>
+%wa = numpy.create_array_from_tensor %w : (tensor<2xf32>) -> !numpy.ndarray<*:!numpy.any_dtype>
+%s = constant dense<[3.0, 4.0]> : tensor<2xf32>
+%sa = numpy.create_array_from_tensor %s : (tensor<2xf32>) -> !numpy.ndarray<*:!numpy.any_dtype>
+torch.nn_module {
+  torch.slot "w", %wa : !numpy.ndarray<*:!numpy.any_dtype>
+  torch.slot "state", %sa : !numpy.ndarray<*:!numpy.any_dtype>
+} : !torch.nn.Module<"c">
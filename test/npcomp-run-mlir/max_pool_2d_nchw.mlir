@@ -0,0 +1,28 @@
+// RUN: npcomp-run-mlir %s \
+// RUN:   -invoke max_pool_2d_nchw \
+// RUN:   -arg-value="dense<[[[[1.0, 4.0], [3.0, 2.0]]]]> : tensor<1x1x2x2xf32>" \
+// RUN:   -shared-libs=%npcomp_runtime_shlib 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=MAX
+
+// RUN: npcomp-run-mlir %s \
+// RUN:   -invoke max_pool_2d_nchw \
+// RUN:   -arg-value="dense<[[[[1.0, 0x7FC00000], [3.0, 2.0]]]]> : tensor<1x1x2x2xf32>" \
+// RUN:   -shared-libs=%npcomp_runtime_shlib 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=NAN
+
+// RUN: npcomp-run-mlir %s \
+// RUN:   -invoke max_pool_2d_nchw \
+// RUN:   -arg-value="dense<[[[[0x7FC00000, 1.0], [3.0, 2.0]]]]> : tensor<1x1x2x2xf32>" \
+// RUN:   -shared-libs=%npcomp_runtime_shlib 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=NAN
+
+// MAX: output #0: dense<4.000000e+00> : tensor<1x1x1x1xf32>
+
+// A NaN anywhere in the window propagates, whether it is reached before or
+// after the maximum.
+// NAN: output #0: dense<0x7FC00000> : tensor<1x1x1x1xf32>
+
+func @max_pool_2d_nchw(%arg0: tensor<?x?x?x?xf32>) -> tensor<?x?x?x?xf32> {
+  %0 = tcf.max_pool_2d_nchw %arg0 {dilations = [1, 1], kernel_size = [2, 2], padding = [0, 0], strides = [1, 1]} : (tensor<?x?x?x?xf32>) -> tensor<?x?x?x?xf32>
+  return %0 : tensor<?x?x?x?xf32>
+}
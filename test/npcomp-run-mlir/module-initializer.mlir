@@ -0,0 +1,27 @@
+// RUN: npcomp-run-mlir %s \
+// RUN:   -invoke read_state \
+// RUN:   -arg-value="dense<[3.0, 5.0]> : tensor<2xf32>" \
+// RUN:   -shared-libs=%npcomp_runtime_shlib 2>&1 \
+// RUN:   | FileCheck %s
+
+// The module initializer runs once when the module is loaded, before any
+// function is invoked.
+// CHECK: output #0: dense<[5.000000e+00, 9.000000e+00]> : tensor<2xf32>
+
+global_memref "private" @state : memref<2xf32> = uninitialized
+
+func @__npcomp_module_init() {
+  %0 = constant dense<[1.0, 2.0]> : tensor<2xf32>
+  %1 = tcf.add %0, %0 : (tensor<2xf32>, tensor<2xf32>) -> tensor<2xf32>
+  %2 = tensor_to_memref %1 : memref<2xf32>
+  %3 = get_global_memref @state : memref<2xf32>
+  linalg.copy(%2, %3) : memref<2xf32>, memref<2xf32>
+  return
+}
+
+func @read_state(%arg0: tensor<2xf32>) -> tensor<2xf32> {
+  %0 = get_global_memref @state : memref<2xf32>
+  %1 = tensor_load %0 : memref<2xf32>
+  %2 = tcf.add %arg0, %1 : (tensor<2xf32>, tensor<2xf32>) -> tensor<2xf32>
+  return %2 : tensor<2xf32>
+}
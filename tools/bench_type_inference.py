@@ -0,0 +1,86 @@
+#!/usr/bin/env python3
+#  Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+#  See https://llvm.org/LICENSE.txt for license information.
+#  SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+"""Measures how type inference scales with the number of type variables.
+
+Generates functions where each value is a basicpy.binary_expr of !basicpy
+.UnknownType operands (one type variable each) and times a type inference
+pass (by default -npcomp-cpa-type-inference) on them with npcomp-opt. The
+dependency chains are long, so CPA propagation needs as many rounds as
+there are values, and naive unification builds long substitution chains.
+
+Example:
+  ./tools/bench_type_inference.py --npcomp-opt build/bin/npcomp-opt \\
+      --pass basicpy-type-inference --sizes 1000,2000,4000
+"""
+
+import argparse
+import subprocess
+import tempfile
+import time
+
+
+def generate_function(num_vars, fanin):
+  """Generates a function with `num_vars` type variables.
+
+  Value i combines value i-1 with value i-`fanin`, so every variable is
+  reached by the seed type through a path of length ~i.
+  """
+  unknown = "!basicpy.UnknownType"
+  lines = [
+      f"func @chain(%arg0: i64) -> {unknown} {{",
+      f"  %v0 = basicpy.unknown_cast %arg0 : i64 -> {unknown}",
+  ]
+  for i in range(1, num_vars):
+    rhs = max(0, i - fanin)
+    lines.append(f"  %v{i} = basicpy.binary_expr %v{i - 1} \"Add\" %v{rhs} : "
+                 f"({unknown}, {unknown}) -> {unknown}")
+  lines.append(f"  return %v{num_vars - 1} : {unknown}")
+  lines.append("}")
+  return "\n".join(lines) + "\n"
+
+
+def time_inference(npcomp_opt, pass_name, source, repetitions):
+  with tempfile.NamedTemporaryFile("w", suffix=".mlir") as f:
+    f.write(source)
+    f.flush()
+    timings = []
+    for _ in range(repetitions):
+      start = time.perf_counter()
+      subprocess.run(
+          [npcomp_opt, f"-{pass_name}", "-o", "/dev/null", f.name],
+          check=True)
+      timings.append(time.perf_counter() - start)
+    return min(timings)
+
+
+def main():
+  parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+  parser.add_argument("--npcomp-opt", default="npcomp-opt")
+  parser.add_argument("--pass", dest="pass_name",
+                      default="npcomp-cpa-type-inference",
+                      choices=["npcomp-cpa-type-inference",
+                               "basicpy-type-inference"])
+  parser.add_argument("--sizes", default="500,1000,2000,4000",
+                      help="Comma separated numbers of type variables")
+  parser.add_argument("--fanin", type=int, default=4)
+  parser.add_argument("--repetitions", type=int, default=3)
+  parser.add_argument("--emit", action="store_true",
+                      help="Print the largest generated function and exit")
+  args = parser.parse_args()
+
+  sizes = [int(s) for s in args.sizes.split(",")]
+  if args.emit:
+    print(generate_function(max(sizes), args.fanin), end="")
+    return
+
+  for size in sizes:
+    best = time_inference(args.npcomp_opt, args.pass_name,
+                          generate_function(size, args.fanin),
+                          args.repetitions)
+    print(f"{size:8d} vars: {best * 1000:10.1f} ms")
+
+
+if __name__ == "__main__":
+  main()
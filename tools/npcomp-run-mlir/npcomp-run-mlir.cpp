@@ -122,7 +122,8 @@ static void printOutputs(ArrayRef<refbackrt::Ref<refbackrt::Tensor>> outputs,
 
 Error compileAndRun(std::string mlirFile, mlir::MLIRContext &context,
                     std::string invokeFunction, ArrayRef<StringRef> argValues,
-                    ArrayRef<StringRef> sharedLibs, bool optimize) {
+                    ArrayRef<StringRef> sharedLibs, StringRef weightsDir,
+                    bool optimize) {
   OwningModuleRef moduleRef = parseSourceFile(mlirFile, &context);
   if (!moduleRef)
     return make_string_error(Twine("could not open ") + mlirFile);
@@ -138,7 +139,7 @@ Error compileAndRun(std::string mlirFile, mlir::MLIRContext &context,
   }
 
   auto expectedJitModule =
-      refback::JITModule::fromCompiledModule(module, sharedLibs);
+      refback::JITModule::fromCompiledModule(module, sharedLibs, weightsDir);
   if (!expectedJitModule)
     return expectedJitModule.takeError();
   auto jitModule = std::move(*expectedJitModule);
@@ -172,6 +173,10 @@ struct Options {
   cl::list<std::string> sharedLibs{"shared-libs", cl::ZeroOrMore,
                                    cl::MiscFlags::CommaSeparated,
                                    cl::desc("Libraries to link dynamically")};
+  cl::opt<std::string> weightsDir{
+      "weights-dir", cl::Optional,
+      cl::desc("Directory of the blobs of weights imported by reference"),
+      cl::init("")};
   cl::opt<bool> optimize{
       "optimize", cl::Optional,
       cl::desc("whether the refback pass pipeline should run optimizations"),
@@ -203,7 +208,8 @@ int main(int argc, char **argv) {
                                       options.argValues.end());
   Error error =
       compileAndRun(options.inputFile, context, options.invokeFunction,
-                    argValues, sharedLibs, options.optimize);
+                    argValues, sharedLibs, options.weightsDir,
+                    options.optimize);
 
   int exitCode = EXIT_SUCCESS;
   llvm::handleAllErrors(std::move(error),